@@ -756,47 +756,23 @@ invalid_fs:
 
 GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_fstat, 3.4.0);
 
-struct glfs_fd *
-pub_glfs_creat(struct glfs *fs, const char *path, int flags, mode_t mode)
+/* Creates or opens @path with @xattr_req, which has the gfid-req of the new
+ * file, and returns the reply of the create in @xattr_rsp. */
+static struct glfs_fd *
+glfs_creat_common(struct glfs *fs, xlator_t *subvol, const char *path,
+                  int flags, mode_t mode, dict_t *xattr_req,
+                  dict_t **xattr_rsp)
 {
     int ret = -1;
     struct glfs_fd *glfd = NULL;
-    xlator_t *subvol = NULL;
     loc_t loc = {
         0,
     };
     struct iatt iatt = {
         0,
     };
-    uuid_t gfid;
-    dict_t *xattr_req = NULL;
     int reval = 0;
 
-    DECLARE_OLD_THIS;
-    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
-
-    subvol = glfs_active_subvol(fs);
-    if (!subvol) {
-        ret = -1;
-        errno = EIO;
-        goto out;
-    }
-
-    xattr_req = dict_new();
-    if (!xattr_req) {
-        ret = -1;
-        errno = ENOMEM;
-        goto out;
-    }
-
-    gf_uuid_generate(gfid);
-    ret = dict_set_gfuuid(xattr_req, "gfid-req", gfid, true);
-    if (ret) {
-        ret = -1;
-        errno = ENOMEM;
-        goto out;
-    }
-
     glfd = glfs_fd_new(fs);
     if (!glfd)
         goto out;
@@ -872,8 +848,12 @@ retry:
         ret = syncop_open(subvol, &loc, flags, glfd->fd, xattr_req, NULL);
         DECODE_SYNCOP_ERR(ret);
     } else {
+        if (xattr_rsp && *xattr_rsp) {
+            dict_unref(*xattr_rsp);
+            *xattr_rsp = NULL;
+        }
         ret = syncop_create(subvol, &loc, flags, mode, glfd->fd, &iatt,
-                            xattr_req, NULL);
+                            xattr_req, xattr_rsp);
         DECODE_SYNCOP_ERR(ret);
     }
 
@@ -884,9 +864,6 @@ retry:
 out:
     loc_wipe(&loc);
 
-    if (xattr_req)
-        dict_unref(xattr_req);
-
     if (ret && glfd) {
         GF_REF_PUT(glfd);
         glfd = NULL;
@@ -894,6 +871,48 @@ out:
         glfd_set_state_bind(glfd);
     }
 
+    return glfd;
+}
+
+struct glfs_fd *
+pub_glfs_creat(struct glfs *fs, const char *path, int flags, mode_t mode)
+{
+    int ret = -1;
+    struct glfs_fd *glfd = NULL;
+    xlator_t *subvol = NULL;
+    uuid_t gfid;
+    dict_t *xattr_req = NULL;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
+
+    subvol = glfs_active_subvol(fs);
+    if (!subvol) {
+        ret = -1;
+        errno = EIO;
+        goto out;
+    }
+
+    xattr_req = dict_new();
+    if (!xattr_req) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    gf_uuid_generate(gfid);
+    ret = dict_set_gfuuid(xattr_req, "gfid-req", gfid, true);
+    if (ret) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    glfd = glfs_creat_common(fs, subvol, path, flags, mode, xattr_req, NULL);
+out:
+    if (xattr_req)
+        dict_unref(xattr_req);
+
     glfs_subvol_done(fs, subvol);
 
     __GLFS_EXIT_FS;
@@ -904,6 +923,138 @@ invalid_fs:
 
 GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_creat, 3.4.0);
 
+ssize_t
+pub_glfs_creat_write(struct glfs *fs, const char *path, int flags,
+                     mode_t mode, const void *buf, size_t count)
+{
+    ssize_t ret = -1;
+    struct glfs_fd *glfd = NULL;
+    xlator_t *subvol = NULL;
+    fd_t *fd = NULL;
+    uuid_t gfid;
+    dict_t *xattr_req = NULL;
+    dict_t *xattr_rsp = NULL;
+    struct iobref *iobref = NULL;
+    struct iobuf *iobuf = NULL;
+    struct iovec data = {
+        0,
+    };
+    struct iovec iov = {
+        0,
+    };
+    int32_t written = 0;
+
+    DECLARE_OLD_THIS;
+    __GLFS_ENTRY_VALIDATE_FS(fs, invalid_fs);
+
+    subvol = glfs_active_subvol(fs);
+    if (!subvol) {
+        ret = -1;
+        errno = EIO;
+        goto out;
+    }
+
+    xattr_req = dict_new();
+    if (!xattr_req) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    gf_uuid_generate(gfid);
+    ret = dict_set_gfuuid(xattr_req, "gfid-req", gfid, true);
+    if (ret) {
+        ret = -1;
+        errno = ENOMEM;
+        goto out;
+    }
+
+    /* protocol/client sends the create, the write and the flush in a
+     * single request and returns the result of the write in the reply */
+    if ((count > 0) && (count <= GF_CREATE_WRITE_MAX)) {
+        ret = dict_set_static_bin(xattr_req, GF_CREATE_WRITE_KEY, (void *)buf,
+                                  count);
+        if (ret) {
+            ret = -1;
+            errno = ENOMEM;
+            goto out;
+        }
+    }
+
+    glfd = glfs_creat_common(fs, subvol, path, flags | O_CREAT | O_EXCL, mode,
+                             xattr_req, &xattr_rsp);
+    if (!glfd) {
+        ret = -1;
+        goto out;
+    }
+
+    if (xattr_rsp &&
+        !dict_get_int32_sizen(xattr_rsp, GF_CREATE_WRITE_KEY, &written)) {
+        if (written < 0) {
+            ret = -1;
+            errno = -written;
+        } else {
+            ret = written;
+        }
+        goto out;
+    }
+
+    fd = glfs_resolve_fd(fs, subvol, glfd);
+    if (!fd) {
+        ret = -1;
+        errno = EBADFD;
+        goto out;
+    }
+
+    written = 0;
+    if (count > 0) {
+        data.iov_base = (void *)buf;
+        data.iov_len = count;
+        ret = iobuf_copy(subvol->ctx->iobuf_pool, &data, 1, &iobref, &iobuf,
+                         &iov);
+        if (ret) {
+            iobref = NULL;
+            iobuf = NULL;
+            ret = -1;
+            goto out;
+        }
+
+        ret = syncop_writev(subvol, fd, &iov, 1, 0, iobref, 0, NULL, NULL,
+                            NULL, NULL);
+        DECODE_SYNCOP_ERR(ret);
+        if (ret < 0)
+            goto out;
+        written = ret;
+    }
+
+    ret = syncop_flush(subvol, fd, NULL, NULL);
+    DECODE_SYNCOP_ERR(ret);
+    if (ret == 0)
+        ret = written;
+out:
+    if (fd)
+        fd_unref(fd);
+    if (glfd)
+        glfs_mark_glfd_for_deletion(glfd);
+    if (iobuf)
+        iobuf_unref(iobuf);
+    if (iobref)
+        iobref_unref(iobref);
+    if (xattr_req)
+        dict_unref(xattr_req);
+    if (xattr_rsp)
+        dict_unref(xattr_rsp);
+
+    glfs_subvol_done(fs, subvol);
+
+    __GLFS_EXIT_FS;
+
+invalid_fs:
+    return ret;
+}
+
+GFAPI_SYMVER_PUBLIC_DEFAULT(glfs_creat_write, 9.0);
+
 #ifdef HAVE_SEEK_HOLE
 static int
 glfs_seek(struct glfs_fd *glfd, off_t offset, int whence)
@@ -626,6 +626,45 @@ glfs_fd_t *
 glfs_creat(glfs_t *fs, const char *path, int flags, mode_t mode) __THROW
     GFAPI_PUBLIC(glfs_creat, 3.4.0);
 
+/*
+  SYNOPSIS
+
+  glfs_creat_write: Create a file, write to it and close it.
+
+  DESCRIPTION
+
+  This function creates a new file on a virtual mount and writes @count
+  bytes of @buf at its beginning. When client.create-write-compound is set
+  on the volume and the bricks support it, up to 128KB are sent with the
+  create and the close in a single request to the brick.
+
+  PARAMETERS
+
+  @fs: The 'virtual mount' object to be initialized.
+
+  @path: Path of the file within the virtual mount.
+
+  @flags: Open flags. See open(2). O_CREAT and O_EXCL are implied.
+
+  @mode: Permission of the file to be created.
+
+  @buf: Data to be written.
+
+  @count: Size of the data.
+
+  RETURN VALUES
+
+  -1 : Failure. @errno will be set with the type of failure. The file is
+       left in place if only the write or the close failed.
+  Others : Number of bytes written.
+
+ */
+
+ssize_t
+glfs_creat_write(glfs_t *fs, const char *path, int flags, mode_t mode,
+                 const void *buf, size_t count) __THROW
+    GFAPI_PUBLIC(glfs_creat_write, 9.0);
+
 int
 glfs_close(glfs_fd_t *fd) __THROW GFAPI_PUBLIC(glfs_close, 3.4.0);
 
@@ -5685,6 +5685,16 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
         if (ret) {
             gf_log("cli", GF_LOG_DEBUG, "failed to get %s from dict", key);
         }
+
+        /* not sent by older bricks, they're left at 0 */
+        snprintf(key, sizeof(key), "%d-%d-%d-p50latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p50_latency);
+        snprintf(key, sizeof(key), "%d-%d-%d-p90latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p90_latency);
+        snprintf(key, sizeof(key), "%d-%d-%d-p99latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p99_latency);
+        snprintf(key, sizeof(key), "%d-%d-%d-p999latency", count, interval, i);
+        ret = dict_get_double(dict, key, &profile_info[i].p999_latency);
         profile_info[i].fop_name = (char *)gf_fop_list[i];
 
         total_percentage_latency += (profile_info[i].fop_hits *
@@ -5801,6 +5811,24 @@ cmd_profile_volume_brick_out(dict_t *dict, int count, int interval)
         }
     }
 
+    is_header_printed = 0;
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        if (profile_info[i].fop_hits == 0 || profile_info[i].p50_latency == 0)
+            continue;
+        if (is_header_printed == 0) {
+            cli_out(" ");
+            cli_out("%13s %13s %13s %13s %11s", "P50-Latency", "P90-Latency",
+                    "P99-Latency", "P99.9-Latency", "Fop");
+            cli_out("%13s %13s %13s %13s %11s", "-----------", "-----------",
+                    "-----------", "-------------", "----");
+            is_header_printed = 1;
+        }
+        cli_out("%10.2lf us %10.2lf us %10.2lf us %10.2lf us %11s",
+                profile_info[i].p50_latency, profile_info[i].p90_latency,
+                profile_info[i].p99_latency, profile_info[i].p999_latency,
+                profile_info[i].fop_name);
+    }
+
     cli_out(" ");
     cli_out("%12s: %" PRId64 " seconds", "Duration", sec);
     cli_out("%12s: %" PRId64 " bytes", "Data Read", r_count);
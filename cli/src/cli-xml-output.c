@@ -1919,6 +1919,34 @@ out:
 }
 
 #if (HAVE_LIB_XML)
+/* The percentiles are only sent by bricks that keep latency histograms */
+static int
+cli_xml_output_vol_profile_percentiles(xmlTextWriterPtr writer, dict_t *dict,
+                                       int brick_index, int interval, int fop)
+{
+    const char *keys[] = {"p50", "p90", "p99", "p999"};
+    const char *elements[] = {"p50Latency", "p90Latency", "p99Latency",
+                              "p999Latency"};
+    char key[1024] = {0};
+    double latency = 0.0;
+    int ret = 0;
+    int i = 0;
+
+    for (i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "%d-%d-%d-%slatency", brick_index, interval,
+                 fop, keys[i]);
+        if (dict_get_double(dict, key, &latency))
+            return 0;
+
+        ret = xmlTextWriterWriteFormatElement(writer, (xmlChar *)elements[i],
+                                              "%f", latency);
+        if (ret < 0)
+            return ret;
+    }
+
+    return 0;
+}
+
 int
 cli_xml_output_vol_profile_stats(xmlTextWriterPtr writer, dict_t *dict,
                                  int brick_index, int interval)
@@ -2035,6 +2063,10 @@ cli_xml_output_vol_profile_stats(xmlTextWriterPtr writer, dict_t *dict,
                                               "%f", max_latency);
         XML_RET_CHECK_AND_GOTO(ret, out);
 
+        ret = cli_xml_output_vol_profile_percentiles(writer, dict,
+                                                     brick_index, interval, i);
+        XML_RET_CHECK_AND_GOTO(ret, out);
+
         /* </fop> */
         ret = xmlTextWriterEndElement(writer);
         XML_RET_CHECK_AND_GOTO(ret, out);
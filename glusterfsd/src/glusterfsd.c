@@ -205,6 +205,13 @@ static struct argp_option gf_options[] = {
      "Enables thin mount and connects via gfproxyd daemon"},
     {"global-threading", ARGP_GLOBAL_THREADING_KEY, "BOOL", OPTION_ARG_OPTIONAL,
      "Use the global thread pool instead of io-threads"},
+    {"event-thread-affinity", ARGP_EVENT_THREAD_AFFINITY_KEY, "BOOL",
+     OPTION_ARG_OPTIONAL,
+     "Give every event thread its own epoll instance and bind each "
+     "connection to one of them"},
+    {"timer-wheels", ARGP_TIMER_WHEELS_KEY, "N", 0,
+     "Number of timer wheels, each with its own thread. The timers are "
+     "spread among them by the thread that adds them [default: 1]"},
     {0, 0, 0, 0, "Fuse options:"},
     {"direct-io-mode", ARGP_DIRECT_IO_MODE_KEY, "BOOL|auto",
      OPTION_ARG_OPTIONAL, "Specify direct I/O strategy [default: \"auto\"]"},
@@ -226,6 +233,9 @@ static struct argp_option gf_options[] = {
     {"invalidate-limit", ARGP_FUSE_INVALIDATE_LIMIT_KEY, "N", 0,
      "Suspend inode invalidations implied by 'lru-limit' if the number of "
      "outstanding invalidations reaches N"},
+    {"inode-table-stripes", ARGP_FUSE_INODE_TABLE_STRIPES_KEY, "N", 0,
+     "Protect fuse module's inode table with N striped locks "
+     "[default: 0 (single lock)]"},
     {"background-qlen", ARGP_FUSE_BACKGROUND_QLEN_KEY, "N", 0,
      "Set fuse module's background queue length to N "
      "[default: 64]"},
@@ -531,6 +541,16 @@ set_fuse_mount_options(glusterfs_ctx_t *ctx, dict_t *options)
         }
     }
 
+    if (cmd_args->inode_table_stripes) {
+        ret = dict_set_uint32(options, "inode-table-stripes",
+                              cmd_args->inode_table_stripes);
+        if (ret < 0) {
+            gf_msg("glusterfsd", GF_LOG_ERROR, 0, glusterfsd_msg_4,
+                   "inode-table-stripes");
+            goto err;
+        }
+    }
+
     if (cmd_args->background_qlen) {
         ret = dict_set_int32(options, "background-qlen",
                              cmd_args->background_qlen);
@@ -1329,6 +1349,14 @@ parse_opts(int key, char *arg, struct argp_state *state)
                          arg);
             break;
 
+        case ARGP_FUSE_INODE_TABLE_STRIPES_KEY:
+            if (!gf_string2uint32(arg, &cmd_args->inode_table_stripes))
+                break;
+
+            argp_failure(state, -1, 0, "unknown inode table stripes option %s",
+                         arg);
+            break;
+
         case ARGP_FUSE_BACKGROUND_QLEN_KEY:
             if (!gf_string2int(arg, &cmd_args->background_qlen))
                 break;
@@ -1562,6 +1590,31 @@ parse_opts(int key, char *arg, struct argp_state *state)
                          "Invalid value for global threading \"%s\"", arg);
             break;
 
+        case ARGP_EVENT_THREAD_AFFINITY_KEY:
+            if (!arg || (*arg == 0)) {
+                arg = "yes";
+            }
+
+            if (gf_string2boolean(arg, &b) == 0) {
+                cmd_args->event_thread_affinity = b;
+                break;
+            }
+
+            argp_failure(state, -1, 0,
+                         "Invalid value for event thread affinity \"%s\"",
+                         arg);
+            break;
+
+        case ARGP_TIMER_WHEELS_KEY:
+            if (!gf_string2uint32(arg, &cmd_args->timer_wheels) &&
+                (cmd_args->timer_wheels >= 1) &&
+                (cmd_args->timer_wheels <= GF_TIMER_MAX_WHEELS))
+                break;
+
+            argp_failure(state, -1, 0, "Invalid number of timer wheels %s",
+                         arg);
+            break;
+
         case ARGP_FUSE_DEV_EPERM_RATELIMIT_NS_KEY:
             if (gf_string2uint32(arg, &cmd_args->fuse_dev_eperm_ratelimit_ns)) {
                 argp_failure(state, -1, 0,
@@ -2880,6 +2933,10 @@ main(int argc, char *argv[])
         goto out;
     }
 
+    /* nothing is registered with the event pool yet */
+    if (cmd->event_thread_affinity)
+        gf_event_pool_set_affinity(ctx->event_pool);
+
     /* log the version of glusterfs running here along with the actual
        command line options. */
     {
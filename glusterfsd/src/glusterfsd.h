@@ -115,6 +115,9 @@ enum argp_option_keys {
     ARGP_BRICK_MUX_KEY = 193,
     ARGP_FUSE_DEV_EPERM_RATELIMIT_NS_KEY = 194,
     ARGP_FUSE_INVALIDATE_LIMIT_KEY = 195,
+    ARGP_FUSE_INODE_TABLE_STRIPES_KEY = 196,
+    ARGP_EVENT_THREAD_AFFINITY_KEY = 197,
+    ARGP_TIMER_WHEELS_KEY = 198,
 };
 
 struct _gfd_vol_top_priv {
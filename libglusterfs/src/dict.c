@@ -19,6 +19,7 @@
 #include "glusterfs/dict.h"
 #define XXH_INLINE_ALL
 #include "xxhash.h"
+#include "glusterfs/glusterfs.h"
 #include "glusterfs/compat.h"
 #include "glusterfs/compat-errno.h"
 #include "glusterfs/byte-order.h"
@@ -57,48 +58,280 @@ get_new_data()
 
     GF_ATOMIC_INIT(data->refcount, 0);
     data->is_static = _gf_false;
+    data->is_stdalloc = _gf_false;
 
     return data;
 }
 
+/* Keys which are set in the xdata of most of the fops. Pairs using one of
+ * them point to the static string instead of a copy of the key. */
+static const char *const dict_interned_key_names[] = {
+    "gfid-req",
+    GLUSTERFS_INODELK_COUNT,
+    GLUSTERFS_INODELK_DOM_COUNT,
+    GLUSTERFS_ENTRYLK_COUNT,
+    GLUSTERFS_POSIXLK_COUNT,
+    GLUSTERFS_PARENT_ENTRYLK,
+    GLUSTERFS_OPEN_FD_COUNT,
+    GLUSTERFS_ACTIVE_FD_COUNT,
+    GLUSTERFS_WRITE_IS_APPEND,
+    GLUSTERFS_WRITE_UPDATE_ATOMIC,
+    GLUSTERFS_INTERNAL_FOP_KEY,
+    GLUSTERFS_DURABLE_OP,
+    GLUSTERFS_BAD_INODE,
+    GF_XATTR_PATHINFO_KEY,
+    GF_XATTR_NODE_UUID_KEY,
+    GF_XATTR_LINKINFO_KEY,
+    GF_XATTR_MDATA_KEY,
+    GF_XATTR_SHARD_FILE_SIZE,
+    GF_CONTENT_KEY,
+    GF_GFIDLESS_LOOKUP,
+    GF_PREOP_PARENT_KEY,
+    GF_PREOP_CHECK_FAILED,
+    GF_REQUEST_LINK_COUNT_XDATA,
+    GF_RESPONSE_LINK_COUNT_XDATA,
+    GF_INTERNAL_CTX_KEY,
+    GF_PRESTAT,
+    GF_POSTSTAT,
+    GF_AFR_DIRTY,
+    GFID_XATTR_KEY,
+    QUOTA_SIZE_KEY,
+    DHT_IATT_IN_XDATA_KEY,
+    GET_ANCESTRY_PATH_KEY,
+    /* owned by xlators, but carried by the fops of every volume type */
+    "trusted.glusterfs.dht",
+    "trusted.glusterfs.dht.linkto",
+    "trusted.ec.version",
+    "trusted.ec.size",
+    "trusted.ec.config",
+    "trusted.ec.dirty",
+    "link-count",
+};
+
+#define DICT_INTERNED_KEY_COUNT                                                \
+    (sizeof(dict_interned_key_names) / sizeof(dict_interned_key_names[0]))
+
+/* Must be a power of 2, with at least half of the slots free. */
+#define DICT_INTERNED_SLOTS 128
+
+/* Smallest index built for a dict growing over DICT_INDEX_THRESHOLD. */
+#define DICT_INDEX_MIN_SIZE 32
+
+static struct {
+    const char *key;
+    uint32_t hash;
+    uint32_t len;
+} dict_interned_keys[DICT_INTERNED_SLOTS];
+
+static __attribute__((constructor)) void
+dict_interned_keys_init(void)
+{
+    const uint32_t mask = DICT_INTERNED_SLOTS - 1;
+    uint32_t hash = 0;
+    uint32_t len = 0;
+    uint32_t slot = 0;
+    int i = 0;
+
+    GF_ASSERT(DICT_INTERNED_KEY_COUNT <= DICT_INTERNED_SLOTS / 2);
+
+    for (i = 0; i < DICT_INTERNED_KEY_COUNT; i++) {
+        len = strlen(dict_interned_key_names[i]);
+        hash = (uint32_t)XXH64(dict_interned_key_names[i], len, 0);
+
+        for (slot = hash & mask; dict_interned_keys[slot].key;
+             slot = (slot + 1) & mask)
+            ;
+
+        dict_interned_keys[slot].key = dict_interned_key_names[i];
+        dict_interned_keys[slot].hash = hash;
+        dict_interned_keys[slot].len = len;
+    }
+}
+
+static char *
+dict_interned_key(const char *key, const int keylen, const uint32_t hash)
+{
+    const uint32_t mask = DICT_INTERNED_SLOTS - 1;
+    uint32_t slot = 0;
+
+    for (slot = hash & mask; dict_interned_keys[slot].key;
+         slot = (slot + 1) & mask) {
+        if ((dict_interned_keys[slot].hash == hash) &&
+            (dict_interned_keys[slot].len == keylen) &&
+            !memcmp(dict_interned_keys[slot].key, key, keylen))
+            return (char *)dict_interned_keys[slot].key;
+    }
+
+    return NULL;
+}
+
+/* Always called under lock */
+static data_pair_t *
+dict_pair_get(dict_t *this)
+{
+    int i = 0;
+
+    if (this->inline_used != (1U << DICT_INLINE_PAIRS) - 1) {
+        i = __builtin_ctz(~this->inline_used);
+        this->inline_used |= 1U << i;
+        return &this->inline_pairs[i];
+    }
+
+    return mem_get(THIS->ctx->dict_pair_pool);
+}
+
+/* Always called under lock */
+static void
+dict_pair_put(dict_t *this, data_pair_t *pair)
+{
+    uintptr_t i = (uintptr_t)(pair - this->inline_pairs);
+
+    if (i < DICT_INLINE_PAIRS)
+        this->inline_used &= ~(1U << i);
+    else
+        mem_put(pair);
+}
+
+static int
+dict_pair_set_key(data_pair_t *pair, char *key, const int keylen,
+                  const uint32_t hash)
+{
+    pair->key = dict_interned_key(key, keylen, hash);
+    if (pair->key) {
+        pair->key_interned = 1;
+    } else {
+        pair->key = GF_MALLOC(keylen + 1, gf_common_mt_char);
+        if (!pair->key)
+            return -1;
+        memcpy(pair->key, key, keylen);
+        pair->key[keylen] = '\0';
+        pair->key_interned = 0;
+    }
+
+    pair->key_len = keylen;
+    pair->key_hash = hash;
+
+    return 0;
+}
+
+static void
+dict_pair_free_key(data_pair_t *pair)
+{
+    if (!pair->key_interned)
+        GF_FREE(pair->key);
+    pair->key = NULL;
+}
+
+/* Always called under lock */
+static void
+dict_index_add(dict_t *this, data_pair_t *pair)
+{
+    const uint32_t mask = this->hash_size - 1;
+    uint32_t i = pair->key_hash & mask;
+
+    while (this->members[i])
+        i = (i + 1) & mask;
+
+    this->members[i] = pair;
+}
+
+/* Always called under lock. If the new index can't be allocated the old
+ * one is dropped too, and lookups go back to walking members_list. */
+static int
+dict_index_resize(dict_t *this, int32_t size)
+{
+    data_pair_t **members = NULL;
+    data_pair_t *pair = NULL;
+
+    members = GF_CALLOC(size, sizeof(*members), gf_common_mt_dict_index_t);
+
+    GF_FREE(this->members);
+    this->members = members;
+    this->hash_size = members ? size : 0;
+
+    if (!members)
+        return -1;
+
+    for (pair = this->members_list; pair; pair = pair->next)
+        dict_index_add(this, pair);
+
+    return 0;
+}
+
+/* Always called under lock, once @pair is already in members_list. The
+ * index is kept at most half full. */
+static void
+dict_index_insert(dict_t *this, data_pair_t *pair)
+{
+    int32_t size = 0;
+
+    if (this->members) {
+        if (this->count * 2 <= this->hash_size) {
+            dict_index_add(this, pair);
+            return;
+        }
+        size = this->hash_size * 2;
+    } else {
+        if (this->count <= DICT_INDEX_THRESHOLD)
+            return;
+        size = DICT_INDEX_MIN_SIZE;
+    }
+
+    while (size < this->count * 2)
+        size *= 2;
+
+    (void)dict_index_resize(this, size);
+}
+
+/* Always called under lock. Removes @pair from the index moving back the
+ * following pairs of the same cluster, so that no tombstones are needed. */
+static void
+dict_index_del(dict_t *this, data_pair_t *pair)
+{
+    const uint32_t mask = this->hash_size - 1;
+    uint32_t i = pair->key_hash & mask;
+    uint32_t j = 0;
+    uint32_t k = 0;
+
+    while (this->members[i] != pair)
+        i = (i + 1) & mask;
+
+    j = i;
+    for (;;) {
+        this->members[i] = NULL;
+        do {
+            j = (j + 1) & mask;
+            if (!this->members[j])
+                return;
+            /* k is the slot where members[j] would ideally be. It can
+             * only be moved to i if that doesn't put it before k. */
+            k = this->members[j]->key_hash & mask;
+        } while ((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j)));
+
+        this->members[i] = this->members[j];
+        i = j;
+    }
+}
+
+/* @size_hint is the number of keys the dict is expected to hold. */
 static dict_t *
 get_new_dict_full(int size_hint)
 {
     dict_t *dict = mem_get0(THIS->ctx->dict_pool);
+    int32_t size = DICT_INDEX_MIN_SIZE;
 
     if (!dict) {
         return NULL;
     }
 
-    dict->hash_size = size_hint;
-    if (size_hint == 1) {
-        /*
-         * This is the only case we ever see currently.  If we ever
-         * need to support resizing the hash table, the resize function
-         * will have to take into account the possibility that
-         * "members" is not separately allocated (i.e. don't just call
-         * realloc() blindly.
-         */
-        dict->members = &dict->members_internal;
-    } else {
-        /*
-         * We actually need to allocate space for size_hint *pointers*
-         * but we actually allocate space for one *structure*.  Since
-         * a data_pair_t consists of five pointers, we're wasting four
-         * pointers' worth for N=1, and will overrun what we allocated
-         * for N>5.  If anybody ever starts using size_hint, we'll need
-         * to fix this.
-         */
-        GF_ASSERT(size_hint <= (sizeof(data_pair_t) / sizeof(data_pair_t *)));
-        dict->members = mem_get0(THIS->ctx->dict_pair_pool);
-        if (!dict->members) {
-            mem_put(dict);
-            return NULL;
-        }
-    }
-
     LOCK_INIT(&dict->lock);
 
+    if (size_hint > DICT_INDEX_THRESHOLD) {
+        while (size < size_hint * 2)
+            size *= 2;
+        (void)dict_index_resize(dict, size);
+    }
+
     return dict;
 }
 
@@ -292,7 +525,9 @@ void
 data_destroy(data_t *data)
 {
     if (data) {
-        if (!data->is_static)
+        if (data->is_stdalloc)
+            free(data->data);
+        else if (!data->is_static)
             GF_FREE(data->data);
 
         data->len = 0xbabababa;
@@ -337,17 +572,23 @@ err_out:
 static data_pair_t *
 dict_lookup_common(dict_t *this, char *key, uint32_t hash)
 {
-    int hashval = 0;
     data_pair_t *pair;
+    uint32_t mask;
+    uint32_t i;
+
+    if (this->members) {
+        mask = this->hash_size - 1;
+        for (i = hash & mask; (pair = this->members[i]) != NULL;
+             i = (i + 1) & mask) {
+            if ((hash == pair->key_hash) && !strcmp(pair->key, key))
+                return pair;
+        }
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-    if (this->hash_size != 1)
-        hashval = hash % this->hash_size;
+        return NULL;
+    }
 
-    for (pair = this->members[hashval]; pair != NULL; pair = pair->hash_next) {
-        if (pair->key && (hash == pair->key_hash) && !strcmp(pair->key, key))
+    for (pair = this->members_list; pair != NULL; pair = pair->next) {
+        if ((hash == pair->key_hash) && !strcmp(pair->key, key))
             return pair;
     }
 
@@ -385,7 +626,6 @@ static int32_t
 dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
             const uint32_t hash, gf_boolean_t replace)
 {
-    int hashval = 0;
     data_pair_t *pair;
     int key_free = 0;
     uint32_t key_hash;
@@ -417,46 +657,26 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
         }
     }
 
-    if (this->free_pair_in_use) {
-        pair = mem_get(THIS->ctx->dict_pair_pool);
-        if (!pair) {
-            if (key_free)
-                GF_FREE(key);
-            return -1;
-        }
-    } else {
-        pair = &this->free_pair;
-        this->free_pair_in_use = _gf_true;
+    pair = dict_pair_get(this);
+    if (!pair) {
+        if (key_free)
+            GF_FREE(key);
+        return -1;
     }
 
     if (key_free) {
         /* It's ours.  Use it. */
         pair->key = key;
+        pair->key_len = keylen;
+        pair->key_hash = key_hash;
+        pair->key_interned = 0;
         key_free = 0;
-    } else {
-        pair->key = (char *)GF_MALLOC(keylen + 1, gf_common_mt_char);
-        if (!pair->key) {
-            if (pair == &this->free_pair) {
-                this->free_pair_in_use = _gf_false;
-            } else {
-                mem_put(pair);
-            }
-            return -1;
-        }
-        strcpy(pair->key, key);
+    } else if (dict_pair_set_key(pair, key, keylen, key_hash) != 0) {
+        dict_pair_put(this, pair);
+        return -1;
     }
-    pair->key_hash = key_hash;
     pair->value = data_ref(value);
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-    if (this->hash_size != 1) {
-        hashval = (key_hash % this->hash_size);
-    }
-    pair->hash_next = this->members[hashval];
-    this->members[hashval] = pair;
-
     pair->next = this->members_list;
     pair->prev = NULL;
     if (this->members_list)
@@ -464,6 +684,8 @@ dict_set_lk(dict_t *this, char *key, const int key_len, data_t *value,
     this->members_list = pair;
     this->count++;
 
+    dict_index_insert(this, pair);
+
     if (key_free)
         GF_FREE(key);
 
@@ -615,7 +837,7 @@ dict_del(dict_t *this, char *key)
 void
 dict_deln(dict_t *this, char *key, const int keylen)
 {
-    int hashval = 0;
+    data_pair_t *pair = NULL;
     uint32_t hash;
 
     if (!this || !key) {
@@ -628,44 +850,24 @@ dict_deln(dict_t *this, char *key, const int keylen)
 
     LOCK(&this->lock);
 
-    /* If the divisor is 1, the modulo is always 0,
-     * in such case avoid hash calculation.
-     */
-    if (this->hash_size != 1)
-        hashval = hash % this->hash_size;
-
-    data_pair_t *pair = this->members[hashval];
-    data_pair_t *prev = NULL;
-
-    while (pair) {
-        if ((hash == pair->key_hash) && strcmp(pair->key, key) == 0) {
-            if (prev)
-                prev->hash_next = pair->hash_next;
-            else
-                this->members[hashval] = pair->hash_next;
-
-            data_unref(pair->value);
+    pair = dict_lookup_common(this, key, hash);
+    if (pair) {
+        if (this->members)
+            dict_index_del(this, pair);
 
-            if (pair->prev)
-                pair->prev->next = pair->next;
-            else
-                this->members_list = pair->next;
+        data_unref(pair->value);
 
-            if (pair->next)
-                pair->next->prev = pair->prev;
+        if (pair->prev)
+            pair->prev->next = pair->next;
+        else
+            this->members_list = pair->next;
 
-            GF_FREE(pair->key);
-            if (pair == &this->free_pair) {
-                this->free_pair_in_use = _gf_false;
-            } else {
-                mem_put(pair);
-            }
-            this->count--;
-            break;
-        }
+        if (pair->next)
+            pair->next->prev = pair->prev;
 
-        prev = pair;
-        pair = pair->hash_next;
+        dict_pair_free_key(pair);
+        dict_pair_put(this, pair);
+        this->count--;
     }
 
     UNLOCK(&this->lock);
@@ -693,17 +895,13 @@ dict_destroy(dict_t *this)
     while (prev) {
         pair = pair->next;
         data_unref(prev->value);
-        GF_FREE(prev->key);
-        if (prev != &this->free_pair) {
-            mem_put(prev);
-        }
+        dict_pair_free_key(prev);
+        dict_pair_put(this, prev);
         total_pairs++;
         prev = pair;
     }
 
-    if (this->members != &this->members_internal) {
-        mem_put(this->members);
-    }
+    GF_FREE(this->members);
 
     GF_FREE(this->extra_free);
     free(this->extra_stdfree);
@@ -1067,6 +1265,24 @@ data_from_dynptr(void *value, int32_t len)
     return data;
 }
 
+/* Takes ownership of a buffer allocated with malloc() instead of
+ * GF_MALLOC(), like the ones returned by the XDR decoder. */
+data_t *
+data_from_stdalloc(void *value, int32_t len, gf_dict_data_type_t type)
+{
+    data_t *data = get_new_data();
+
+    if (!data)
+        return NULL;
+
+    data->len = len;
+    data->data = value;
+    data->data_type = type;
+    data->is_stdalloc = _gf_true;
+
+    return data;
+}
+
 data_t *
 bin_to_data(void *value, int32_t len)
 {
@@ -1410,7 +1626,7 @@ dict_copy(dict_t *dict, dict_t *new)
     }
 
     if (!new)
-        new = get_new_dict_full(dict->hash_size);
+        new = get_new_dict_full(dict->count);
 
     dict_foreach(dict, dict_copy_one, new);
 
@@ -2074,7 +2290,6 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
     int ret = 0;
     data_pair_t *pair = NULL;
     char *ptr = NULL;
-    int hashval = 0;
     uint32_t hash;
 
     if (!this || !key) {
@@ -2125,43 +2340,11 @@ _dict_modify_flag(dict_t *this, char *key, int flag, int op)
             else
                 BIT_CLEAR((unsigned char *)(data->data), flag);
 
-            if (this->free_pair_in_use) {
-                pair = mem_get0(THIS->ctx->dict_pair_pool);
-                if (!pair) {
-                    gf_msg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
-                           "unable to allocate dict pair");
-                    ret = -ENOMEM;
-                    goto err;
-                }
-            } else {
-                pair = &this->free_pair;
-                this->free_pair_in_use = _gf_true;
-            }
-
-            pair->key = (char *)GF_MALLOC(strlen(key) + 1, gf_common_mt_char);
-            if (!pair->key) {
-                gf_msg("dict", GF_LOG_ERROR, ENOMEM, LG_MSG_NO_MEMORY,
-                       "unable to allocate dict pair");
+            ret = dict_set_lk(this, key, strlen(key), data, hash, 0);
+            if (ret) {
                 ret = -ENOMEM;
                 goto err;
             }
-            strcpy(pair->key, key);
-            pair->key_hash = hash;
-            pair->value = data_ref(data);
-
-            hashval = hash % this->hash_size;
-            pair->hash_next = this->members[hashval];
-            this->members[hashval] = pair;
-
-            pair->next = this->members_list;
-            pair->prev = NULL;
-            if (this->members_list)
-                this->members_list->prev = pair;
-            this->members_list = pair;
-            this->count++;
-
-            if (this->max_count < this->count)
-                this->max_count = this->count;
         }
     }
 
@@ -2172,17 +2355,6 @@ err:
     if (key && this)
         UNLOCK(&this->lock);
 
-    if (pair) {
-        if (pair->key)
-            free(pair->key);
-
-        if (pair == &this->free_pair) {
-            this->free_pair_in_use = _gf_false;
-        } else {
-            mem_put(pair);
-        }
-    }
-
     if (data)
         data_destroy(data);
 
@@ -2900,7 +3072,7 @@ dict_serialized_length_lk(dict_t *this)
             goto out;
         }
 
-        len += strlen(pair->key) + 1 /* for '\0' */;
+        len += pair->key_len + 1 /* for '\0' */;
 
         if (!pair->value) {
             gf_msg("dict", GF_LOG_ERROR, EINVAL, LG_MSG_NULL_PTR,
@@ -2976,7 +3148,7 @@ dict_serialize_lk(dict_t *this, char *buf)
             goto out;
         }
 
-        keylen = strlen(pair->key);
+        keylen = pair->key_len;
         netword = hton32(keylen);
         memcpy(buf, &netword, sizeof(netword));
         buf += DICT_DATA_HDR_KEY_LEN;
@@ -3136,9 +3308,6 @@ dict_unserialize(char *orig_buf, int32_t size, dict_t **fill)
         goto out;
     }
 
-    /* count will be set by the dict_set's below */
-    (*fill)->count = 0;
-
     for (i = 0; i < count; i++) {
         if ((buf + DICT_DATA_HDR_KEY_LEN) > (orig_buf + size)) {
             gf_msg_callingfn("dict", GF_LOG_ERROR, 0, LG_MSG_UNDERSIZED_BUF,
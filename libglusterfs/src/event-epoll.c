@@ -20,6 +20,14 @@
 #ifdef HAVE_SYS_EPOLL_H
 #include <sys/epoll.h>
 
+/* Maximum number of events reaped per epoll_wait() by a thread with its
+ * own epoll instance */
+#define EVENT_AFFINITY_BATCH 16
+
+/* Threads with their own epoll instance wake up at least this often (in
+ * milliseconds) to notice that they have to exit */
+#define EVENT_AFFINITY_TIMEOUT 1000
+
 struct event_slot_epoll {
     int fd;
     int events;
@@ -29,6 +37,8 @@ struct event_slot_epoll {
     int do_close;
     int in_handler;
     int handled_error;
+    int poller; /* thread the fd is bound to, with affinity */
+    int armed;  /* fd is in the epoll instance of its thread */
     void *data;
     event_handler_t handler;
     gf_lock_t lock;
@@ -62,6 +72,67 @@ __event_newtable(struct event_pool *event_pool, int table_idx)
     return table;
 }
 
+/* Number of threads fds can be bound to, with affinity */
+static int
+__event_poller_count(struct event_pool *event_pool)
+{
+    int count = event_pool->eventthreadcount;
+
+    if (count > EVENT_MAX_THREADS)
+        count = EVENT_MAX_THREADS;
+
+    return count;
+}
+
+/* Returns the least loaded thread */
+static int
+__event_poller_pick(struct event_pool *event_pool)
+{
+    int count = __event_poller_count(event_pool);
+    int poller = 0;
+    int i = 0;
+
+    for (i = 1; i < count; i++) {
+        if (event_pool->pollerfd[i] == -1)
+            continue;
+        if (event_pool->pollerload[i] < event_pool->pollerload[poller])
+            poller = i;
+    }
+
+    return poller;
+}
+
+static int
+__event_poller_new(struct event_pool *event_pool, int poller)
+{
+    int epfd = -1;
+
+    if (event_pool->pollerfd[poller] != -1)
+        return 0;
+
+    epfd = epoll_create(event_pool->count);
+    if (epfd == -1) {
+        gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_CREATE_FAILED,
+               "epoll fd creation failed for thread %d", poller);
+        return -1;
+    }
+
+    event_pool->pollerfd[poller] = epfd;
+    event_pool->pollerload[poller] = 0;
+
+    return 0;
+}
+
+/* epoll fd the slot's fd is added to */
+static int
+__slot_epfd(struct event_pool *event_pool, struct event_slot_epoll *slot)
+{
+    if (!event_pool->affinity)
+        return event_pool->fd;
+
+    return event_pool->pollerfd[slot->poller];
+}
+
 static int
 event_slot_ref(struct event_slot_epoll *slot)
 {
@@ -123,6 +194,10 @@ retry:
             INIT_LIST_HEAD(&table[j].poller_death);
 
             table[j].fd = fd;
+            if (event_pool->affinity) {
+                table[j].poller = __event_poller_pick(event_pool);
+                event_pool->pollerload[table[j].poller]++;
+            }
             if (notify_poller_death) {
                 table[j].idx = table_idx * EVENT_EPOLL_SLOTS + j;
                 list_add_tail(&table[j].poller_death,
@@ -185,8 +260,11 @@ __event_slot_dealloc(struct event_pool *event_pool, int idx)
     slot->handled_error = 0;
     slot->in_handler = 0;
     list_del_init(&slot->poller_death);
-    if (fd != -1)
+    if (fd != -1) {
         event_pool->slots_used[table_idx]--;
+        if (event_pool->affinity)
+            event_pool->pollerload[slot->poller]--;
+    }
 
     return;
 }
@@ -361,6 +439,7 @@ event_register_epoll(struct event_pool *event_pool, int fd,
 {
     int idx = -1;
     int ret = -1;
+    int epfd = -1;
     int destroy = 0;
     struct epoll_event epoll_event = {
         0,
@@ -406,9 +485,14 @@ event_register_epoll(struct event_pool *event_pool, int fd,
            thread has picked up and is processing an event,
            another poller will not try to pick this at the same
            time as well.
+
+           With affinity only the thread the fd is bound to
+           polls it, so the fd is left armed.
         */
 
-        slot->events = EPOLLPRI | EPOLLHUP | EPOLLERR | EPOLLONESHOT;
+        slot->events = EPOLLPRI | EPOLLHUP | EPOLLERR;
+        if (!event_pool->affinity)
+            slot->events |= EPOLLONESHOT;
         slot->handler = handler;
         slot->data = data;
 
@@ -418,7 +502,10 @@ event_register_epoll(struct event_pool *event_pool, int fd,
         ev_data->idx = idx;
         ev_data->gen = slot->gen;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_ADD, fd, &epoll_event);
+        epfd = __slot_epfd(event_pool, slot);
+        ret = epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &epoll_event);
+        if (ret == 0)
+            slot->armed = 1;
         /* check ret after UNLOCK() to avoid deadlock in
            event_slot_unref()
         */
@@ -429,7 +516,7 @@ event_register_epoll(struct event_pool *event_pool, int fd,
         gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
                "failed to add fd(=%d) to "
                "epoll fd(=%d)",
-               fd, event_pool->fd);
+               fd, epfd);
         event_slot_unref(event_pool, slot, idx);
         idx = -1;
     }
@@ -444,6 +531,7 @@ event_unregister_epoll_common(struct event_pool *event_pool, int fd, int idx,
                               int do_close)
 {
     int ret = -1;
+    int epfd = -1;
     struct event_slot_epoll *slot = NULL;
 
     GF_VALIDATE_OR_GOTO("event", event_pool, out);
@@ -467,16 +555,22 @@ event_unregister_epoll_common(struct event_pool *event_pool, int fd, int idx,
 
     LOCK(&slot->lock);
     {
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_DEL, fd, NULL);
+        epfd = __slot_epfd(event_pool, slot);
+        if (slot->armed && (epfd != -1))
+            ret = epoll_ctl(epfd, EPOLL_CTL_DEL, fd, NULL);
+        else
+            ret = 0;
 
         if (ret == -1) {
             gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
                    "fail to del "
                    "fd(=%d) from epoll fd(=%d)",
-                   fd, event_pool->fd);
+                   fd, epfd);
             goto unlock;
         }
 
+        slot->armed = 0;
+
         slot->do_close = do_close;
         slot->gen++; /* detect unregister in dispatch_handler() */
     }
@@ -540,7 +634,12 @@ event_select_on_epoll(struct event_pool *event_pool, int fd, int idx,
         ev_data->idx = idx;
         ev_data->gen = slot->gen;
 
-        if (slot->in_handler)
+        if (event_pool->affinity) {
+            /* a disarmed fd gets the new events when it is re-armed
+             * by event_handled_epoll() */
+            if (!slot->armed)
+                goto unlock;
+        } else if (slot->in_handler)
             /*
              * in_handler indicates at least one thread
              * executing event_dispatch_epoll_handler()
@@ -555,7 +654,8 @@ event_select_on_epoll(struct event_pool *event_pool, int fd, int idx,
              */
             goto unlock;
 
-        ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+        ret = epoll_ctl(__slot_epfd(event_pool, slot), EPOLL_CTL_MOD, fd,
+                        &epoll_event);
         if (ret == -1) {
             gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_MODIFY_FAILED,
                    "failed to "
@@ -572,6 +672,176 @@ out:
     return idx;
 }
 
+/* With affinity the fd is not disarmed after each event. It is removed from
+ * the epoll instance of its thread while it can't be handled (a handler is
+ * still in progress, or the error was already handled) so that the thread
+ * doesn't keep getting the same event, and is added back by
+ * event_handled_epoll(). */
+static void
+__slot_disarm(struct event_pool *event_pool, struct event_slot_epoll *slot)
+{
+    int epfd = -1;
+
+    if (!event_pool->affinity || !slot->armed)
+        return;
+
+    epfd = __slot_epfd(event_pool, slot);
+    if (epoll_ctl(epfd, EPOLL_CTL_DEL, slot->fd, NULL) == -1) {
+        gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
+               "fail to del fd(=%d) from epoll fd(=%d)", slot->fd, epfd);
+        return;
+    }
+
+    slot->armed = 0;
+}
+
+/* Binds the fd of a slot to another thread. Called with event_pool->mutex
+ * and slot->lock held. */
+static void
+__slot_move(struct event_pool *event_pool, struct event_slot_epoll *slot,
+            int idx, int poller)
+{
+    struct epoll_event epoll_event = {
+        0,
+    };
+    struct event_data *ev_data = (void *)&epoll_event.data;
+    int from = event_pool->pollerfd[slot->poller];
+    int to = event_pool->pollerfd[poller];
+
+    if (slot->armed) {
+        if ((from != -1) &&
+            (epoll_ctl(from, EPOLL_CTL_DEL, slot->fd, NULL) == -1)) {
+            gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_DEL_FAILED,
+                   "fail to del fd(=%d) from epoll fd(=%d)", slot->fd, from);
+            return;
+        }
+
+        epoll_event.events = slot->events;
+        ev_data->idx = idx;
+        ev_data->gen = slot->gen;
+
+        if (epoll_ctl(to, EPOLL_CTL_ADD, slot->fd, &epoll_event) == -1) {
+            gf_msg("epoll", GF_LOG_ERROR, errno, LG_MSG_EPOLL_FD_ADD_FAILED,
+                   "failed to add fd(=%d) to epoll fd(=%d)", slot->fd, to);
+            slot->armed = 0;
+        }
+    }
+
+    event_pool->pollerload[slot->poller]--;
+    event_pool->pollerload[poller]++;
+    slot->poller = poller;
+}
+
+/* Moves fds away from threads that are exiting or that have more than their
+ * share of fds. Called with event_pool->mutex held whenever the number of
+ * threads changes. */
+static void
+__event_rebalance_epoll(struct event_pool *event_pool)
+{
+    struct event_slot_epoll *table = NULL;
+    struct event_slot_epoll *slot = NULL;
+    int count = __event_poller_count(event_pool);
+    int total = 0;
+    int share = 0;
+    int poller = 0;
+    int moved = 0;
+    int i = 0;
+    int j = 0;
+
+    if (count <= 0)
+        return;
+
+    for (i = 0; i < EVENT_MAX_THREADS; i++)
+        total += event_pool->pollerload[i];
+    share = (total + count - 1) / count;
+
+    for (i = 0; i < EVENT_EPOLL_TABLES; i++) {
+        table = event_pool->ereg[i];
+        if (!table)
+            continue;
+
+        for (j = 0; j < EVENT_EPOLL_SLOTS; j++) {
+            slot = &table[j];
+
+            LOCK(&slot->lock);
+            {
+                if ((slot->fd != -1) &&
+                    ((slot->poller >= count) ||
+                     (event_pool->pollerload[slot->poller] > share))) {
+                    poller = __event_poller_pick(event_pool);
+                    if (poller != slot->poller) {
+                        __slot_move(event_pool, slot, i * EVENT_EPOLL_SLOTS + j,
+                                    poller);
+                        moved++;
+                    }
+                }
+            }
+            UNLOCK(&slot->lock);
+        }
+    }
+
+    gf_msg_debug("epoll", 0, "moved %d fds across %d threads", moved, count);
+}
+
+static int
+event_set_affinity_epoll(struct event_pool *event_pool)
+{
+    int count = 0;
+    int ret = -1;
+    int i = 0;
+
+    pthread_mutex_lock(&event_pool->mutex);
+    {
+        if (event_pool->affinity) {
+            ret = 0;
+            goto unlock;
+        }
+
+        for (i = 0; i < EVENT_EPOLL_TABLES; i++) {
+            if (event_pool->slots_used[i]) {
+                gf_msg("epoll", GF_LOG_ERROR, EBUSY,
+                       LG_MSG_EPOLL_AFFINITY_FAILED,
+                       "event thread affinity must be set before "
+                       "registering fds");
+                goto unlock;
+            }
+        }
+
+        for (i = 0; i < EVENT_MAX_THREADS; i++) {
+            event_pool->pollerfd[i] = -1;
+            event_pool->pollerload[i] = 0;
+        }
+
+        count = __event_poller_count(event_pool);
+        if (count <= 0)
+            count = 1;
+
+        for (i = 0; i < count; i++) {
+            if (__event_poller_new(event_pool, i) != 0)
+                break;
+        }
+
+        if (i < count) {
+            while (i-- > 0) {
+                sys_close(event_pool->pollerfd[i]);
+                event_pool->pollerfd[i] = -1;
+            }
+            goto unlock;
+        }
+
+        event_pool->affinity = 1;
+        ret = 0;
+    }
+unlock:
+    pthread_mutex_unlock(&event_pool->mutex);
+
+    if (ret == 0)
+        gf_msg("epoll", GF_LOG_INFO, 0, LG_MSG_STARTED_EPOLL_THREAD,
+               "event threads use one epoll instance each");
+
+    return ret;
+}
+
 static int
 event_dispatch_epoll_handler(struct event_pool *event_pool,
                              struct epoll_event *event)
@@ -628,11 +898,13 @@ event_dispatch_epoll_handler(struct event_pool *event_pool,
         if (slot->in_handler > 0) {
             /* Another handler is inprogress, skip this one. */
             handler = NULL;
+            __slot_disarm(event_pool, slot);
             goto pre_unlock;
         }
 
         if (slot->handled_error) {
             handled_error_previously = _gf_true;
+            __slot_disarm(event_pool, slot);
         } else {
             slot->handled_error = (event->events & (EPOLLERR | EPOLLHUP));
             slot->in_handler++;
@@ -660,8 +932,9 @@ out:
 static void *
 event_dispatch_epoll_worker(void *data)
 {
-    struct epoll_event event;
+    struct epoll_event events[EVENT_AFFINITY_BATCH];
     int ret = -1;
+    int i = 0;
     struct event_thread_data *ev_data = data;
     struct event_pool *event_pool;
     int myindex = -1;
@@ -707,6 +980,12 @@ event_dispatch_epoll_worker(void *data)
                      * die */
                     event_pool->pollers[myindex - 1] = 0;
                     event_pool->activethreadcount--;
+                    if (event_pool->affinity) {
+                        /* its fds were moved when the thread count was
+                         * reduced */
+                        sys_close(event_pool->pollerfd[myindex - 1]);
+                        event_pool->pollerfd[myindex - 1] = -1;
+                    }
                     timetodie = 1;
                     gen = ++event_pool->poller_gen;
                     list_for_each_entry(slot, &event_pool->poller_death,
@@ -750,7 +1029,11 @@ event_dispatch_epoll_worker(void *data)
             }
         }
 
-        ret = epoll_wait(event_pool->fd, &event, 1, -1);
+        if (event_pool->affinity)
+            ret = epoll_wait(event_pool->pollerfd[myindex - 1], events,
+                             EVENT_AFFINITY_BATCH, EVENT_AFFINITY_TIMEOUT);
+        else
+            ret = epoll_wait(event_pool->fd, events, 1, -1);
 
         if (ret == 0)
             /* timeout */
@@ -760,10 +1043,11 @@ event_dispatch_epoll_worker(void *data)
             /* sys call */
             continue;
 
-        ret = event_dispatch_epoll_handler(event_pool, &event);
-        if (ret) {
-            gf_msg("epoll", GF_LOG_ERROR, 0, LG_MSG_EXITED_EPOLL_THREAD,
-                   "Failed to dispatch handler");
+        for (i = 0; i < ret; i++) {
+            if (event_dispatch_epoll_handler(event_pool, &events[i])) {
+                gf_msg("epoll", GF_LOG_ERROR, 0, LG_MSG_EXITED_EPOLL_THREAD,
+                       "Failed to dispatch handler");
+            }
         }
     }
 out:
@@ -897,6 +1181,17 @@ event_reconfigure_threads_epoll(struct event_pool *event_pool, int value)
 
         oldthreadcount = event_pool->eventthreadcount;
 
+        if (event_pool->affinity) {
+            /* every thread needs its epoll instance before fds can be
+             * bound to it */
+            for (i = 0; i < value; i++) {
+                if (__event_poller_new(event_pool, i) != 0) {
+                    value = (i > 0) ? i : 1;
+                    break;
+                }
+            }
+        }
+
         /* Start 'worker' threads as necessary only if event_dispatch()
          * was called before. If event_dispatch() was not called, there
          * will be no epoll 'worker' threads running yet. */
@@ -938,6 +1233,9 @@ event_reconfigure_threads_epoll(struct event_pool *event_pool, int value)
 
         /* if value decreases, threads will terminate, themselves */
         event_pool->eventthreadcount = value;
+
+        if (event_pool->affinity && (oldthreadcount != value))
+            __event_rebalance_epoll(event_pool);
     }
     pthread_mutex_unlock(&event_pool->mutex);
 
@@ -956,6 +1254,13 @@ event_pool_destroy_epoll(struct event_pool *event_pool)
 
     ret = sys_close(event_pool->fd);
 
+    if (event_pool->affinity) {
+        for (i = 0; i < EVENT_MAX_THREADS; i++) {
+            if (event_pool->pollerfd[i] != -1)
+                sys_close(event_pool->pollerfd[i]);
+        }
+    }
+
     for (i = 0; i < EVENT_EPOLL_TABLES; i++) {
         if (event_pool->ereg[i]) {
             table = event_pool->ereg[i];
@@ -1012,16 +1317,35 @@ event_handled_epoll(struct event_pool *event_pool, int fd, int idx, int gen)
             goto unlock;
         }
 
+        /* A handler can consume an EPOLLERR which isn't fatal, like the
+           MSG_ZEROCOPY completions queued on the error queue of a socket,
+           and keep using the fd. EPOLLHUP is final: the events following
+           it are still ignored until the fd is unregistered.
+        */
+        if (!(slot->handled_error & EPOLLHUP))
+            slot->handled_error = 0;
+
         /* This call also picks up the changes made by another
            thread calling event_select_on_epoll() while this
            thread was busy in handler()
+
+           With affinity the fd is still armed, unless it had to be
+           disarmed while handler() was running.
         */
         if (slot->in_handler == 0) {
             epoll_event.events = slot->events;
             ev_data->idx = idx;
             ev_data->gen = gen;
 
-            ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd, &epoll_event);
+            if (!event_pool->affinity) {
+                ret = epoll_ctl(event_pool->fd, EPOLL_CTL_MOD, fd,
+                                &epoll_event);
+            } else if (!slot->armed) {
+                ret = epoll_ctl(__slot_epfd(event_pool, slot), EPOLL_CTL_ADD,
+                                fd, &epoll_event);
+                if (ret == 0)
+                    slot->armed = 1;
+            }
         }
     }
 unlock:
@@ -1042,6 +1366,7 @@ struct event_ops event_ops_epoll = {
     .event_reconfigure_threads = event_reconfigure_threads_epoll,
     .event_pool_destroy = event_pool_destroy_epoll,
     .event_handled = event_handled_epoll,
+    .event_set_affinity = event_set_affinity_epoll,
 };
 
 #endif
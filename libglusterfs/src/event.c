@@ -302,3 +302,24 @@ gf_event_handled(struct event_pool *event_pool, int fd, int idx, int gen)
 
     return ret;
 }
+
+/* Gives every event thread its own epoll instance and binds each fd to one
+ * of them. Must be called before any fd is registered. */
+int
+gf_event_pool_set_affinity(struct event_pool *event_pool)
+{
+    int ret = -1;
+
+    GF_VALIDATE_OR_GOTO("event", event_pool, out);
+
+    if (!event_pool->ops->event_set_affinity) {
+        gf_msg("event", GF_LOG_WARNING, ENOTSUP, LG_MSG_EPOLL_AFFINITY_FAILED,
+               "event thread affinity is not supported by this event "
+               "mechanism");
+        goto out;
+    }
+
+    ret = event_pool->ops->event_set_affinity(event_pool);
+out:
+    return ret;
+}
@@ -94,36 +94,44 @@ typedef struct _data_pair data_pair_t;
 #define DICT_DATA_HDR_KEY_LEN 4
 #define DICT_DATA_HDR_VAL_LEN 4
 
+/* Number of pairs stored in the dict itself. Most of the dicts carried by
+ * the fops have less keys than this and never allocate a pair. */
+#define DICT_INLINE_PAIRS 5
+/* Dicts with more keys than this get an open-addressed index of their
+ * pairs. Smaller ones are looked up by walking members_list. */
+#define DICT_INDEX_THRESHOLD 8
+
 struct _data {
     char *data;
     gf_atomic_t refcount;
     gf_dict_data_type_t data_type;
     int32_t len;
     gf_boolean_t is_static;
+    gf_boolean_t is_stdalloc; /* data is released with free() */
 };
 
 struct _data_pair {
-    struct _data_pair *hash_next;
     struct _data_pair *prev;
     struct _data_pair *next;
     data_t *value;
     char *key;
     uint32_t key_hash;
+    uint32_t key_len : 31;
+    uint32_t key_interned : 1; /* key points to a static string */
 };
 
 struct _dict {
     uint64_t max_count;
-    int32_t hash_size;
+    int32_t hash_size; /* slots in members, 0 if there is no index */
     int32_t count;
     gf_atomic_t refcount;
-    data_pair_t **members;
+    data_pair_t **members; /* open-addressed index, linear probing */
     data_pair_t *members_list;
     char *extra_free;
     char *extra_stdfree;
     gf_lock_t lock;
-    data_pair_t *members_internal;
-    data_pair_t free_pair;
-    gf_boolean_t free_pair_in_use;
+    uint32_t inline_used; /* bitmap of the inline_pairs in use */
+    data_pair_t inline_pairs[DICT_INLINE_PAIRS];
 };
 
 typedef gf_boolean_t (*dict_match_t)(dict_t *d, char *k, data_t *v, void *data);
@@ -194,6 +202,8 @@ strn_to_data(char *value, const int vallen);
 data_t *
 data_from_dynptr(void *value, int32_t len);
 data_t *
+data_from_stdalloc(void *value, int32_t len, gf_dict_data_type_t type);
+data_t *
 bin_to_data(void *value, int32_t len);
 data_t *
 static_str_to_data(char *value);
@@ -78,6 +78,12 @@ struct event_pool {
      * TBD: consider auto-scaling for clients as well
      */
     int auto_thread_count;
+
+    /* When set, every epoll thread has its own epoll instance and each fd
+     * is bound to one of the threads (see gf_event_pool_set_affinity()). */
+    int affinity;
+    int pollerfd[EVENT_MAX_THREADS];   /* epoll fd of each thread */
+    int pollerload[EVENT_MAX_THREADS]; /* number of fds bound to a thread */
 };
 
 struct event_destroy_data {
@@ -107,6 +113,7 @@ struct event_ops {
     int (*event_pool_destroy)(struct event_pool *event_pool);
     int (*event_handled)(struct event_pool *event_pool, int fd, int idx,
                          int gen);
+    int (*event_set_affinity)(struct event_pool *event_pool);
 };
 
 struct event_pool *
@@ -132,5 +139,7 @@ int
 gf_event_dispatch_destroy(struct event_pool *event_pool);
 int
 gf_event_handled(struct event_pool *event_pool, int fd, int idx, int gen);
+int
+gf_event_pool_set_affinity(struct event_pool *event_pool);
 
 #endif /* _GF_EVENT_H_ */
@@ -442,6 +442,14 @@ fop_enum_to_pri_string(glusterfs_fop_t fop);
 /* key value which quick read uses to get small files in lookup cbk */
 #define GF_CONTENT_KEY "glusterfs.content"
 
+/* data which protocol/client writes at offset 0 of the file it creates, in
+ * the same request as the create and a flush of the new fd, if its option
+ * create-write-compound is set. The reply has the number of bytes written,
+ * or -errno, under the same key. Translators which can't send the data down
+ * as it is must remove the key. */
+#define GF_CREATE_WRITE_KEY "glusterfs.create-write"
+#define GF_CREATE_WRITE_MAX (128 * 1024)
+
 struct _xlator_cmdline_option {
     struct list_head cmd_args;
     char *volume;
@@ -528,6 +536,7 @@ struct _cmd_args {
     unsigned uid_map_root;
     int32_t lru_limit;
     int32_t invalidate_limit;
+    uint32_t inode_table_stripes;
     int background_qlen;
     int congestion_threshold;
     char *fuse_mountopts;
@@ -574,6 +583,9 @@ struct _cmd_args {
 
     bool global_threading;
     bool brick_mux;
+    bool event_thread_affinity;
+    /* number of timer wheels, each with its own thread */
+    uint32_t timer_wheels;
 
     uint32_t fuse_dev_eperm_ratelimit_ns;
 };
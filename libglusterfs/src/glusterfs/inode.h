@@ -33,6 +33,10 @@ typedef struct _dentry dentry_t;
 #include "glusterfs/compat-uuid.h"
 #include "glusterfs/fd.h"
 
+/* Upper bound for the number of stripe locks protecting the inode and
+   dentry hash tables. */
+#define GF_INODE_TABLE_MAX_STRIPES 4096
+
 struct _inode_table {
     pthread_mutex_t lock;
     size_t hashsize;    /* bucket size of inode hash and dentry hash */
@@ -65,6 +69,17 @@ struct _inode_table {
     /* flag to indicate whether the cleanup of the inode
        table started or not */
     gf_boolean_t cleanup_started;
+
+    /* Lock striping. When hash_lock_count is not 0, every change to the
+       inode_hash and name_hash chains is done holding both table->lock and
+       the stripe lock of the bucket, so lookups only need the stripe lock.
+       Refcount changes that do not move an inode between the active and
+       lru lists are then done atomically without table->lock, and pruning
+       is handed over to a background worker. */
+    pthread_mutex_t *hash_locks;
+    uint32_t hash_lock_count; /* power of 2, 0 when striping is disabled */
+    gf_atomic_int32_t prune_state;  /* state of the background pruner */
+    struct _gf_async *prune_async; /* job used to run the pruner */
 };
 
 struct _dentry {
@@ -127,6 +142,9 @@ inode_table_with_invalidator(uint32_t lru_limit, xlator_t *xl,
                              int32_t (*invalidator_fn)(xlator_t *, inode_t *),
                              xlator_t *invalidator_xl);
 
+int
+inode_table_set_lock_stripes(inode_table_t *table, uint32_t stripes);
+
 void
 inode_table_destroy_all(glusterfs_ctx_t *ctx);
 
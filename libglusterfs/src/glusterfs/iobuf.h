@@ -22,6 +22,11 @@
 
 #define GF_RDMA_DEVICE_COUNT 8
 
+/* Maximum number of iobufs of each page size kept in the cache of a thread.
+ * Bigger page sizes are limited further so that the memory held by an idle
+ * thread stays bounded (see iobuf.c). */
+#define GF_IOBUF_THREAD_CACHE_DEPTH 16
+
 /* Lets try to define the new anonymous mapping
  * flag, in case the system is still using the
  * now deprecated MAP_ANON flag.
@@ -103,6 +108,7 @@ struct iobuf_arena {
     int active_cnt;
     int passive_cnt;
     int max_active; /* max active buffers at a given time */
+    int pin_count;  /* the arena is not pruned while pinned */
 };
 
 struct iobuf_pool {
@@ -125,6 +131,12 @@ struct iobuf_pool {
     uint64_t request_misses; /* mostly the requests for higher
                                value of iobufs */
     int arena_cnt;
+
+    struct list_head thread_caches; /* per-thread caches using this pool */
+    /* counters of the thread caches already released */
+    uint64_t cache_hits;
+    uint64_t cache_misses;
+    uint64_t cache_flushes;
     int rdma_device_count;
     struct list_head *mr_list[GF_RDMA_DEVICE_COUNT];
     void *device[GF_RDMA_DEVICE_COUNT];
@@ -191,4 +203,12 @@ iobuf_copy(struct iobuf_pool *iobuf_pool, const struct iovec *iovec_src,
            int iovcnt, struct iobref **iobref, struct iobuf **iobuf,
            struct iovec *iov_dst);
 
+int
+iobuf_pool_pin_arenas(struct iobuf_pool *iobuf_pool,
+                      struct iobuf_arena **arenas, int max);
+
+void
+iobuf_pool_unpin_arenas(struct iobuf_pool *iobuf_pool,
+                        struct iobuf_arena **arenas, int count);
+
 #endif /* !_IOBUF_H_ */
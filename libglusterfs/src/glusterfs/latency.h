@@ -12,6 +12,7 @@
 #define __LATENCY_H__
 
 #include "glusterfs/glusterfs.h"
+#include "glusterfs/atomic.h"
 
 typedef struct fop_latency {
     double min;   /* min time for the call (microseconds) */
@@ -20,4 +21,38 @@ typedef struct fop_latency {
     uint64_t count;
 } fop_latency_t;
 
+/* Log-linear histogram of latencies in nanoseconds, in the style of
+ * HdrHistogram. Values below 2^GF_LATENCY_HIST_SUB_BITS have a bucket
+ * each; above that, every power of two is split in as many buckets, so
+ * that the values reported are within 1/2^(GF_LATENCY_HIST_SUB_BITS + 1)
+ * of the real ones. Values above 2^GF_LATENCY_HIST_MAX_BITS ns (~18
+ * minutes) are counted in the last bucket. Buckets are updated with atomic
+ * operations, without any lock. */
+#define GF_LATENCY_HIST_SUB_BITS 4
+#define GF_LATENCY_HIST_MAX_BITS 40
+#define GF_LATENCY_HIST_SUB_COUNT (1 << GF_LATENCY_HIST_SUB_BITS)
+#define GF_LATENCY_HIST_BUCKETS                                                \
+    ((GF_LATENCY_HIST_MAX_BITS - GF_LATENCY_HIST_SUB_BITS + 1) *               \
+     GF_LATENCY_HIST_SUB_COUNT)
+
+typedef struct gf_latency_hist {
+    gf_atomic_t count;
+    gf_atomic_t buckets[GF_LATENCY_HIST_BUCKETS];
+} gf_latency_hist_t;
+
+gf_latency_hist_t *
+gf_latency_hist_new(void);
+
+gf_latency_hist_t *
+gf_latency_hist_get(gf_latency_hist_t **slot);
+
+void
+gf_latency_hist_record(gf_latency_hist_t *hist, uint64_t value);
+
+uint64_t
+gf_latency_hist_percentile(gf_latency_hist_t *hist, double percentile);
+
+void
+gf_latency_hist_reset(gf_latency_hist_t *hist);
+
 #endif /* __LATENCY_H__ */
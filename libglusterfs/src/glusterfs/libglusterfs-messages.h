@@ -112,6 +112,6 @@ GLFS_MSGID(
     LG_MSG_XXH64_TO_GFID_FAILED, LG_MSG_ASYNC_WARNING, LG_MSG_ASYNC_FAILURE,
     LG_MSG_GRAPH_CLEANUP_FAILED, LG_MSG_GRAPH_SETUP_FAILED,
     LG_MSG_GRAPH_DETACH_STARTED, LG_MSG_GRAPH_ATTACH_FAILED,
-    LG_MSG_GRAPH_ATTACH_PID_FILE_UPDATED);
+    LG_MSG_GRAPH_ATTACH_PID_FILE_UPDATED, LG_MSG_EPOLL_AFFINITY_FAILED);
 
 #endif /* !_LG_MESSAGES_H_ */
@@ -18,6 +18,24 @@
 
 typedef void (*gf_timer_cbk_t)(void *);
 
+/* Timers are kept in a hierarchical timer wheel with a resolution of
+ * GF_TIMER_TICK nanoseconds. The root level has one slot per tick and each
+ * of the upper levels covers GF_TIMER_LEVEL_SIZE slots of the one below, so
+ * that adding and cancelling a timer is O(1) whatever the number of them.
+ * Timers further than the whole wheel (~49 days) are kept in its last slot
+ * until they come into range. */
+#define GF_TIMER_TICK 1000000 /* 1 ms */
+#define GF_TIMER_ROOT_BITS 8
+#define GF_TIMER_LEVEL_BITS 6
+#define GF_TIMER_ROOT_SIZE (1 << GF_TIMER_ROOT_BITS)
+#define GF_TIMER_LEVEL_SIZE (1 << GF_TIMER_LEVEL_BITS)
+#define GF_TIMER_LEVELS 4
+
+/* Maximum number of wheels, each one with its own lock and thread */
+#define GF_TIMER_MAX_WHEELS 64
+
+struct _gf_timer_wheel;
+
 struct _gf_timer {
     union {
         struct list_head list;
@@ -30,18 +48,34 @@ struct _gf_timer {
     gf_timer_cbk_t callbk;
     void *data;
     xlator_t *xl;
+    struct _gf_timer_wheel *wheel;
+    uint64_t expires; /* in ticks */
     gf_boolean_t fired;
 };
 
-struct _gf_timer_registry {
-    struct list_head active;
+struct _gf_timer_wheel {
+    struct list_head root[GF_TIMER_ROOT_SIZE];
+    struct list_head level[GF_TIMER_LEVELS][GF_TIMER_LEVEL_SIZE];
+    /* non empty slots of each level */
+    uint64_t root_map[GF_TIMER_ROOT_SIZE / 64];
+    uint64_t level_map[GF_TIMER_LEVELS];
+    uint64_t base;   /* next tick to process */
+    uint64_t wakeup; /* tick the thread sleeps until */
+    uint64_t count;
     pthread_mutex_t lock;
     pthread_cond_t cond;
     pthread_t th;
     char fin;
 };
 
+struct _gf_timer_registry {
+    struct _gf_timer_wheel *wheels;
+    uint32_t count;
+    gf_atomic_t next;
+};
+
 typedef struct _gf_timer gf_timer_t;
+typedef struct _gf_timer_wheel gf_timer_wheel_t;
 typedef struct _gf_timer_registry gf_timer_registry_t;
 
 gf_timer_t *
@@ -793,6 +793,8 @@ struct _xlator {
         struct {
             /* for latency measurement */
             fop_metrics_t metrics[GF_FOP_MAXVALUE];
+            /* allocated the first time a latency is recorded */
+            gf_latency_hist_t *hist[GF_FOP_MAXVALUE];
 
             gf_atomic_t count;
         } total;
@@ -1097,4 +1099,7 @@ gf_boolean_t
 xlator_is_cleanup_starting(xlator_t *this);
 int
 graph_total_client_xlator(glusterfs_graph_t *graph);
+
+void
+gf_latency_hist_free_all(xlator_t *xl);
 #endif /* _XLATOR_H */
@@ -14,9 +14,11 @@
 #include <pthread.h>
 #include <sys/types.h>
 #include <stdint.h>
+#include <sched.h>
 #include "glusterfs/list.h"
 #include <assert.h>
 #include "glusterfs/libglusterfs-messages.h"
+#include "glusterfs/async.h"
 
 /* TODO:
    move latest accessed dentry to list_head of inode
@@ -129,12 +131,63 @@ Based on this, the code could be similar to this:
         }                                                                      \
     }
 
+/* inode->ref and the per xlator ref counters are always updated atomically,
+ * even with table->lock held, because when lock striping is enabled they can
+ * also be changed without the table lock by inode_ref_fast() and
+ * inode_unref_fast(). Transitions from and to 0 always need table->lock since
+ * they move the inode between lists. */
+#if defined(HAVE_ATOMIC_BUILTINS)
+#define INODE_LOCKLESS_REF 1
+#define INODE_REF_GET(_ptr) __atomic_load_n(_ptr, __ATOMIC_ACQUIRE)
+#define INODE_REF_SET(_ptr, _val) __atomic_store_n(_ptr, _val, __ATOMIC_RELEASE)
+#define INODE_REF_ADD(_ptr, _val)                                              \
+    __atomic_add_fetch(_ptr, _val, __ATOMIC_ACQ_REL)
+#define INODE_REF_SUB(_ptr, _val)                                              \
+    __atomic_sub_fetch(_ptr, _val, __ATOMIC_ACQ_REL)
+#define INODE_REF_CMP_SWAP(_ptr, _old, _new)                                   \
+    __atomic_compare_exchange_n(_ptr, _old, _new, false, __ATOMIC_ACQ_REL,     \
+                                __ATOMIC_ACQUIRE)
+#else
+#define INODE_REF_GET(_ptr) (*(_ptr))
+#define INODE_REF_SET(_ptr, _val) (*(_ptr) = (_val))
+#define INODE_REF_ADD(_ptr, _val) (*(_ptr) += (_val))
+#define INODE_REF_SUB(_ptr, _val) (*(_ptr) -= (_val))
+#endif
+
+/* States of the background pruner of a striped inode table. */
+#define INODE_PRUNE_IDLE 0
+#define INODE_PRUNE_RUNNING 1
+#define INODE_PRUNE_REQUESTED 2
+
+static inline pthread_mutex_t *
+inode_hash_lock(inode_table_t *table, uint32_t bucket)
+{
+    return &table->hash_locks[bucket & (table->hash_lock_count - 1)];
+}
+
+static inline void
+inode_hash_lock_acquire(inode_table_t *table, uint32_t bucket)
+{
+    if (table->hash_lock_count)
+        pthread_mutex_lock(inode_hash_lock(table, bucket));
+}
+
+static inline void
+inode_hash_lock_release(inode_table_t *table, uint32_t bucket)
+{
+    if (table->hash_lock_count)
+        pthread_mutex_unlock(inode_hash_lock(table, bucket));
+}
+
 static inode_t *
 __inode_unref(inode_t *inode, bool clear);
 
 static int
 inode_table_prune(inode_table_t *table);
 
+static void
+inode_table_prune_maybe(inode_table_t *table);
+
 void
 fd_dump(struct list_head *head, char *prefix);
 
@@ -168,8 +221,12 @@ __dentry_hash(dentry_t *dentry, const int hash)
 
     table = dentry->inode->table;
 
-    list_del_init(&dentry->hash);
-    list_add(&dentry->hash, &table->name_hash[hash]);
+    inode_hash_lock_acquire(table, hash);
+    {
+        list_del_init(&dentry->hash);
+        list_add(&dentry->hash, &table->name_hash[hash]);
+    }
+    inode_hash_lock_release(table, hash);
 }
 
 static int
@@ -181,7 +238,24 @@ __is_dentry_hashed(dentry_t *dentry)
 static void
 __dentry_unhash(dentry_t *dentry)
 {
-    list_del_init(&dentry->hash);
+    inode_table_t *table = NULL;
+    int hash = 0;
+
+    table = dentry->inode->table;
+    if (!table->hash_lock_count || !dentry->parent) {
+        list_del_init(&dentry->hash);
+        return;
+    }
+
+    /* Hashed dentries always have a parent, and the bucket they live in
+       is derived from it. */
+    hash = hash_dentry(dentry->parent, dentry->name, table->hashsize);
+
+    inode_hash_lock_acquire(table, hash);
+    {
+        list_del_init(&dentry->hash);
+    }
+    inode_hash_lock_release(table, hash);
 }
 
 static void
@@ -287,7 +361,21 @@ __is_dentry_cyclic(dentry_t *dentry)
 static void
 __inode_unhash(inode_t *inode)
 {
-    list_del_init(&inode->hash);
+    inode_table_t *table = inode->table;
+    int hash = 0;
+
+    if (!table->hash_lock_count) {
+        list_del_init(&inode->hash);
+        return;
+    }
+
+    hash = hash_gfid(inode->gfid, 65536);
+
+    inode_hash_lock_acquire(table, hash);
+    {
+        list_del_init(&inode->hash);
+    }
+    inode_hash_lock_release(table, hash);
 }
 
 static int
@@ -301,8 +389,12 @@ __inode_hash(inode_t *inode, const int hash)
 {
     inode_table_t *table = inode->table;
 
-    list_del_init(&inode->hash);
-    list_add(&inode->hash, &table->inode_hash[hash]);
+    inode_hash_lock_acquire(table, hash);
+    {
+        list_del_init(&inode->hash);
+        list_add(&inode->hash, &table->inode_hash[hash]);
+    }
+    inode_hash_lock_release(table, hash);
 }
 
 static dentry_t *
@@ -465,6 +557,7 @@ __inode_unref(inode_t *inode, bool clear)
     int index = 0;
     xlator_t *this = NULL;
     uint64_t nlookup = 0;
+    uint32_t ref = 0;
 
     /*
      * Root inode should always be in active list of inode table. So unrefs
@@ -517,15 +610,15 @@ __inode_unref(inode_t *inode, bool clear)
     }
     GF_ASSERT(inode->ref);
 
-    --inode->ref;
+    ref = INODE_REF_SUB(&inode->ref, 1);
 
     index = __inode_get_xl_index(inode, this);
     if (index >= 0) {
         inode->_ctx[index].xl_key = this;
-        inode->_ctx[index].ref--;
+        INODE_REF_SUB(&inode->_ctx[index].ref, 1);
     }
 
-    if (!inode->ref && !inode->in_invalidate_list) {
+    if (!ref && !inode->in_invalidate_list) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -576,17 +669,78 @@ __inode_ref(inode_t *inode, bool is_invalidate)
         }
     }
 
-    inode->ref++;
+    INODE_REF_ADD(&inode->ref, 1);
 
     index = __inode_get_xl_index(inode, this);
     if (index >= 0) {
         inode->_ctx[index].xl_key = this;
-        inode->_ctx[index].ref++;
+        INODE_REF_ADD(&inode->_ctx[index].ref, 1);
     }
 
     return inode;
 }
 
+/* Lock-free variants of __inode_ref()/__inode_unref() for striped tables.
+ * They only succeed when the inode stays active (ref > 0 before and after
+ * the change) and the calling xlator already owns its ctx slot, so no list
+ * or ctx ownership change is required. Otherwise the caller must fall back
+ * to the locked path. */
+static gf_boolean_t
+inode_ref_fast(inode_t *inode)
+{
+#ifdef INODE_LOCKLESS_REF
+    xlator_t *this = NULL;
+    uint32_t ref = 0;
+
+    if (!inode->table->hash_lock_count)
+        return _gf_false;
+
+    ref = INODE_REF_GET(&inode->ref);
+    if (__is_root_gfid(inode->gfid) && ref)
+        return _gf_true;
+
+    this = THIS;
+    if (inode->_ctx[this->xl_id].xl_key != this)
+        return _gf_false;
+
+    while (ref) {
+        if (INODE_REF_CMP_SWAP(&inode->ref, &ref, ref + 1)) {
+            INODE_REF_ADD(&inode->_ctx[this->xl_id].ref, 1);
+            return _gf_true;
+        }
+    }
+#endif
+    return _gf_false;
+}
+
+static gf_boolean_t
+inode_unref_fast(inode_t *inode)
+{
+#ifdef INODE_LOCKLESS_REF
+    xlator_t *this = NULL;
+    uint32_t ref = 0;
+
+    if (!inode->table->hash_lock_count)
+        return _gf_false;
+
+    if (__is_root_gfid(inode->gfid))
+        return _gf_true;
+
+    this = THIS;
+    if (inode->_ctx[this->xl_id].xl_key != this)
+        return _gf_false;
+
+    ref = INODE_REF_GET(&inode->ref);
+    while (ref > 1) {
+        if (INODE_REF_CMP_SWAP(&inode->ref, &ref, ref - 1)) {
+            INODE_REF_SUB(&inode->_ctx[this->xl_id].ref, 1);
+            return _gf_true;
+        }
+    }
+#endif
+    return _gf_false;
+}
+
 inode_t *
 inode_unref(inode_t *inode)
 {
@@ -595,6 +749,9 @@ inode_unref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    if (inode_unref_fast(inode))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -603,7 +760,7 @@ inode_unref(inode_t *inode)
     }
     pthread_mutex_unlock(&table->lock);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return inode;
 }
@@ -616,6 +773,9 @@ inode_ref(inode_t *inode)
     if (!inode)
         return NULL;
 
+    if (inode_ref_fast(inode))
+        return inode;
+
     table = inode->table;
 
     pthread_mutex_lock(&table->lock);
@@ -726,14 +886,18 @@ __inode_ref_reduce_by_n(inode_t *inode, uint64_t nref)
 {
     uint64_t nlookup = 0;
 
+    uint32_t ref = 0;
+
     GF_ASSERT(inode->ref >= nref);
 
-    inode->ref -= nref;
+    ref = INODE_REF_SUB(&inode->ref, nref);
 
-    if (!nref)
-        inode->ref = 0;
+    if (!nref) {
+        INODE_REF_SET(&inode->ref, 0);
+        ref = 0;
+    }
 
-    if (!inode->ref) {
+    if (!ref) {
         inode->table->active_size--;
 
         nlookup = GF_ATOMIC_GET(inode->nlookup);
@@ -797,6 +961,21 @@ inode_grep(inode_table_t *table, inode_t *parent, const char *name)
 
     int hash = hash_dentry(parent, name, table->hashsize);
 
+    if (table->hash_lock_count) {
+        inode_hash_lock_acquire(table, hash);
+        {
+            dentry = __dentry_grep(table, parent, name, hash);
+            if (dentry)
+                inode = dentry->inode;
+            if (inode && !inode_ref_fast(inode))
+                inode = NULL;
+        }
+        inode_hash_lock_release(table, hash);
+
+        if (inode || !dentry)
+            return inode;
+    }
+
     pthread_mutex_lock(&table->lock);
     {
         dentry = __dentry_grep(table, parent, name, hash);
@@ -873,7 +1052,12 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
 
     int hash = hash_dentry(parent, name, table->hashsize);
 
-    pthread_mutex_lock(&table->lock);
+    /* Nothing is referenced here, so the stripe lock is enough when the
+       table is striped. */
+    if (table->hash_lock_count)
+        inode_hash_lock_acquire(table, hash);
+    else
+        pthread_mutex_lock(&table->lock);
     {
         dentry = __dentry_grep(table, parent, name, hash);
         if (dentry) {
@@ -885,7 +1069,10 @@ inode_grep_for_gfid(inode_table_t *table, inode_t *parent, const char *name,
             }
         }
     }
-    pthread_mutex_unlock(&table->lock);
+    if (table->hash_lock_count)
+        inode_hash_lock_release(table, hash);
+    else
+        pthread_mutex_unlock(&table->lock);
 
     return ret;
 }
@@ -926,6 +1113,7 @@ inode_t *
 inode_find(inode_table_t *table, uuid_t gfid)
 {
     inode_t *inode = NULL;
+    gf_boolean_t found = _gf_false;
 
     if (!table) {
         gf_msg_callingfn(THIS->name, GF_LOG_WARNING, 0,
@@ -937,6 +1125,21 @@ inode_find(inode_table_t *table, uuid_t gfid)
 
     int hash = hash_gfid(gfid, 65536);
 
+    if (table->hash_lock_count) {
+        inode_hash_lock_acquire(table, hash);
+        {
+            inode = __inode_find(table, gfid, hash);
+            if (inode && inode_ref_fast(inode))
+                found = _gf_true;
+        }
+        inode_hash_lock_release(table, hash);
+
+        /* Inodes in the lru list need table->lock to be activated. */
+        if (found || !inode)
+            return inode;
+        inode = NULL;
+    }
+
     pthread_mutex_lock(&table->lock);
     {
         inode = __inode_find(table, gfid, hash);
@@ -1091,7 +1294,7 @@ inode_link(inode_t *inode, inode_t *parent, const char *name, struct iatt *iatt)
     }
     pthread_mutex_unlock(&table->lock);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return linked_inode;
 }
@@ -1129,7 +1332,7 @@ inode_ref_reduce_by_n(inode_t *inode, uint64_t nref)
     }
     pthread_mutex_unlock(&table->lock);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return 0;
 }
@@ -1149,7 +1352,7 @@ inode_forget(inode_t *inode, uint64_t nlookup)
 
     inode_forget_atomic(inode, nlookup);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return 0;
 }
@@ -1174,7 +1377,7 @@ inode_forget_with_unref(inode_t *inode, uint64_t nlookup)
     }
     pthread_mutex_unlock(&table->lock);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return 0;
 }
@@ -1269,7 +1472,7 @@ inode_unlink(inode_t *inode, inode_t *parent, const char *name)
 
     dentry_destroy(dentry);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 }
 
 int
@@ -1308,7 +1511,7 @@ inode_rename(inode_table_t *table, inode_t *srcdir, const char *srcname,
     /* free the old dentry */
     dentry_destroy(dentry);
 
-    inode_table_prune(table);
+    inode_table_prune_maybe(table);
 
     return 0;
 }
@@ -1634,6 +1837,124 @@ inode_table_prune(inode_table_t *table)
     return ret;
 }
 
+typedef struct _inode_prune_job {
+    gf_async_t async;
+    inode_table_t *table;
+} inode_prune_job_t;
+
+static void
+inode_table_prune_async(xlator_t *xl, gf_async_t *async)
+{
+    inode_prune_job_t *job = NULL;
+    inode_table_t *table = NULL;
+
+    job = caa_container_of(async, inode_prune_job_t, async);
+    table = job->table;
+
+    /* Requests received while pruning make the loop run again, so that
+       no inode is left behind in the purge list. */
+    do {
+        GF_ATOMIC_SWAP(table->prune_state, INODE_PRUNE_RUNNING);
+        inode_table_prune(table);
+    } while (!GF_ATOMIC_CMP_SWAP(table->prune_state, INODE_PRUNE_RUNNING,
+                                 INODE_PRUNE_IDLE));
+}
+
+/* Called after every change that may have made inodes eligible for purging.
+ * Non striped tables prune synchronously as they always did. Striped tables
+ * only do the work when there's something to purge, and do it from the
+ * asynchronous workers so that forget callbacks of all xlators are not run
+ * in the fop path. The unlocked checks are safe since the thread that made
+ * the lists grow will always see its own update. */
+static void
+inode_table_prune_maybe(inode_table_t *table)
+{
+    if (!table->hash_lock_count || table->cleanup_started) {
+        inode_table_prune(table);
+        return;
+    }
+
+    if (list_empty(&table->purge) &&
+        (!table->lru_limit || (table->lru_size <= table->lru_limit)))
+        return;
+
+    if (GF_ATOMIC_SWAP(table->prune_state, INODE_PRUNE_REQUESTED) ==
+        INODE_PRUNE_IDLE) {
+        gf_async(table->prune_async, table->xl, inode_table_prune_async);
+    }
+}
+
+int
+inode_table_set_lock_stripes(inode_table_t *table, uint32_t stripes)
+{
+    inode_prune_job_t *job = NULL;
+    pthread_mutex_t *locks = NULL;
+    uint32_t count = 1;
+    uint32_t i = 0;
+
+    if (!table || !stripes || table->hash_lock_count)
+        return 0;
+
+#ifndef INODE_LOCKLESS_REF
+    gf_msg(table->name, GF_LOG_WARNING, ENOTSUP, LG_MSG_INVALID_ARG,
+           "atomic builtins not available, inode table lock striping "
+           "disabled");
+    return -1;
+#endif
+
+    if (stripes > GF_INODE_TABLE_MAX_STRIPES)
+        stripes = GF_INODE_TABLE_MAX_STRIPES;
+    while (count < stripes)
+        count <<= 1;
+
+    job = GF_CALLOC(1, sizeof(*job), gf_common_mt_inode_stripes_t);
+    locks = GF_CALLOC(count, sizeof(*locks), gf_common_mt_inode_stripes_t);
+    if (!job || !locks) {
+        GF_FREE(job);
+        GF_FREE(locks);
+        return -1;
+    }
+
+    for (i = 0; i < count; i++)
+        pthread_mutex_init(&locks[i], NULL);
+
+    job->table = table;
+    GF_ATOMIC_INIT(table->prune_state, INODE_PRUNE_IDLE);
+
+    /* Striping can only be enabled before the table is shared, so
+       there's no need to protect these updates. */
+    table->prune_async = &job->async;
+    table->hash_locks = locks;
+    table->hash_lock_count = count;
+
+    gf_msg_debug(table->name, 0, "inode table using %u lock stripes", count);
+
+    return 0;
+}
+
+static void
+inode_table_stripes_destroy(inode_table_t *table)
+{
+    uint32_t i = 0;
+
+    if (!table->hash_lock_count)
+        return;
+
+    /* Wait for a pending background prune to finish before the table
+       goes away. */
+    while (GF_ATOMIC_GET(table->prune_state) != INODE_PRUNE_IDLE)
+        sched_yield();
+
+    for (i = 0; i < table->hash_lock_count; i++)
+        pthread_mutex_destroy(&table->hash_locks[i]);
+
+    GF_FREE(table->hash_locks);
+    GF_FREE(caa_container_of(table->prune_async, inode_prune_job_t, async));
+    table->hash_locks = NULL;
+    table->prune_async = NULL;
+    table->hash_lock_count = 0;
+}
+
 static void
 __inode_table_init_root(inode_table_t *table)
 {
@@ -1927,6 +2248,8 @@ inode_table_destroy(inode_table_t *inode_table)
 
     inode_table_prune(inode_table);
 
+    inode_table_stripes_destroy(inode_table);
+
     GF_FREE(inode_table->inode_hash);
     GF_FREE(inode_table->name_hash);
     if (inode_table->dentry_pool)
@@ -2479,6 +2802,8 @@ inode_table_dump(inode_table_t *itable, char *prefix)
 
     gf_proc_dump_build_key(key, prefix, "hashsize");
     gf_proc_dump_write(key, "%" GF_PRI_SIZET, itable->hashsize);
+    gf_proc_dump_build_key(key, prefix, "lock_stripes");
+    gf_proc_dump_write(key, "%u", itable->hash_lock_count);
     gf_proc_dump_build_key(key, prefix, "name");
     gf_proc_dump_write(key, "%s", itable->name);
 
@@ -58,6 +58,12 @@ gf_iobuf_get_pagesize(const size_t page_size, int *index)
     return -1;
 }
 
+static struct iobuf *
+__iobuf_get(struct iobuf_pool *iobuf_pool, const size_t page_size,
+            const int index);
+static void
+__iobuf_put(struct iobuf *iobuf, struct iobuf_arena *iobuf_arena);
+
 static void
 __iobuf_arena_init_iobufs(struct iobuf_arena *iobuf_arena)
 {
@@ -237,6 +243,318 @@ __iobuf_pool_add_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
     return iobuf_arena;
 }
 
+/*
+ * Per-thread iobuf caches.
+ *
+ * Each thread using a pool keeps a small stack of free iobufs for every
+ * page size, so that most iobuf_get2() and iobuf_put() calls only take the
+ * lock of its own cache, which nobody else takes in the normal case. When
+ * the stack is empty (or full), half of it is refilled from (or returned
+ * to) the arenas with a single acquisition of the pool mutex.
+ *
+ * Cached iobufs stay in the active list of their arena with a reference
+ * count of 0, so the arena is not pruned while they are in a cache.
+ *
+ * Lock ordering is iobuf_cache_lock -> iobuf_pool->mutex -> cache->lock.
+ * iobuf_cache_lock protects the binding between a cache and a pool
+ * (cache->pool and the pool's thread_caches list), cache->lock protects
+ * the cached iobufs and the counters.
+ */
+typedef struct iobuf_thread_cache {
+    struct list_head list; /* in iobuf_pool->thread_caches */
+    struct iobuf_pool *pool;
+    pthread_spinlock_t lock;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t flushes;
+    int count[IOBUF_ARENA_MAX_INDEX];
+    struct iobuf *iobufs[IOBUF_ARENA_MAX_INDEX][GF_IOBUF_THREAD_CACHE_DEPTH];
+} iobuf_thread_cache_t;
+
+/* Upper limit of the memory a thread caches for each page size. */
+#define IOBUF_THREAD_CACHE_BYTES (512 * GF_UNIT_KB)
+
+static pthread_mutex_t iobuf_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t iobuf_cache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t iobuf_cache_key;
+static gf_boolean_t iobuf_cache_enabled = _gf_false;
+static int iobuf_cache_limit[IOBUF_ARENA_MAX_INDEX];
+static __thread iobuf_thread_cache_t *iobuf_thread_cache = NULL;
+
+/* Called with the pool mutex and the cache lock held. The oldest iobufs
+ * are the ones given back, the most recently used ones are kept. */
+static void
+__iobuf_thread_cache_drain(iobuf_thread_cache_t *cache, const int index,
+                           int count)
+{
+    struct iobuf **stack = cache->iobufs[index];
+    int i = 0;
+
+    if (count > cache->count[index])
+        count = cache->count[index];
+
+    for (i = 0; i < count; i++)
+        __iobuf_put(stack[i], stack[i]->iobuf_arena);
+
+    cache->count[index] -= count;
+    memmove(stack, stack + count, cache->count[index] * sizeof(*stack));
+}
+
+/* Called with the pool mutex and the cache lock held. */
+static void
+__iobuf_thread_cache_release(iobuf_thread_cache_t *cache)
+{
+    struct iobuf_pool *iobuf_pool = cache->pool;
+    int i = 0;
+
+    for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++)
+        __iobuf_thread_cache_drain(cache, i, cache->count[i]);
+
+    iobuf_pool->cache_hits += cache->hits;
+    iobuf_pool->cache_misses += cache->misses;
+    iobuf_pool->cache_flushes += cache->flushes;
+
+    cache->hits = 0;
+    cache->misses = 0;
+    cache->flushes = 0;
+    cache->pool = NULL;
+}
+
+/* pthread key destructor, run when a thread which used a cache exits. */
+static void
+iobuf_thread_cache_destroy(void *data)
+{
+    iobuf_thread_cache_t *cache = data;
+    struct iobuf_pool *iobuf_pool = NULL;
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    {
+        iobuf_pool = cache->pool;
+        if (iobuf_pool) {
+            pthread_mutex_lock(&iobuf_pool->mutex);
+            pthread_spin_lock(&cache->lock);
+            __iobuf_thread_cache_release(cache);
+            pthread_spin_unlock(&cache->lock);
+            pthread_mutex_unlock(&iobuf_pool->mutex);
+
+            list_del_init(&cache->list);
+        }
+    }
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    iobuf_thread_cache = NULL;
+
+    pthread_spin_destroy(&cache->lock);
+    FREE(cache);
+}
+
+static void
+iobuf_thread_cache_init_once(void)
+{
+    size_t limit = 0;
+    int ret = 0;
+    int i = 0;
+
+    for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
+        limit = IOBUF_THREAD_CACHE_BYTES / gf_iobuf_init_config[i].pagesize;
+        if (limit < 2)
+            limit = 2;
+        if (limit > GF_IOBUF_THREAD_CACHE_DEPTH)
+            limit = GF_IOBUF_THREAD_CACHE_DEPTH;
+
+        iobuf_cache_limit[i] = limit;
+    }
+
+    ret = pthread_key_create(&iobuf_cache_key, iobuf_thread_cache_destroy);
+    if (ret != 0) {
+        gf_msg("iobuf", GF_LOG_WARNING, ret, LG_MSG_PTHREAD_KEY_CREATE_FAILED,
+               "failed to create the pthread key, per-thread iobuf caches "
+               "are disabled");
+        return;
+    }
+
+    iobuf_cache_enabled = _gf_true;
+}
+
+static void
+iobuf_pool_release_thread_caches(struct iobuf_pool *iobuf_pool)
+{
+    iobuf_thread_cache_t *cache = NULL;
+    iobuf_thread_cache_t *tmp = NULL;
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    {
+        pthread_mutex_lock(&iobuf_pool->mutex);
+        {
+            list_for_each_entry_safe(cache, tmp, &iobuf_pool->thread_caches,
+                                     list)
+            {
+                pthread_spin_lock(&cache->lock);
+                __iobuf_thread_cache_release(cache);
+                pthread_spin_unlock(&cache->lock);
+
+                list_del_init(&cache->list);
+            }
+        }
+        pthread_mutex_unlock(&iobuf_pool->mutex);
+    }
+    pthread_mutex_unlock(&iobuf_cache_lock);
+}
+
+/* Returns the cache of the calling thread if it can be used for iobufs of
+ * @iobuf_pool. A thread only caches iobufs of one pool at a time; it moves
+ * to another pool only after the previous one has been destroyed. The
+ * unlocked check of cache->pool is just a hint, the callers check it again
+ * with the cache lock held. */
+static iobuf_thread_cache_t *
+iobuf_thread_cache_get(struct iobuf_pool *iobuf_pool)
+{
+    iobuf_thread_cache_t *cache = iobuf_thread_cache;
+
+    if (cache) {
+        if (cache->pool == iobuf_pool)
+            return cache;
+        if (cache->pool)
+            return NULL;
+    } else {
+        if (!iobuf_cache_enabled)
+            return NULL;
+
+        cache = CALLOC(1, sizeof(*cache));
+        if (!cache)
+            return NULL;
+
+        INIT_LIST_HEAD(&cache->list);
+        pthread_spin_init(&cache->lock, PTHREAD_PROCESS_PRIVATE);
+
+        if (pthread_setspecific(iobuf_cache_key, cache) != 0) {
+            pthread_spin_destroy(&cache->lock);
+            FREE(cache);
+            return NULL;
+        }
+
+        iobuf_thread_cache = cache;
+    }
+
+    pthread_mutex_lock(&iobuf_cache_lock);
+    {
+        if (!cache->pool) {
+            pthread_spin_lock(&cache->lock);
+            cache->pool = iobuf_pool;
+            pthread_spin_unlock(&cache->lock);
+
+            list_add(&cache->list, &iobuf_pool->thread_caches);
+        }
+    }
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    return (cache->pool == iobuf_pool) ? cache : NULL;
+}
+
+/* Returns an iobuf without taking a reference on it, or NULL when the
+ * thread cache can't be used and the caller has to go to the arenas. */
+static struct iobuf *
+iobuf_thread_cache_get_iobuf(struct iobuf_pool *iobuf_pool,
+                             const size_t page_size, const int index)
+{
+    iobuf_thread_cache_t *cache = NULL;
+    struct iobuf *iobuf = NULL;
+    struct iobuf *tmp = NULL;
+    int i = 0;
+
+    cache = iobuf_thread_cache_get(iobuf_pool);
+    if (!cache)
+        return NULL;
+
+    pthread_spin_lock(&cache->lock);
+    {
+        if ((cache->pool == iobuf_pool) && (cache->count[index] > 0)) {
+            iobuf = cache->iobufs[index][--cache->count[index]];
+            cache->hits++;
+        }
+    }
+    pthread_spin_unlock(&cache->lock);
+
+    if (iobuf)
+        return iobuf;
+
+    /* Empty cache: take one iobuf for the caller and refill half of the
+     * cache with the same acquisition of the pool mutex. */
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        iobuf = __iobuf_get(iobuf_pool, page_size, index);
+        if (iobuf) {
+            pthread_spin_lock(&cache->lock);
+            if (cache->pool == iobuf_pool) {
+                cache->misses++;
+                for (i = 0; i < iobuf_cache_limit[index] / 2; i++) {
+                    tmp = __iobuf_get(iobuf_pool, page_size, index);
+                    if (!tmp)
+                        break;
+                    cache->iobufs[index][cache->count[index]++] = tmp;
+                }
+            }
+            pthread_spin_unlock(&cache->lock);
+        }
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    return iobuf;
+}
+
+/* Returns _gf_true if the iobuf has been taken by the thread cache. */
+static gf_boolean_t
+iobuf_thread_cache_put_iobuf(struct iobuf_pool *iobuf_pool,
+                             struct iobuf *iobuf, const int index)
+{
+    iobuf_thread_cache_t *cache = NULL;
+    gf_boolean_t cached = _gf_false;
+
+    cache = iobuf_thread_cache_get(iobuf_pool);
+    if (!cache)
+        return _gf_false;
+
+    /* Same as __iobuf_put(), see iobuf_get_page_aligned(). */
+    if (iobuf->free_ptr) {
+        iobuf->ptr = iobuf->free_ptr;
+        iobuf->free_ptr = NULL;
+    }
+
+    pthread_spin_lock(&cache->lock);
+    {
+        if ((cache->pool == iobuf_pool) &&
+            (cache->count[index] < iobuf_cache_limit[index])) {
+            cache->iobufs[index][cache->count[index]++] = iobuf;
+            cached = _gf_true;
+        }
+    }
+    pthread_spin_unlock(&cache->lock);
+
+    if (cached)
+        return _gf_true;
+
+    /* Full cache: give half of it back to the arenas and keep this one,
+     * which is the most likely to be still warm in the CPU cache. */
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        pthread_spin_lock(&cache->lock);
+        if (cache->pool == iobuf_pool) {
+            __iobuf_thread_cache_drain(cache, index,
+                                       iobuf_cache_limit[index] / 2);
+            cache->flushes++;
+            cache->iobufs[index][cache->count[index]++] = iobuf;
+            cached = _gf_true;
+        }
+        pthread_spin_unlock(&cache->lock);
+
+        if (!cached)
+            __iobuf_put(iobuf, iobuf->iobuf_arena);
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    return _gf_true;
+}
+
 /* This function destroys all the iobufs and the iobuf_pool */
 void
 iobuf_pool_destroy(struct iobuf_pool *iobuf_pool)
@@ -247,6 +565,9 @@ iobuf_pool_destroy(struct iobuf_pool *iobuf_pool)
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
 
+    /* Give back the iobufs cached by the threads before the arenas go. */
+    iobuf_pool_release_thread_caches(iobuf_pool);
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++) {
@@ -332,6 +653,7 @@ iobuf_pool_new(void)
     if (!iobuf_pool)
         goto out;
     INIT_LIST_HEAD(&iobuf_pool->all_arenas);
+    INIT_LIST_HEAD(&iobuf_pool->thread_caches);
     pthread_mutex_init(&iobuf_pool->mutex, NULL);
     for (i = 0; i <= IOBUF_ARENA_MAX_INDEX; i++) {
         INIT_LIST_HEAD(&iobuf_pool->arenas[i]);
@@ -364,6 +686,8 @@ iobuf_pool_new(void)
     iobuf_create_stdalloc_arena(iobuf_pool);
 
     iobuf_pool->arena_size = arena_size;
+
+    pthread_once(&iobuf_cache_once, iobuf_thread_cache_init_once);
 out:
 
     return iobuf_pool;
@@ -381,6 +705,10 @@ __iobuf_arena_prune(struct iobuf_pool *iobuf_pool,
     if (list_empty(&iobuf_pool->arenas[index]))
         goto out;
 
+    /* Somebody relies on the memory of the arena staying mapped */
+    if (iobuf_arena->pin_count)
+        goto out;
+
     /* All cases matched, destroy */
     list_del_init(&iobuf_arena->list);
     list_del_init(&iobuf_arena->all_list);
@@ -421,6 +749,66 @@ out:
     return;
 }
 
+/*
+ * Pins the arenas the pool has right now, so that their memory stays
+ * mapped until they are unpinned. This allows the memory to be registered
+ * once with the kernel (e.g. as io_uring fixed buffers) and used for as
+ * long as the pin is held. Arenas created later are not pinned, and the
+ * arena of the big, std-allocated, iobufs is never returned.
+ *
+ * Returns the number of arenas stored in @arenas.
+ */
+int
+iobuf_pool_pin_arenas(struct iobuf_pool *iobuf_pool,
+                      struct iobuf_arena **arenas, int max)
+{
+    struct iobuf_arena *iobuf_arena = NULL;
+    int count = 0;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
+    GF_VALIDATE_OR_GOTO("iobuf", arenas, out);
+
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        list_for_each_entry(iobuf_arena, &iobuf_pool->all_arenas, all_list)
+        {
+            if (count == max)
+                break;
+            if (!iobuf_arena->mem_base || !iobuf_arena->arena_size)
+                continue;
+
+            iobuf_arena->pin_count++;
+            arenas[count++] = iobuf_arena;
+        }
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+out:
+    return count;
+}
+
+void
+iobuf_pool_unpin_arenas(struct iobuf_pool *iobuf_pool,
+                        struct iobuf_arena **arenas, int count)
+{
+    int i = 0;
+
+    GF_VALIDATE_OR_GOTO("iobuf", iobuf_pool, out);
+
+    pthread_mutex_lock(&iobuf_pool->mutex);
+    {
+        for (i = 0; i < count; i++)
+            arenas[i]->pin_count--;
+    }
+    pthread_mutex_unlock(&iobuf_pool->mutex);
+
+    /* Arenas left unused while they were pinned can go now. */
+    iobuf_pool_prune(iobuf_pool);
+
+out:
+    return;
+}
+
 /* Always called under the iobuf_pool mutex lock */
 static struct iobuf_arena *
 __iobuf_select_arena(struct iobuf_pool *iobuf_pool, const size_t page_size,
@@ -559,6 +947,10 @@ iobuf_get2(struct iobuf_pool *iobuf_pool, size_t page_size)
         return NULL;
     }
 
+    iobuf = iobuf_thread_cache_get_iobuf(iobuf_pool, rounded_size, index);
+    if (iobuf)
+        return iobuf_ref(iobuf);
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         iobuf = __iobuf_get(iobuf_pool, rounded_size, index);
@@ -625,6 +1017,11 @@ iobuf_get(struct iobuf_pool *iobuf_pool)
         return NULL;
     }
 
+    iobuf = iobuf_thread_cache_get_iobuf(
+        iobuf_pool, iobuf_pool->default_page_size, index);
+    if (iobuf)
+        return iobuf_ref(iobuf);
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         iobuf = __iobuf_get(iobuf_pool, iobuf_pool->default_page_size, index);
@@ -696,6 +1093,7 @@ iobuf_put(struct iobuf *iobuf)
 {
     struct iobuf_arena *iobuf_arena = NULL;
     struct iobuf_pool *iobuf_pool = NULL;
+    int index = 0;
 
     GF_VALIDATE_OR_GOTO("iobuf", iobuf, out);
 
@@ -713,6 +1111,11 @@ iobuf_put(struct iobuf *iobuf)
         return;
     }
 
+    /* iobufs allocated with calloc() are never cached */
+    index = gf_iobuf_get_arena_index(iobuf_arena->page_size);
+    if ((index != -1) && iobuf_thread_cache_put_iobuf(iobuf_pool, iobuf, index))
+        return;
+
     pthread_mutex_lock(&iobuf_pool->mutex);
     {
         __iobuf_put(iobuf, iobuf_arena);
@@ -1042,6 +1445,45 @@ out:
     return;
 }
 
+/* Called with the pool mutex held. iobuf_cache_lock comes before the pool
+ * mutex, so it can only be tried here. */
+static void
+iobuf_thread_caches_dump(struct iobuf_pool *iobuf_pool)
+{
+    iobuf_thread_cache_t *cache = NULL;
+    uint64_t hits = iobuf_pool->cache_hits;
+    uint64_t misses = iobuf_pool->cache_misses;
+    uint64_t flushes = iobuf_pool->cache_flushes;
+    uint64_t cached = 0;
+    int threads = 0;
+    int i = 0;
+
+    if (pthread_mutex_trylock(&iobuf_cache_lock) != 0)
+        return;
+
+    list_for_each_entry(cache, &iobuf_pool->thread_caches, list)
+    {
+        pthread_spin_lock(&cache->lock);
+        {
+            hits += cache->hits;
+            misses += cache->misses;
+            flushes += cache->flushes;
+            for (i = 0; i < IOBUF_ARENA_MAX_INDEX; i++)
+                cached += cache->count[i];
+        }
+        pthread_spin_unlock(&cache->lock);
+        threads++;
+    }
+
+    pthread_mutex_unlock(&iobuf_cache_lock);
+
+    gf_proc_dump_write("iobuf_pool.thread_caches", "%d", threads);
+    gf_proc_dump_write("iobuf_pool.thread_cache_iobufs", "%" PRIu64, cached);
+    gf_proc_dump_write("iobuf_pool.thread_cache_hits", "%" PRIu64, hits);
+    gf_proc_dump_write("iobuf_pool.thread_cache_misses", "%" PRIu64, misses);
+    gf_proc_dump_write("iobuf_pool.thread_cache_flushes", "%" PRIu64, flushes);
+}
+
 void
 iobuf_stats_dump(struct iobuf_pool *iobuf_pool)
 {
@@ -1068,6 +1510,8 @@ iobuf_stats_dump(struct iobuf_pool *iobuf_pool)
     gf_proc_dump_write("iobuf_pool.request_misses", "%" PRId64,
                        iobuf_pool->request_misses);
 
+    iobuf_thread_caches_dump(iobuf_pool);
+
     for (j = 0; j < IOBUF_ARENA_MAX_INDEX; j++) {
         list_for_each_entry(trav, &iobuf_pool->arenas[j], list)
         {
@@ -16,6 +16,157 @@
 #include "glusterfs/glusterfs.h"
 #include "glusterfs/statedump.h"
 
+gf_latency_hist_t *
+gf_latency_hist_new(void)
+{
+    gf_latency_hist_t *hist = NULL;
+    int i;
+
+    hist = GF_MALLOC(sizeof(*hist), gf_common_mt_latency_hist_t);
+    if (!hist)
+        return NULL;
+
+    GF_ATOMIC_INIT(hist->count, 0);
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++)
+        GF_ATOMIC_INIT(hist->buckets[i], 0);
+
+    return hist;
+}
+
+static int
+gf_latency_hist_index(uint64_t value)
+{
+    int msb;
+
+    if (value < GF_LATENCY_HIST_SUB_COUNT)
+        return value;
+
+    msb = 63 - __builtin_clzll(value);
+    if (msb >= GF_LATENCY_HIST_MAX_BITS)
+        return GF_LATENCY_HIST_BUCKETS - 1;
+
+    /* the bits below the most significant one select the sub-bucket */
+    return (msb - GF_LATENCY_HIST_SUB_BITS + 1) * GF_LATENCY_HIST_SUB_COUNT +
+           ((value >> (msb - GF_LATENCY_HIST_SUB_BITS)) -
+            GF_LATENCY_HIST_SUB_COUNT);
+}
+
+/* middle of the range of values counted in a bucket */
+static uint64_t
+gf_latency_hist_value(int index)
+{
+    int group = index / GF_LATENCY_HIST_SUB_COUNT;
+    int sub = index % GF_LATENCY_HIST_SUB_COUNT;
+    uint64_t low;
+
+    if (!group)
+        return sub;
+
+    low = (uint64_t)(GF_LATENCY_HIST_SUB_COUNT + sub) << (group - 1);
+
+    return low + ((1ULL << (group - 1)) >> 1);
+}
+
+void
+gf_latency_hist_record(gf_latency_hist_t *hist, uint64_t value)
+{
+    GF_ATOMIC_INC(hist->buckets[gf_latency_hist_index(value)]);
+    GF_ATOMIC_INC(hist->count);
+}
+
+/* Value below which 'percentile' % of the recorded ones are. As the
+ * buckets are updated while this runs, it's only approximate. The rank is
+ * taken from a snapshot of the buckets rather than from hist->count, which
+ * can be out of line with them for a while. */
+uint64_t
+gf_latency_hist_percentile(gf_latency_hist_t *hist, double percentile)
+{
+    uint64_t buckets[GF_LATENCY_HIST_BUCKETS];
+    uint64_t count = 0;
+    uint64_t target;
+    uint64_t seen = 0;
+    int64_t n;
+    int i;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        n = GF_ATOMIC_GET(hist->buckets[i]);
+        buckets[i] = (n > 0) ? n : 0;
+        count += buckets[i];
+    }
+
+    if (!count)
+        return 0;
+
+    target = (uint64_t)(count * percentile / 100.0 + 0.5);
+    if (!target)
+        target = 1;
+    if (target > count)
+        target = count;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen >= target)
+            return gf_latency_hist_value(i);
+    }
+
+    return gf_latency_hist_value(GF_LATENCY_HIST_BUCKETS - 1);
+}
+
+/* Takes away what was counted so far instead of zeroing the counters, so
+ * that the values recorded meanwhile are kept and hist->count doesn't drift
+ * from the buckets. */
+void
+gf_latency_hist_reset(gf_latency_hist_t *hist)
+{
+    int64_t removed = 0;
+    int64_t n;
+    int i;
+
+    for (i = 0; i < GF_LATENCY_HIST_BUCKETS; i++) {
+        n = GF_ATOMIC_GET(hist->buckets[i]);
+        if (n) {
+            GF_ATOMIC_SUB(hist->buckets[i], n);
+            removed += n;
+        }
+    }
+    GF_ATOMIC_SUB(hist->count, removed);
+}
+
+void
+gf_latency_hist_free_all(xlator_t *xl)
+{
+    int i;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        GF_FREE(xl->stats.total.hist[i]);
+        xl->stats.total.hist[i] = NULL;
+    }
+}
+
+/* Returns the histogram in *slot, allocating it if needed */
+gf_latency_hist_t *
+gf_latency_hist_get(gf_latency_hist_t **slot)
+{
+    gf_latency_hist_t *hist = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+    gf_latency_hist_t *expected = NULL;
+
+    if (hist)
+        return hist;
+
+    hist = gf_latency_hist_new();
+    if (!hist)
+        return NULL;
+
+    /* another thread may have been quicker */
+    if (!__atomic_compare_exchange_n(slot, &expected, hist, false,
+                                     __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE)) {
+        GF_FREE(hist);
+        hist = expected;
+    }
+
+    return hist;
+}
+
 void
 gf_update_latency(call_frame_t *frame)
 {
@@ -23,6 +174,7 @@ gf_update_latency(call_frame_t *frame)
     struct timespec *begin, *end;
 
     fop_latency_t *lat;
+    gf_latency_hist_t *hist;
 
     begin = &frame->begin;
     end = &frame->end;
@@ -54,6 +206,10 @@ gf_update_latency(call_frame_t *frame)
 
     lat->total += elapsed;
     lat->count++;
+
+    hist = gf_latency_hist_get(&frame->this->stats.total.hist[frame->op]);
+    if (hist)
+        gf_latency_hist_record(hist, (uint64_t)elapsed);
 out:
     return;
 }
@@ -84,6 +240,27 @@ gf_proc_dump_latency_info(xlator_t *xl)
             lat->max);
     }
 
+    /* the histograms are never reset, they cover the whole life of the
+       xlator */
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        gf_latency_hist_t *hist = xl->stats.total.hist[i];
+
+        if (!hist || !GF_ATOMIC_GET(hist->count))
+            continue;
+
+        gf_proc_dump_build_key(key, key_prefix, "%s.percentiles",
+                               (char *)gf_fop_list[i]);
+
+        gf_proc_dump_write(key,
+                           "CNT:%" GF_PRI_ATOMIC ",P50:%" PRIu64
+                           ",P90:%" PRIu64 ",P99:%" PRIu64 ",P999:%" PRIu64,
+                           GF_ATOMIC_GET(hist->count),
+                           gf_latency_hist_percentile(hist, 50),
+                           gf_latency_hist_percentile(hist, 90),
+                           gf_latency_hist_percentile(hist, 99),
+                           gf_latency_hist_percentile(hist, 99.9));
+    }
+
     memset(xl->stats.interval.latencies, 0,
            sizeof(xl->stats.interval.latencies));
 
@@ -15,18 +15,215 @@
 #include "glusterfs/timespec.h"
 #include "glusterfs/libglusterfs-messages.h"
 
+#define GF_TIMER_ROOT_MASK (GF_TIMER_ROOT_SIZE - 1)
+#define GF_TIMER_LEVEL_MASK (GF_TIMER_LEVEL_SIZE - 1)
+#define GF_TIMER_LEVEL_SHIFT(n) (GF_TIMER_ROOT_BITS + (n)*GF_TIMER_LEVEL_BITS)
+#define GF_TIMER_MAX_DELTA ((1ULL << GF_TIMER_LEVEL_SHIFT(GF_TIMER_LEVELS)) - 1)
+
 /* fwd decl */
 static gf_timer_registry_t *
 gf_timer_registry_init(glusterfs_ctx_t *);
 
+/* wheel used by the timers the current thread adds */
+static __thread int gf_timer_wheel_idx = -1;
+
+static uint64_t
+gf_timer_ticks(struct timespec *ts)
+{
+    /* rounded up, a timer never fires early */
+    return (TS((*ts)) + GF_TIMER_TICK - 1) / GF_TIMER_TICK;
+}
+
+static gf_timer_wheel_t *
+gf_timer_wheel_get(gf_timer_registry_t *reg)
+{
+    if (gf_timer_wheel_idx < 0)
+        gf_timer_wheel_idx = GF_ATOMIC_INC(reg->next) - 1;
+
+    return &reg->wheels[gf_timer_wheel_idx % reg->count];
+}
+
+static void
+__gf_timer_wheel_add(gf_timer_wheel_t *wheel, gf_timer_t *event)
+{
+    uint64_t expires = event->expires;
+    uint64_t delta = 0;
+    uint32_t idx = 0;
+    int n = 0;
+
+    if (expires < wheel->base)
+        expires = wheel->base;
+
+    delta = expires - wheel->base;
+    if (delta < GF_TIMER_ROOT_SIZE) {
+        idx = expires & GF_TIMER_ROOT_MASK;
+        list_add_tail(&event->list, &wheel->root[idx]);
+        wheel->root_map[idx / 64] |= 1ULL << (idx % 64);
+        return;
+    }
+
+    if (delta > GF_TIMER_MAX_DELTA)
+        expires = wheel->base + GF_TIMER_MAX_DELTA;
+
+    for (n = 0; n < GF_TIMER_LEVELS - 1; n++) {
+        if (delta < (1ULL << GF_TIMER_LEVEL_SHIFT(n + 1)))
+            break;
+    }
+
+    idx = (expires >> GF_TIMER_LEVEL_SHIFT(n)) & GF_TIMER_LEVEL_MASK;
+    list_add_tail(&event->list, &wheel->level[n][idx]);
+    wheel->level_map[n] |= 1ULL << idx;
+}
+
+static void
+__gf_timer_wheel_del(gf_timer_wheel_t *wheel, gf_timer_t *event)
+{
+    struct list_head *head = event->list.next;
+
+    if (head != event->list.prev) {
+        list_del(&event->list);
+        return;
+    }
+
+    /* the timer was alone in its slot, find which one to clear it */
+    list_del(&event->list);
+    if ((head >= wheel->root) && (head < wheel->root + GF_TIMER_ROOT_SIZE)) {
+        uint32_t idx = head - wheel->root;
+
+        wheel->root_map[idx / 64] &= ~(1ULL << (idx % 64));
+    } else {
+        uint32_t idx = head - wheel->level[0];
+
+        wheel->level_map[idx / GF_TIMER_LEVEL_SIZE] &=
+            ~(1ULL << (idx % GF_TIMER_LEVEL_SIZE));
+    }
+}
+
+/* Moves the timers of a slot of level 'n' down to the levels below */
+static void
+__gf_timer_wheel_cascade(gf_timer_wheel_t *wheel, int n, uint32_t idx)
+{
+    struct list_head head;
+    gf_timer_t *event = NULL;
+    gf_timer_t *tmp = NULL;
+
+    if (!(wheel->level_map[n] & (1ULL << idx)))
+        return;
+
+    INIT_LIST_HEAD(&head);
+    list_splice_init(&wheel->level[n][idx], &head);
+    wheel->level_map[n] &= ~(1ULL << idx);
+
+    list_for_each_entry_safe(event, tmp, &head, list)
+    {
+        __gf_timer_wheel_add(wheel, event);
+    }
+}
+
+/* Index of the first bit set in 'map' from position 'start' on, wrapping
+ * around, or -1 */
+static int
+gf_timer_map_next(uint64_t *map, int words, int start)
+{
+    uint64_t word = 0;
+    int pos = start;
+    int i = 0;
+
+    for (i = 0; i <= words; i++) {
+        word = map[(pos / 64) % words];
+        if (i == 0)
+            word &= ~0ULL << (pos % 64);
+        if (word)
+            return ((pos / 64) % words) * 64 + __builtin_ctzll(word);
+        pos = (pos / 64 + 1) * 64;
+    }
+
+    return -1;
+}
+
+/* First tick from wheel->base on at which there is something to do: either
+ * timers to fire or a slot to cascade. Nothing happens in between, so the
+ * wheel can jump directly there. */
+static uint64_t
+__gf_timer_wheel_next(gf_timer_wheel_t *wheel)
+{
+    uint64_t next = UINT64_MAX;
+    uint64_t start = 0;
+    uint64_t first = 0;
+    uint64_t base = wheel->base;
+    uint32_t pos = 0;
+    int shift = 0;
+    int idx = 0;
+    int n = 0;
+
+    if (!wheel->count)
+        return next;
+
+    idx = gf_timer_map_next(wheel->root_map, GF_TIMER_ROOT_SIZE / 64,
+                            base & GF_TIMER_ROOT_MASK);
+    if (idx >= 0)
+        next = base + ((idx - base) & GF_TIMER_ROOT_MASK);
+
+    for (n = 0; n < GF_TIMER_LEVELS; n++) {
+        shift = GF_TIMER_LEVEL_SHIFT(n);
+        /* unless base is where it starts, the current slot has already
+         * been cascaded and its timers are for the next round */
+        first = base >> shift;
+        if (base & ((1ULL << shift) - 1))
+            first++;
+        pos = first & GF_TIMER_LEVEL_MASK;
+        idx = gf_timer_map_next(&wheel->level_map[n], 1, pos);
+        if (idx < 0)
+            continue;
+
+        start = (first + ((idx - pos) & GF_TIMER_LEVEL_MASK)) << shift;
+        if (start < next)
+            next = start;
+    }
+
+    return next;
+}
+
+/* Processes the tick wheel->base, moving the timers that expire in it to
+ * 'expired' */
+static void
+__gf_timer_wheel_tick(gf_timer_wheel_t *wheel, struct list_head *expired)
+{
+    uint64_t base = wheel->base;
+    uint32_t idx = base & GF_TIMER_ROOT_MASK;
+    uint32_t pos = 0;
+    gf_timer_t *event = NULL;
+    int n = 0;
+
+    if (!idx) {
+        for (n = 0; n < GF_TIMER_LEVELS; n++) {
+            pos = (base >> GF_TIMER_LEVEL_SHIFT(n)) & GF_TIMER_LEVEL_MASK;
+            __gf_timer_wheel_cascade(wheel, n, pos);
+            if (pos)
+                break;
+        }
+    }
+
+    if (wheel->root_map[idx / 64] & (1ULL << (idx % 64))) {
+        list_for_each_entry(event, &wheel->root[idx], list)
+        {
+            event->fired = _gf_true;
+            wheel->count--;
+        }
+        list_append_init(&wheel->root[idx], expired);
+        wheel->root_map[idx / 64] &= ~(1ULL << (idx % 64));
+    }
+
+    wheel->base++;
+}
+
 gf_timer_t *
 gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
                     gf_timer_cbk_t callbk, void *data)
 {
     gf_timer_registry_t *reg = NULL;
+    gf_timer_wheel_t *wheel = NULL;
     gf_timer_t *event = NULL;
-    gf_timer_t *trav = NULL;
-    uint64_t at = 0;
 
     if ((ctx == NULL) || (ctx->cleanup_started)) {
         gf_msg_callingfn("timer", GF_LOG_ERROR, EINVAL, LG_MSG_INVALID_ARG,
@@ -49,23 +246,23 @@ gf_timer_call_after(glusterfs_ctx_t *ctx, struct timespec delta,
     }
     timespec_now(&event->at);
     timespec_adjust_delta(&event->at, delta);
-    at = TS(event->at);
+    event->expires = gf_timer_ticks(&event->at);
     event->callbk = callbk;
     event->data = data;
     event->xl = THIS;
-    pthread_mutex_lock(&reg->lock);
+
+    wheel = gf_timer_wheel_get(reg);
+    event->wheel = wheel;
+
+    pthread_mutex_lock(&wheel->lock);
     {
-        list_for_each_entry_reverse(trav, &reg->active, list)
-        {
-            if (TS(trav->at) < at)
-                break;
-        }
-        list_add(&event->list, &trav->list);
-        if (&trav->list == &reg->active) {
-            pthread_cond_signal(&reg->cond);
+        __gf_timer_wheel_add(wheel, event);
+        wheel->count++;
+        if (event->expires < wheel->wakeup) {
+            pthread_cond_signal(&wheel->cond);
         }
     }
-    pthread_mutex_unlock(&reg->lock);
+    pthread_mutex_unlock(&wheel->lock);
     return event;
 }
 
@@ -73,6 +270,7 @@ int32_t
 gf_timer_call_cancel(glusterfs_ctx_t *ctx, gf_timer_t *event)
 {
     gf_timer_registry_t *reg = NULL;
+    gf_timer_wheel_t *wheel = NULL;
     gf_boolean_t fired = _gf_false;
 
     if (ctx == NULL || event == NULL) {
@@ -101,15 +299,18 @@ gf_timer_call_cancel(glusterfs_ctx_t *ctx, gf_timer_t *event)
         return -1;
     }
 
-    pthread_mutex_lock(&reg->lock);
+    wheel = event->wheel;
+
+    pthread_mutex_lock(&wheel->lock);
     {
         fired = event->fired;
         if (fired)
             goto unlock;
-        list_del(&event->list);
+        __gf_timer_wheel_del(wheel, event);
+        wheel->count--;
     }
 unlock:
-    pthread_mutex_unlock(&reg->lock);
+    pthread_mutex_unlock(&wheel->lock);
 
     if (!fired) {
         GF_FREE(event);
@@ -118,75 +319,156 @@ unlock:
     return -1;
 }
 
-static void *
-gf_timer_proc(void *data)
+static void
+gf_timer_fire(struct list_head *expired)
 {
-    gf_timer_registry_t *reg = data;
     gf_timer_t *event = NULL;
-    gf_timer_t *tmp = NULL;
     xlator_t *old_THIS = NULL;
 
-    pthread_mutex_lock(&reg->lock);
+    while (!list_empty(expired)) {
+        event = list_first_entry(expired, gf_timer_t, list);
+        list_del_init(&event->list);
 
-    while (!reg->fin) {
-        if (list_empty(&reg->active)) {
-            pthread_cond_wait(&reg->cond, &reg->lock);
-        } else {
-            struct timespec now;
+        old_THIS = NULL;
+        if (event->xl) {
+            old_THIS = THIS;
+            THIS = event->xl;
+        }
+        event->callbk(event->data);
+        GF_FREE(event);
+        if (old_THIS) {
+            THIS = old_THIS;
+        }
+    }
+}
 
-            timespec_now(&now);
-            event = list_first_entry(&reg->active, gf_timer_t, list);
-            if (TS(now) < TS(event->at)) {
-                pthread_cond_timedwait(&reg->cond, &reg->lock, &event->at);
+static void *
+gf_timer_proc(void *data)
+{
+    gf_timer_wheel_t *wheel = data;
+    gf_timer_t *event = NULL;
+    gf_timer_t *tmp = NULL;
+    struct list_head expired;
+    struct timespec now;
+    struct timespec at;
+    uint64_t next = 0;
+    uint64_t tick = 0;
+    int i = 0;
+    int n = 0;
+
+    INIT_LIST_HEAD(&expired);
+
+    pthread_mutex_lock(&wheel->lock);
+
+    while (!wheel->fin) {
+        timespec_now(&now);
+        tick = TS(now) / GF_TIMER_TICK;
+
+        next = __gf_timer_wheel_next(wheel);
+        if (next > tick) {
+            wheel->wakeup = next;
+            if (next == UINT64_MAX) {
+                /* nothing pending, keep the wheel in sync with the clock */
+                wheel->base = tick + 1;
+                pthread_cond_wait(&wheel->cond, &wheel->lock);
             } else {
-                event->fired = _gf_true;
-                list_del_init(&event->list);
+                at.tv_sec = next * GF_TIMER_TICK / GIGA;
+                at.tv_nsec = next * GF_TIMER_TICK % GIGA;
+                pthread_cond_timedwait(&wheel->cond, &wheel->lock, &at);
+            }
+            wheel->wakeup = 0;
+            continue;
+        }
+
+        /* process all the ticks up to now that have something to do */
+        while ((next <= tick) && list_empty(&expired)) {
+            wheel->base = next;
+            __gf_timer_wheel_tick(wheel, &expired);
+            next = __gf_timer_wheel_next(wheel);
+        }
 
-                pthread_mutex_unlock(&reg->lock);
+        if (list_empty(&expired))
+            continue;
 
-                old_THIS = NULL;
-                if (event->xl) {
-                    old_THIS = THIS;
-                    THIS = event->xl;
-                }
-                event->callbk(event->data);
-                GF_FREE(event);
-                if (old_THIS) {
-                    THIS = old_THIS;
-                }
+        pthread_mutex_unlock(&wheel->lock);
 
-                pthread_mutex_lock(&reg->lock);
-            }
-        }
+        gf_timer_fire(&expired);
+
+        pthread_mutex_lock(&wheel->lock);
     }
 
     /* Do not call gf_timer_call_cancel(),
      * it will lead to deadlock
      */
-    list_for_each_entry_safe(event, tmp, &reg->active, list)
-    {
-        list_del(&event->list);
-        /* TODO Possible resource leak
-         * Before freeing the event, we need to call the respective
-         * event functions and free any resources.
-         * For example, In case of rpc_clnt_reconnect, we need to
-         * unref rpc object which was taken when added to timer
-         * wheel.
-         */
-        GF_FREE(event);
+    for (i = 0; i < GF_TIMER_ROOT_SIZE; i++) {
+        list_for_each_entry_safe(event, tmp, &wheel->root[i], list)
+        {
+            list_del(&event->list);
+            /* TODO Possible resource leak
+             * Before freeing the event, we need to call the respective
+             * event functions and free any resources.
+             * For example, In case of rpc_clnt_reconnect, we need to
+             * unref rpc object which was taken when added to timer
+             * wheel.
+             */
+            GF_FREE(event);
+        }
+    }
+    for (n = 0; n < GF_TIMER_LEVELS; n++) {
+        for (i = 0; i < GF_TIMER_LEVEL_SIZE; i++) {
+            list_for_each_entry_safe(event, tmp, &wheel->level[n][i], list)
+            {
+                list_del(&event->list);
+                GF_FREE(event);
+            }
+        }
     }
 
-    pthread_mutex_unlock(&reg->lock);
+    pthread_mutex_unlock(&wheel->lock);
 
     return NULL;
 }
 
+static void
+gf_timer_wheel_init(gf_timer_wheel_t *wheel)
+{
+    pthread_condattr_t attr;
+    struct timespec now;
+    int i = 0;
+    int n = 0;
+
+    for (i = 0; i < GF_TIMER_ROOT_SIZE; i++)
+        INIT_LIST_HEAD(&wheel->root[i]);
+    for (n = 0; n < GF_TIMER_LEVELS; n++) {
+        for (i = 0; i < GF_TIMER_LEVEL_SIZE; i++)
+            INIT_LIST_HEAD(&wheel->level[n][i]);
+    }
+
+    timespec_now(&now);
+    wheel->base = TS(now) / GF_TIMER_TICK;
+    wheel->wakeup = UINT64_MAX;
+
+    pthread_mutex_init(&wheel->lock, NULL);
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&wheel->cond, &attr);
+    pthread_condattr_destroy(&attr);
+}
+
 static gf_timer_registry_t *
 gf_timer_registry_init(glusterfs_ctx_t *ctx)
 {
     gf_timer_registry_t *reg = NULL;
+    gf_timer_wheel_t *wheels = NULL;
+    uint32_t count = 0;
+    uint32_t i = 0;
     int ret = -1;
-    pthread_condattr_t attr;
+
+    count = ctx->cmd_args.timer_wheels;
+    if (count < 1)
+        count = 1;
+    if (count > GF_TIMER_MAX_WHEELS)
+        count = GF_TIMER_MAX_WHEELS;
 
     LOCK(&ctx->lock);
     {
@@ -196,22 +478,31 @@ gf_timer_registry_init(glusterfs_ctx_t *ctx)
             goto out;
         }
         reg = GF_CALLOC(1, sizeof(*reg), gf_common_mt_gf_timer_registry_t);
-        if (!reg) {
+        wheels = GF_CALLOC(count, sizeof(*wheels),
+                           gf_common_mt_gf_timer_registry_t);
+        if (!reg || !wheels) {
             UNLOCK(&ctx->lock);
+            GF_FREE(reg);
+            GF_FREE(wheels);
+            reg = NULL;
             goto out;
         }
+        reg->wheels = wheels;
+        reg->count = count;
+        GF_ATOMIC_INIT(reg->next, 0);
+        for (i = 0; i < count; i++)
+            gf_timer_wheel_init(&wheels[i]);
         ctx->timer = reg;
-        pthread_mutex_init(&reg->lock, NULL);
-        pthread_condattr_init(&attr);
-        pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
-        pthread_cond_init(&reg->cond, &attr);
-        INIT_LIST_HEAD(&reg->active);
     }
     UNLOCK(&ctx->lock);
-    ret = gf_thread_create(&reg->th, NULL, gf_timer_proc, reg, "timer");
-    if (ret) {
-        gf_msg(THIS->name, GF_LOG_ERROR, ret, LG_MSG_PTHREAD_FAILED,
-               "Thread creation failed");
+
+    for (i = 0; i < count; i++) {
+        ret = gf_thread_create(&wheels[i].th, NULL, gf_timer_proc, &wheels[i],
+                               "timer%u", i);
+        if (ret) {
+            gf_msg(THIS->name, GF_LOG_ERROR, ret, LG_MSG_PTHREAD_FAILED,
+                   "Thread creation failed");
+        }
     }
 
 out:
@@ -221,8 +512,9 @@ out:
 void
 gf_timer_registry_destroy(glusterfs_ctx_t *ctx)
 {
-    pthread_t thr_id;
     gf_timer_registry_t *reg = NULL;
+    gf_timer_wheel_t *wheel = NULL;
+    uint32_t i = 0;
 
     if (ctx == NULL)
         return;
@@ -237,19 +529,26 @@ gf_timer_registry_destroy(glusterfs_ctx_t *ctx)
     if (!reg)
         return;
 
-    thr_id = reg->th;
+    for (i = 0; i < reg->count; i++) {
+        wheel = &reg->wheels[i];
 
-    pthread_mutex_lock(&reg->lock);
+        pthread_mutex_lock(&wheel->lock);
 
-    reg->fin = 1;
-    pthread_cond_signal(&reg->cond);
+        wheel->fin = 1;
+        pthread_cond_signal(&wheel->cond);
 
-    pthread_mutex_unlock(&reg->lock);
+        pthread_mutex_unlock(&wheel->lock);
+    }
+
+    for (i = 0; i < reg->count; i++) {
+        wheel = &reg->wheels[i];
 
-    pthread_join(thr_id, NULL);
+        pthread_join(wheel->th, NULL);
 
-    pthread_cond_destroy(&reg->cond);
-    pthread_mutex_destroy(&reg->lock);
+        pthread_cond_destroy(&wheel->cond);
+        pthread_mutex_destroy(&wheel->lock);
+    }
 
+    GF_FREE(reg->wheels);
     GF_FREE(reg);
 }
@@ -0,0 +1,327 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Benchmark for dict_t.
+ *
+ * It reports the number of allocations needed to build the xdata of a
+ * typical fop (a handful of well-known keys) and of a dict with custom
+ * keys, and the throughput of dict_get(), dict_serialize() and
+ * dict_unserialize() for small and big dicts.
+ *
+ * Allocations are counted with the memory accounting of the benchmark
+ * xlator (GF_MALLOC and friends) and with the number of active objects of
+ * the dict, pair and data mem-pools. The benchmark only uses the public
+ * dict API, so it can be built against older trees for comparison.
+ *
+ * Usage: dict_bench [-n dicts] [-d seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/dict.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/mem-types.h"
+#include "glusterfs/common-utils.h"
+
+#define BENCH_BIG_DICT_KEYS 32
+
+typedef dict_t *(*bench_build_t)(void);
+
+static xlator_t bench_xl;
+static uuid_t bench_gfid;
+
+/* xdata of a lookup coming from the fuse bridge and the cluster xlators */
+static dict_t *
+bench_build_fop_xdata(void)
+{
+    dict_t *xdata = dict_new();
+
+    if (!xdata)
+        return NULL;
+
+    if (dict_set_gfuuid(xdata, "gfid-req", bench_gfid, true) ||
+        dict_set_int32(xdata, GLUSTERFS_INODELK_COUNT, 1) ||
+        dict_set_int32(xdata, GLUSTERFS_ENTRYLK_COUNT, 1) ||
+        dict_set_int32(xdata, GLUSTERFS_POSIXLK_COUNT, 1) ||
+        dict_set_uint32(xdata, GF_REQUEST_LINK_COUNT_XDATA, 1)) {
+        dict_unref(xdata);
+        return NULL;
+    }
+
+    return xdata;
+}
+
+/* same shape, but with keys the dict doesn't know about */
+static dict_t *
+bench_build_custom_xdata(void)
+{
+    dict_t *xdata = dict_new();
+
+    if (!xdata)
+        return NULL;
+
+    if (dict_set_gfuuid(xdata, "user.bench.gfid", bench_gfid, true) ||
+        dict_set_int32(xdata, "user.bench.one", 1) ||
+        dict_set_int32(xdata, "user.bench.two", 2) ||
+        dict_set_int32(xdata, "user.bench.three", 3) ||
+        dict_set_uint32(xdata, "user.bench.four", 4)) {
+        dict_unref(xdata);
+        return NULL;
+    }
+
+    return xdata;
+}
+
+static dict_t *
+bench_build_big(void)
+{
+    dict_t *dict = dict_new();
+    char key[64];
+    int i = 0;
+
+    if (!dict)
+        return NULL;
+
+    for (i = 0; i < BENCH_BIG_DICT_KEYS; i++) {
+        snprintf(key, sizeof(key), "trusted.bench.key-%d", i);
+        if (dict_set_int32(dict, key, i)) {
+            dict_unref(dict);
+            return NULL;
+        }
+    }
+
+    return dict;
+}
+
+static uint64_t
+bench_gf_allocs(void)
+{
+    uint64_t total = 0;
+    int i = 0;
+
+    for (i = 0; i < bench_xl.mem_acct->num_types; i++)
+        total += bench_xl.mem_acct->rec[i].total_allocs;
+
+    return total;
+}
+
+static uint64_t
+bench_pool_objects(glusterfs_ctx_t *ctx)
+{
+    return GF_ATOMIC_GET(ctx->dict_pool->active) +
+           GF_ATOMIC_GET(ctx->dict_pair_pool->active) +
+           GF_ATOMIC_GET(ctx->dict_data_pool->active);
+}
+
+static int
+bench_allocs(glusterfs_ctx_t *ctx, const char *name, bench_build_t build,
+             uint32_t count)
+{
+    dict_t **dicts = NULL;
+    uint64_t gf_allocs = 0;
+    uint64_t objects = 0;
+    uint32_t i = 0;
+
+    dicts = calloc(count, sizeof(*dicts));
+    if (!dicts)
+        return -1;
+
+    gf_allocs = bench_gf_allocs();
+    objects = bench_pool_objects(ctx);
+
+    for (i = 0; i < count; i++) {
+        dicts[i] = build();
+        if (!dicts[i])
+            break;
+    }
+
+    gf_allocs = bench_gf_allocs() - gf_allocs;
+    objects = bench_pool_objects(ctx) - objects;
+
+    printf("%-24s %12.2f %12.2f %12.2f\n", name, (double)gf_allocs / count,
+           (double)objects / count, (double)(gf_allocs + objects) / count);
+
+    while (i > 0)
+        dict_unref(dicts[--i]);
+    free(dicts);
+
+    return 0;
+}
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static int
+bench_throughput(const char *name, bench_build_t build, uint32_t seconds)
+{
+    dict_t *dict = NULL;
+    dict_t *copy = NULL;
+    char *buf = NULL;
+    char key[64];
+    data_pair_t *pair = NULL;
+    double start = 0;
+    double elapsed = 0;
+    uint64_t gets = 0;
+    uint64_t sers = 0;
+    uint64_t unsers = 0;
+    int len = 0;
+    int i = 0;
+
+    dict = build();
+    if (!dict)
+        return -1;
+
+    len = dict_serialized_length(dict);
+    buf = malloc(len);
+    if (!buf || dict_serialize(dict, buf) != 0)
+        goto err;
+
+    start = bench_now();
+    do {
+        dict_foreach_inline(dict, pair)
+        {
+            /* copy the key so that lookups can't compare pointers */
+            snprintf(key, sizeof(key), "%s", pair->key);
+            if (!dict_get(dict, key))
+                goto err;
+            gets++;
+        }
+    } while ((elapsed = bench_now() - start) < seconds);
+    gets = gets / elapsed;
+
+    start = bench_now();
+    do {
+        for (i = 0; i < 64; i++) {
+            if (dict_serialized_length(dict) != len ||
+                dict_serialize(dict, buf) != 0)
+                goto err;
+        }
+        sers += 64;
+    } while ((elapsed = bench_now() - start) < seconds);
+    sers = sers / elapsed;
+
+    start = bench_now();
+    do {
+        for (i = 0; i < 64; i++) {
+            copy = dict_new();
+            if (!copy || dict_unserialize(buf, len, &copy) != 0)
+                goto err;
+            dict_unref(copy);
+            copy = NULL;
+        }
+        unsers += 64;
+    } while ((elapsed = bench_now() - start) < seconds);
+    unsers = unsers / elapsed;
+
+    printf("%-24s %14" PRIu64 " %14" PRIu64 " %14" PRIu64 "\n", name, gets,
+           sers, unsers);
+
+    free(buf);
+    dict_unref(dict);
+    return 0;
+
+err:
+    if (copy)
+        dict_unref(copy);
+    free(buf);
+    dict_unref(dict);
+    return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    uint32_t count = 100000;
+    uint32_t seconds = 2;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:d:")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                seconds = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-n dicts] [-d seconds]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    if (!count || !seconds) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx) != 0) {
+        fprintf(stderr, "failed to initialize glusterfs context\n");
+        return 1;
+    }
+    ctx->mem_acct_enable = 1;
+    THIS->ctx = ctx;
+
+    ctx->dict_pool = mem_pool_new(dict_t, 1024);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 1024);
+    ctx->dict_data_pool = mem_pool_new(data_t, 1024);
+    if (!ctx->dict_pool || !ctx->dict_pair_pool || !ctx->dict_data_pool)
+        goto err;
+
+    bench_xl.name = "dict-bench";
+    bench_xl.ctx = ctx;
+    if (xlator_mem_acct_init(&bench_xl, gf_common_mt_end + 1) != 0)
+        goto err;
+    THIS = &bench_xl;
+
+    gf_uuid_generate(bench_gfid);
+
+    printf("allocations per dict (%u dicts)\n", count);
+    printf("%-24s %12s %12s %12s\n", "dict", "GF_*ALLOC", "mem_get",
+           "total");
+    if (bench_allocs(ctx, "fop xdata", bench_build_fop_xdata, count) ||
+        bench_allocs(ctx, "custom keys", bench_build_custom_xdata, count) ||
+        bench_allocs(ctx, "32 keys", bench_build_big, count / 10 ?: 1))
+        goto err;
+
+    printf("\nthroughput (ops/s)\n");
+    printf("%-24s %14s %14s %14s\n", "dict", "dict_get", "serialize",
+           "unserialize");
+    if (bench_throughput("fop xdata", bench_build_fop_xdata, seconds) ||
+        bench_throughput("custom keys", bench_build_custom_xdata, seconds) ||
+        bench_throughput("32 keys", bench_build_big, seconds))
+        goto err;
+
+    return 0;
+
+err:
+    fprintf(stderr, "benchmark failed\n");
+    return 1;
+}
@@ -0,0 +1,417 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/dict.h"
+#include "glusterfs/mem-pool.h"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+#define KEY_FMT "unittest-key-%d"
+
+/*
+ * Helper functions
+ */
+static void
+helper_key(char *key, size_t size, int i)
+{
+    snprintf(key, size, KEY_FMT, i);
+}
+
+static void
+helper_add_keys(dict_t *dict, int from, int to)
+{
+    char key[64];
+    int i;
+
+    for (i = from; i < to; i++) {
+        helper_key(key, sizeof(key), i);
+        assert_int_equal(dict_set_int32(dict, key, i), 0);
+    }
+}
+
+static void
+helper_check_key(dict_t *dict, int i, gf_boolean_t present)
+{
+    char key[64];
+    int32_t value = -1;
+
+    helper_key(key, sizeof(key), i);
+    if (present) {
+        assert_int_equal(dict_get_int32(dict, key, &value), 0);
+        assert_int_equal(value, i);
+    } else {
+        assert_null(dict_get(dict, key));
+    }
+}
+
+/* Checks that members_list and the index agree: every pair is found, the
+ * index holds each pair once and no pair is separated from its home slot
+ * by an empty one. */
+static void
+helper_check_index(dict_t *dict)
+{
+    data_pair_t *pair;
+    uint32_t mask;
+    uint32_t home;
+    uint32_t i;
+    uint32_t j;
+    int count = 0;
+    int used = 0;
+
+    for (pair = dict->members_list; pair; pair = pair->next) {
+        assert_ptr_equal(dict_get(dict, pair->key), pair->value);
+        count++;
+    }
+    assert_int_equal(count, dict->count);
+
+    if (dict->count > DICT_INDEX_THRESHOLD)
+        assert_non_null(dict->members);
+
+    if (!dict->members) {
+        assert_int_equal(dict->hash_size, 0);
+        return;
+    }
+
+    assert_int_equal(dict->hash_size & (dict->hash_size - 1), 0);
+    assert_true(dict->count * 2 <= dict->hash_size);
+
+    mask = dict->hash_size - 1;
+    for (i = 0; i < dict->hash_size; i++) {
+        if (!dict->members[i])
+            continue;
+        used++;
+        home = dict->members[i]->key_hash & mask;
+        for (j = home; j != i; j = (j + 1) & mask)
+            assert_non_null(dict->members[j]);
+    }
+    assert_int_equal(used, dict->count);
+}
+
+static int
+helper_collect_key(dict_t *dict, char *key, data_t *value, void *data)
+{
+    int *keys = data;
+
+    keys[++keys[0]] = data_to_int32(value);
+
+    return 0;
+}
+
+static void
+helper_check_equal(dict_t *one, dict_t *two)
+{
+    data_pair_t *pair;
+    data_t *data;
+
+    assert_int_equal(one->count, two->count);
+
+    for (pair = one->members_list; pair; pair = pair->next) {
+        data = dict_get(two, pair->key);
+        assert_non_null(data);
+        assert_int_equal(data->len, pair->value->len);
+        assert_memory_equal(data->data, pair->value->data, data->len);
+    }
+}
+
+static int
+helper_setup(void **state)
+{
+    glusterfs_ctx_t *ctx;
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx) != 0)
+        return -1;
+    THIS->ctx = ctx;
+
+    ctx->dict_pool = mem_pool_new(dict_t, 64);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 512);
+    ctx->dict_data_pool = mem_pool_new(data_t, 512);
+    if (!ctx->dict_pool || !ctx->dict_pair_pool || !ctx->dict_data_pool)
+        return -1;
+
+    return 0;
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_dict_inline_pairs(void **state)
+{
+    dict_t *dict;
+    data_pair_t *pair;
+    int i;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    helper_add_keys(dict, 0, DICT_INLINE_PAIRS);
+    assert_int_equal(dict->inline_used, (1U << DICT_INLINE_PAIRS) - 1);
+    for (pair = dict->members_list; pair; pair = pair->next)
+        assert_in_range(pair - dict->inline_pairs, 0, DICT_INLINE_PAIRS - 1);
+
+    /* the next pair comes from the pool */
+    helper_add_keys(dict, DICT_INLINE_PAIRS, DICT_INLINE_PAIRS + 1);
+    pair = dict->members_list;
+    assert_false((pair >= dict->inline_pairs) &&
+                 (pair < dict->inline_pairs + DICT_INLINE_PAIRS));
+
+    /* a deleted inline pair is reused */
+    dict_del(dict, "unittest-key-2");
+    assert_int_equal(dict->inline_used,
+                     ((1U << DICT_INLINE_PAIRS) - 1) & ~(1U << 2));
+    helper_add_keys(dict, 100, 101);
+    assert_ptr_equal(dict->members_list, &dict->inline_pairs[2]);
+
+    for (i = 0; i <= DICT_INLINE_PAIRS; i++)
+        helper_check_key(dict, i, i != 2);
+    helper_check_key(dict, 100, _gf_true);
+    helper_check_index(dict);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_grow_and_rehash(void **state)
+{
+    dict_t *dict;
+    int32_t hash_size = 0;
+    int resizes = 0;
+    int i;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    for (i = 0; i < 300; i++) {
+        helper_add_keys(dict, i, i + 1);
+        assert_int_equal(dict->count, i + 1);
+
+        if (dict->count <= DICT_INDEX_THRESHOLD)
+            assert_null(dict->members);
+
+        if (dict->hash_size != hash_size) {
+            /* only grows, and at least doubles */
+            assert_true(dict->hash_size >= hash_size * 2);
+            hash_size = dict->hash_size;
+            resizes++;
+        }
+
+        helper_check_index(dict);
+    }
+
+    /* 32 -> 64 -> ... -> 1024 */
+    assert_int_equal(resizes, 6);
+
+    for (i = 0; i < 300; i++)
+        helper_check_key(dict, i, _gf_true);
+    helper_check_key(dict, 300, _gf_false);
+
+    /* replacing a value doesn't add a pair */
+    assert_int_equal(dict_set_int32(dict, "unittest-key-7", 7), 0);
+    assert_int_equal(dict->count, 300);
+    helper_check_index(dict);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_del_collisions(void **state)
+{
+    dict_t *dict;
+    data_pair_t *moved = NULL;
+    data_pair_t *pair;
+    uint32_t mask;
+    uint32_t i;
+    int count;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    /* add keys until one is not in its home slot */
+    for (count = 0; !moved; count++) {
+        assert_true(count < 256);
+        helper_add_keys(dict, count, count + 1);
+        if (!dict->members)
+            continue;
+
+        mask = dict->hash_size - 1;
+        for (i = 0; i < dict->hash_size; i++) {
+            pair = dict->members[i];
+            if (pair && ((pair->key_hash & mask) != i)) {
+                moved = pair;
+                break;
+            }
+        }
+    }
+
+    /* deleting the pair in its home slot moves a pair of the cluster back,
+     * without losing the displaced one */
+    mask = dict->hash_size - 1;
+    i = moved->key_hash & mask;
+    pair = dict->members[i];
+    dict_del(dict, pair->key);
+    assert_int_equal(dict->count, count - 1);
+    assert_non_null(dict->members[i]);
+    assert_ptr_equal(dict_get(dict, moved->key), moved->value);
+    helper_check_index(dict);
+
+    /* delete the others one at a time, every third first */
+    for (i = 0; i < 3; i++) {
+        while ((pair = dict->members_list) != NULL) {
+            while (pair && (data_to_int32(pair->value) % 3 != i))
+                pair = pair->next;
+            if (!pair)
+                break;
+            dict_del(dict, pair->key);
+            helper_check_index(dict);
+        }
+    }
+    assert_int_equal(dict->count, 0);
+    assert_null(dict->members_list);
+
+    /* still usable once empty */
+    helper_add_keys(dict, 0, 20);
+    helper_check_index(dict);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_iterate_after_delete(void **state)
+{
+    dict_t *dict;
+    int keys[32] = {
+        0,
+    };
+    int i;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    helper_add_keys(dict, 0, 20);
+    for (i = 0; i < 20; i += 2) {
+        char key[64];
+
+        helper_key(key, sizeof(key), i);
+        dict_del(dict, key);
+    }
+
+    /* the most recently added first, deleted ones skipped */
+    assert_int_equal(dict_foreach(dict, helper_collect_key, keys), 0);
+    assert_int_equal(keys[0], 10);
+    for (i = 0; i < 10; i++)
+        assert_int_equal(keys[i + 1], 19 - i * 2);
+
+    /* a new key goes first, reusing a freed inline pair */
+    helper_add_keys(dict, 20, 21);
+    keys[0] = 0;
+    assert_int_equal(dict_foreach(dict, helper_collect_key, keys), 0);
+    assert_int_equal(keys[0], 11);
+    assert_int_equal(keys[1], 20);
+    for (i = 0; i < 10; i++)
+        assert_int_equal(keys[i + 2], 19 - i * 2);
+
+    helper_check_index(dict);
+
+    dict_unref(dict);
+}
+
+static void
+test_dict_copy_and_serialize(void **state)
+{
+    dict_t *dict;
+    dict_t *copy;
+    dict_t *unser = NULL;
+    char bin[] = "binary\0value";
+    char *buf;
+    char *str = NULL;
+    int32_t len;
+    int i;
+
+    dict = dict_new();
+    assert_non_null(dict);
+
+    /* interned and regular keys, values of several types */
+    assert_int_equal(dict_set_int32(dict, GLUSTERFS_INODELK_COUNT, 1), 0);
+    assert_int_equal(dict_set_str(dict, "trusted.glusterfs.dht", "layout"),
+                     0);
+    assert_int_equal(dict_set_uint64(dict, "unittest-u64", UINT64_MAX), 0);
+    assert_int_equal(dict_set_static_bin(dict, "unittest-bin", bin,
+                                         sizeof(bin)),
+                     0);
+    assert_int_equal(dict_set_str(dict, "unittest-str", "value"), 0);
+
+    for (i = 0; i < 2; i++) {
+        copy = dict_copy_with_ref(dict, NULL);
+        assert_non_null(copy);
+        helper_check_equal(dict, copy);
+        helper_check_index(copy);
+        dict_unref(copy);
+
+        copy = dict_ref(dict_copy(dict, NULL));
+        assert_non_null(copy);
+        helper_check_equal(dict, copy);
+        /* sized for the dict it copies */
+        if (dict->count > DICT_INDEX_THRESHOLD)
+            assert_true(copy->hash_size >= dict->count * 2);
+        helper_check_index(copy);
+        dict_unref(copy);
+
+        len = dict_serialized_length(dict);
+        assert_true(len > 0);
+        buf = GF_MALLOC(len, gf_common_mt_char);
+        assert_non_null(buf);
+        assert_int_equal(dict_serialize(dict, buf), 0);
+
+        unser = dict_new();
+        assert_non_null(unser);
+        assert_int_equal(dict_unserialize(buf, len, &unser), 0);
+        helper_check_equal(dict, unser);
+        helper_check_index(unser);
+        assert_int_equal(dict_serialized_length(unser), len);
+        assert_int_equal(dict_get_str(unser, "unittest-str", &str), 0);
+        assert_string_equal(str, "value");
+
+        /* the data may point into buf */
+        dict_unref(unser);
+        GF_FREE(buf);
+
+        /* again with an index */
+        helper_add_keys(dict, 0, 100);
+    }
+
+    dict_unref(dict);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_dict_tests[] = {
+        cmocka_unit_test(test_dict_inline_pairs),
+        cmocka_unit_test(test_dict_grow_and_rehash),
+        cmocka_unit_test(test_dict_del_collisions),
+        cmocka_unit_test(test_dict_iterate_after_delete),
+        cmocka_unit_test(test_dict_copy_and_serialize),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_dict_tests, helper_setup,
+                                  NULL);
+}
@@ -0,0 +1,291 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Contention benchmark for the inode table.
+ *
+ * A set of inodes is linked under the root directory and then several
+ * threads run a metadata-like workload on them (inode_find(), inode_grep(),
+ * inode_link() and the matching inode_unref()). The test is repeated for
+ * an increasing number of threads, with and without lock striping, and the
+ * aggregated throughput is printed.
+ *
+ * Usage: inode_table_bench [-n inodes] [-s stripes] [-t max-threads]
+ *                          [-d seconds] [-l]
+ *
+ * With -l the benchmark doesn't keep a reference on the inodes, so most
+ * lookups need to move them out of the lru list.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <inttypes.h>
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/inode.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/common-utils.h"
+
+typedef struct {
+    inode_table_t *table;
+    inode_t **inodes;
+    char (*names)[32];
+    uint32_t count;
+    volatile int stop;
+} bench_ctx_t;
+
+typedef struct {
+    bench_ctx_t *bench;
+    pthread_t thread;
+    uint64_t ops;
+    uint32_t seed;
+} bench_thread_t;
+
+static xlator_t bench_xl;
+static glusterfs_graph_t bench_graph;
+
+static void *
+bench_worker(void *data)
+{
+    bench_thread_t *bt = data;
+    bench_ctx_t *bench = bt->bench;
+    inode_table_t *table = bench->table;
+    inode_t *inode = NULL;
+    inode_t *linked = NULL;
+    struct iatt iatt = {
+        0,
+    };
+    uint32_t idx = 0;
+    uint64_t ops = 0;
+
+    THIS = &bench_xl;
+
+    while (!bench->stop) {
+        idx = rand_r(&bt->seed) % bench->count;
+
+        /* Resolve by gfid, as protocol/server does for most fops. */
+        inode = inode_find(table, bench->inodes[idx]->gfid);
+        if (inode)
+            inode_unref(inode);
+
+        /* Resolve by name, as a path based lookup does. */
+        inode = inode_grep(table, table->root, bench->names[idx]);
+        if (inode)
+            inode_unref(inode);
+
+        /* Link an already known entry again, as a lookup reply does. */
+        if ((ops & 7) == 0) {
+            gf_uuid_copy(iatt.ia_gfid, bench->inodes[idx]->gfid);
+            iatt.ia_type = IA_IFREG;
+            linked = inode_link(bench->inodes[idx], table->root,
+                                bench->names[idx], &iatt);
+            if (linked)
+                inode_unref(linked);
+        }
+
+        ops += 2 + ((ops & 7) == 0);
+    }
+
+    bt->ops = ops;
+
+    return NULL;
+}
+
+static double
+bench_run(bench_ctx_t *bench, uint32_t threads, uint32_t seconds)
+{
+    bench_thread_t *bt = NULL;
+    uint64_t total = 0;
+    uint32_t i = 0;
+
+    bt = calloc(threads, sizeof(*bt));
+    if (!bt)
+        return 0;
+
+    bench->stop = 0;
+    for (i = 0; i < threads; i++) {
+        bt[i].bench = bench;
+        bt[i].seed = i + 1;
+        if (pthread_create(&bt[i].thread, NULL, bench_worker, &bt[i]) != 0) {
+            threads = i;
+            break;
+        }
+    }
+
+    sleep(seconds);
+    bench->stop = 1;
+
+    for (i = 0; i < threads; i++) {
+        pthread_join(bt[i].thread, NULL);
+        total += bt[i].ops;
+    }
+
+    free(bt);
+
+    return (double)total / seconds;
+}
+
+static int
+bench_setup(bench_ctx_t *bench, uint32_t count, uint32_t stripes,
+            gf_boolean_t hold)
+{
+    struct iatt iatt = {
+        0,
+    };
+    inode_t *inode = NULL;
+    uint32_t i = 0;
+
+    bench->table = inode_table_new(count * 2, &bench_xl);
+    if (!bench->table)
+        return -1;
+
+    if (stripes && inode_table_set_lock_stripes(bench->table, stripes) != 0)
+        return -1;
+
+    /* The root inode is kept active by the mount in real life. */
+    inode_ref(bench->table->root);
+
+    bench->count = count;
+    bench->inodes = calloc(count, sizeof(*bench->inodes));
+    bench->names = calloc(count, sizeof(*bench->names));
+    if (!bench->inodes || !bench->names)
+        return -1;
+
+    for (i = 0; i < count; i++) {
+        inode = inode_new(bench->table);
+        if (!inode)
+            return -1;
+
+        gf_uuid_generate(iatt.ia_gfid);
+        iatt.ia_type = IA_IFREG;
+        snprintf(bench->names[i], sizeof(bench->names[i]), "file-%u", i);
+
+        bench->inodes[i] = inode_link(inode, bench->table->root,
+                                      bench->names[i], &iatt);
+        inode_lookup(bench->inodes[i]);
+        inode_unref(inode);
+        if (!hold)
+            inode_unref(bench->inodes[i]);
+    }
+
+    return 0;
+}
+
+static void
+bench_teardown(bench_ctx_t *bench, gf_boolean_t hold)
+{
+    uint32_t i = 0;
+
+    if (hold) {
+        for (i = 0; i < bench->count; i++)
+            inode_unref(bench->inodes[i]);
+    }
+
+    inode_table_destroy(bench->table);
+    free(bench->inodes);
+    free(bench->names);
+    memset(bench, 0, sizeof(*bench));
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    bench_ctx_t bench = {
+        0,
+    };
+    uint32_t count = 100000;
+    uint32_t stripes = 256;
+    uint32_t max_threads = 32;
+    uint32_t seconds = 3;
+    uint32_t threads = 0;
+    gf_boolean_t hold = _gf_true;
+    double base = 0;
+    double striped = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:s:t:d:l")) != -1) {
+        switch (opt) {
+            case 'n':
+                count = strtoul(optarg, NULL, 0);
+                break;
+            case 's':
+                stripes = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                max_threads = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                seconds = strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                hold = _gf_false;
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n inodes] [-s stripes] "
+                        "[-t max-threads] [-d seconds] [-l]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    if (!count || !seconds || !max_threads) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx) != 0) {
+        fprintf(stderr, "failed to initialize glusterfs context\n");
+        return 1;
+    }
+    THIS->ctx = ctx;
+
+    bench_graph.xl_count = 1;
+    bench_xl.name = "inode-table-bench";
+    bench_xl.ctx = ctx;
+    bench_xl.graph = &bench_graph;
+    bench_xl.xl_id = 0;
+    THIS = &bench_xl;
+
+    printf("inodes: %u, stripes: %u, %s\n", count, stripes,
+           hold ? "active inodes" : "lru inodes");
+    printf("%8s %16s %16s %8s\n", "threads", "single (ops/s)",
+           "striped (ops/s)", "speedup");
+
+    for (threads = 1; threads <= max_threads; threads *= 2) {
+        if (bench_setup(&bench, count, 0, hold) != 0)
+            goto err;
+        base = bench_run(&bench, threads, seconds);
+        bench_teardown(&bench, hold);
+
+        if (bench_setup(&bench, count, stripes, hold) != 0)
+            goto err;
+        striped = bench_run(&bench, threads, seconds);
+        bench_teardown(&bench, hold);
+
+        printf("%8u %16.0f %16.0f %7.2fx\n", threads, base, striped,
+               base ? striped / base : 0);
+    }
+
+    return 0;
+
+err:
+    fprintf(stderr, "failed to set up the inode table\n");
+    return 1;
+}
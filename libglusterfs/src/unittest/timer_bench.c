@@ -0,0 +1,361 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Benchmark for gf_timer_call_after() and gf_timer_call_cancel().
+ *
+ * It keeps a large number of timers outstanding, like a client connected
+ * to many bricks does with its ping and call-bail timers, and measures:
+ *
+ *   - the rate at which they can be added and cancelled,
+ *   - the rate of cancel + add of a random one, which is what every rpc
+ *     request does with the ping timer,
+ *   - how late short timers fire while all the others are pending.
+ *
+ * Several threads can add and cancel timers at the same time, and several
+ * timer wheels can be used, each thread using the same one for all its
+ * timers.
+ *
+ * Usage: timer_bench [-n timers] [-t threads] [-w wheels] [-d seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/timer.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/common-utils.h"
+
+#define BENCH_PROBES 1000
+
+typedef struct {
+    pthread_t th;
+    gf_timer_t **timers;
+    uint32_t count;
+    uint32_t seed;
+    uint64_t ops;
+    double add;
+    double cancel;
+    int ret;
+} bench_thread_t;
+
+static glusterfs_ctx_t *bench_ctx;
+static xlator_t bench_xl;
+static uint32_t bench_seconds = 2;
+
+static pthread_mutex_t bench_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t bench_cond = PTHREAD_COND_INITIALIZER;
+static uint32_t bench_fired;
+static double bench_late_sum;
+static double bench_late_max;
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void
+bench_never(void *data)
+{
+    fprintf(stderr, "unexpected timer fired\n");
+    abort();
+}
+
+static void
+bench_probe(void *data)
+{
+    double *at = data;
+    double late = bench_now() - *at;
+
+    pthread_mutex_lock(&bench_lock);
+    {
+        bench_late_sum += late;
+        if (late > bench_late_max)
+            bench_late_max = late;
+        if (++bench_fired == BENCH_PROBES)
+            pthread_cond_signal(&bench_cond);
+    }
+    pthread_mutex_unlock(&bench_lock);
+}
+
+/* between 10 and 60 minutes, they never fire during the benchmark */
+static struct timespec
+bench_delay(uint32_t *seed)
+{
+    struct timespec delta;
+
+    delta.tv_sec = 600 + rand_r(seed) % 3000;
+    delta.tv_nsec = rand_r(seed) % 1000000000;
+
+    return delta;
+}
+
+static gf_timer_t *
+bench_add(uint32_t *seed)
+{
+    return gf_timer_call_after(bench_ctx, bench_delay(seed), bench_never,
+                               NULL);
+}
+
+static void *
+bench_fill(void *data)
+{
+    bench_thread_t *bt = data;
+    double start = 0;
+    uint32_t i = 0;
+
+    THIS = &bench_xl;
+
+    start = bench_now();
+    for (i = 0; i < bt->count; i++) {
+        bt->timers[i] = bench_add(&bt->seed);
+        if (!bt->timers[i]) {
+            bt->ret = -1;
+            return NULL;
+        }
+    }
+    bt->add = bench_now() - start;
+
+    return NULL;
+}
+
+static void *
+bench_churn(void *data)
+{
+    bench_thread_t *bt = data;
+    double start = bench_now();
+    uint32_t i = 0;
+    int n = 0;
+
+    THIS = &bench_xl;
+
+    bt->ops = 0;
+    do {
+        for (n = 0; n < 256; n++) {
+            i = rand_r(&bt->seed) % bt->count;
+            if (gf_timer_call_cancel(bench_ctx, bt->timers[i]) != 0) {
+                bt->ret = -1;
+                return NULL;
+            }
+            bt->timers[i] = bench_add(&bt->seed);
+            if (!bt->timers[i]) {
+                bt->ret = -1;
+                return NULL;
+            }
+        }
+        bt->ops += 256;
+    } while (bench_now() - start < bench_seconds);
+    bt->add = bench_now() - start;
+
+    return NULL;
+}
+
+static void *
+bench_drain(void *data)
+{
+    bench_thread_t *bt = data;
+    double start = 0;
+    uint32_t i = 0;
+    uint32_t j = 0;
+    gf_timer_t *tmp = NULL;
+
+    THIS = &bench_xl;
+
+    /* cancel them in random order */
+    for (i = bt->count - 1; i > 0; i--) {
+        j = rand_r(&bt->seed) % (i + 1);
+        tmp = bt->timers[i];
+        bt->timers[i] = bt->timers[j];
+        bt->timers[j] = tmp;
+    }
+
+    start = bench_now();
+    for (i = 0; i < bt->count; i++) {
+        if (gf_timer_call_cancel(bench_ctx, bt->timers[i]) != 0) {
+            bt->ret = -1;
+            return NULL;
+        }
+    }
+    bt->cancel = bench_now() - start;
+
+    return NULL;
+}
+
+static int
+bench_run(bench_thread_t *threads, uint32_t count, void *(*fn)(void *))
+{
+    uint32_t i = 0;
+
+    for (i = 0; i < count; i++) {
+        if (pthread_create(&threads[i].th, NULL, fn, &threads[i]) != 0)
+            return -1;
+    }
+
+    for (i = 0; i < count; i++) {
+        pthread_join(threads[i].th, NULL);
+        if (threads[i].ret)
+            return -1;
+    }
+
+    return 0;
+}
+
+/* short timers fired while all the others are pending */
+static int
+bench_lateness(void)
+{
+    static double at[BENCH_PROBES];
+    struct timespec delta;
+    uint32_t seed = 1;
+    uint64_t ms = 0;
+    int i = 0;
+
+    for (i = 0; i < BENCH_PROBES; i++) {
+        ms = 10 + rand_r(&seed) % 490;
+        delta.tv_sec = 0;
+        delta.tv_nsec = ms * 1000000;
+        at[i] = bench_now() + ms / 1e3;
+        if (!gf_timer_call_after(bench_ctx, delta, bench_probe, &at[i]))
+            return -1;
+    }
+
+    pthread_mutex_lock(&bench_lock);
+    {
+        while (bench_fired < BENCH_PROBES)
+            pthread_cond_wait(&bench_cond, &bench_lock);
+    }
+    pthread_mutex_unlock(&bench_lock);
+
+    printf("%-24s %9.3f ms avg %9.3f ms max\n", "lateness",
+           bench_late_sum * 1e3 / BENCH_PROBES, bench_late_max * 1e3);
+
+    return 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+    bench_thread_t *threads = NULL;
+    uint32_t timers = 100000;
+    uint32_t nthreads = 1;
+    uint32_t wheels = 1;
+    uint64_t ops = 0;
+    double add = 0;
+    double cancel = 0;
+    uint32_t i = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "n:t:w:d:")) != -1) {
+        switch (opt) {
+            case 'n':
+                timers = strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                nthreads = strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                wheels = strtoul(optarg, NULL, 0);
+                break;
+            case 'd':
+                bench_seconds = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-n timers] [-t threads] [-w wheels] "
+                        "[-d seconds]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    if (!nthreads || timers < nthreads || !wheels ||
+        wheels > GF_TIMER_MAX_WHEELS || !bench_seconds) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    mem_pools_init();
+
+    bench_ctx = glusterfs_ctx_new();
+    if (!bench_ctx || glusterfs_globals_init(bench_ctx) != 0) {
+        fprintf(stderr, "failed to initialize glusterfs context\n");
+        return 1;
+    }
+    THIS->ctx = bench_ctx;
+    bench_ctx->cmd_args.timer_wheels = wheels;
+
+    bench_xl.name = "timer-bench";
+    bench_xl.ctx = bench_ctx;
+    THIS = &bench_xl;
+
+    threads = calloc(nthreads, sizeof(*threads));
+    if (!threads)
+        goto err;
+
+    for (i = 0; i < nthreads; i++) {
+        threads[i].count = timers / nthreads;
+        threads[i].seed = i + 1;
+        threads[i].timers = calloc(threads[i].count, sizeof(gf_timer_t *));
+        if (!threads[i].timers)
+            goto err;
+    }
+
+    printf("%u timers, %u threads, %u wheels\n", timers, nthreads, wheels);
+
+    if (bench_run(threads, nthreads, bench_fill))
+        goto err;
+    for (i = 0; i < nthreads; i++) {
+        if (threads[i].add > add)
+            add = threads[i].add;
+    }
+    printf("%-24s %12.0f ops/s\n", "add", timers / add);
+
+    if (bench_lateness())
+        goto err;
+
+    if (bench_run(threads, nthreads, bench_churn))
+        goto err;
+    add = 0;
+    for (i = 0; i < nthreads; i++) {
+        ops += threads[i].ops;
+        if (threads[i].add > add)
+            add = threads[i].add;
+    }
+    printf("%-24s %12.0f ops/s\n", "cancel + add", ops / add);
+
+    if (bench_run(threads, nthreads, bench_drain))
+        goto err;
+    for (i = 0; i < nthreads; i++) {
+        if (threads[i].cancel > cancel)
+            cancel = threads[i].cancel;
+    }
+    printf("%-24s %12.0f ops/s\n", "cancel", timers / cancel);
+
+    gf_timer_registry_destroy(bench_ctx);
+
+    return 0;
+
+err:
+    fprintf(stderr, "benchmark failed\n");
+    return 1;
+}
@@ -0,0 +1,352 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* The wheel is driven by hand, tick by tick, through the static functions
+ * of timer.c, so that the tests don't depend on the clock. */
+#include "../timer.c"
+
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <inttypes.h>
+#include <string.h>
+#include <cmocka_pbc.h>
+#include <cmocka.h>
+
+static glusterfs_ctx_t *helper_ctx;
+
+/*
+ * Helper functions
+ */
+static void
+helper_cbk(void *data)
+{
+    int *fired = data;
+
+    (*fired)++;
+}
+
+static void
+helper_wheel_init(gf_timer_wheel_t *wheel, uint64_t base)
+{
+    memset(wheel, 0, sizeof(*wheel));
+    gf_timer_wheel_init(wheel);
+    wheel->base = base;
+}
+
+static void
+helper_wheel_fini(gf_timer_wheel_t *wheel)
+{
+    assert_int_equal(wheel->count, 0);
+    pthread_cond_destroy(&wheel->cond);
+    pthread_mutex_destroy(&wheel->lock);
+}
+
+static gf_timer_t *
+helper_add(gf_timer_wheel_t *wheel, uint64_t expires, int *fired)
+{
+    gf_timer_t *event;
+
+    event = GF_CALLOC(1, sizeof(*event), gf_common_mt_gf_timer_t);
+    assert_non_null(event);
+
+    event->expires = expires;
+    event->callbk = helper_cbk;
+    event->data = fired;
+    event->wheel = wheel;
+
+    __gf_timer_wheel_add(wheel, event);
+    wheel->count++;
+
+    return event;
+}
+
+/* Runs the wheel as gf_timer_proc() does until some timers expire, and
+ * returns the tick at which they did, or UINT64_MAX if nothing is left. */
+static uint64_t
+helper_run(gf_timer_wheel_t *wheel, struct list_head *expired)
+{
+    uint64_t next;
+
+    while ((next = __gf_timer_wheel_next(wheel)) != UINT64_MAX) {
+        assert_true(next >= wheel->base);
+        wheel->base = next;
+        __gf_timer_wheel_tick(wheel, expired);
+        if (!list_empty(expired))
+            return next;
+    }
+
+    return UINT64_MAX;
+}
+
+static void
+helper_check_empty(gf_timer_wheel_t *wheel)
+{
+    int n;
+
+    for (n = 0; n < GF_TIMER_ROOT_SIZE / 64; n++)
+        assert_int_equal(wheel->root_map[n], 0);
+    for (n = 0; n < GF_TIMER_LEVELS; n++)
+        assert_int_equal(wheel->level_map[n], 0);
+    assert_int_equal(__gf_timer_wheel_next(wheel), UINT64_MAX);
+}
+
+static int
+helper_setup(void **state)
+{
+    mem_pools_init();
+
+    helper_ctx = glusterfs_ctx_new();
+    if (!helper_ctx || glusterfs_globals_init(helper_ctx) != 0)
+        return -1;
+    THIS->ctx = helper_ctx;
+
+    return 0;
+}
+
+/*
+ * Unit tests
+ */
+static void
+test_timer_root(void **state)
+{
+    gf_timer_wheel_t wheel;
+    struct list_head expired;
+    uint64_t base = 1000003;
+    uint64_t deltas[] = {0, 1, 2, 100, GF_TIMER_ROOT_SIZE - 1};
+    int fired = 0;
+    int i;
+
+    INIT_LIST_HEAD(&expired);
+    helper_wheel_init(&wheel, base);
+
+    for (i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++)
+        helper_add(&wheel, base + deltas[i], &fired);
+
+    for (i = 0; i < sizeof(deltas) / sizeof(deltas[0]); i++) {
+        assert_int_equal(helper_run(&wheel, &expired), base + deltas[i]);
+        gf_timer_fire(&expired);
+        assert_int_equal(fired, i + 1);
+    }
+
+    assert_int_equal(helper_run(&wheel, &expired), UINT64_MAX);
+    helper_check_empty(&wheel);
+    helper_wheel_fini(&wheel);
+}
+
+static void
+test_timer_cascade(void **state)
+{
+    gf_timer_wheel_t wheel;
+    struct list_head expired;
+    gf_timer_t *event;
+    uint64_t base = 0x123456789ULL;
+    uint64_t expires[64];
+    uint64_t last = 0;
+    uint64_t tick;
+    uint64_t seed = 42;
+    int count = 0;
+    int fired = 0;
+    int n;
+    int i;
+
+    INIT_LIST_HEAD(&expired);
+    helper_wheel_init(&wheel, base);
+
+    /* around the boundaries of every level */
+    for (n = 0; n < GF_TIMER_LEVELS; n++) {
+        expires[count++] = base + (1ULL << GF_TIMER_LEVEL_SHIFT(n)) - 1;
+        expires[count++] = base + (1ULL << GF_TIMER_LEVEL_SHIFT(n));
+        expires[count++] = base + (1ULL << GF_TIMER_LEVEL_SHIFT(n)) + 1;
+    }
+    /* and spread over the levels below the last one */
+    while (count < 64) {
+        seed = seed * 6364136223846793005ULL + 1442695040888963407ULL;
+        expires[count++] = base + (seed >> 40) % (1ULL << 26);
+    }
+
+    for (i = 0; i < count; i++)
+        helper_add(&wheel, expires[i], &fired);
+
+    /* every timer fires exactly at its tick, in order */
+    while ((tick = helper_run(&wheel, &expired)) != UINT64_MAX) {
+        assert_true(tick >= last);
+        list_for_each_entry(event, &expired, list)
+        {
+            assert_int_equal(event->expires, tick);
+            assert_true(event->fired);
+        }
+        last = tick;
+        gf_timer_fire(&expired);
+    }
+
+    assert_int_equal(fired, count);
+    helper_check_empty(&wheel);
+    helper_wheel_fini(&wheel);
+}
+
+static void
+test_timer_cancel_pending(void **state)
+{
+    gf_timer_wheel_t wheel;
+    gf_timer_registry_t reg;
+    struct list_head expired;
+    gf_timer_t *events[8];
+    uint64_t base = 5000;
+    int fired = 0;
+
+    INIT_LIST_HEAD(&expired);
+    helper_wheel_init(&wheel, base);
+    helper_ctx->timer = &reg;
+
+    /* alone or not in their slot, in the root and in upper levels */
+    events[0] = helper_add(&wheel, base + 10, &fired);
+    events[1] = helper_add(&wheel, base + 10, &fired);
+    events[2] = helper_add(&wheel, base + 11, &fired);
+    events[3] = helper_add(&wheel, base + 1000, &fired);
+    events[4] = helper_add(&wheel, base + 1001, &fired);
+    events[5] = helper_add(&wheel, base + 100000, &fired);
+    events[6] = helper_add(&wheel, base + 100000, &fired);
+    events[7] = helper_add(&wheel, base + GF_TIMER_MAX_DELTA + 1, &fired);
+
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, events[0]), 0);
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, events[2]), 0);
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, events[3]), 0);
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, events[6]), 0);
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, events[7]), 0);
+    assert_int_equal(wheel.count, 3);
+
+    /* the slots of the cancelled timers are no longer visited */
+    assert_int_equal(helper_run(&wheel, &expired), base + 10);
+    gf_timer_fire(&expired);
+    assert_int_equal(helper_run(&wheel, &expired), base + 1001);
+    gf_timer_fire(&expired);
+    assert_int_equal(helper_run(&wheel, &expired), base + 100000);
+    gf_timer_fire(&expired);
+    assert_int_equal(fired, 3);
+
+    assert_int_equal(helper_run(&wheel, &expired), UINT64_MAX);
+    helper_check_empty(&wheel);
+
+    helper_ctx->timer = NULL;
+    helper_wheel_fini(&wheel);
+}
+
+static void
+test_timer_cancel_fired(void **state)
+{
+    gf_timer_wheel_t wheel;
+    gf_timer_registry_t reg;
+    struct list_head expired;
+    gf_timer_t *event;
+    uint64_t base = 7777;
+    int fired = 0;
+
+    INIT_LIST_HEAD(&expired);
+    helper_wheel_init(&wheel, base);
+    helper_ctx->timer = &reg;
+
+    event = helper_add(&wheel, base + 300, &fired);
+    assert_int_equal(helper_run(&wheel, &expired), base + 300);
+    assert_ptr_equal(list_first_entry(&expired, gf_timer_t, list), event);
+
+    /* being fired: the callback still runs, and frees it */
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, event), -1);
+    assert_int_equal(fired, 0);
+    gf_timer_fire(&expired);
+    assert_int_equal(fired, 1);
+
+    helper_check_empty(&wheel);
+
+    helper_ctx->timer = NULL;
+    helper_wheel_fini(&wheel);
+}
+
+static void
+test_timer_expired_and_far(void **state)
+{
+    gf_timer_wheel_t wheel;
+    struct list_head expired;
+    gf_timer_t *event;
+    uint64_t base = 1ULL << 40;
+    uint64_t far = base + GF_TIMER_MAX_DELTA + 12345;
+    int fired = 0;
+
+    INIT_LIST_HEAD(&expired);
+    helper_wheel_init(&wheel, base);
+
+    /* already expired: fires at the next tick processed */
+    helper_add(&wheel, base - 100, &fired);
+    helper_add(&wheel, 0, &fired);
+    assert_int_equal(helper_run(&wheel, &expired), base);
+    gf_timer_fire(&expired);
+    assert_int_equal(fired, 2);
+
+    /* beyond the wheel: parked in its last slot, then fires on time */
+    helper_add(&wheel, far, &fired);
+    event = helper_add(&wheel, UINT64_MAX / 2, &fired);
+    assert_int_equal(helper_run(&wheel, &expired), far);
+    gf_timer_fire(&expired);
+    assert_int_equal(fired, 3);
+
+    /* the other one is parked again, never further than the wheel */
+    assert_int_equal(wheel.count, 1);
+    assert_true(__gf_timer_wheel_next(&wheel) - wheel.base <=
+                GF_TIMER_MAX_DELTA + 1);
+    __gf_timer_wheel_del(&wheel, event);
+    wheel.count--;
+    GF_FREE(event);
+
+    helper_check_empty(&wheel);
+    helper_wheel_fini(&wheel);
+}
+
+static void
+test_timer_call_after(void **state)
+{
+    struct timespec delta = {
+        0,
+    };
+    gf_timer_t *event;
+    int fired = 0;
+    int i;
+
+    event = gf_timer_call_after(helper_ctx, delta, helper_cbk, &fired);
+    assert_non_null(event);
+    for (i = 0; (i < 1000) && !__atomic_load_n(&fired, __ATOMIC_ACQUIRE);
+         i++)
+        usleep(1000);
+    assert_int_equal(__atomic_load_n(&fired, __ATOMIC_ACQUIRE), 1);
+
+    delta.tv_sec = 3600;
+    event = gf_timer_call_after(helper_ctx, delta, helper_cbk, &fired);
+    assert_non_null(event);
+    assert_int_equal(gf_timer_call_cancel(helper_ctx, event), 0);
+
+    gf_timer_registry_destroy(helper_ctx);
+    assert_null(helper_ctx->timer);
+    assert_int_equal(fired, 1);
+}
+
+int
+main(void)
+{
+    const struct CMUnitTest libglusterfs_timer_tests[] = {
+        cmocka_unit_test(test_timer_root),
+        cmocka_unit_test(test_timer_cascade),
+        cmocka_unit_test(test_timer_cancel_pending),
+        cmocka_unit_test(test_timer_cancel_fired),
+        cmocka_unit_test(test_timer_expired_and_far),
+        cmocka_unit_test(test_timer_call_after),
+    };
+
+    return cmocka_run_group_tests(libglusterfs_timer_tests, helper_setup,
+                                  NULL);
+}
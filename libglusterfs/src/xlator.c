@@ -827,6 +827,8 @@ xlator_members_free(xlator_t *xl)
         GF_FREE(vol_opt);
     }
 
+    gf_latency_hist_free_all(xl);
+
     return 0;
 }
 
@@ -918,6 +920,8 @@ xlator_mem_free(xlator_t *xl)
         GF_FREE(vol_opt);
     }
 
+    gf_latency_hist_free_all(xl);
+
     xlator_memrec_free(xl);
 
     return 0;
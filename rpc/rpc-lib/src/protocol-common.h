@@ -346,6 +346,9 @@ typedef enum gf_getspec_flags_type gf_getspec_flags_type;
 
 #define GLUSTER_FOP_VERSION_v2 400 /* 4.0.0 */
 
+/* Maximum number of fops in a GFS3_OP_COMPOUND request */
+#define GF_COMPOUND_MAX_FOPS 16
+
 /* Aggregator */
 #define GLUSTER_AGGREGATOR_PROGRAM 29852134 /* Completely random */
 #define GLUSTER_AGGREGATOR_VERSION 1
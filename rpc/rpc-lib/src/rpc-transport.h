@@ -189,6 +189,8 @@ struct rpc_transport {
 
     uint64_t total_bytes_read;
     uint64_t total_bytes_write;
+    uint64_t total_msgs_write; /* messages written ... */
+    uint64_t total_writes;     /* ... with this many syscalls */
     uint32_t xid; /* RPC/XID used for callbacks */
     int32_t outstanding_rpc_count;
 
@@ -32,8 +32,14 @@
 
 #include <fcntl.h>
 #include <errno.h>
+#include <poll.h>
 #include <rpc/xdr.h>
 #include <sys/ioctl.h>
+
+#if defined(GF_LINUX_HOST_OS) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define SOCKET_ZEROCOPY 1
+#endif
 #define GF_LOG_ERRNO(errno) ((errno == ENOTCONN) ? GF_LOG_DEBUG : GF_LOG_ERROR)
 #define SA(ptr) ((struct sockaddr *)ptr)
 
@@ -736,8 +742,10 @@ __socket_rwv(rpc_transport_t *this, struct iovec *vector, int count,
             if (ret == 0 || (ret == -1 && errno == EAGAIN)) {
                 /* done for now */
                 break;
-            } else if (ret > 0)
+            } else if (ret > 0) {
                 this->total_bytes_write += ret;
+                this->total_writes++;
+            }
         } else {
             ret = __socket_cached_read(this, opvector, opcount);
             if (ret == 0) {
@@ -1047,6 +1055,24 @@ __socket_nodelay(int fd)
     return ret;
 }
 
+static int
+__socket_zerocopy(int fd)
+{
+    int ret = -1;
+#ifdef SOCKET_ZEROCOPY
+    int on = 1;
+
+    ret = setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &on, sizeof(on));
+    if (!ret)
+        gf_log(THIS->name, GF_LOG_TRACE, "ZEROCOPY enabled for socket %d",
+               fd);
+#else
+    errno = ENOTSUP;
+#endif
+
+    return ret;
+}
+
 static int
 __socket_keepalive(int fd, int family, int keepaliveintvl, int keepaliveidle,
                    int keepalivecnt, int timeout)
@@ -1154,9 +1180,14 @@ __socket_connect_finish(int fd)
     return ret;
 }
 
+static void
+__socket_ioq_entry_free(struct ioq *entry);
+
 static void
 __socket_reset(rpc_transport_t *this)
 {
+    struct ioq *entry = NULL;
+
     socket_private_t *priv = NULL;
 
     GF_VALIDATE_OR_GOTO("socket", this, out);
@@ -1193,6 +1224,15 @@ __socket_reset(rpc_transport_t *this)
     priv->sock = -1;
     priv->idx = -1;
     priv->connected = -1;
+    priv->zerocopy = 0;
+
+    /* the kernel numbers the MSG_ZEROCOPY sends of the next socket from 0,
+     * nothing will ever complete the entries sent on this one */
+    while (!list_empty(&priv->zc_ioq)) {
+        entry = list_first_entry(&priv->zc_ioq, struct ioq, list);
+        __socket_ioq_entry_free(entry);
+    }
+    priv->zc_next = 0;
     priv->ssl_connected = _gf_false;
     priv->ssl_accepted = _gf_false;
     priv->ssl_context_created = _gf_false;
@@ -1332,6 +1372,13 @@ __socket_ioq_flush(rpc_transport_t *this)
         __socket_ioq_entry_free(entry);
     }
 
+    while (!list_empty(&priv->zc_ioq)) {
+        entry = list_first_entry(&priv->zc_ioq, struct ioq, list);
+        __socket_ioq_entry_free(entry);
+    }
+
+    priv->ioq_pollout = 0;
+
 out:
     return;
 }
@@ -1348,11 +1395,180 @@ __socket_ioq_churn_entry(rpc_transport_t *this, struct ioq *entry, int direct)
         /* current entry was completely written */
         GF_ASSERT(entry->pending_count == 0);
         __socket_ioq_entry_free(entry);
+        this->total_msgs_write++;
     }
 
     return ret;
 }
 
+/* Consumes 'bytes' from a vector, returns what is left of them */
+static size_t
+__socket_iov_advance(struct iovec **vector, int *count, size_t bytes)
+{
+    struct iovec *iov = *vector;
+    int n = *count;
+
+    while (n > 0) {
+        if (iov->iov_len > bytes) {
+            iov->iov_base += bytes;
+            iov->iov_len -= bytes;
+            bytes = 0;
+            break;
+        }
+
+        bytes -= iov->iov_len;
+        iov++;
+        n--;
+    }
+
+    *vector = iov;
+    *count = n;
+
+    return bytes;
+}
+
+static void
+__socket_cork(socket_private_t *priv, int on)
+{
+#ifdef TCP_CORK
+    if (setsockopt(priv->sock, IPPROTO_TCP, TCP_CORK, &on, sizeof(on)) != 0)
+        gf_log(THIS->name, GF_LOG_DEBUG, "TCP_CORK on %d failed (%s)",
+               priv->sock, strerror(errno));
+#endif
+}
+
+/* Clears *zerocopy when the data had to be copied after all */
+static ssize_t
+__socket_sendv(socket_private_t *priv, struct iovec *vector, int count,
+               gf_boolean_t *zerocopy)
+{
+#ifdef SOCKET_ZEROCOPY
+    struct msghdr msg = {
+        0,
+    };
+    ssize_t ret = -1;
+
+    if (*zerocopy) {
+        msg.msg_iov = vector;
+        msg.msg_iovlen = count;
+
+        ret = sendmsg(priv->sock, &msg, MSG_ZEROCOPY);
+        /* out of optmem for the notifications, copy this time */
+        if ((ret != -1) || (errno != ENOBUFS))
+            return ret;
+    }
+#endif
+
+    *zerocopy = _gf_false;
+
+    return sys_writev(priv->sock, vector, count);
+}
+
+/* Writes the queued entries gathering the pending vectors of as many of them
+ * as fit in one writev(). Entries of at least zerocopy_threshold bytes are
+ * sent with MSG_ZEROCOPY, and the socket is corked while a burst needs more
+ * than one call. Returns like __socket_rwv(): 0 when the queue is empty,
+ * > 0 when the socket is full and -1 on error. */
+static int
+__socket_ioq_churn_batch(rpc_transport_t *this)
+{
+    socket_private_t *priv = this->private;
+    struct iovec vector[IOV_MAX];
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    gf_boolean_t zerocopy = _gf_false;
+    gf_boolean_t corked = _gf_false;
+    size_t bytes = 0;
+    ssize_t ret = 0;
+    int count = 0;
+
+    priv->ioq_deferred = 0;
+
+    while (!list_empty(&priv->ioq)) {
+        count = 0;
+        zerocopy = _gf_false;
+
+        list_for_each_entry(entry, &priv->ioq, list)
+        {
+            if (count + entry->pending_count > IOV_MAX)
+                break;
+
+            memcpy(&vector[count], entry->pending_vector,
+                   entry->pending_count * sizeof(*vector));
+            count += entry->pending_count;
+
+            if (priv->zerocopy &&
+                (iov_length(entry->pending_vector, entry->pending_count) >=
+                 priv->zerocopy_threshold))
+                zerocopy = _gf_true;
+        }
+
+        if (!corked && (&entry->list != &priv->ioq)) {
+            __socket_cork(priv, 1);
+            corked = _gf_true;
+        }
+
+        ret = __socket_sendv(priv, vector, count, &zerocopy);
+        if (ret == -1) {
+            if (errno == EINTR)
+                continue;
+            if (errno == EAGAIN) {
+                ret = 1;
+                break;
+            }
+
+            if (__does_socket_rwv_error_need_logging(priv, 1)) {
+                GF_LOG_OCCASIONALLY(priv->log_ctr, this->name, GF_LOG_WARNING,
+                                    "writev on %s failed (%s)",
+                                    this->peerinfo.identifier, strerror(errno));
+            }
+            break;
+        }
+
+        if (ret == 0) {
+            /* done for now */
+            ret = 1;
+            break;
+        }
+
+        this->total_bytes_write += ret;
+        this->total_writes++;
+
+        bytes = ret;
+        list_for_each_entry_safe(entry, tmp, &priv->ioq, list)
+        {
+            if (zerocopy) {
+                entry->zc_id = priv->zc_next;
+                entry->zc_pending = _gf_true;
+            }
+
+            bytes = __socket_iov_advance(&entry->pending_vector,
+                                         &entry->pending_count, bytes);
+            if (entry->pending_count)
+                break;
+
+            this->total_msgs_write++;
+            if (entry->zc_pending)
+                list_move_tail(&entry->list, &priv->zc_ioq);
+            else
+                __socket_ioq_entry_free(entry);
+
+            if (!bytes)
+                break;
+        }
+
+        if (zerocopy)
+            priv->zc_next++;
+
+        ret = 0;
+    }
+
+    if (corked)
+        __socket_cork(priv, 0);
+
+    return ret;
+}
+
 static int
 __socket_ioq_churn(rpc_transport_t *this)
 {
@@ -1365,20 +1581,25 @@ __socket_ioq_churn(rpc_transport_t *this)
 
     priv = this->private;
 
-    while (!list_empty(&priv->ioq)) {
-        /* pick next entry */
-        entry = priv->ioq_next;
+    if (!priv->use_ssl) {
+        ret = __socket_ioq_churn_batch(this);
+    } else {
+        while (!list_empty(&priv->ioq)) {
+            /* pick next entry */
+            entry = priv->ioq_next;
 
-        ret = __socket_ioq_churn_entry(this, entry, 0);
+            ret = __socket_ioq_churn_entry(this, entry, 0);
 
-        if (ret != 0)
-            break;
+            if (ret != 0)
+                break;
+        }
     }
 
     if (list_empty(&priv->ioq)) {
         /* all pending writes done, not interested in POLLOUT */
         priv->idx = gf_event_select_on(this->ctx->event_pool, priv->sock,
                                        priv->idx, -1, 0);
+        priv->ioq_pollout = 0;
     }
 
 out:
@@ -2955,6 +3176,75 @@ socket_complete_connection(rpc_transport_t *this)
     return ret;
 }
 
+/* Zerocopy completions are reported through the error queue of the socket,
+ * which shows up as POLLERR. Releases the entries whose pages the kernel
+ * doesn't use anymore and returns whether there is a real error left.
+ *
+ * A message of the error queue can't be peeked, so anything else found
+ * there has been consumed already: it is logged and reported as an error,
+ * and the socket is disconnected as for any other POLLERR. */
+static int
+socket_event_zerocopy(rpc_transport_t *this)
+{
+    int ret = 1;
+#ifdef SOCKET_ZEROCOPY
+    socket_private_t *priv = this->private;
+    char control[CMSG_SPACE(sizeof(struct sock_extended_err))];
+    struct sock_extended_err *serr = NULL;
+    struct msghdr msg = {
+        0,
+    };
+    struct cmsghdr *cm = NULL;
+    struct ioq *entry = NULL;
+    struct ioq *tmp = NULL;
+    struct pollfd pfd = {
+        0,
+    };
+    int error = 0;
+
+    pthread_mutex_lock(&priv->out_lock);
+    {
+        for (;;) {
+            msg.msg_control = control;
+            msg.msg_controllen = sizeof(control);
+
+            if (recvmsg(priv->sock, &msg, MSG_ERRQUEUE) == -1)
+                break;
+
+            cm = CMSG_FIRSTHDR(&msg);
+            serr = cm ? (struct sock_extended_err *)CMSG_DATA(cm) : NULL;
+            if (!serr || (serr->ee_origin != SO_EE_ORIGIN_ZEROCOPY)) {
+                gf_log(this->name, GF_LOG_WARNING,
+                       "unexpected message on the error queue of sock:%d "
+                       "(origin %d): %s",
+                       priv->sock, serr ? serr->ee_origin : -1,
+                       strerror(serr ? serr->ee_errno : EIO));
+                error = 1;
+                break;
+            }
+
+            /* ids are 32-bit counters that wrap around */
+            list_for_each_entry_safe(entry, tmp, &priv->zc_ioq, list)
+            {
+                if ((entry->zc_id - serr->ee_info) <=
+                    (serr->ee_data - serr->ee_info))
+                    __socket_ioq_entry_free(entry);
+            }
+        }
+
+        pfd.fd = priv->sock;
+        pfd.events = POLLIN;
+        if (error)
+            ret = 1;
+        else if (poll(&pfd, 1, 0) >= 0)
+            ret = !!(pfd.revents & (POLLERR | POLLHUP | POLLNVAL));
+    }
+    pthread_mutex_unlock(&priv->out_lock);
+#endif
+
+    return ret;
+}
+
 /* reads rpc_requests during pollin */
 static void
 socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
@@ -2988,6 +3278,9 @@ socket_event_handler(int fd, int idx, int gen, void *data, int poll_in,
     }
     pthread_mutex_unlock(&priv->out_lock);
 
+    if (poll_err && priv->zerocopy)
+        poll_err = socket_event_zerocopy(this);
+
     gf_log(this->name, GF_LOG_TRACE, "%s (sock:%d) in:%d, out:%d, err:%d",
            (priv->is_server ? "server" : "client"), priv->sock, poll_in,
            poll_out, poll_err);
@@ -3258,6 +3551,17 @@ socket_server_event_handler(int fd, int idx, int gen, void *data, int poll_in,
 
         new_priv->sock = new_sock;
 
+        new_priv->zerocopy_threshold = priv->zerocopy_threshold;
+        if (!new_priv->use_ssl && new_priv->zerocopy_threshold &&
+            (new_sockaddr.ss_family != AF_UNIX)) {
+            if (__socket_zerocopy(new_sock) == 0)
+                new_priv->zerocopy = 1;
+            else
+                gf_log(this->name, GF_LOG_DEBUG,
+                       "setsockopt() failed for ZEROCOPY (%s)",
+                       strerror(errno));
+        }
+
         new_priv->ssl_enabled = priv->ssl_enabled;
         new_priv->connected = 1;
         new_priv->is_server = _gf_true;
@@ -3538,6 +3842,16 @@ socket_connect(rpc_transport_t *this, int port)
             }
         }
 
+        if (!priv->use_ssl && priv->zerocopy_threshold &&
+            (sa_family != AF_UNIX)) {
+            if (__socket_zerocopy(priv->sock) == 0)
+                priv->zerocopy = 1;
+            else
+                gf_log(this->name, GF_LOG_DEBUG,
+                       "ZEROCOPY on %d failed (%s)", priv->sock,
+                       strerror(errno));
+        }
+
         if (priv->keepalive && sa_family != AF_UNIX) {
             ret = __socket_keepalive(priv->sock, sa_family,
                                      priv->keepaliveintvl, priv->keepaliveidle,
@@ -3868,6 +4182,7 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
     int ret = -1;
     char need_poll_out = 0;
     char need_append = 1;
+    int churn = 0;
     struct ioq *entry = NULL;
     glusterfs_ctx_t *ctx = NULL;
     socket_private_t *priv = NULL;
@@ -3878,7 +4193,9 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
     priv = this->private;
     ctx = this->ctx;
 
+    GF_ATOMIC_INC(priv->out_waiters);
     pthread_mutex_lock(&priv->out_lock);
+    GF_ATOMIC_DEC(priv->out_waiters);
     {
         if (priv->connected != 1) {
             if (!priv->submit_log && !priv->connect_finish_log) {
@@ -3891,28 +4208,52 @@ socket_submit_outgoing_msg(rpc_transport_t *this, rpc_transport_msg_t *msg)
 
         priv->submit_log = 0;
         entry = __socket_ioq_new(this, msg);
-        if (!entry)
-            goto unlock;
 
-        if (list_empty(&priv->ioq)) {
-            ret = __socket_ioq_churn_entry(this, entry, 1);
+        if (priv->use_ssl) {
+            if (!entry)
+                goto unlock;
+
+            if (list_empty(&priv->ioq)) {
+                ret = __socket_ioq_churn_entry(this, entry, 1);
 
-            if (ret == 0) {
-                need_append = 0;
+                if (ret == 0) {
+                    need_append = 0;
+                }
+                if (ret > 0) {
+                    need_poll_out = 1;
+                }
             }
-            if (ret > 0) {
-                need_poll_out = 1;
+
+            if (need_append) {
+                list_add_tail(&entry->list, &priv->ioq);
+                ret = 0;
+            }
+        } else {
+            if (entry) {
+                list_add_tail(&entry->list, &priv->ioq);
+                priv->ioq_deferred++;
+                ret = 0;
             }
-        }
 
-        if (need_append) {
-            list_add_tail(&entry->list, &priv->ioq);
-            ret = 0;
+            /* Only the last of the threads queueing messages writes them,
+             * all at once, unless enough of them are waiting already. When
+             * POLLOUT is armed the poller does it. */
+            if (!priv->ioq_pollout && !list_empty(&priv->ioq) &&
+                ((GF_ATOMIC_GET(priv->out_waiters) == 0) ||
+                 (priv->ioq_deferred >= GF_SOCKET_MAX_DEFERRED_MSGS))) {
+                churn = __socket_ioq_churn_batch(this);
+                if (churn > 0)
+                    need_poll_out = 1;
+                else if (churn < 0)
+                    ret = -1;
+            }
         }
+
         if (need_poll_out) {
             /* first entry to wait. continue writing on POLLOUT */
             priv->idx = gf_event_select_on(ctx->event_pool, priv->sock,
                                            priv->idx, -1, 1);
+            priv->ioq_pollout = 1;
         }
     }
 unlock:
@@ -4114,6 +4455,18 @@ reconfigure(rpc_transport_t *this, dict_t *options)
            "Reconfigued transport.socket.keepalive-count=%d",
            priv->keepalivecnt);
 
+    /* applies to the connections accepted from now on */
+    optstr = NULL;
+    priv->zerocopy_threshold = 0;
+    if (dict_get_str_sizen(options, "transport.socket.zerocopy-threshold",
+                           &optstr) == 0) {
+        if (gf_string2bytesize_uint64(optstr, &priv->zerocopy_threshold)) {
+            gf_log(this->name, GF_LOG_ERROR, "invalid number format: %s",
+                   optstr);
+            goto out;
+        }
+    }
+
     optstr = NULL;
     if (dict_get_str_sizen(options, "tcp-window-size", &optstr) == 0) {
         if (gf_string2uint64(optstr, &windowsize) != 0) {
@@ -4528,6 +4881,8 @@ socket_init(rpc_transport_t *this)
     priv->ssl_connected = _gf_false;
     priv->windowsize = GF_DEFAULT_SOCKET_WINDOW_SIZE;
     INIT_LIST_HEAD(&priv->ioq);
+    INIT_LIST_HEAD(&priv->zc_ioq);
+    GF_ATOMIC_INIT(priv->out_waiters, 0);
     pthread_mutex_init(&priv->notify.lock, NULL);
     pthread_cond_init(&priv->notify.cond, NULL);
 
@@ -4629,6 +4984,16 @@ socket_init(rpc_transport_t *this)
         priv->backlog = GLUSTERFS_SOCKET_LISTEN_BACKLOG;
     }
 
+    optstr = NULL;
+    if (dict_get_str_sizen(this->options, "transport.socket.zerocopy-threshold",
+                           &optstr) == 0) {
+        if (gf_string2bytesize_uint64(optstr, &priv->zerocopy_threshold)) {
+            gf_log(this->name, GF_LOG_ERROR, "invalid number format: %s",
+                   optstr);
+            return -1;
+        }
+    }
+
     optstr = NULL;
 
     /* Check if socket read failures are to be logged */
@@ -4788,6 +5153,14 @@ struct volume_options options[] = {
      .op_version = {GD_OP_VERSION_3_10_2},
      .default_value = "9"},
     {.key = {"transport.socket.read-fail-log"}, .type = GF_OPTION_TYPE_BOOL},
+    {.key = {"transport.socket.zerocopy-threshold"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE,
+     .default_value = "0",
+     .description = "Replies of at least this size are sent with "
+                    "MSG_ZEROCOPY, which avoids copying them into the "
+                    "socket buffer. 0 disables it."},
     {.key = {SSL_ENABLED_OPT}, .type = GF_OPTION_TYPE_BOOL},
     {.key = {SSL_OWN_CERT_OPT}, .type = GF_OPTION_TYPE_STR},
     {.key = {SSL_PRIVATE_KEY_OPT}, .type = GF_OPTION_TYPE_STR},
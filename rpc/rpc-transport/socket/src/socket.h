@@ -49,6 +49,9 @@
 #define GF_KEEPALIVE_INTERVAL (2)
 #define GF_KEEPALIVE_COUNT (9)
 
+/* messages a submitter leaves in the queue for the next one to write */
+#define GF_SOCKET_MAX_DEFERRED_MSGS (64)
+
 typedef enum {
     SP_STATE_NADA = 0,
     SP_STATE_COMPLETE,
@@ -109,6 +112,9 @@ struct ioq {
     int pending_count;
     struct iobref *iobref;
     uint32_t fraghdr;
+    /* id of the last MSG_ZEROCOPY send that included the entry */
+    uint32_t zc_id;
+    gf_boolean_t zc_pending;
     char _pad[4];
 };
 
@@ -238,6 +244,13 @@ typedef struct {
     char *crl_path;
     int pipe[2];
     struct gf_sock_incoming incoming;
+    /* entries already written with MSG_ZEROCOPY whose buffers the kernel
+     * may still read, released by socket_event_zerocopy() */
+    struct list_head zc_ioq;
+    uint64_t zerocopy_threshold;
+    uint32_t zc_next;         /* id of the next MSG_ZEROCOPY send */
+    gf_atomic_t out_waiters;  /* threads waiting for out_lock to submit */
+    uint32_t ioq_deferred;    /* messages queued since the last write */
     mgmt_ssl_t srvr_ssl;
     /* -1 = not connected. 0 = in progress. 1 = connected */
     char connected;
@@ -249,6 +262,8 @@ typedef struct {
     char submit_log;
     char lowlat;
     char nodelay;
+    char ioq_pollout; /* waiting for POLLOUT to write the ioq */
+    char zerocopy;    /* SO_ZEROCOPY is enabled on the socket */
     gf_boolean_t read_fail_log;
     gf_boolean_t ssl_enabled; /* outbound I/O */
     gf_boolean_t mgmt_ssl;    /* outbound mgmt */
@@ -678,6 +678,51 @@ gfx_stat_from_iattx(struct gfx_iattx *gf_stat, struct iatt *iatt)
     gf_stat->mode = st_mode_from_ia(iatt->ia_prot, iatt->ia_type);
 }
 
+#define GF_XDR_UNITS(len)                                                      \
+    ((((len) + XDR_BYTES_PER_UNIT - 1) / XDR_BYTES_PER_UNIT) *                 \
+     XDR_BYTES_PER_UNIT)
+
+/* Encoded size of a gfx_dict_pair, as xdr_gfx_dict_pair() would write it.
+ * This avoids a full xdr_sizeof() pass over the dict for every fop. */
+static inline size_t
+gfx_dict_pair_xdr_size(gfx_dict_pair *xpair)
+{
+    /* key length, key, value discriminant */
+    size_t size = XDR_BYTES_PER_UNIT + GF_XDR_UNITS(xpair->key.key_len) +
+                  XDR_BYTES_PER_UNIT;
+
+    switch (xpair->value.type) {
+        case GF_DATA_TYPE_INT:
+        case GF_DATA_TYPE_UINT:
+        case GF_DATA_TYPE_DOUBLE:
+            size += 2 * XDR_BYTES_PER_UNIT;
+            break;
+        case GF_DATA_TYPE_STR:
+            size += XDR_BYTES_PER_UNIT +
+                    GF_XDR_UNITS(
+                        xpair->value.gfx_value_u.val_string.val_string_len);
+            break;
+        case GF_DATA_TYPE_IATT:
+            size += xdr_sizeof((xdrproc_t)xdr_gfx_iattx,
+                               &xpair->value.gfx_value_u.iatt);
+            break;
+        case GF_DATA_TYPE_GFUUID:
+            size += sizeof(uuid_t);
+            break;
+        case GF_DATA_TYPE_PTR:
+        case GF_DATA_TYPE_STR_OLD:
+            size += XDR_BYTES_PER_UNIT +
+                    GF_XDR_UNITS(xpair->value.gfx_value_u.other.other_len);
+            break;
+        case GF_DATA_TYPE_MDATA:
+            size += xdr_sizeof((xdrproc_t)xdr_gfx_mdata_iatt,
+                               &xpair->value.gfx_value_u.mdata_iatt);
+            break;
+    }
+
+    return size;
+}
+
 /* dict_to_xdr () */
 static inline int
 dict_to_xdr(dict_t *this, gfx_dict *dict)
@@ -687,7 +732,7 @@ dict_to_xdr(dict_t *this, gfx_dict *dict)
     int index = 0;
     data_pair_t *dpair = NULL;
     gfx_dict_pair *xpair = NULL;
-    ssize_t size = 0;
+    size_t size = 0;
 
     /* This is a failure as we expect destination to be valid */
     if (!dict)
@@ -718,7 +763,7 @@ dict_to_xdr(dict_t *this, gfx_dict *dict)
         xpair = &dict->pairs.pairs_val[index];
 
         xpair->key.key_val = dpair->key;
-        xpair->key.key_len = strlen(dpair->key) + 1;
+        xpair->key.key_len = dpair->key_len + 1;
         xpair->value.type = dpair->value->data_type;
         switch (dpair->value->data_type) {
                 /* Add more type here */
@@ -785,8 +830,11 @@ dict_to_xdr(dict_t *this, gfx_dict *dict)
                 gf_msg("dict", GF_LOG_WARNING, EINVAL,
                        LG_MSG_DICT_SERIAL_FAILED,
                        "key '%s' is not sent on wire", dpair->key);
+                xpair = NULL;
                 break;
         }
+        if (xpair)
+            size += gfx_dict_pair_xdr_size(xpair);
         dpair = dpair->next;
     }
 
@@ -796,10 +844,9 @@ dict_to_xdr(dict_t *this, gfx_dict *dict)
     /* This is required mainly in the RPC layer to understand the
        boundary for proper payload. Hence only send the size of
        variable XDR size. ie, the formula should be:
-       xdr_size = total size - (xdr_size + count + pairs.pairs_len))  */
-    size = xdr_sizeof((xdrproc_t)xdr_gfx_dict, dict);
-
-    dict->xdr_size = (size > 12) ? (size - 12) : 0;
+       xdr_size = total size - (xdr_size + count + pairs.pairs_len))
+       which is the sum of the encoded sizes of the pairs. */
+    dict->xdr_size = size;
 
     ret = 0;
 out:
@@ -810,6 +857,23 @@ out:
     return ret;
 }
 
+/* Takes the buffer allocated by the XDR decoder for a value instead of
+ * copying it. It only has to grow by one byte for the '\0' terminator,
+ * which realloc() can usually do in place. */
+static inline char *
+xdr_to_dict_value(char **buf, u_int len)
+{
+    char *value = realloc(*buf, len + 1);
+
+    if (!value)
+        return NULL;
+
+    *buf = NULL;
+    value[len] = '\0';
+
+    return value;
+}
+
 static inline int
 xdr_to_dict(gfx_dict *dict, dict_t **to)
 {
@@ -817,6 +881,7 @@ xdr_to_dict(gfx_dict *dict, dict_t **to)
     int index = 0;
     char *key = NULL;
     char *value = NULL;
+    data_t *data = NULL;
     gfx_dict_pair *xpair = NULL;
     dict_t *this = NULL;
     unsigned char *uuid = NULL;
@@ -856,20 +921,23 @@ xdr_to_dict(gfx_dict *dict, dict_t **to)
                                       xpair->value.gfx_value_u.value_dbl);
                 break;
             case GF_DATA_TYPE_STR:
-                value = GF_MALLOC(
-                    xpair->value.gfx_value_u.val_string.val_string_len + 1,
-                    gf_common_mt_char);
+                value = xdr_to_dict_value(
+                    &xpair->value.gfx_value_u.val_string.val_string_val,
+                    xpair->value.gfx_value_u.val_string.val_string_len);
                 if (!value) {
                     errno = ENOMEM;
                     goto out;
                 }
-                memcpy(value,
-                       xpair->value.gfx_value_u.val_string.val_string_val,
-                       xpair->value.gfx_value_u.val_string.val_string_len);
-                value[xpair->value.gfx_value_u.val_string.val_string_len] =
-                    '\0';
-                free(xpair->value.gfx_value_u.val_string.val_string_val);
-                ret = dict_set_dynstr(this, key, value);
+                data = data_from_stdalloc(value, strlen(value) + 1,
+                                          GF_DATA_TYPE_STR);
+                if (!data) {
+                    free(value);
+                    errno = ENOMEM;
+                    goto out;
+                }
+                ret = dict_set(this, key, data);
+                if (ret < 0)
+                    data_destroy(data);
                 break;
             case GF_DATA_TYPE_GFUUID:
                 uuid = GF_MALLOC(sizeof(uuid_t), gf_common_mt_uuid_t);
@@ -915,18 +983,24 @@ xdr_to_dict(gfx_dict *dict, dict_t **to)
                 break;
             case GF_DATA_TYPE_PTR:
             case GF_DATA_TYPE_STR_OLD:
-                value = GF_MALLOC(xpair->value.gfx_value_u.other.other_len + 1,
-                                  gf_common_mt_char);
+                value = xdr_to_dict_value(
+                    &xpair->value.gfx_value_u.other.other_val,
+                    xpair->value.gfx_value_u.other.other_len);
                 if (!value) {
                     errno = ENOMEM;
                     goto out;
                 }
-                memcpy(value, xpair->value.gfx_value_u.other.other_val,
-                       xpair->value.gfx_value_u.other.other_len);
-                value[xpair->value.gfx_value_u.other.other_len] = '\0';
-                free(xpair->value.gfx_value_u.other.other_val);
-                ret = dict_set_dynptr(this, key, value,
-                                      xpair->value.gfx_value_u.other.other_len);
+                data = data_from_stdalloc(
+                    value, xpair->value.gfx_value_u.other.other_len,
+                    GF_DATA_TYPE_PTR);
+                if (!data) {
+                    free(value);
+                    errno = ENOMEM;
+                    goto out;
+                }
+                ret = dict_set(this, key, data);
+                if (ret < 0)
+                    data_destroy(data);
                 break;
             default:
                 ret = 0;
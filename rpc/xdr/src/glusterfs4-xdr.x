@@ -640,6 +640,43 @@ struct gfx_seek_rsp {
         gfx_dict dict;
 }  ;
 
+/* Only the fops which can be chained on the fd created or opened by the
+ * first one are supported */
+union compound_req_v2 switch (int fop_enum) {
+        case GF_FOP_CREATE:    gfx_create_req    compound_create_req;
+        case GF_FOP_OPEN:      gfx_open_req      compound_open_req;
+        case GF_FOP_WRITE:     gfx_write_req     compound_write_req;
+        case GF_FOP_FSETXATTR: gfx_fsetxattr_req compound_fsetxattr_req;
+        case GF_FOP_FSETATTR:  gfx_fsetattr_req  compound_fsetattr_req;
+        case GF_FOP_FSYNC:     gfx_fsync_req     compound_fsync_req;
+        case GF_FOP_FLUSH:     gfx_flush_req     compound_flush_req;
+        default:               void;
+};
+
+struct gfx_compound_req {
+        int                compound_version;
+        compound_req_v2    compound_req_array<>;
+        gfx_dict           xdata;
+};
+
+union compound_rsp_v2 switch (int fop_enum) {
+        case GF_FOP_CREATE:    gfx_create_rsp       compound_create_rsp;
+        case GF_FOP_OPEN:      gfx_open_rsp         compound_open_rsp;
+        case GF_FOP_WRITE:     gfx_common_2iatt_rsp compound_write_rsp;
+        case GF_FOP_FSETXATTR: gfx_common_rsp       compound_fsetxattr_rsp;
+        case GF_FOP_FSETATTR:  gfx_common_2iatt_rsp compound_fsetattr_rsp;
+        case GF_FOP_FSYNC:     gfx_common_2iatt_rsp compound_fsync_rsp;
+        case GF_FOP_FLUSH:     gfx_common_rsp       compound_flush_rsp;
+        default:               void;
+};
+
+struct gfx_compound_rsp {
+        int                op_ret;
+        int                op_errno;
+        compound_rsp_v2    compound_rsp_array<>;
+        gfx_dict           xdata;
+};
+
  struct   gfx_copy_file_range_req {
         opaque gfid1[16];
         opaque gfid2[16];
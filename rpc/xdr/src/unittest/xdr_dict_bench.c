@@ -0,0 +1,310 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Benchmark for the conversion of xdata between dict_t and gfx_dict.
+ *
+ * It reproduces what protocol/client and protocol/server do for every fop
+ * of an xattr heavy workload: the xdata of a lookup request (the keys the
+ * fuse bridge and the cluster xlators ask for) and of its reply (the
+ * values of the AFR, DHT and EC xattrs) is converted with dict_to_xdr(),
+ * encoded into a buffer, decoded back and converted with xdr_to_dict().
+ * The throughput of each direction and of the whole round trip is printed.
+ *
+ * Before starting, the xdr_size computed by dict_to_xdr() is checked
+ * against xdr_sizeof().
+ *
+ * Usage: xdr_dict_bench [-d seconds]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <inttypes.h>
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/dict.h"
+#include "glusterfs/mem-pool.h"
+#include "glusterfs/common-utils.h"
+#include "glusterfs3.h"
+
+#define BENCH_BUF_SIZE (64 * GF_UNIT_KB)
+
+typedef dict_t *(*bench_build_t)(void);
+
+static xlator_t bench_xl;
+static uuid_t bench_gfid;
+static char bench_buf[BENCH_BUF_SIZE];
+
+/* xdata of a lookup as sent by a replicated and distributed volume */
+static dict_t *
+bench_build_request(void)
+{
+    dict_t *xdata = dict_new();
+
+    if (!xdata)
+        return NULL;
+
+    if (dict_set_gfuuid(xdata, "gfid-req", bench_gfid, true) ||
+        dict_set_int32(xdata, GLUSTERFS_INODELK_COUNT, 1) ||
+        dict_set_int32(xdata, GLUSTERFS_ENTRYLK_COUNT, 1) ||
+        dict_set_int32(xdata, GLUSTERFS_POSIXLK_COUNT, 1) ||
+        dict_set_uint32(xdata, GF_REQUEST_LINK_COUNT_XDATA, 1) ||
+        dict_set_int32(xdata, GLUSTERFS_PARENT_ENTRYLK, 0) ||
+        dict_set_uint64(xdata, "trusted.afr.vol-client-0", 0) ||
+        dict_set_uint64(xdata, "trusted.afr.vol-client-1", 0) ||
+        dict_set_uint64(xdata, "trusted.afr.vol-client-2", 0) ||
+        dict_set_uint64(xdata, "trusted.afr.dirty", 0) ||
+        dict_set_uint32(xdata, "trusted.glusterfs.dht", 16) ||
+        dict_set_uint32(xdata, "trusted.glusterfs.dht.linkto", 256) ||
+        dict_set_int32(xdata, GF_GFIDLESS_LOOKUP, 1)) {
+        dict_unref(xdata);
+        return NULL;
+    }
+
+    return xdata;
+}
+
+/* the matching reply, with the values of the requested xattrs */
+static dict_t *
+bench_build_reply(void)
+{
+    static char pending[12];
+    static char layout[16];
+    dict_t *xdata = dict_new();
+
+    if (!xdata)
+        return NULL;
+
+    if (dict_set_static_bin(xdata, "trusted.afr.vol-client-0", pending,
+                            sizeof(pending)) ||
+        dict_set_static_bin(xdata, "trusted.afr.vol-client-1", pending,
+                            sizeof(pending)) ||
+        dict_set_static_bin(xdata, "trusted.afr.vol-client-2", pending,
+                            sizeof(pending)) ||
+        dict_set_static_bin(xdata, "trusted.afr.dirty", pending,
+                            sizeof(pending)) ||
+        dict_set_static_bin(xdata, "trusted.glusterfs.dht", layout,
+                            sizeof(layout)) ||
+        dict_set_str(xdata, "trusted.gfid2path.0123456789abcdef",
+                     "00000000-0000-0000-0000-000000000001/file") ||
+        dict_set_str(xdata, "security.selinux",
+                     "system_u:object_r:fusefs_t:s0") ||
+        dict_set_int32(xdata, GLUSTERFS_INODELK_COUNT, 0) ||
+        dict_set_int32(xdata, GLUSTERFS_ENTRYLK_COUNT, 0) ||
+        dict_set_int32(xdata, GLUSTERFS_POSIXLK_COUNT, 0) ||
+        dict_set_uint32(xdata, GF_REQUEST_LINK_COUNT_XDATA, 1) ||
+        dict_set_uint32(xdata, GLUSTERFS_OPEN_FD_COUNT, 0)) {
+        dict_unref(xdata);
+        return NULL;
+    }
+
+    return xdata;
+}
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/* dict_t -> gfx_dict -> wire, returns the encoded length */
+static int
+bench_encode(dict_t *dict)
+{
+    gfx_dict xdict = {
+        0,
+    };
+    XDR xdr;
+    int len = -1;
+
+    if (dict_to_xdr(dict, &xdict) != 0)
+        goto out;
+
+    xdrmem_create(&xdr, bench_buf, sizeof(bench_buf), XDR_ENCODE);
+    if (xdr_gfx_dict(&xdr, &xdict))
+        len = xdr_getpos(&xdr);
+
+out:
+    GF_FREE(xdict.pairs.pairs_val);
+    return len;
+}
+
+/* wire -> gfx_dict -> dict_t */
+static int
+bench_decode(int len)
+{
+    gfx_dict xdict = {
+        0,
+    };
+    dict_t *dict = NULL;
+    XDR xdr;
+
+    xdrmem_create(&xdr, bench_buf, len, XDR_DECODE);
+    if (!xdr_gfx_dict(&xdr, &xdict))
+        return -1;
+
+    if (xdr_to_dict(&xdict, &dict) != 0 || !dict)
+        return -1;
+
+    dict_unref(dict);
+    return 0;
+}
+
+static int
+bench_check(dict_t *dict)
+{
+    gfx_dict xdict = {
+        0,
+    };
+    unsigned int size = 0;
+    int ret = -1;
+
+    if (dict_to_xdr(dict, &xdict) != 0)
+        goto out;
+
+    size = xdr_sizeof((xdrproc_t)xdr_gfx_dict, &xdict) - 12;
+    if (xdict.xdr_size != size) {
+        fprintf(stderr, "xdr_size is %u, expected %u\n", xdict.xdr_size,
+                size);
+        goto out;
+    }
+
+    ret = 0;
+out:
+    GF_FREE(xdict.pairs.pairs_val);
+    return ret;
+}
+
+static int
+bench_throughput(const char *name, bench_build_t build, uint32_t seconds)
+{
+    dict_t *dict = NULL;
+    double start = 0;
+    double elapsed = 0;
+    uint64_t encodes = 0;
+    uint64_t decodes = 0;
+    uint64_t trips = 0;
+    int len = 0;
+    int i = 0;
+
+    dict = build();
+    if (!dict || bench_check(dict) != 0)
+        goto err;
+
+    start = bench_now();
+    do {
+        for (i = 0; i < 64; i++) {
+            len = bench_encode(dict);
+            if (len < 0)
+                goto err;
+        }
+        encodes += 64;
+    } while ((elapsed = bench_now() - start) < seconds);
+    encodes = encodes / elapsed;
+
+    start = bench_now();
+    do {
+        for (i = 0; i < 64; i++) {
+            if (bench_decode(len) != 0)
+                goto err;
+        }
+        decodes += 64;
+    } while ((elapsed = bench_now() - start) < seconds);
+    decodes = decodes / elapsed;
+
+    start = bench_now();
+    do {
+        for (i = 0; i < 64; i++) {
+            len = bench_encode(dict);
+            if (len < 0 || bench_decode(len) != 0)
+                goto err;
+        }
+        trips += 64;
+    } while ((elapsed = bench_now() - start) < seconds);
+    trips = trips / elapsed;
+
+    printf("%-16s %6d %6d %12" PRIu64 " %12" PRIu64 " %12" PRIu64 "\n",
+           name, dict->count, len, encodes, decodes, trips);
+
+    dict_unref(dict);
+    return 0;
+
+err:
+    if (dict)
+        dict_unref(dict);
+    return -1;
+}
+
+int
+main(int argc, char *argv[])
+{
+    glusterfs_ctx_t *ctx = NULL;
+    uint32_t seconds = 2;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "d:")) != -1) {
+        switch (opt) {
+            case 'd':
+                seconds = strtoul(optarg, NULL, 0);
+                break;
+            default:
+                fprintf(stderr, "usage: %s [-d seconds]\n", argv[0]);
+                return 1;
+        }
+    }
+
+    if (!seconds) {
+        fprintf(stderr, "invalid arguments\n");
+        return 1;
+    }
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx) != 0) {
+        fprintf(stderr, "failed to initialize glusterfs context\n");
+        return 1;
+    }
+    THIS->ctx = ctx;
+
+    ctx->dict_pool = mem_pool_new(dict_t, 1024);
+    ctx->dict_pair_pool = mem_pool_new(data_pair_t, 1024);
+    ctx->dict_data_pool = mem_pool_new(data_t, 1024);
+    if (!ctx->dict_pool || !ctx->dict_pair_pool || !ctx->dict_data_pool)
+        goto err;
+
+    bench_xl.name = "xdr-dict-bench";
+    bench_xl.ctx = ctx;
+    THIS = &bench_xl;
+
+    gf_uuid_generate(bench_gfid);
+
+    printf("throughput (ops/s)\n");
+    printf("%-16s %6s %6s %12s %12s %12s\n", "xdata", "keys", "bytes",
+           "encode", "decode", "round trip");
+    if (bench_throughput("lookup request", bench_build_request, seconds) ||
+        bench_throughput("lookup reply", bench_build_reply, seconds))
+        goto err;
+
+    return 0;
+
+err:
+    fprintf(stderr, "benchmark failed\n");
+    return 1;
+}
@@ -0,0 +1,49 @@
+#!/bin/bash
+#Test the diff data self-heal of sparse files with several blocks healed
+#at the same time.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.data-self-heal-algorithm diff
+TEST $CLI volume set $V0 cluster.self-heal-pipeline-depth 8
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST truncate -s 1G $M0/image
+for i in 1 100 500 1000; do
+        TEST dd if=/dev/urandom of=$M0/image bs=64k count=4 seek=$i conv=notrunc
+done
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+#Small scattered changes, some of them in what used to be holes
+for i in 2 300 700 16000; do
+        TEST dd if=/dev/urandom of=$M0/image bs=4k count=1 seek=$((i * 16)) conv=notrunc
+done
+#Data which is replaced by a hole on the source
+TEST fallocate -p -o $((500 * 65536)) -l 262144 $M0/image
+image_md5sum=$(md5sum $M0/image | awk '{print $1}')
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+TEST cmp $B0/${V0}0/image $B0/${V0}1/image
+EXPECT "$image_md5sum" echo $(md5sum $B0/${V0}0/image | awk '{print $1}')
+
+#The holes have not been filled on the healed brick
+EXPECT "1" echo $(( $(du -k $B0/${V0}0/image | cut -f1) < 4096 ))
+
+cleanup;
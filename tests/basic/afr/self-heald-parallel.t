@@ -0,0 +1,43 @@
+#!/bin/bash
+#Test the index heal of new directories and files by several threads of the
+#self-heal daemon with a limited heal rate.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 cluster.shd-max-threads 8
+TEST $CLI volume set $V0 cluster.shd-heal-rate-limit 50
+TEST $CLI volume set $V0 cluster.self-heal-daemon off
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0;
+TEST kill_brick $V0 $H0 $B0/${V0}0
+
+for i in {1..5}; do
+        TEST mkdir -p $M0/dir$i/sub
+        for j in {1..10}; do
+                echo "$i.$j" > $M0/dir$i/sub/file$j
+        done
+done
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status $V0 0
+TEST $CLI volume set $V0 cluster.self-heal-daemon on
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" glustershd_up_status
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "1" afr_child_up_status_in_shd $V0 1
+TEST $CLI volume heal $V0
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+for i in {1..5}; do
+        for j in {1..10}; do
+                EXPECT "$i.$j" cat $B0/${V0}0/dir$i/sub/file$j
+        done
+done
+
+cleanup;
@@ -0,0 +1,86 @@
+#!/bin/bash
+#Test the persistent disk cache: the data read is served from the local
+#directory after a remount, and is dropped when the file changes.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function dkc_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        sed -n '/^\[performance\/disk-cache/,/^$/p' $fpath | \
+                grep -a "^$1=" | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function dkc_synced {
+        test "$(dkc_stat stored_blocks)" != "0" && \
+        test "$(dkc_stat queued_bytes)" = "0" && \
+        test "$(dkc_stat pending_records)" = "0" && echo "Y"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.disk-cache on
+TEST $CLI volume set $V0 performance.disk-cache-dir $B0/cache
+TEST $CLI volume set $V0 performance.disk-cache-size 64MB
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+EXPECT "yes" dkc_stat enabled
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=4
+TEST dd if=/dev/urandom of=$M0/tail bs=1000 count=333
+file=$(md5sum < $M0/file)
+tail=$(md5sum < $M0/tail)
+
+#The first read fills the cache
+drop_cache $M0
+EXPECT "$file" echo "$(md5sum < $M0/file)"
+EXPECT "$tail" echo "$(md5sum < $M0/tail)"
+#Blocks are stored and the index written in background
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" dkc_synced
+
+#It is still there after a remount
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_NOT "0" dkc_stat blocks
+EXPECT "$file" echo "$(md5sum < $M0/file)"
+EXPECT "$tail" echo "$(md5sum < $M0/tail)"
+EXPECT_NOT "0" dkc_stat hits
+
+#A second client can't use the same directory, but still works
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M1
+EXPECT "$file" echo "$(md5sum < $M1/file)"
+EXPECT "Y" force_umount $M1
+
+#Writes drop the cached data
+TEST dd if=/dev/urandom of=$M0/file bs=64k count=1 seek=3 conv=notrunc
+file=$(md5sum < $B0/${V0}0/file)
+drop_cache $M0
+EXPECT "$file" echo "$(md5sum < $M0/file)"
+EXPECT_NOT "0" dkc_stat invalidations
+
+#And so does an open with O_TRUNC, even without a write over the old data
+drop_cache $M0
+EXPECT "$file" echo "$(md5sum < $M0/file)"
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" dkc_synced
+TEST $PYTHON -c "
+import os
+fd = os.open('$M0/file', os.O_WRONLY | os.O_TRUNC)
+os.pwrite(fd, b'x' * 4096, 1048576)
+os.close(fd)
+"
+file=$(md5sum < $B0/${V0}0/file)
+drop_cache $M0
+EXPECT "$file" echo "$(md5sum < $M0/file)"
+
+#So do changes made on the volume while the client was down
+EXPECT "Y" force_umount $M0
+TEST dd if=/dev/urandom of=$B0/${V0}0/tail bs=1000 count=333
+tail=$(md5sum < $B0/${V0}0/tail)
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT "$tail" echo "$(md5sum < $M0/tail)"
+
+cleanup;
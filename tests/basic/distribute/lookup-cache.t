@@ -0,0 +1,52 @@
+#!/bin/bash
+#Test the caches of directory layouts and of names not found on any
+#subvolume.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+function cache_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..3}
+TEST $CLI volume set $V0 cluster.lookup-optimize off
+TEST $CLI volume set $V0 cluster.lookup-cache-timeout 600
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+for i in {1..10}; do
+        TEST mkdir $M0/dir/sub$i
+done
+
+#The names are not looked up everywhere again
+for i in {1..10}; do
+        TEST ! stat $M0/dir/missing$i
+done
+for i in {1..10}; do
+        TEST ! stat $M0/dir/missing$i
+done
+EXPECT "10" cache_stat negative-cache.entries
+EXPECT_NOT "0" cache_stat negative-cache.hits
+
+#The layouts of the forgotten directories are reused
+drop_cache $M0
+for i in {1..10}; do
+        TEST stat $M0/dir/sub$i
+done
+EXPECT_NOT "0" cache_stat layout-cache.hits
+TEST touch $M0/dir/sub1/file{1..20}
+EXPECT "20" echo $(ls $M0/dir/sub1 | wc -l)
+
+#Disabling the caches does not affect the lookups
+TEST $CLI volume set $V0 cluster.lookup-cache-timeout 0
+TEST ! stat $M0/dir/missing2
+
+cleanup;
@@ -0,0 +1,49 @@
+#!/bin/bash
+#Test the listing of directories with the entries of all the subvolumes
+#prefetched in parallel.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}{0..5}
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST mkdir $M0/dir
+TEST touch $M0/dir/file{1..2000}
+TEST mkdir $M0/dir/sub{1..50}
+expected=$(ls -l $M0/dir | awk '{print $1, $NF}' | sort | md5sum)
+
+TEST $CLI volume set $V0 cluster.readdir-prefetch-size 256KB
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+EXPECT "2052" echo $(ls -la $M0/dir | tail -n +2 | wc -l)
+EXPECT "$expected" echo "$(ls -l $M0/dir | awk '{print $1, $NF}' | sort | md5sum)"
+#Entries don't appear twice when the directory is read again
+EXPECT "2050" echo $(ls $M0/dir | sort -u | wc -l)
+EXPECT "2050" echo $(find $M0/dir -mindepth 1 | wc -l)
+
+#A file resized while the directory is being read is not listed with the
+#attributes prefetched before
+function size_while_listing {
+        $PYTHON -c "
+import os
+d = os.scandir('$M0/dir')
+next(d)
+os.truncate('$M0/dir/$1', $2)
+print(sum(e.stat().st_size for e in d if e.name == '$1'))
+"
+}
+EXPECT "12345" size_while_listing file1999 12345
+EXPECT "0" size_while_listing file1999 0
+
+#A limit smaller than a request disables the prefetching
+TEST $CLI volume set $V0 cluster.readdir-prefetch-size 4KB
+EXPECT "2050" echo $(ls $M0/dir | wc -l)
+
+cleanup;
@@ -0,0 +1,37 @@
+#!/bin/bash
+#Test the migration of large files by rebalance with several ranges of
+#each file copied at the same time.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 cluster.rebal-copy-streams 8
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+for i in {1..4}; do
+        TEST dd if=/dev/urandom of=$M0/big$i bs=1M count=100
+        md5[$i]=$(md5sum $M0/big$i | awk '{print $1}')
+done
+for i in {1..20}; do
+        TEST dd if=/dev/urandom of=$M0/small$i bs=4k count=1
+done
+
+TEST $CLI volume add-brick $V0 $H0:$B0/${V0}1 $H0:$B0/${V0}2
+TEST $CLI volume rebalance $V0 start force
+EXPECT_WITHIN $REBALANCE_TIMEOUT "completed" rebalance_status_field $V0
+
+#Read the files back with the caches dropped
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+for i in {1..4}; do
+        EXPECT "${md5[$i]}" echo $(md5sum $M0/big$i | awk '{print $1}')
+done
+EXPECT "20" echo $(ls $M0/small* | wc -l)
+
+cleanup;
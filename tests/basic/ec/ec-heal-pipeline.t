@@ -0,0 +1,52 @@
+#!/bin/bash
+#Test data heal with several windows and files healed at the same time.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 6 redundancy 2 $H0:$B0/${V0}{0..5}
+TEST $CLI volume set $V0 disperse.self-heal-pipeline-depth 4
+TEST $CLI volume set $V0 disperse.self-heal-memory-limit 1MB
+TEST $CLI volume set $V0 disperse.shd-max-threads 4
+TEST $CLI volume heal $V0 disable
+TEST $CLI volume start $V0
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+
+TEST kill_brick $V0 $H0 $B0/${V0}0
+TEST kill_brick $V0 $H0 $B0/${V0}1
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+
+for i in {1..8}; do
+        TEST dd if=/dev/urandom of=$M0/file$i bs=1M count=4
+        md5[$i]=$(md5sum $M0/file$i | awk '{print $1}')
+done
+
+TEST $CLI volume start $V0 force
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count $V0 0
+TEST $CLI volume heal $V0 enable
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "[0-9][0-9]*" get_shd_process_pid $V0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "6" ec_child_up_count_shd $V0 0
+TEST $CLI volume heal $V0 full
+EXPECT_WITHIN $HEAL_TIMEOUT "^0$" get_pending_heal_count $V0
+
+#The healed fragments are used once the other bricks are down
+TEST kill_brick $V0 $H0 $B0/${V0}2
+TEST kill_brick $V0 $H0 $B0/${V0}3
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "4" ec_child_up_count $V0 0
+for i in {1..8}; do
+        EXPECT "${md5[$i]}" echo $(md5sum $M0/file$i | awk '{print $1}')
+done
+
+statedump=$(generate_shd_statedump $V0)
+TEST grep -E "^bytes=[1-9]" $statedump
+EXPECT "^0$" echo $(grep -E "^in-flight=" $statedump | grep -cv "=0$")
+
+cleanup
@@ -48,5 +48,19 @@ TEST dd if=$M0/1 of=/dev/null bs=1M count=4
 #TEST that reads are executed on all bricks
 gh_reads=$($CLI volume profile $V0 info cumulative| grep -w READ |  wc -l)
 EXPECT "^4$" echo $gh_reads
+TEST $CLI volume profile $V0 info clear
+
+TEST $CLI volume set $V0 disperse.read-policy adaptive
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "adaptive" mount_get_option_value $M0 $V0-disperse-0 read-policy
+
+#Bricks that are much slower than the others may be skipped
+TEST dd if=$M0/1 of=/dev/null bs=1M count=4
+ad_reads=$($CLI volume profile $V0 info cumulative| grep -w READ |  wc -l)
+TEST [ $ad_reads -ge 4 ]
+
+#The latency of each brick is tracked
+statedump=$(generate_mount_statedump $V0)
+EXPECT "^6$" echo $(grep -c "^read_latency\[[0-5]\]=[1-9]" $statedump)
+cleanup_mount_statedump $V0
 
 cleanup;
@@ -0,0 +1,42 @@
+#!/bin/bash
+#Test small writes that cross a stripe boundary of a disperse volume.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 disperse 11 redundancy 3 $H0:$B0/${V0}{0..10}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 disperse.stripe-cache 0
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "11" ec_child_up_count $V0 0
+
+TEST dd if=/dev/urandom of=$B0/test_file bs=1M count=1
+TEST cp $B0/test_file $M0/test_file
+
+#4KiB writes at offsets that are not multiple of the 4KiB stripe
+for off in 512 5000 70001 1044480 1048000; do
+        TEST dd if=/dev/urandom of=$B0/data bs=4096 count=1
+        TEST dd if=$B0/data of=$B0/test_file bs=4096 count=1 \
+             oflag=seek_bytes seek=$off conv=notrunc
+        TEST dd if=$B0/data of=$M0/test_file bs=4096 count=1 \
+             oflag=seek_bytes seek=$off conv=notrunc
+done
+
+EXPECT "$(stat -c %s $B0/test_file)" stat -c %s $M0/test_file
+EXPECT "$(get_md5_sum $B0/test_file)" get_md5_sum $M0/test_file
+
+#Read back with the caches dropped
+EXPECT_WITHIN $UMOUNT_TIMEOUT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+EXPECT_WITHIN $CHILD_UP_TIMEOUT "11" ec_child_up_count $V0 0
+EXPECT "$(get_md5_sum $B0/test_file)" get_md5_sum $M0/test_file
+
+TEST rm -f $B0/test_file $B0/data
+cleanup
@@ -0,0 +1,38 @@
+#!/bin/bash
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_args() {
+    ps -o args= -p $(get_brick_pid $V0 $H0 $B0/${V0}0)
+}
+
+cleanup
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 config.event-thread-affinity on
+TEST $CLI volume set $V0 server.event-threads 4
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" online_brick_count
+EXPECT "1" echo $(brick_args | grep -c -- --event-thread-affinity)
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --event-thread-affinity $M1
+
+TEST mkdir $M0/dir
+TEST dd if=/dev/urandom of=$M0/dir/file bs=128k count=64
+TEST cmp $M0/dir/file $M1/dir/file
+
+# Connections are moved to the remaining threads
+TEST $CLI volume set $V0 server.event-threads 1
+TEST dd if=/dev/urandom of=$M1/dir/file2 bs=128k count=64
+TEST cmp $M0/dir/file2 $M1/dir/file2
+
+TEST $CLI volume set $V0 server.event-threads 8
+TEST dd if=/dev/urandom of=$M0/dir/file3 bs=128k count=64
+TEST cmp $M0/dir/file3 $M1/dir/file3
+
+cleanup
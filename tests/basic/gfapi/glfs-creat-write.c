@@ -0,0 +1,97 @@
+#include <fcntl.h>
+#include <unistd.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <glusterfs/api/glfs.h>
+
+#define WRITE_SIZE 4096
+
+#define VALIDATE(func, cond)                                                   \
+    do {                                                                       \
+        if (!(cond)) {                                                         \
+            fprintf(stderr, "%s : unexpected result, errno(%d)\n", func,      \
+                    errno);                                                    \
+            goto out;                                                          \
+        }                                                                      \
+        fprintf(stderr, "%s : ok\n", func);                                    \
+    } while (0)
+
+int
+main(int argc, char *argv[])
+{
+    glfs_t *fs = NULL;
+    glfs_fd_t *fd = NULL;
+    ssize_t ret = -1;
+    int status = 1;
+    char *hostname = NULL;
+    char *volname = NULL;
+    char *logfile = NULL;
+    char buf[WRITE_SIZE];
+    char rbuf[WRITE_SIZE];
+    struct stat sb = {
+        0,
+    };
+
+    if (argc != 4) {
+        fprintf(stderr, "Invalid argument\n");
+        return 1;
+    }
+
+    hostname = argv[1];
+    volname = argv[2];
+    logfile = argv[3];
+
+    memset(buf, 'a', sizeof(buf));
+
+    fs = glfs_new(volname);
+    if (!fs) {
+        fprintf(stderr, "glfs_new: returned NULL\n");
+        return 1;
+    }
+
+    ret = glfs_set_volfile_server(fs, "tcp", hostname, 24007);
+    VALIDATE("glfs_set_volfile_server", ret == 0);
+
+    ret = glfs_set_logging(fs, logfile, 8);
+    VALIDATE("glfs_set_logging", ret == 0);
+
+    ret = glfs_init(fs);
+    VALIDATE("glfs_init", ret == 0);
+
+    /* create + write + close */
+    ret = glfs_creat_write(fs, "/small", O_WRONLY, 0644, buf, WRITE_SIZE);
+    VALIDATE("glfs_creat_write", ret == WRITE_SIZE);
+
+    ret = glfs_stat(fs, "/small", &sb);
+    VALIDATE("glfs_stat", (ret == 0) && (sb.st_size == WRITE_SIZE));
+
+    fd = glfs_open(fs, "/small", O_RDONLY);
+    VALIDATE("glfs_open", fd != NULL);
+
+    ret = glfs_read(fd, rbuf, WRITE_SIZE, 0);
+    VALIDATE("glfs_read",
+             (ret == WRITE_SIZE) && !memcmp(buf, rbuf, WRITE_SIZE));
+
+    ret = glfs_creat_write(fs, "/small", O_WRONLY, 0644, buf, WRITE_SIZE);
+    VALIDATE("glfs_creat_write of an existing file",
+             (ret == -1) && (errno == EEXIST));
+
+    /* the create succeeds and the write fails */
+    ret = glfs_creat_write(fs, "/rdonly", O_RDONLY, 0644, buf, WRITE_SIZE);
+    VALIDATE("glfs_creat_write of a read-only fd",
+             (ret == -1) && (errno == EBADF));
+
+    ret = glfs_stat(fs, "/rdonly", &sb);
+    VALIDATE("glfs_stat of the read-only file",
+             (ret == 0) && (sb.st_size == 0));
+
+    status = 0;
+out:
+    if (fd)
+        glfs_close(fd);
+    glfs_fini(fs);
+
+    return status;
+}
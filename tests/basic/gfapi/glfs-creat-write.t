@@ -0,0 +1,53 @@
+#!/bin/bash
+#Test that a create, a write and a close of a small file are sent to the
+#brick as a single compound fop when client.create-write-compound is set, and
+#that a failure of the write is returned while the created file is kept.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/brick1;
+EXPECT 'Created' volinfo_field $V0 'Status';
+
+TEST $CLI volume start $V0;
+EXPECT 'Started' volinfo_field $V0 'Status';
+
+logdir=`gluster --print-logdir`
+logfile=$logdir/glfs-creat-write.log
+rm -f $logfile
+
+TEST build_tester $(dirname $0)/glfs-creat-write.c -lgfapi
+
+#By default, the data is sent by a regular write
+TEST ./$(dirname $0)/glfs-creat-write $H0 $V0 $logfile
+
+EXPECT "4096" stat -c %s $B0/brick1/small
+EXPECT "0" stat -c %s $B0/brick1/rdonly
+EXPECT "0" grep -c "as a compound" $logfile
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST rm -f $M0/small $M0/rdonly
+EXPECT "Y" force_umount $M0
+
+TEST $CLI volume set $V0 client.create-write-compound on
+rm -f $logfile
+
+TEST ./$(dirname $0)/glfs-creat-write $H0 $V0 $logfile
+
+EXPECT "4096" stat -c %s $B0/brick1/small
+EXPECT "0" stat -c %s $B0/brick1/rdonly
+
+#Both creates went out as a compound, the second one failed at its write
+EXPECT "2" grep -c "as a compound" $logfile
+EXPECT_NOT "0" grep -c "compound_cbk.*Bad file descriptor" $logfile
+
+cleanup_tester $(dirname $0)/glfs-creat-write
+
+TEST $CLI volume stop $V0
+TEST $CLI volume delete $V0
+
+cleanup;
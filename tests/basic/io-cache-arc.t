@@ -0,0 +1,51 @@
+#!/bin/bash
+#Test the adaptive replacement policy of io-cache and its counters.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function ioc_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | cut -f2 -d'='
+        rm -f $fpath
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache on
+TEST $CLI volume set $V0 performance.cache-size 4MB
+TEST $CLI volume set $V0 performance.cache-replacement-policy arc
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$M0/hot bs=128k count=8
+TEST dd if=/dev/urandom of=$M0/scan bs=1M count=16
+hot=$(md5sum < $M0/hot)
+
+EXPECT "arc" ioc_stat replacement_policy
+
+#Pages read again are kept apart from the pages read once
+for i in {1..3}; do
+        drop_cache $M0
+        EXPECT "$hot" echo "$(md5sum < $M0/hot)"
+done
+EXPECT_NOT "0" ioc_stat hits
+EXPECT_NOT "0" ioc_stat frequent_pages
+
+#A sequential read larger than the cache doesn't evict them
+drop_cache $M0
+TEST dd if=$M0/scan of=/dev/null bs=128k
+EXPECT_NOT "0" ioc_stat frequent_pages
+drop_cache $M0
+EXPECT "$hot" echo "$(md5sum < $M0/hot)"
+
+TEST $CLI volume set $V0 performance.cache-replacement-policy lru
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "lru" ioc_stat replacement_policy
+drop_cache $M0
+TEST dd if=$M0/scan of=/dev/null bs=128k
+EXPECT "$hot" echo "$(md5sum < $M0/hot)"
+
+cleanup;
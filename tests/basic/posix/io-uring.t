@@ -0,0 +1,48 @@
+#!/bin/bash
+#Test the io_uring engine of the posix xlator.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 performance.write-behind off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 storage.linux-io_uring on
+
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" online_brick_count
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+TEST dd if=/dev/urandom of=$B0/src bs=128k count=64
+TEST dd if=$B0/src of=$M0/file bs=128k count=64 conv=fsync
+TEST fallocate -l 16M $M0/file2
+EXPECT "16777216" stat -c %s $M0/file2
+
+#Read back through the mount with the caches dropped
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+TEST cmp $B0/src $M0/file
+TEST cmp $B0/src $B0/${V0}0/file
+TEST cmp $B0/src $B0/${V0}1/file
+
+#O_DIRECT writes, the ones not aligned in memory go through the
+#synchronous path
+TEST $CLI volume set $V0 performance.strict-o-direct on
+TEST dd if=$B0/src of=$M0/file3 bs=4k count=64 oflag=direct
+TEST cmp -n 262144 $B0/src $B0/${V0}0/file3
+TEST $CLI volume set $V0 performance.strict-o-direct off
+
+#Switch back to synchronous IO at runtime
+TEST $CLI volume set $V0 storage.linux-io_uring off
+TEST dd if=/dev/urandom of=$M0/file bs=128k count=8 conv=notrunc,fsync
+TEST cmp $B0/${V0}0/file $B0/${V0}1/file
+
+cleanup;
@@ -0,0 +1,48 @@
+#!/bin/bash
+#Test the batched submission of the linux-aio engine of the posix xlator.
+
+. $(dirname $0)/../../include.rc
+. $(dirname $0)/../../volume.rc
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 replica 2 $H0:$B0/${V0}{0,1}
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 performance.open-behind off
+TEST $CLI volume set $V0 storage.linux-aio on
+
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "2" online_brick_count
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+TEST dd if=/dev/urandom of=$B0/src bs=128k count=64
+
+#Aligned writes of several files at once, contiguous ones get merged
+for i in {1..8}; do
+        dd if=$B0/src of=$M0/file$i bs=4k oflag=direct conv=fsync &
+done
+wait
+
+#Unaligned writes mixed with aligned ones on the same file
+TEST dd if=$B0/src of=$M0/mixed bs=4k count=64 oflag=direct
+TEST dd if=$B0/src of=$M0/mixed bs=1000 skip=262 seek=262 count=64 \
+        conv=notrunc,fsync
+TEST dd if=$B0/src of=$M0/mixed bs=4k skip=80 seek=80 oflag=direct \
+        conv=notrunc,fsync
+
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+for i in {1..8}; do
+        TEST cmp $B0/src $M0/file$i
+        TEST cmp $B0/src $B0/${V0}0/file$i
+        TEST cmp $B0/src $B0/${V0}1/file$i
+done
+TEST cmp $B0/src $M0/mixed
+TEST cmp $B0/${V0}0/mixed $B0/${V0}1/mixed
+
+cleanup;
@@ -0,0 +1,43 @@
+#!/bin/bash
+#Test the latency percentiles reported by 'volume profile' and statedumps.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+#Counts the percentile headers in the sections of $1 whose title has $2
+function percentile_headers {
+        echo "$1" | awk -v s="$2" '/Stats:$/ {in_s = index($0, s) > 0}
+                                   in_s && /P50-Latency/ {n++}
+                                   END {print n + 0}'
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 diagnostics.stats-dump-interval 3600
+TEST $CLI volume start $V0
+TEST $CLI volume profile $V0 start
+TEST $GFS --volfile-server=$H0 --volfile-id=$V0 $M0
+
+TEST dd if=/dev/zero of=$M0/file bs=128k count=64 conv=fsync
+
+output=$($CLI volume profile $V0 info)
+EXPECT "1" percentile_headers "$output" "Cumulative"
+EXPECT "1" percentile_headers "$output" "Interval"
+TEST echo "$output" | grep -E "us +WRITE$"
+
+#The incremental stats were cleared by the previous call
+output=$($CLI volume profile $V0 info incremental)
+EXPECT "0" percentile_headers "$output" "Interval"
+
+output=$($CLI --xml volume profile $V0 info cumulative)
+TEST echo "$output" | grep "<p99Latency>"
+
+#Every xlator of the brick keeps its own histograms
+statedump=$(generate_brick_statedump $V0 $H0 $B0/${V0}0)
+TEST grep -E "WRITE.percentiles=CNT:[0-9]+,P50:[0-9]+" $statedump
+
+cleanup;
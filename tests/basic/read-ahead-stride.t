@@ -0,0 +1,58 @@
+#!/bin/bash
+#Test the detection of strided and reverse reads by read-ahead, and its
+#per-fd counters.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function ra_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+#Reads 64KB every 256KB, forward or backward, on the fd given
+function strided_read {
+        $PYTHON -c "
+import os
+for i in range(32):
+    off = (i if '$2' == 'forward' else 31 - i) * 262144
+    assert len(os.pread($1, 65536, off)) == 65536
+"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.read-ahead on
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+
+TEST dd if=/dev/urandom of=$M0/file bs=1M count=8
+
+exec 5<$M0/file
+TEST strided_read 5 forward
+EXPECT "1" ra_stat strided-streams
+EXPECT_NOT "0" ra_stat prefetch-hits
+exec 5<&-
+
+exec 5<$M0/file
+TEST strided_read 5 backward
+EXPECT "1" ra_stat reverse-streams
+EXPECT_NOT "0" ra_stat prefetch-hits
+exec 5<&-
+
+#Plain sequential reads still work as before
+exec 5<$M0/file
+TEST dd bs=128k count=64 of=/dev/null <&5
+EXPECT_NOT "0" ra_stat sequential-streams
+EXPECT_NOT "0" ra_stat prefetch-hits
+exec 5<&-
+
+EXPECT "$(md5sum < $B0/${V0}0/file)" echo "$(md5sum < $M0/file)"
+
+cleanup;
@@ -0,0 +1,45 @@
+#!/bin/bash
+#Test the batched writes of the socket transport.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function brick_dump_value() {
+    local fname=$(generate_statedump $(get_brick_pid $V0 $H0 $B0/${V0}0))
+    grep "^server.$1=" $fname | cut -f2 -d'='
+    rm -f $fname
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.io-cache off
+TEST $CLI volume set $V0 performance.read-ahead off
+TEST $CLI volume set $V0 performance.quick-read off
+TEST $CLI volume set $V0 server.zerocopy-threshold 64KB
+TEST $CLI volume start $V0
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "1" online_brick_count
+
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+
+TEST dd if=/dev/urandom of=$B0/src bs=128k count=64
+TEST dd if=$B0/src of=$M0/file bs=128k count=64 conv=fsync
+
+#Many small replies in flight at the same time
+for i in {1..64}; do
+    stat $M0/file > /dev/null &
+done
+wait
+
+#Read back the big replies, sent with MSG_ZEROCOPY when available
+EXPECT "Y" force_umount $M0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 $M0
+TEST cmp $B0/src $M0/file
+
+TEST [ $(brick_dump_value total-msgs-write) -gt 0 ]
+TEST [ $(brick_dump_value total-write-calls) -gt 0 ]
+
+cleanup;
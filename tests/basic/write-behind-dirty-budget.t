@@ -0,0 +1,70 @@
+#!/bin/bash
+#Test the dirty budget of write-behind and the background syncing of writes
+#held for aggregation.
+
+. $(dirname $0)/../include.rc
+. $(dirname $0)/../volume.rc
+
+function wb_stat {
+        local fpath=$(generate_mount_statedump $V0 $M0)
+        grep -a "^$1=" $fpath | head -1 | cut -f2 -d'='
+        rm -f $fpath
+}
+
+function ingested {
+        test -e $M0/done && echo "Y"
+}
+
+#Writes 96KB to each of 16 files, 4KB at a time round robin, and keeps them
+#open for a while
+function ingest {
+        exec $PYTHON -c "
+import os, time
+fds = [os.open('$M0/file%d' % i, os.O_CREAT | os.O_WRONLY) for i in range(16)]
+for off in range(0, 98304, 4096):
+    for fd in fds:
+        os.pwrite(fd, b'x' * 4096, off)
+open('$M0/done', 'w').close()
+time.sleep(30)
+"
+}
+
+cleanup;
+
+TEST glusterd
+TEST pidof glusterd
+TEST $CLI volume create $V0 $H0:$B0/${V0}0
+TEST $CLI volume set $V0 performance.write-behind on
+TEST $CLI volume set $V0 performance.write-behind-trickling-writes off
+TEST $CLI volume set $V0 performance.write-behind-dirty-budget 64KB
+TEST $CLI volume set $V0 performance.write-behind-writeback-interval 1
+TEST $CLI volume start $V0
+TEST $GFS --volfile-id=/$V0 --volfile-server=$H0 --direct-io-mode=yes $M0
+
+EXPECT "65536" wb_stat dirty_budget
+
+ingest &
+pid=$!
+EXPECT_WITHIN $PROCESS_UP_TIMEOUT "Y" ingested
+
+#The 1.5MB written are way beyond the budget, so some of the writes to the
+#files holding their share of it were not written behind
+EXPECT_NOT "0" wb_stat throttled_writes
+
+#Writes held back for aggregation are synced while the files are open
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" wb_stat dirty
+EXPECT_NOT "0" wb_stat background_syncs
+EXPECT "98304" stat -c %s $B0/${V0}0/file7
+
+kill $pid
+wait $pid
+
+for i in {0..15}; do
+        EXPECT "98304" stat -c %s $M0/file$i
+done
+EXPECT "$(md5sum < $B0/${V0}0/file0)" echo "$(md5sum < $M0/file15)"
+
+TEST $CLI volume set $V0 performance.write-behind-dirty-budget 0
+EXPECT_WITHIN $CONFIG_UPDATE_TIMEOUT "0" wb_stat dirty_budget
+
+cleanup;
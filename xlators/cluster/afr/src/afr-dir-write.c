@@ -432,6 +432,10 @@ afr_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     int ret = -1;
     int op_errno = ENOMEM;
 
+    /* the data must be written in a data transaction, by a regular writev */
+    if (xdata)
+        dict_del_sizen(xdata, GF_CREATE_WRITE_KEY);
+
     transaction_frame = copy_frame(frame);
     if (!transaction_frame)
         goto out;
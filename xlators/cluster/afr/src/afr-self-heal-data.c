@@ -225,45 +225,197 @@ __afr_selfheal_data_read_write(call_frame_t *frame, xlator_t *this, fd_t *fd,
     return ret;
 }
 
+static int
+__afr_selfheal_data_block(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                          int source, unsigned char *healed_sinks, off_t offset,
+                          size_t size, int type, struct afr_reply *replies)
+{
+    if (type == AFR_SELFHEAL_DATA_DIFF &&
+        __afr_can_skip_data_block_heal(frame, this, fd, source, healed_sinks,
+                                       offset, size,
+                                       &replies[source].poststat))
+        return 0;
+
+    return __afr_selfheal_data_read_write(frame, this, fd, source,
+                                          healed_sinks, offset, size, replies,
+                                          type);
+}
+
+typedef struct afr_data_heal_block {
+    call_frame_t *frame;
+    xlator_t *this;
+    fd_t *fd;
+    int source;
+    unsigned char *healed_sinks;
+    off_t offset;
+    size_t size;
+    int type;
+    struct afr_reply *replies;
+    syncbarrier_t *barrier;
+    int ret;
+} afr_data_heal_block_t;
+
+static int
+afr_selfheal_data_block_task(void *opaque)
+{
+    afr_data_heal_block_t *blk = opaque;
+
+    blk->ret = __afr_selfheal_data_block(
+        blk->frame, blk->this, blk->fd, blk->source, blk->healed_sinks,
+        blk->offset, blk->size, blk->type, blk->replies);
+
+    return 0;
+}
+
+static int
+afr_selfheal_data_block_done(int ret, call_frame_t *frame, void *opaque)
+{
+    afr_data_heal_block_t *blk = opaque;
+
+    syncbarrier_wake(blk->barrier);
+
+    return 0;
+}
+
+/* Heals 'count' consecutive blocks with a single lock. When there are more
+ * than one, the checksums, reads and writes of every block are done by its
+ * own synctask, so that they are all in flight at the same time. Each one
+ * works on a private copy of the sinks, which are merged at the end. */
 static int
 afr_selfheal_data_block(call_frame_t *frame, xlator_t *this, fd_t *fd,
                         int source, unsigned char *healed_sinks, off_t offset,
-                        size_t size, int type, struct afr_reply *replies)
+                        size_t size, int count, int type,
+                        struct afr_reply *replies)
 {
     int ret = -1;
     int sink_count = 0;
     afr_private_t *priv = NULL;
     unsigned char *data_lock = NULL;
+    afr_data_heal_block_t *blocks = NULL;
+    afr_data_heal_block_t *blk = NULL;
+    syncbarrier_t barrier;
+    int launched = 0;
+    int i = 0;
+    int j = 0;
 
     priv = this->private;
     sink_count = AFR_COUNT(healed_sinks, priv->child_count);
     data_lock = alloca0(priv->child_count);
 
-    ret = afr_selfheal_inodelk(frame, this, fd->inode, this->name, offset, size,
-                               data_lock);
+    ret = afr_selfheal_inodelk(frame, this, fd->inode, this->name, offset,
+                               size * count, data_lock);
     {
         if (ret < sink_count) {
             ret = -ENOTCONN;
             goto unlock;
         }
 
-        if (type == AFR_SELFHEAL_DATA_DIFF &&
-            __afr_can_skip_data_block_heal(frame, this, fd, source,
-                                           healed_sinks, offset, size,
-                                           &replies[source].poststat)) {
-            ret = 0;
+        if (count == 1) {
+            ret = __afr_selfheal_data_block(frame, this, fd, source,
+                                            healed_sinks, offset, size, type,
+                                            replies);
             goto unlock;
         }
 
-        ret = __afr_selfheal_data_read_write(
-            frame, this, fd, source, healed_sinks, offset, size, replies, type);
+        ret = syncbarrier_init(&barrier);
+        if (ret) {
+            ret = -ENOMEM;
+            goto unlock;
+        }
+
+        blocks = alloca0(sizeof(*blocks) * count);
+        for (i = 0; i < count; i++) {
+            blk = &blocks[i];
+            blk->this = this;
+            blk->fd = fd;
+            blk->source = source;
+            blk->offset = offset + i * size;
+            blk->size = size;
+            blk->type = type;
+            blk->replies = replies;
+            blk->barrier = &barrier;
+            blk->healed_sinks = alloca0(priv->child_count);
+            memcpy(blk->healed_sinks, healed_sinks, priv->child_count);
+            blk->frame = afr_copy_frame(frame);
+            if (!blk->frame) {
+                blk->ret = -ENOMEM;
+                continue;
+            }
+
+            if (synctask_new(this->ctx->env, afr_selfheal_data_block_task,
+                             afr_selfheal_data_block_done, NULL, blk) == 0) {
+                launched++;
+            } else {
+                afr_selfheal_data_block_task(blk);
+            }
+        }
+        syncbarrier_wait(&barrier, launched);
+        syncbarrier_destroy(&barrier);
+
+        ret = 0;
+        for (i = 0; i < count; i++) {
+            blk = &blocks[i];
+            if (blk->frame)
+                AFR_STACK_DESTROY(blk->frame);
+            if (blk->ret < 0 && ret == 0)
+                ret = blk->ret;
+            for (j = 0; j < priv->child_count; j++) {
+                if (!blk->healed_sinks[j])
+                    healed_sinks[j] = 0;
+            }
+        }
     }
 unlock:
-    afr_selfheal_uninodelk(frame, this, fd->inode, this->name, offset, size,
-                           data_lock);
+    afr_selfheal_uninodelk(frame, this, fd->inode, this->name, offset,
+                           size * count, data_lock);
     return ret;
 }
 
+/* Returns the offset of the first block at or after 'offset' that may have
+ * data on the source or on any of the sinks. Regions that are holes in all
+ * of them don't need to be healed. If some brick can't tell where its data
+ * is, nothing is skipped.
+ *
+ * 'data' keeps, for each brick, where its data was found last time (-1 if
+ * it hasn't been asked yet). A brick is only asked again once the heal has
+ * gone past that point, and none is asked once one has data at 'offset'. */
+static off_t
+afr_selfheal_data_next(xlator_t *this, fd_t *fd, int source,
+                       unsigned char *healed_sinks, off_t *data, off_t offset,
+                       size_t block, off_t end)
+{
+    afr_private_t *priv = NULL;
+    off_t next = end;
+    int ret = 0;
+    int i = 0;
+
+    priv = this->private;
+
+    for (i = 0; i < priv->child_count; i++) {
+        if (i != source && !healed_sinks[i])
+            continue;
+
+        if (data[i] < offset) {
+            ret = syncop_seek(priv->children[i], fd, offset, GF_SEEK_DATA,
+                              NULL, &data[i]);
+            if (ret == -ENXIO) {
+                data[i] = end;
+            } else if (ret < 0) {
+                data[i] = -1;
+                return offset;
+            }
+        }
+
+        if (data[i] <= offset)
+            return offset;
+        if (data[i] < next)
+            next = data[i];
+    }
+
+    /* The last block needs to be written anyway, if it's a hole. */
+    return min(next, end - 1) / block * block;
+}
+
 static int
 afr_selfheal_data_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd,
                         unsigned char *healed_sinks)
@@ -318,11 +470,15 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
 {
     afr_private_t *priv = NULL;
     off_t off = 0;
+    off_t end = 0;
     size_t block = 0;
+    int count = 0;
     int type = AFR_SELFHEAL_DATA_FULL;
     int ret = -1;
+    int i = 0;
     call_frame_t *iter_frame = NULL;
     unsigned char arbiter_sink_status = 0;
+    off_t *data = NULL;
 
     gf_msg(this->name, GF_LOG_INFO, 0, AFR_MSG_SELF_HEAL_INFO,
            "performing data selfheal on %s", uuid_utoa(fd->inode->gfid));
@@ -337,20 +493,34 @@ afr_selfheal_data_do(call_frame_t *frame, xlator_t *this, fd_t *fd, int source,
 
     type = afr_data_self_heal_type_get(priv, healed_sinks, source, replies);
 
+    data = alloca(priv->child_count * sizeof(*data));
+    for (i = 0; i < priv->child_count; i++)
+        data[i] = -1;
+
     iter_frame = afr_copy_frame(frame);
     if (!iter_frame) {
         ret = -ENOMEM;
         goto out;
     }
 
-    for (off = 0; off < replies[source].poststat.ia_size; off += block) {
+    end = replies[source].poststat.ia_size;
+    for (off = 0; off < end; off += block * count) {
         if (AFR_COUNT(healed_sinks, priv->child_count) == 0) {
             ret = -ENOTCONN;
             goto out;
         }
 
+        if (HAS_HOLES((&replies[source].poststat)))
+            off = afr_selfheal_data_next(this, fd, source, healed_sinks, data,
+                                         off, block, end);
+
+        count = priv->data_self_heal_pipeline_depth;
+        if (off + block * count > end)
+            count = (end - off + block - 1) / block;
+
         ret = afr_selfheal_data_block(iter_frame, this, fd, source,
-                                      healed_sinks, off, block, type, replies);
+                                      healed_sinks, off, block, count, type,
+                                      replies);
         if (ret < 0)
             goto out;
 
@@ -398,6 +398,51 @@ afr_shd_sweep_done(struct subvol_healer *healer)
     _unmask_cancellation();
 }
 
+static void
+afr_shd_sleep_done(void *data)
+{
+    syncbarrier_wake(data);
+}
+
+/* Waits until the next heal is allowed by shd-heal-rate-limit. Heals are
+ * run from synctasks, so the wait can't block the thread. */
+static void
+afr_shd_rate_limit(struct subvol_healer *healer)
+{
+    afr_private_t *priv = NULL;
+    struct timespec now;
+    struct timespec delta;
+    syncbarrier_t barrier;
+    uint64_t usecs = 0;
+    uint64_t slot = 0;
+    uint32_t rate = 0;
+
+    priv = healer->this->private;
+    rate = priv->shd.heal_rate_limit;
+    if (rate == 0)
+        return;
+
+    timespec_now(&now);
+    usecs = now.tv_sec * 1000000ULL + now.tv_nsec / 1000;
+
+    pthread_mutex_lock(&healer->mutex);
+    {
+        slot = max(usecs, healer->next_heal);
+        healer->next_heal = slot + 1000000 / rate;
+    }
+    pthread_mutex_unlock(&healer->mutex);
+
+    if (slot == usecs || syncbarrier_init(&barrier))
+        return;
+
+    delta.tv_sec = (slot - usecs) / 1000000;
+    delta.tv_nsec = ((slot - usecs) % 1000000) * 1000;
+    if (gf_timer_call_after(healer->this->ctx, delta, afr_shd_sleep_done,
+                            &barrier))
+        syncbarrier_wait(&barrier, 1);
+    syncbarrier_destroy(&barrier);
+}
+
 int
 afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
                    void *data)
@@ -421,6 +466,8 @@ afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
 
     inode_ctx_get2(parent->inode, subvol, NULL, &val);
 
+    afr_shd_rate_limit(healer);
+
     ret = afr_shd_selfheal(healer, healer->subvol, gfid);
 
     if (ret == -ENOENT || ret == -ESTALE)
@@ -437,6 +484,16 @@ afr_shd_index_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
     return 0;
 }
 
+static int
+afr_shd_index_heal_dir(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
+                       void *data)
+{
+    if (entry->d_type != DT_DIR)
+        return 0;
+
+    return afr_shd_index_heal(subvol, entry, parent, data);
+}
+
 int
 afr_shd_index_sweep(struct subvol_healer *healer, char *vgfid)
 {
@@ -471,6 +528,20 @@ afr_shd_index_sweep(struct subvol_healer *healer, char *vgfid)
         goto out;
     }
 
+    /* When several entries are healed in parallel, the files could be
+     * healed before the directories that contain them, and fail because
+     * they don't exist yet on the sinks. Heal the directories first. */
+    if (priv->shd.max_threads > 1 &&
+        !strcmp(vgfid, GF_XATTROP_INDEX_GFID)) {
+        ret = syncop_mt_dir_scan(frame, subvol, &loc,
+                                 GF_CLIENT_PID_SELF_HEALD, healer,
+                                 afr_shd_index_heal_dir, xdata,
+                                 priv->shd.max_threads,
+                                 priv->shd.wait_qlength);
+        if (ret < 0)
+            goto out;
+    }
+
     ret = syncop_mt_dir_scan(frame, subvol, &loc, GF_CLIENT_PID_SELF_HEALD,
                              healer, afr_shd_index_heal, xdata,
                              priv->shd.max_threads, priv->shd.wait_qlength);
@@ -43,6 +43,8 @@ struct subvol_healer {
     gf_boolean_t local;
     gf_boolean_t running;
     gf_boolean_t rerun;
+    uint64_t next_heal; /* Earliest time (usecs) for the next index heal
+                           when the heal rate is limited. */
 };
 
 typedef struct {
@@ -54,6 +56,7 @@ typedef struct {
     int timeout;
     uint32_t max_threads;
     uint32_t wait_qlength;
+    uint32_t heal_rate_limit;
     uint32_t halo_max_latency_msec;
     gf_boolean_t iamshd;
     gf_boolean_t enabled;
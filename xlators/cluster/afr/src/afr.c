@@ -176,6 +176,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("data-self-heal-window-size",
                      priv->data_self_heal_window_size, options, uint32, out);
 
+    GF_OPTION_RECONF("data-self-heal-pipeline-depth",
+                     priv->data_self_heal_pipeline_depth, options, uint32, out);
+
     GF_OPTION_RECONF("data-self-heal-algorithm", data_self_heal_algorithm,
                      options, str, out);
     set_data_self_heal_algorithm(priv, data_self_heal_algorithm);
@@ -275,6 +278,9 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("shd-wait-qlength", priv->shd.wait_qlength, options,
                      uint32, out);
 
+    GF_OPTION_RECONF("shd-heal-rate-limit", priv->shd.heal_rate_limit,
+                     options, uint32, out);
+
     GF_OPTION_RECONF("favorite-child-policy", fav_child_policy, options, str,
                      out);
     if (afr_set_favorite_child_policy(priv, fav_child_policy) == -1)
@@ -477,6 +483,9 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("shd-wait-qlength", priv->shd.wait_qlength, uint32, out);
 
+    GF_OPTION_INIT("shd-heal-rate-limit", priv->shd.heal_rate_limit, uint32,
+                   out);
+
     GF_OPTION_INIT("background-self-heal-count",
                    priv->background_self_heal_count, uint32, out);
 
@@ -492,6 +501,9 @@ init(xlator_t *this)
     GF_OPTION_INIT("data-self-heal-window-size",
                    priv->data_self_heal_window_size, uint32, out);
 
+    GF_OPTION_INIT("data-self-heal-pipeline-depth",
+                   priv->data_self_heal_pipeline_depth, uint32, out);
+
     GF_OPTION_INIT("metadata-self-heal", priv->metadata_self_heal, bool, out);
 
     GF_OPTION_INIT("entry-self-heal", priv->entry_self_heal, bool, out);
@@ -948,6 +960,17 @@ struct volume_options options[] = {
      .tags = {"replicate"},
      .description = "Maximum number blocks per file for which self-heal "
                     "process would be applied simultaneously."},
+    {.key = {"data-self-heal-pipeline-depth"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Number of consecutive blocks of a file that are locked "
+                    "and healed at the same time. The checksums, reads and "
+                    "writes of all of them are sent in parallel."},
     {.key = {"metadata-self-heal"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "off",
@@ -1217,6 +1240,17 @@ struct volume_options options[] = {
         .description = "This option can be used to control number of heals"
                        " that can wait in SHD per subvolume",
     },
+    {.key = {"shd-heal-rate-limit"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 1000000,
+     .default_value = "0",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC,
+     .tags = {"replicate"},
+     .description = "Maximum number of entries per second that SHD heals "
+                    "from the index of each local brick, to limit the load "
+                    "of the heals on the bricks. 0 means no limit."},
     {
         .key = {"locking-scheme"},
         .type = GF_OPTION_TYPE_STR,
@@ -199,6 +199,8 @@ typedef struct _afr_private {
     afr_data_self_heal_type_t data_self_heal_algorithm;
     unsigned int data_self_heal_window_size; /* max number of pipelined
                                                 read/writes */
+    unsigned int data_self_heal_pipeline_depth; /* blocks healed at the
+                                                   same time */
 
     struct list_head heal_waiting; /*queue for files that need heal*/
     uint32_t heal_wait_qlen; /*configurable queue length for heal_waiting*/
@@ -2328,6 +2328,10 @@ dht_lookup_everywhere_done(call_frame_t *frame, xlator_t *this)
                          "unlink on hashed is not skipped %s",
                          local->loc.path);
 
+            /* Not cached if some subvolume failed with another error */
+            if (local->op_errno == ENOENT)
+                dht_negative_cache_add(this, &local->loc);
+
             DHT_STACK_UNWIND(lookup, frame, -1, ENOENT, NULL, NULL, NULL, NULL);
         }
         return 0;
@@ -3043,6 +3047,8 @@ dht_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     dht_local_t *local = NULL;
     loc_t *loc = NULL;
     xlator_t *prev = NULL;
+    dht_layout_t *layout = NULL;
+    xlator_t *mds_subvol = NULL;
     int ret = 0;
     uint32_t vol_commit_hash = 0;
 
@@ -3073,6 +3079,10 @@ dht_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
                          loc->path, prev->name);
 
             if (dht_should_lookup_everywhere(this, conf, loc)) {
+                /* Not found anywhere by a recent lookup */
+                if (dht_negative_cache_check(this, loc))
+                    goto out;
+
                 local->op_errno = ENOENT;
                 dht_lookup_everywhere(frame, this, loc);
                 return 0;
@@ -3114,6 +3124,21 @@ dht_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
 
     is_dir = check_is_dir(inode, stbuf, xattr);
     if (is_dir) {
+        /* The layout is still valid if the directory was forgotten
+         * recently, there is no need to read it from all subvols */
+        if (!__is_root_gfid(stbuf->ia_gfid)) {
+            layout = dht_layout_cache_get(this, stbuf->ia_gfid, &mds_subvol);
+            if (layout) {
+                dht_layout_set(this, inode, layout);
+                dht_layout_unref(this, layout);
+                if (mds_subvol)
+                    dht_inode_ctx_mdsvol_set(inode, this, mds_subvol);
+                dht_inode_ctx_time_update(inode, this, stbuf, 1);
+                GF_REMOVE_INTERNAL_XATTR(conf->mds_xattr_key, xattr);
+                goto out;
+            }
+        }
+
         /* A directory is present on all subvols, send the lookup to
          * all subvols now */
         local->inode = inode_ref(inode);
@@ -6689,6 +6714,7 @@ dht_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
     inode_table_t *itable = NULL;
     inode_t *inode = NULL;
     gf_boolean_t skip_hashed_check = _gf_false;
+    gf_boolean_t eof = (op_ret <= 0) || (op_errno == ENOENT);
 
     INIT_LIST_HEAD(&entries.list);
 
@@ -6932,12 +6958,17 @@ done:
             }
         }
 
-        STACK_WIND_COOKIE(frame, dht_readdirp_cbk, next_subvol, next_subvol,
-                          next_subvol->fops->readdirp, local->fd, local->size,
-                          next_offset, local->xattr);
+        dht_readdirp_wind(frame, this, next_subvol, next_offset);
         return 0;
     }
 
+    /* The next entries of this subvol will be requested from the last
+     * one returned */
+    if ((count > 0) && !eof) {
+        entry = list_last_entry(&entries.list, gf_dirent_t, list);
+        dht_readdirp_prefetch_next(frame, this, prev, entry->d_off);
+    }
+
 unwind:
     /* We need to ensure that only the last subvolume's end-of-directory
      * notification is respected so that directory reading does not stop
@@ -7154,8 +7185,7 @@ dht_do_readdir(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
             }
         }
 
-        STACK_WIND_COOKIE(frame, dht_readdirp_cbk, xvol, xvol,
-                          xvol->fops->readdirp, fd, size, yoff, local->xattr);
+        dht_readdirp_wind(frame, this, xvol, yoff);
     } else {
         STACK_WIND_COOKIE(frame, dht_readdir_cbk, xvol, xvol,
                           xvol->fops->readdir, fd, size, yoff, local->xattr);
@@ -10665,6 +10695,7 @@ dht_forget(xlator_t *this, inode_t *inode)
 
     layout = ctx->layout;
     ctx->layout = NULL;
+    dht_layout_cache_save(this, inode, layout, ctx->mds_subvol);
     dht_layout_unref(this, layout);
     GF_FREE(ctx);
 
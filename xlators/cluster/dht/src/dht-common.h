@@ -595,6 +595,9 @@ struct gf_defrag_info_ {
     /*stands for current running thread count*/
     int32_t current_thread_count;
 
+    /* Migrator threads busy with a large file, protected by dfq_mutex */
+    int32_t large_file_count;
+
     gf_boolean_t stats;
     /* lock migration flag */
     gf_boolean_t lock_migration_enabled;
@@ -612,6 +615,18 @@ struct dht_methods_s {
 
 typedef struct dht_methods_s dht_methods_t;
 
+typedef struct dht_lookup_cache_entry dht_lookup_cache_entry_t;
+
+/* Cache of directory layouts or of names not found on any subvolume. */
+typedef struct dht_lookup_cache {
+    gf_lock_t lock;
+    struct list_head *buckets;
+    struct list_head lru;
+    uint32_t count;
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+} dht_lookup_cache_t;
+
 struct dht_conf {
     xlator_t **subvolumes;
     char *subvolume_status;
@@ -691,6 +706,18 @@ struct dht_conf {
 
     gf_boolean_t force_migration;
 
+    /* Number of ranges of a large file copied in parallel by rebalance */
+    uint32_t rebal_copy_streams;
+
+    /* Layouts of forgotten directories and names not found anywhere */
+    dht_lookup_cache_t layout_cache;
+    dht_lookup_cache_t negative_cache;
+    uint32_t lookup_cache_timeout;
+    uint32_t lookup_cache_size;
+
+    /* Bytes of directory entries prefetched per fd, 0 if disabled */
+    uint64_t readdir_prefetch_size;
+
     gf_boolean_t lookup_optimize;
 
     gf_boolean_t unhashed_sticky_bit;
@@ -1550,4 +1577,44 @@ dht_pt_rename(call_frame_t *frame, xlator_t *this, loc_t *oldloc, loc_t *newloc,
 int32_t
 dht_check_remote_fd_failed_error(dht_local_t *local, int op_ret, int op_errno);
 
+int
+dht_lookup_cache_init(xlator_t *this, dht_lookup_cache_t *cache);
+
+void
+dht_lookup_cache_fini(xlator_t *this, dht_lookup_cache_t *cache);
+
+void
+dht_lookup_cache_dump(xlator_t *this);
+
+void
+dht_layout_cache_save(xlator_t *this, inode_t *inode, dht_layout_t *layout,
+                      xlator_t *mds_subvol);
+
+dht_layout_t *
+dht_layout_cache_get(xlator_t *this, uuid_t gfid, xlator_t **mds_subvol);
+
+void
+dht_negative_cache_add(xlator_t *this, loc_t *loc);
+
+gf_boolean_t
+dht_negative_cache_check(xlator_t *this, loc_t *loc);
+
+int
+dht_readdirp_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int op_ret,
+                 int op_errno, gf_dirent_t *orig_entries, dict_t *xdata);
+
+int
+dht_readdirp_wind(call_frame_t *frame, xlator_t *this, xlator_t *subvol,
+                  off_t offset);
+
+void
+dht_readdirp_prefetch_next(call_frame_t *frame, xlator_t *this,
+                           xlator_t *subvol, off_t offset);
+
+int
+dht_readdirp_prefetch_release(xlator_t *this, fd_t *fd);
+
+void
+dht_readdirp_prefetch_invalidate(xlator_t *this, inode_t *inode);
+
 #endif /* _DHT_H */
@@ -220,6 +220,8 @@ dht_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
     local->rebalance.iobref = iobref_ref(iobref);
     local->call_cnt = 1;
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     STACK_WIND_COOKIE(frame, dht_writev_cbk, subvol, subvol,
                       subvol->fops->writev, fd, local->rebalance.vector,
                       local->rebalance.count, local->rebalance.offset,
@@ -410,6 +412,8 @@ dht_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, loc->inode);
+
     STACK_WIND_COOKIE(frame, dht_truncate_cbk, subvol, subvol,
                       subvol->fops->truncate, loc, offset, xdata);
 
@@ -452,6 +456,8 @@ dht_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     STACK_WIND_COOKIE(frame, dht_truncate_cbk, subvol, subvol,
                       subvol->fops->ftruncate, fd, local->rebalance.offset,
                       local->xattr_req);
@@ -628,6 +634,8 @@ dht_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     STACK_WIND_COOKIE(frame, dht_fallocate_cbk, subvol, subvol,
                       subvol->fops->fallocate, fd, local->rebalance.flags,
                       local->rebalance.offset, local->rebalance.size,
@@ -802,6 +810,8 @@ dht_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     STACK_WIND_COOKIE(frame, dht_discard_cbk, subvol, subvol,
                       subvol->fops->discard, fd, local->rebalance.offset,
                       local->rebalance.size, local->xattr_req);
@@ -977,6 +987,8 @@ dht_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     STACK_WIND_COOKIE(frame, dht_zerofill_cbk, subvol, subvol,
                       subvol->fops->zerofill, fd, local->rebalance.offset,
                       local->rebalance.size, local->xattr_req);
@@ -1271,6 +1283,8 @@ dht_setattr(call_frame_t *frame, xlator_t *this, loc_t *loc, struct iatt *stbuf,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, loc->inode);
+
     if (IA_ISREG(loc->inode->ia_type)) {
         /* in the regular file _cbk(), we need to check for
            migration possibilities */
@@ -1373,6 +1387,8 @@ dht_fsetattr(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iatt *stbuf,
     if (xdata)
         local->xattr_req = dict_ref(xdata);
 
+    dht_readdirp_prefetch_invalidate(this, fd->inode);
+
     if (IA_ISREG(fd->inode->ia_type)) {
         /* in the regular file _cbk(), we need to check for
            migration possibilities */
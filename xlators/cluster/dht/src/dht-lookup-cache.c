@@ -0,0 +1,361 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Client side caches that avoid sending lookups to all the subvolumes.
+ *
+ * The layout cache keeps the layout of directories whose inode has been
+ * forgotten. When the directory is looked up again, the cached layout is
+ * used instead of reading it from all the subvolumes.
+ *
+ * The negative cache keeps the names which were not found on any subvolume
+ * by a lookup everywhere. A new lookup of the name which fails on the hashed
+ * subvolume is not sent everywhere again.
+ *
+ * Entries are only valid while the generation of the volume (which changes
+ * when subvolumes go up or down) and the commit hash of the layouts are the
+ * same as when they were added, and for at most lookup-cache-timeout
+ * seconds. */
+
+#include "dht-common.h"
+#include <glusterfs/hashfn.h>
+#include <glusterfs/statedump.h>
+
+#define DHT_LOOKUP_CACHE_BUCKETS 4096
+
+struct dht_lookup_cache_entry {
+    struct list_head hash;
+    struct list_head lru;
+    uuid_t gfid; /* directory for layouts, parent for names */
+    char *name;  /* NULL for layouts */
+    uint32_t hashval;
+    time_t expires;
+    int gen;
+    uint32_t commit_hash;
+    dht_layout_t *layout;
+    xlator_t *mds_subvol;
+};
+
+static uint32_t
+dht_lookup_cache_hash(uuid_t gfid, const char *name)
+{
+    uint32_t hashval = 0;
+
+    memcpy(&hashval, &gfid[12], sizeof(hashval));
+    if (name)
+        hashval ^= SuperFastHash(name, strlen(name));
+
+    return hashval;
+}
+
+int
+dht_lookup_cache_init(xlator_t *this, dht_lookup_cache_t *cache)
+{
+    int i = 0;
+
+    cache->buckets = GF_CALLOC(DHT_LOOKUP_CACHE_BUCKETS,
+                               sizeof(*cache->buckets),
+                               gf_dht_mt_lookup_cache_t);
+    if (!cache->buckets)
+        return -1;
+
+    for (i = 0; i < DHT_LOOKUP_CACHE_BUCKETS; i++)
+        INIT_LIST_HEAD(&cache->buckets[i]);
+    INIT_LIST_HEAD(&cache->lru);
+    LOCK_INIT(&cache->lock);
+    cache->count = 0;
+    GF_ATOMIC_INIT(cache->hits, 0);
+    GF_ATOMIC_INIT(cache->misses, 0);
+
+    return 0;
+}
+
+static void
+__dht_lookup_cache_del(xlator_t *this, dht_lookup_cache_t *cache,
+                       dht_lookup_cache_entry_t *entry)
+{
+    list_del(&entry->hash);
+    list_del(&entry->lru);
+    cache->count--;
+
+    if (entry->layout)
+        dht_layout_unref(this, entry->layout);
+    GF_FREE(entry->name);
+    GF_FREE(entry);
+}
+
+void
+dht_lookup_cache_fini(xlator_t *this, dht_lookup_cache_t *cache)
+{
+    dht_lookup_cache_entry_t *entry = NULL;
+    dht_lookup_cache_entry_t *tmp = NULL;
+
+    if (!cache->buckets)
+        return;
+
+    list_for_each_entry_safe(entry, tmp, &cache->lru, lru)
+    {
+        __dht_lookup_cache_del(this, cache, entry);
+    }
+
+    GF_FREE(cache->buckets);
+    cache->buckets = NULL;
+    LOCK_DESTROY(&cache->lock);
+}
+
+static dht_lookup_cache_entry_t *
+__dht_lookup_cache_find(dht_lookup_cache_t *cache, uuid_t gfid,
+                        const char *name, uint32_t hashval)
+{
+    dht_lookup_cache_entry_t *entry = NULL;
+    struct list_head *bucket = NULL;
+
+    bucket = &cache->buckets[hashval % DHT_LOOKUP_CACHE_BUCKETS];
+    list_for_each_entry(entry, bucket, hash)
+    {
+        if ((entry->hashval != hashval) || gf_uuid_compare(entry->gfid, gfid))
+            continue;
+        if ((name == NULL) != (entry->name == NULL))
+            continue;
+        if (name && strcmp(name, entry->name))
+            continue;
+
+        return entry;
+    }
+
+    return NULL;
+}
+
+/* Adds a new entry, replacing the previous one for the same key. The least
+ * recently added entry is dropped when the cache is full. */
+static void
+dht_lookup_cache_add(xlator_t *this, dht_lookup_cache_t *cache, uuid_t gfid,
+                     const char *name, uint32_t commit_hash,
+                     dht_layout_t *layout, xlator_t *mds_subvol)
+{
+    dht_conf_t *conf = this->private;
+    dht_lookup_cache_entry_t *entry = NULL;
+    dht_lookup_cache_entry_t *old = NULL;
+    uint32_t hashval = 0;
+
+    if (!cache->buckets || !conf->lookup_cache_timeout ||
+        !conf->lookup_cache_size)
+        return;
+
+    entry = GF_CALLOC(1, sizeof(*entry), gf_dht_mt_lookup_cache_t);
+    if (!entry)
+        return;
+    if (name) {
+        entry->name = gf_strdup(name);
+        if (!entry->name) {
+            GF_FREE(entry);
+            return;
+        }
+    }
+
+    hashval = dht_lookup_cache_hash(gfid, name);
+    gf_uuid_copy(entry->gfid, gfid);
+    entry->hashval = hashval;
+    entry->expires = time(NULL) + conf->lookup_cache_timeout;
+    entry->gen = conf->gen;
+    entry->commit_hash = commit_hash;
+    entry->mds_subvol = mds_subvol;
+    if (layout)
+        entry->layout = dht_layout_ref(this, layout);
+
+    LOCK(&cache->lock);
+    {
+        old = __dht_lookup_cache_find(cache, gfid, name, hashval);
+        if (old)
+            __dht_lookup_cache_del(this, cache, old);
+
+        while (cache->count >= conf->lookup_cache_size) {
+            old = list_first_entry(&cache->lru, dht_lookup_cache_entry_t, lru);
+            __dht_lookup_cache_del(this, cache, old);
+        }
+
+        list_add_tail(&entry->hash,
+                      &cache->buckets[hashval % DHT_LOOKUP_CACHE_BUCKETS]);
+        list_add_tail(&entry->lru, &cache->lru);
+        cache->count++;
+    }
+    UNLOCK(&cache->lock);
+}
+
+/* Returns the entry for the key if it's still valid, removing it from the
+ * cache when 'take' is set. Stale entries are dropped. Called with the
+ * cache lock held. */
+static dht_lookup_cache_entry_t *
+__dht_lookup_cache_get(xlator_t *this, dht_lookup_cache_t *cache, uuid_t gfid,
+                       const char *name, uint32_t commit_hash)
+{
+    dht_conf_t *conf = this->private;
+    dht_lookup_cache_entry_t *entry = NULL;
+
+    entry = __dht_lookup_cache_find(cache, gfid, name,
+                                    dht_lookup_cache_hash(gfid, name));
+    if (!entry)
+        return NULL;
+
+    if ((entry->gen != conf->gen) || (entry->commit_hash != commit_hash) ||
+        (entry->expires < time(NULL))) {
+        __dht_lookup_cache_del(this, cache, entry);
+        return NULL;
+    }
+
+    return entry;
+}
+
+void
+dht_layout_cache_save(xlator_t *this, inode_t *inode, dht_layout_t *layout,
+                      xlator_t *mds_subvol)
+{
+    dht_conf_t *conf = this->private;
+
+    /* forget can come after fini, like in dht_layout_unref() */
+    if (!conf)
+        return;
+
+    if (!layout || layout->preset || (inode->ia_type != IA_IFDIR) ||
+        __is_root_gfid(inode->gfid) || (layout->gen != conf->gen))
+        return;
+
+    dht_lookup_cache_add(this, &conf->layout_cache, inode->gfid, NULL,
+                         layout->commit_hash, layout, mds_subvol);
+}
+
+/* Returns a reference to the cached layout of the directory, if any. The
+ * entry is removed, the layout is cached again when the inode is
+ * forgotten. */
+dht_layout_t *
+dht_layout_cache_get(xlator_t *this, uuid_t gfid, xlator_t **mds_subvol)
+{
+    dht_conf_t *conf = this->private;
+    dht_lookup_cache_t *cache = &conf->layout_cache;
+    dht_lookup_cache_entry_t *entry = NULL;
+    dht_layout_t *layout = NULL;
+
+    if (!cache->buckets || !conf->lookup_cache_timeout)
+        return NULL;
+
+    LOCK(&cache->lock);
+    {
+        entry = __dht_lookup_cache_get(this, cache, gfid, NULL,
+                                       conf->vol_commit_hash);
+        if (entry) {
+            layout = entry->layout;
+            entry->layout = NULL;
+            *mds_subvol = entry->mds_subvol;
+            __dht_lookup_cache_del(this, cache, entry);
+        }
+    }
+    UNLOCK(&cache->lock);
+
+    if (layout)
+        GF_ATOMIC_INC(cache->hits);
+    else
+        GF_ATOMIC_INC(cache->misses);
+
+    return layout;
+}
+
+static int
+dht_negative_cache_key(xlator_t *this, loc_t *loc, uuid_t pargfid,
+                       uint32_t *commit_hash)
+{
+    dht_layout_t *layout = NULL;
+
+    if (!loc->parent || !loc->name)
+        return -1;
+
+    if (dht_inode_ctx_layout_get(loc->parent, this, &layout) || !layout)
+        return -1;
+
+    gf_uuid_copy(pargfid, loc->parent->gfid);
+    *commit_hash = layout->commit_hash;
+
+    return 0;
+}
+
+void
+dht_negative_cache_add(xlator_t *this, loc_t *loc)
+{
+    dht_conf_t *conf = this->private;
+    uuid_t pargfid = {0};
+    uint32_t commit_hash = 0;
+
+    if (conf->defrag ||
+        dht_negative_cache_key(this, loc, pargfid, &commit_hash))
+        return;
+
+    dht_lookup_cache_add(this, &conf->negative_cache, pargfid, loc->name,
+                         commit_hash, NULL, NULL);
+}
+
+/* Returns true if the name was not found on any subvolume by a recent
+ * lookup, with the same layout of the parent directory. */
+gf_boolean_t
+dht_negative_cache_check(xlator_t *this, loc_t *loc)
+{
+    dht_conf_t *conf = this->private;
+    dht_lookup_cache_t *cache = &conf->negative_cache;
+    dht_lookup_cache_entry_t *entry = NULL;
+    uuid_t pargfid = {0};
+    uint32_t commit_hash = 0;
+
+    if (!cache->buckets || !conf->lookup_cache_timeout || conf->defrag ||
+        dht_negative_cache_key(this, loc, pargfid, &commit_hash))
+        return _gf_false;
+
+    LOCK(&cache->lock);
+    {
+        entry = __dht_lookup_cache_get(this, cache, pargfid, loc->name,
+                                       commit_hash);
+    }
+    UNLOCK(&cache->lock);
+
+    if (entry) {
+        GF_ATOMIC_INC(cache->hits);
+        return _gf_true;
+    }
+
+    GF_ATOMIC_INC(cache->misses);
+    return _gf_false;
+}
+
+static void
+dht_lookup_cache_dump_one(dht_lookup_cache_t *cache, const char *name)
+{
+    char key[GF_DUMP_MAX_BUF_LEN];
+    uint64_t hits = GF_ATOMIC_GET(cache->hits);
+    uint64_t misses = GF_ATOMIC_GET(cache->misses);
+
+    snprintf(key, sizeof(key), "%s.entries", name);
+    gf_proc_dump_write(key, "%u", cache->count);
+    snprintf(key, sizeof(key), "%s.hits", name);
+    gf_proc_dump_write(key, "%" PRIu64, hits);
+    snprintf(key, sizeof(key), "%s.misses", name);
+    gf_proc_dump_write(key, "%" PRIu64, misses);
+    snprintf(key, sizeof(key), "%s.hit-rate", name);
+    gf_proc_dump_write(key, "%.2lf",
+                       hits + misses ? (double)hits * 100 / (hits + misses)
+                                     : 0.0);
+}
+
+void
+dht_lookup_cache_dump(xlator_t *this)
+{
+    dht_conf_t *conf = this->private;
+
+    gf_proc_dump_write("lookup-cache-timeout", "%u",
+                       conf->lookup_cache_timeout);
+    gf_proc_dump_write("lookup-cache-size", "%u", conf->lookup_cache_size);
+    dht_lookup_cache_dump_one(&conf->layout_cache, "layout-cache");
+    dht_lookup_cache_dump_one(&conf->negative_cache, "negative-cache");
+}
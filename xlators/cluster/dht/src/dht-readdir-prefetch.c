@@ -0,0 +1,424 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Prefetching of directory entries from all the subvolumes.
+ *
+ * readdirp reads the subvolumes one after the other, and the offsets given
+ * to the application encode the subvolume and the offset in it (see
+ * gf_itransform()). This order is kept: while the entries of a subvolume
+ * are returned, the first batch of the next subvolumes and the next batch
+ * of the current one are requested in parallel and kept in the fd context.
+ * A readdirp for the same subvolume and offset is answered from there, or
+ * waits for the pending request instead of sending a new one.
+ *
+ * At most readdir-prefetch-size bytes (the size of the requests) are
+ * buffered or pending for each directory fd. Everything is dropped when a
+ * file of the directory is modified, so that no stale attributes are
+ * returned. */
+
+#include "dht-common.h"
+
+typedef struct dht_rdp_ctx dht_rdp_ctx_t;
+typedef struct dht_rdp_req dht_rdp_req_t;
+
+typedef enum {
+    DHT_RDP_IDLE,
+    DHT_RDP_PENDING,
+    DHT_RDP_READY,
+} dht_rdp_state_t;
+
+typedef struct dht_rdp_slot {
+    dht_rdp_state_t state;
+    gf_boolean_t started; /* the first batch was requested */
+    off_t offset;
+    size_t size;
+    dht_rdp_req_t *req;
+    gf_dirent_t entries;
+    int op_ret;
+    int op_errno;
+    dict_t *xdata;
+} dht_rdp_slot_t;
+
+struct dht_rdp_ctx {
+    gf_lock_t lock;
+    size_t reserved;
+    int count;
+    dht_rdp_slot_t slots[];
+};
+
+struct dht_rdp_req {
+    dht_rdp_ctx_t *ctx;
+    fd_t *fd;
+    int idx;
+    off_t offset;
+    size_t size;
+    call_frame_t *waiter; /* readdirp waiting for this batch */
+};
+
+static dht_rdp_ctx_t *
+dht_rdp_ctx_get(xlator_t *this, fd_t *fd)
+{
+    dht_conf_t *conf = this->private;
+    dht_rdp_ctx_t *ctx = NULL;
+    uint64_t value = 0;
+    int i = 0;
+
+    LOCK(&fd->lock);
+    {
+        if (__fd_ctx_get(fd, this, &value) == 0) {
+            ctx = (dht_rdp_ctx_t *)(uintptr_t)value;
+            goto unlock;
+        }
+
+        ctx = GF_CALLOC(1,
+                        sizeof(*ctx) +
+                            conf->subvolume_cnt * sizeof(dht_rdp_slot_t),
+                        gf_dht_mt_readdir_prefetch_t);
+        if (!ctx)
+            goto unlock;
+
+        LOCK_INIT(&ctx->lock);
+        ctx->count = conf->subvolume_cnt;
+        for (i = 0; i < ctx->count; i++)
+            INIT_LIST_HEAD(&ctx->slots[i].entries.list);
+
+        if (__fd_ctx_set(fd, this, (uint64_t)(uintptr_t)ctx)) {
+            LOCK_DESTROY(&ctx->lock);
+            GF_FREE(ctx);
+            ctx = NULL;
+        }
+    }
+unlock:
+    UNLOCK(&fd->lock);
+
+    return ctx;
+}
+
+static void
+__dht_rdp_slot_clear(dht_rdp_ctx_t *ctx, dht_rdp_slot_t *slot)
+{
+    if (slot->state == DHT_RDP_READY) {
+        gf_dirent_free(&slot->entries);
+        if (slot->xdata)
+            dict_unref(slot->xdata);
+        slot->xdata = NULL;
+        ctx->reserved -= slot->size;
+    }
+
+    /* a pending request is discarded when it completes */
+    slot->req = NULL;
+    slot->state = DHT_RDP_IDLE;
+}
+
+int
+dht_readdirp_prefetch_release(xlator_t *this, fd_t *fd)
+{
+    dht_rdp_ctx_t *ctx = NULL;
+    uint64_t value = 0;
+    int i = 0;
+
+    if (fd_ctx_del(fd, this, &value) || !value)
+        return 0;
+
+    ctx = (dht_rdp_ctx_t *)(uintptr_t)value;
+    for (i = 0; i < ctx->count; i++)
+        __dht_rdp_slot_clear(ctx, &ctx->slots[i]);
+
+    LOCK_DESTROY(&ctx->lock);
+    GF_FREE(ctx);
+
+    return 0;
+}
+
+/* Drops what was prefetched for the directory containing 'inode': its
+ * entry there would carry the attributes from before the fop that is about
+ * to modify it. Pending requests are discarded too, as they may be answered
+ * before the fop is applied. */
+void
+dht_readdirp_prefetch_invalidate(xlator_t *this, inode_t *inode)
+{
+    dht_conf_t *conf = this->private;
+    dht_rdp_ctx_t *ctx = NULL;
+    inode_t *parent = NULL;
+    fd_t *fd = NULL;
+    uint64_t value = 0;
+    int i = 0;
+
+    if (!conf->readdir_prefetch_size || (conf->subvolume_cnt == 1))
+        return;
+
+    parent = inode_parent(inode, NULL, NULL);
+    if (!parent)
+        return;
+
+    LOCK(&parent->lock);
+    {
+        list_for_each_entry(fd, &parent->fd_list, inode_list)
+        {
+            value = 0;
+            if (fd_ctx_get(fd, this, &value) || !value)
+                continue;
+
+            ctx = (dht_rdp_ctx_t *)(uintptr_t)value;
+            LOCK(&ctx->lock);
+            {
+                for (i = 0; i < ctx->count; i++)
+                    __dht_rdp_slot_clear(ctx, &ctx->slots[i]);
+            }
+            UNLOCK(&ctx->lock);
+        }
+    }
+    UNLOCK(&parent->lock);
+
+    inode_unref(parent);
+}
+
+static int
+dht_rdp_prefetch_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                     int op_ret, int op_errno, gf_dirent_t *entries,
+                     dict_t *xdata)
+{
+    dht_rdp_req_t *req = frame->local;
+    dht_rdp_ctx_t *ctx = req->ctx;
+    dht_rdp_slot_t *slot = &ctx->slots[req->idx];
+    call_frame_t *waiter = NULL;
+    gf_dirent_t batch;
+
+    INIT_LIST_HEAD(&batch.list);
+    frame->local = NULL;
+
+    LOCK(&ctx->lock);
+    {
+        waiter = req->waiter;
+        if (!waiter && (slot->req == req)) {
+            if (op_ret > 0)
+                list_splice_init(&entries->list, &slot->entries.list);
+            slot->op_ret = op_ret;
+            slot->op_errno = op_errno;
+            slot->xdata = xdata ? dict_ref(xdata) : NULL;
+            slot->req = NULL;
+            slot->state = DHT_RDP_READY;
+        } else {
+            if (waiter && (op_ret > 0))
+                list_splice_init(&entries->list, &batch.list);
+            ctx->reserved -= req->size;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (waiter) {
+        dht_readdirp_cbk(waiter, cookie, this, op_ret, op_errno, &batch,
+                         xdata);
+        gf_dirent_free(&batch);
+    }
+
+    fd_unref(req->fd);
+    GF_FREE(req);
+    STACK_DESTROY(frame->root);
+
+    return 0;
+}
+
+/* Requests the entries of the subvolume at index 'idx' from 'offset' if
+ * nothing is buffered for it and the memory limit allows it. */
+static void
+dht_rdp_prefetch(call_frame_t *frame, xlator_t *this, dht_rdp_ctx_t *ctx,
+                 int idx, off_t offset)
+{
+    dht_conf_t *conf = this->private;
+    dht_local_t *local = frame->local;
+    dht_rdp_slot_t *slot = &ctx->slots[idx];
+    xlator_t *subvol = conf->subvolumes[idx];
+    call_frame_t *prefetch_frame = NULL;
+    dht_rdp_req_t *req = NULL;
+    dict_t *xdata = NULL;
+    gf_boolean_t reserved = _gf_false;
+
+    if ((slot->state != DHT_RDP_IDLE) ||
+        (ctx->reserved + local->size > conf->readdir_prefetch_size))
+        return;
+
+    req = GF_CALLOC(1, sizeof(*req), gf_dht_mt_readdir_prefetch_t);
+    prefetch_frame = copy_frame(frame);
+    xdata = dict_copy_with_ref(local->xattr, NULL);
+    if (!req || !prefetch_frame || !xdata)
+        goto out;
+
+    if (conf->readdir_optimize && (subvol != local->first_up_subvol)) {
+        if (dict_set_int32(xdata, GF_READDIR_SKIP_DIRS, 1))
+            goto out;
+    } else {
+        dict_del(xdata, GF_READDIR_SKIP_DIRS);
+    }
+
+    req->ctx = ctx;
+    req->fd = local->fd;
+    req->idx = idx;
+    req->offset = offset;
+    req->size = local->size;
+
+    LOCK(&ctx->lock);
+    {
+        if ((slot->state == DHT_RDP_IDLE) &&
+            (ctx->reserved + req->size <= conf->readdir_prefetch_size)) {
+            ctx->reserved += req->size;
+
+            slot->state = DHT_RDP_PENDING;
+            slot->req = req;
+            slot->offset = offset;
+            slot->size = req->size;
+            if (offset == 0)
+                slot->started = _gf_true;
+            reserved = _gf_true;
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (!reserved)
+        goto out;
+
+    fd_ref(req->fd);
+    prefetch_frame->local = req;
+
+    STACK_WIND_COOKIE(prefetch_frame, dht_rdp_prefetch_cbk, subvol, subvol,
+                      subvol->fops->readdirp, req->fd, req->size, offset,
+                      xdata);
+    dict_unref(xdata);
+
+    return;
+
+out:
+    if (xdata)
+        dict_unref(xdata);
+    if (prefetch_frame)
+        STACK_DESTROY(prefetch_frame->root);
+    GF_FREE(req);
+}
+
+/* Called when the entries of 'subvol' have been returned up to 'offset'
+ * and the directory will be read from there. */
+void
+dht_readdirp_prefetch_next(call_frame_t *frame, xlator_t *this,
+                           xlator_t *subvol, off_t offset)
+{
+    dht_conf_t *conf = this->private;
+    dht_local_t *local = frame->local;
+    dht_rdp_ctx_t *ctx = NULL;
+    int idx = 0;
+
+    if (!conf->readdir_prefetch_size || (conf->subvolume_cnt == 1) ||
+        !local->xattr)
+        return;
+
+    idx = dht_subvol_cnt(this, subvol);
+    if (idx < 0)
+        return;
+
+    ctx = dht_rdp_ctx_get(this, local->fd);
+    if (ctx)
+        dht_rdp_prefetch(frame, this, ctx, idx, offset);
+}
+
+/* Sends the readdirp for 'subvol' at 'offset', or uses the entries already
+ * requested for it. The first batch of the following subvolumes is
+ * prefetched. */
+int
+dht_readdirp_wind(call_frame_t *frame, xlator_t *this, xlator_t *subvol,
+                  off_t offset)
+{
+    dht_conf_t *conf = this->private;
+    dht_local_t *local = frame->local;
+    dht_rdp_ctx_t *ctx = NULL;
+    dht_rdp_slot_t *slot = NULL;
+    gf_dirent_t batch;
+    gf_boolean_t served = _gf_false;
+    gf_boolean_t waiting = _gf_false;
+    dict_t *xdata = NULL;
+    int op_ret = 0;
+    int op_errno = 0;
+    int idx = 0;
+    int i = 0;
+
+    INIT_LIST_HEAD(&batch.list);
+
+    if (!conf->readdir_prefetch_size || (conf->subvolume_cnt == 1) ||
+        !local->xattr)
+        goto wind;
+
+    idx = dht_subvol_cnt(this, subvol);
+    if (idx < 0)
+        goto wind;
+
+    ctx = dht_rdp_ctx_get(this, local->fd);
+    if (!ctx)
+        goto wind;
+
+    slot = &ctx->slots[idx];
+
+    LOCK(&ctx->lock);
+    {
+        /* the directory is read again from the beginning */
+        if ((idx == 0) && (offset == 0)) {
+            for (i = 0; i < ctx->count; i++) {
+                __dht_rdp_slot_clear(ctx, &ctx->slots[i]);
+                ctx->slots[i].started = _gf_false;
+            }
+        }
+        if (offset == 0)
+            slot->started = _gf_true;
+    }
+    UNLOCK(&ctx->lock);
+
+    /* done before waiting, the frame can be unwound at any time after */
+    for (i = idx + 1; i < ctx->count; i++) {
+        if (!ctx->slots[i].started)
+            dht_rdp_prefetch(frame, this, ctx, i, 0);
+    }
+
+    LOCK(&ctx->lock);
+    {
+        if ((slot->state == DHT_RDP_READY) && (slot->offset == offset)) {
+            list_splice_init(&slot->entries.list, &batch.list);
+            op_ret = slot->op_ret;
+            op_errno = slot->op_errno;
+            xdata = slot->xdata;
+            slot->xdata = NULL;
+            ctx->reserved -= slot->size;
+            slot->state = DHT_RDP_IDLE;
+            served = _gf_true;
+        } else if ((slot->state == DHT_RDP_PENDING) &&
+                   (slot->offset == offset)) {
+            slot->req->waiter = frame;
+            slot->req = NULL;
+            slot->state = DHT_RDP_IDLE;
+            waiting = _gf_true;
+        } else {
+            __dht_rdp_slot_clear(ctx, slot);
+        }
+    }
+    UNLOCK(&ctx->lock);
+
+    if (served) {
+        dht_readdirp_cbk(frame, subvol, this, op_ret, op_errno, &batch, xdata);
+        gf_dirent_free(&batch);
+        if (xdata)
+            dict_unref(xdata);
+        return 0;
+    }
+
+    if (waiting)
+        return 0;
+
+wind:
+    STACK_WIND_COOKIE(frame, dht_readdirp_cbk, subvol, subvol,
+                      subvol->fops->readdirp, local->fd, local->size, offset,
+                      local->xattr);
+    return 0;
+}
@@ -18,6 +18,12 @@
 #define GF_DISK_SECTOR_SIZE 512
 #define DHT_REBALANCE_PID 4242              /* Change it if required */
 #define DHT_REBALANCE_BLKSIZE (1024 * 1024) /* 1 MB */
+/* Minimum size of the ranges of a file copied in parallel */
+#define DHT_REBALANCE_RANGE_MIN (8 * DHT_REBALANCE_BLKSIZE)
+/* Files of at least this size are "large" for the migrator scheduling */
+#define DHT_REBALANCE_LARGE_FILE (64 * DHT_REBALANCE_BLKSIZE)
+/* Number of queued entries looked at to find a small file */
+#define DHT_REBALANCE_SMALL_LOOKAHEAD 64
 #define MAX_MIGRATE_QUEUE_COUNT 500
 #define MIN_MIGRATE_QUEUE_COUNT 200
 #define MAX_REBAL_TYPE_SIZE 16
@@ -1090,13 +1096,13 @@ out:
 }
 
 static int
-__dht_rebalance_migrate_data(xlator_t *this, gf_defrag_info_t *defrag,
-                             xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
-                             uint64_t ia_size, int hole_exists, int *fop_errno)
+__dht_rebalance_migrate_range(xlator_t *this, gf_defrag_info_t *defrag,
+                              xlator_t *from, xlator_t *to, fd_t *src,
+                              fd_t *dst, off_t offset, uint64_t size,
+                              int hole_exists, int *fop_errno, int *stop)
 {
     int ret = 0;
     int count = 0;
-    off_t offset = 0;
     struct iovec *vector = NULL;
     struct iobref *iobref = NULL;
     uint64_t total = 0;
@@ -1106,10 +1112,16 @@ __dht_rebalance_migrate_data(xlator_t *this, gf_defrag_info_t *defrag,
 
     conf = this->private;
     /* if file size is '0', no need to enter this loop */
-    while (total < ia_size) {
-        read_size = (((ia_size - total) > DHT_REBALANCE_BLKSIZE)
+    while (total < size) {
+        /* Another range of the file has failed */
+        if (stop && *stop) {
+            ret = -1;
+            break;
+        }
+
+        read_size = (((size - total) > DHT_REBALANCE_BLKSIZE)
                          ? DHT_REBALANCE_BLKSIZE
-                         : (ia_size - total));
+                         : (size - total));
 
         ret = syncop_readv(from, src, read_size, offset, 0, &vector, &count,
                            &iobref, NULL, NULL, NULL);
@@ -1203,6 +1215,123 @@ __dht_rebalance_migrate_data(xlator_t *this, gf_defrag_info_t *defrag,
     return ret;
 }
 
+typedef struct dht_migrate_range {
+    xlator_t *this;
+    gf_defrag_info_t *defrag;
+    xlator_t *from;
+    xlator_t *to;
+    fd_t *src;
+    fd_t *dst;
+    off_t offset;
+    uint64_t size;
+    int hole_exists;
+    int ret;
+    int fop_errno;
+    int *stop;
+    syncbarrier_t *barrier;
+} dht_migrate_range_t;
+
+static int
+dht_migrate_range_task(void *opaque)
+{
+    dht_migrate_range_t *range = opaque;
+    pid_t pid = GF_CLIENT_PID_DEFRAG;
+
+    /* The pid of the migrator thread is not inherited by the task */
+    syncopctx_setfspid(&pid);
+
+    range->ret = __dht_rebalance_migrate_range(
+        range->this, range->defrag, range->from, range->to, range->src,
+        range->dst, range->offset, range->size, range->hole_exists,
+        &range->fop_errno, range->stop);
+    if (range->ret < 0)
+        *range->stop = 1;
+
+    return 0;
+}
+
+static int
+dht_migrate_range_done(int ret, call_frame_t *frame, void *opaque)
+{
+    dht_migrate_range_t *range = opaque;
+
+    syncbarrier_wake(range->barrier);
+
+    return 0;
+}
+
+/* Large files are split into up to rebal-copy-streams ranges which are
+ * copied at the same time, each one by its own synctask. This keeps several
+ * reads and writes of the file in flight, instead of waiting for each block
+ * to be read and then written. */
+static int
+__dht_rebalance_migrate_data(xlator_t *this, gf_defrag_info_t *defrag,
+                             xlator_t *from, xlator_t *to, fd_t *src, fd_t *dst,
+                             uint64_t ia_size, int hole_exists, int *fop_errno)
+{
+    dht_conf_t *conf = NULL;
+    dht_migrate_range_t *ranges = NULL;
+    syncbarrier_t barrier;
+    uint64_t range_size = 0;
+    uint64_t offset = 0;
+    uint32_t streams = 0;
+    uint32_t launched = 0;
+    uint32_t i = 0;
+    int stop = 0;
+    int ret = 0;
+
+    conf = this->private;
+
+    streams = min(conf->rebal_copy_streams, ia_size / DHT_REBALANCE_RANGE_MIN);
+    if ((streams < 2) || syncbarrier_init(&barrier))
+        return __dht_rebalance_migrate_range(this, defrag, from, to, src, dst,
+                                             0, ia_size, hole_exists,
+                                             fop_errno, NULL);
+
+    /* Ranges are a whole number of blocks */
+    range_size = (ia_size + streams - 1) / streams;
+    range_size = (range_size + DHT_REBALANCE_BLKSIZE - 1) /
+                 DHT_REBALANCE_BLKSIZE * DHT_REBALANCE_BLKSIZE;
+
+    ranges = alloca0(sizeof(*ranges) * streams);
+    for (i = 0; (i < streams) && (offset < ia_size); i++) {
+        ranges[i].this = this;
+        ranges[i].defrag = defrag;
+        ranges[i].from = from;
+        ranges[i].to = to;
+        ranges[i].src = src;
+        ranges[i].dst = dst;
+        ranges[i].offset = offset;
+        ranges[i].size = min(range_size, ia_size - offset);
+        ranges[i].hole_exists = hole_exists;
+        ranges[i].stop = &stop;
+        ranges[i].barrier = &barrier;
+        offset += ranges[i].size;
+
+        if (synctask_new(this->ctx->env, dht_migrate_range_task,
+                         dht_migrate_range_done, NULL, &ranges[i]) == 0) {
+            launched++;
+        } else {
+            dht_migrate_range_task(&ranges[i]);
+        }
+    }
+    syncbarrier_wait(&barrier, launched);
+    syncbarrier_destroy(&barrier);
+
+    for (i = 0; i < streams; i++) {
+        if (ranges[i].ret < 0) {
+            ret = -1;
+            /* The ranges stopped by another one have no error */
+            if (ranges[i].fop_errno) {
+                *fop_errno = ranges[i].fop_errno;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
 static int
 __dht_rebalance_open_src_file(xlator_t *this, xlator_t *from, xlator_t *to,
                               loc_t *loc, struct iatt *stbuf, fd_t **src_fd,
@@ -2933,6 +3062,47 @@ out:
     return ret;
 }
 
+static gf_boolean_t
+gf_defrag_is_large_file(struct dht_container *container)
+{
+    return container->df_entry->d_stat.ia_size >= DHT_REBALANCE_LARGE_FILE;
+}
+
+/* Picks the next entry to migrate. Large files take much longer than the
+ * others, so at most half of the migrator threads are allowed to work on
+ * them at the same time. When that limit is reached, the first small file
+ * near the head of the queue is taken instead. Called with dfq_mutex
+ * held. */
+static struct dht_container *
+__gf_defrag_pick_entry(gf_defrag_info_t *defrag, struct list_head *q_head)
+{
+    struct dht_container *iterator = NULL;
+    struct dht_container *entry = NULL;
+    int32_t max_large = 0;
+    int count = 0;
+
+    entry = list_entry(q_head->next, typeof(*entry), list);
+
+    max_large = MAX(defrag->current_thread_count / 2, 1);
+    if (gf_defrag_is_large_file(entry) &&
+        (defrag->large_file_count >= max_large)) {
+        list_for_each_entry(iterator, q_head, list)
+        {
+            if (count++ == DHT_REBALANCE_SMALL_LOOKAHEAD)
+                break;
+            if (!gf_defrag_is_large_file(iterator)) {
+                entry = iterator;
+                break;
+            }
+        }
+    }
+
+    if (gf_defrag_is_large_file(entry))
+        defrag->large_file_count++;
+
+    return entry;
+}
+
 void *
 gf_defrag_task(void *opaque)
 {
@@ -3000,7 +3170,7 @@ gf_defrag_task(void *opaque)
             }
 
             if (defrag->q_entry_count) {
-                iterator = list_entry(q_head->next, typeof(*iterator), list);
+                iterator = __gf_defrag_pick_entry(defrag, q_head);
 
                 gf_msg_debug("DHT", 0,
                              "picking entry "
@@ -3018,6 +3188,14 @@ gf_defrag_task(void *opaque)
                 pthread_mutex_unlock(&defrag->dfq_mutex);
                 ret = gf_defrag_migrate_single_file((void *)iterator);
 
+                if (gf_defrag_is_large_file(iterator)) {
+                    pthread_mutex_lock(&defrag->dfq_mutex);
+                    {
+                        defrag->large_file_count--;
+                    }
+                    pthread_mutex_unlock(&defrag->dfq_mutex);
+                }
+
                 /*Critical errors: ENOTCONN and ENOSPACE*/
                 if (ret) {
                     dht_set_global_defrag_error(defrag, ret);
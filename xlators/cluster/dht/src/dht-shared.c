@@ -138,6 +138,7 @@ dht_priv_dump(xlator_t *this)
     gf_proc_dump_write("refresh_interval", "%d", conf->refresh_interval);
     gf_proc_dump_write("unhashed_sticky_bit", "%d", conf->unhashed_sticky_bit);
     gf_proc_dump_write("use-readdirp", "%d", conf->use_readdirp);
+    dht_lookup_cache_dump(this);
 
     if (conf->du_stats && conf->subvolume_status) {
         for (i = 0; i < conf->subvolume_cnt; i++) {
@@ -203,6 +204,11 @@ dht_fini(xlator_t *this)
     GF_VALIDATE_OR_GOTO("dht", this, out);
 
     conf = this->private;
+    if (conf) {
+        /* layouts are released while this->private is still set */
+        dht_lookup_cache_fini(this, &conf->layout_cache);
+        dht_lookup_cache_fini(this, &conf->negative_cache);
+    }
     this->private = NULL;
     if (conf) {
         if (conf->file_layouts) {
@@ -504,6 +510,17 @@ dht_reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("force-migration", conf->force_migration, options, bool,
                      out);
 
+    GF_OPTION_RECONF("rebal-copy-streams", conf->rebal_copy_streams, options,
+                     uint32, out);
+
+    GF_OPTION_RECONF("lookup-cache-timeout", conf->lookup_cache_timeout,
+                     options, uint32, out);
+    GF_OPTION_RECONF("lookup-cache-size", conf->lookup_cache_size, options,
+                     uint32, out);
+
+    GF_OPTION_RECONF("readdir-prefetch-size", conf->readdir_prefetch_size,
+                     options, size_uint64, out);
+
     if (conf->defrag) {
         if (dict_get_str(options, "rebal-throttle", &temp_str) == 0) {
             ret = dht_configure_throttle(this, conf, temp_str);
@@ -775,6 +792,16 @@ dht_init(xlator_t *this)
 
     GF_OPTION_INIT("force-migration", conf->force_migration, bool, err);
 
+    GF_OPTION_INIT("rebal-copy-streams", conf->rebal_copy_streams, uint32,
+                   err);
+
+    GF_OPTION_INIT("lookup-cache-timeout", conf->lookup_cache_timeout, uint32,
+                   err);
+    GF_OPTION_INIT("lookup-cache-size", conf->lookup_cache_size, uint32, err);
+
+    GF_OPTION_INIT("readdir-prefetch-size", conf->readdir_prefetch_size,
+                   size_uint64, err);
+
     if (defrag) {
         defrag->lock_migration_enabled = conf->lock_migration_enabled;
 
@@ -870,6 +897,10 @@ dht_init(xlator_t *this)
         goto err;
     }
 
+    if (dht_lookup_cache_init(this, &conf->layout_cache) ||
+        dht_lookup_cache_init(this, &conf->negative_cache))
+        goto err;
+
     this->private = conf;
 
     if (dht_set_subvol_range(this))
@@ -905,6 +936,9 @@ err:
         if (conf->lock_pool)
             mem_pool_destroy(conf->lock_pool);
 
+        GF_FREE(conf->layout_cache.buckets);
+        GF_FREE(conf->negative_cache.buckets);
+
         GF_FREE(conf);
     }
 
@@ -1203,6 +1237,55 @@ struct volume_options dht_options[] = {
      .level = OPT_STATUS_ADVANCED,
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
 
+    {.key = {"rebal-copy-streams"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "4",
+     .description = "Maximum number of ranges of a large file that "
+                    "rebalance copies at the same time",
+     .op_version = {GD_OP_VERSION_9_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"lookup-cache-timeout"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 3600,
+     .default_value = "0",
+     .description = "Time in seconds during which the layouts of forgotten "
+                    "directories and the names not found on any subvolume "
+                    "are cached, to avoid sending their lookups to all the "
+                    "subvolumes. Changes made by other clients may not be "
+                    "seen during this time. 0 disables the caches.",
+     .op_version = {GD_OP_VERSION_9_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"lookup-cache-size"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = 1048576,
+     .default_value = "65536",
+     .description = "Maximum number of entries of the layout cache and of "
+                    "the negative lookup cache",
+     .op_version = {GD_OP_VERSION_9_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
+    {.key = {"readdir-prefetch-size"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 0,
+     .max = 64 * GF_UNIT_MB,
+     .default_value = "0",
+     .description = "Maximum amount of directory entries requested in "
+                    "advance from all the subvolumes for each open "
+                    "directory, so that readdirp does not wait for each "
+                    "subvolume in turn. 0 disables the prefetching.",
+     .op_version = {GD_OP_VERSION_9_0},
+     .level = OPT_STATUS_ADVANCED,
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+
     {.key = {NULL}},
 };
 
@@ -639,7 +639,8 @@ struct xlator_fops fops = {
     .setattr = dht_setattr,
 };
 
-struct xlator_cbks cbks = {.forget = dht_forget};
+struct xlator_cbks cbks = {.forget = dht_forget,
+                           .releasedir = dht_readdirp_prefetch_release};
 extern int32_t
 mem_acct_init(xlator_t *this);
 
@@ -185,11 +185,140 @@ ec_lock_conflict(ec_lock_link_t *l1, ec_lock_link_t *l2)
     return ec_is_range_conflict(l1, l2);
 }
 
+/* Expected time to get an answer from a brick: its average read latency
+ * times the number of reads it has to serve. Bricks never measured have no
+ * cost, so that they are tried. */
+static uint64_t
+ec_read_cost(ec_t *ec, uint32_t idx)
+{
+    return GF_ATOMIC_GET(ec->read_latency[idx]) *
+           (GF_ATOMIC_GET(ec->pending_reads[idx]) + 1);
+}
+
+static uint32_t
+ec_select_fastest(ec_t *ec, ec_fop_data_t *fop)
+{
+    uint64_t cost, best = UINT64_MAX;
+    uint32_t i, idx = ec->idx;
+
+    for (i = 0; i < ec->nodes; i++) {
+        if (((fop->remaining >> i) & 1) == 0) {
+            continue;
+        }
+        cost = ec_read_cost(ec, i);
+        if (cost < best) {
+            best = cost;
+            idx = i;
+        }
+    }
+
+    return idx;
+}
+
+/* Selects 'count' bricks to read from. Starting at fop->first, bricks are
+ * taken in order like the round-robin policy does, but skipping the ones
+ * that are much slower than the fastest one. This keeps the number of
+ * different combinations of bricks (and decoding matrices) small. Slow
+ * bricks are only used if there aren't enough fast ones.
+ *
+ * Slow bricks won't get new reads, so their latency wouldn't be updated
+ * anymore. To detect when they recover, one of every EC_READ_PROBE_INTERVAL
+ * reads ignores the costs. */
+static uintptr_t
+ec_select_adaptive(ec_t *ec, ec_fop_data_t *fop, int32_t count)
+{
+    uint64_t cost[EC_MAX_NODES];
+    uint64_t best = UINT64_MAX, limit = UINT64_MAX;
+    uintptr_t mask = 0, slow = 0;
+    uint32_t i, idx;
+
+    for (i = 0; i < ec->nodes; i++) {
+        if (((fop->remaining >> i) & 1) != 0) {
+            cost[i] = ec_read_cost(ec, i);
+            if (cost[i] < best) {
+                best = cost[i];
+            }
+        }
+    }
+
+    if ((GF_ATOMIC_INC(ec->read_count) % EC_READ_PROBE_INTERVAL) != 0) {
+        limit = best * EC_READ_SLOW_FACTOR + EC_READ_SLOW_MARGIN;
+    }
+
+    idx = fop->first;
+    for (i = 0; (i < ec->nodes) && (count > 0); i++) {
+        if (((fop->remaining >> idx) & 1) != 0) {
+            if (cost[idx] <= limit) {
+                mask |= 1ULL << idx;
+                count--;
+            } else {
+                slow |= 1ULL << idx;
+            }
+        }
+        if (++idx >= ec->nodes) {
+            idx = 0;
+        }
+    }
+
+    while ((count-- > 0) && (slow != 0)) {
+        best = UINT64_MAX;
+        for (i = 0; i < ec->nodes; i++) {
+            if ((((slow >> i) & 1) != 0) && (cost[i] < best)) {
+                best = cost[i];
+                idx = i;
+            }
+        }
+        slow ^= 1ULL << idx;
+        mask |= 1ULL << idx;
+    }
+
+    return mask;
+}
+
+void
+ec_read_stats_wind(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
+{
+    GF_ATOMIC_INC(ec->pending_reads[idx]);
+    if (fop->wind_time != NULL) {
+        timespec_now(&fop->wind_time[idx]);
+    }
+}
+
+void
+ec_read_stats_unwind(ec_t *ec, ec_fop_data_t *fop, int32_t idx,
+                     int32_t op_ret)
+{
+    struct timespec now, elapsed;
+    int64_t latency, avg;
+
+    GF_ATOMIC_DEC(ec->pending_reads[idx]);
+
+    /* Failed requests are usually answered immediately. They don't say
+     * anything about the speed of the brick. */
+    if ((op_ret < 0) || (fop->wind_time == NULL)) {
+        return;
+    }
+
+    timespec_now(&now);
+    timespec_sub(&fop->wind_time[idx], &now, &elapsed);
+    latency = elapsed.tv_sec * 1000000 + elapsed.tv_nsec / 1000;
+
+    /* Concurrent updates may lose a sample, but that doesn't matter for a
+     * moving average. */
+    avg = GF_ATOMIC_GET(ec->read_latency[idx]);
+    if (avg != 0) {
+        latency = avg + (latency - avg) / EC_READ_LATENCY_WEIGHT;
+    }
+    GF_ATOMIC_INIT(ec->read_latency[idx], (latency > 0) ? latency : 1);
+}
+
 uint32_t
 ec_select_first_by_read_policy(ec_t *ec, ec_fop_data_t *fop)
 {
     if (ec->read_policy == EC_ROUND_ROBIN) {
         return ec->idx;
+    } else if (ec->read_policy == EC_ADAPTIVE) {
+        return ec_select_fastest(ec, fop);
     } else if (ec->read_policy == EC_GFID_HASH) {
         if (fop->use_fd) {
             return SuperFastHash((char *)fop->fd->inode->gfid,
@@ -682,7 +811,8 @@ ec_child_select(ec_fop_data_t *fop)
             fop->minimum = 1;
     }
 
-    if (ec->read_policy == EC_ROUND_ROBIN) {
+    if ((ec->read_policy == EC_ROUND_ROBIN) ||
+        (ec->read_policy == EC_ADAPTIVE)) {
         first = ec->idx;
         if (++first >= ec->nodes) {
             first = 0;
@@ -872,13 +1002,19 @@ ec_dispatch_min(ec_fop_data_t *fop)
         ec_sleep(fop);
 
         fop->expected = count = ec->fragments;
-        fop->first = ec_select_first_by_read_policy(fop->xl->private, fop);
-        idx = fop->first - 1;
-        mask = 0;
-        while (count-- > 0) {
-            idx = ec_child_next(ec, fop, idx + 1);
-            if (idx < EC_MAX_NODES)
-                mask |= 1ULL << idx;
+        if (ec->read_policy == EC_ADAPTIVE) {
+            fop->first = ec->idx;
+            mask = ec_select_adaptive(ec, fop, count);
+        } else {
+            fop->first = ec_select_first_by_read_policy(fop->xl->private,
+                                                        fop);
+            idx = fop->first - 1;
+            mask = 0;
+            while (count-- > 0) {
+                idx = ec_child_next(ec, fop, idx + 1);
+                if (idx < EC_MAX_NODES)
+                    mask |= 1ULL << idx;
+            }
         }
 
         ec_dispatch_mask(fop, mask);
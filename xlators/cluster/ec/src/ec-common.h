@@ -121,6 +121,15 @@ enum _ec_xattrop_flags {
 #define EC_STATE_HEAL_POST_INODELK_UNLOCK 217
 #define EC_STATE_HEAL_DISPATCH 218
 
+/* Weight of the last sample in the moving average of the read latency */
+#define EC_READ_LATENCY_WEIGHT 8
+/* A brick is slow if its read cost is higher than the one of the fastest
+ * brick times EC_READ_SLOW_FACTOR plus EC_READ_SLOW_MARGIN microseconds */
+#define EC_READ_SLOW_FACTOR 2
+#define EC_READ_SLOW_MARGIN 100
+/* Reads between two reads that ignore the read cost of the bricks */
+#define EC_READ_PROBE_INTERVAL 64
+
 /* Value to cover the full range of a file */
 #define EC_RANGE_FULL ((uint64_t)LLONG_MAX + 1)
 
@@ -191,6 +200,12 @@ ec_dispatch_one(ec_fop_data_t *fop);
 void
 ec_succeed_all(ec_fop_data_t *fop);
 
+void
+ec_read_stats_wind(ec_t *ec, ec_fop_data_t *fop, int32_t idx);
+void
+ec_read_stats_unwind(ec_t *ec, ec_fop_data_t *fop, int32_t idx,
+                     int32_t op_ret);
+
 void
 ec_sleep(ec_fop_data_t *fop);
 void
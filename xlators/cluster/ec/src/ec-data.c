@@ -272,6 +272,7 @@ ec_fop_data_release(ec_fop_data_t *fop)
         loc_wipe(&fop->loc[0]);
         loc_wipe(&fop->loc[1]);
         GF_FREE(fop->errstr);
+        GF_FREE(fop->wind_time);
 
         ec_resume_parent(fop);
 
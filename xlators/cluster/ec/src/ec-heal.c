@@ -349,8 +349,8 @@ ec_heal_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
-void
-ec_heal_data_block(ec_heal_t *heal)
+static void
+ec_heal_data_read(ec_heal_t *heal)
 {
     ec_trace("DATA", heal->fop, "good=%lX, bad=%lX", heal->good, heal->bad);
 
@@ -362,6 +362,26 @@ ec_heal_data_block(ec_heal_t *heal)
     }
 }
 
+void
+ec_heal_data_block(ec_heal_t *heal)
+{
+    uint32_t i;
+
+    if (heal->block_count == 0) {
+        ec_heal_data_read(heal);
+
+        return;
+    }
+
+    /* All the blocks are read and written at the same time, so that the
+     * reads of a block overlap with the writes of the previous ones. The
+     * current state is resumed once all of them have completed. */
+    for (i = 0; i < heal->block_count; i++) {
+        heal->blocks[i].fop = heal->fop;
+        ec_heal_data_read(&heal->blocks[i]);
+    }
+}
+
 /* FOP: fheal */
 
 void
@@ -2028,9 +2048,20 @@ ec_heal_block_done(call_frame_t *frame, void *cookie, xlator_t *this,
 int
 ec_sync_heal_block(call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
 {
+    ec_heal_t *block;
+    uint32_t i;
+
     ec_heal_block(frame, this, heal->bad | heal->good, EC_MINIMUM_ONE,
                   ec_heal_block_done, heal);
     syncbarrier_wait(heal->data, 1);
+    for (i = 0; i < heal->block_count; i++) {
+        block = &heal->blocks[i];
+        heal->good &= block->good;
+        heal->bad &= block->bad;
+        if (block->done) {
+            heal->done = 1;
+        }
+    }
     if (heal->error != 0) {
         return -heal->error;
     }
@@ -2039,18 +2070,124 @@ ec_sync_heal_block(call_frame_t *frame, xlator_t *this, ec_heal_t *heal)
     return 0;
 }
 
+/* Returns how many windows of 'size' bytes can be healed in parallel without
+ * exceeding the memory limit. At least one window is always allowed, so that
+ * all heals make progress. */
+static uint32_t
+ec_heal_reserve(ec_t *ec, uint32_t depth, uint64_t size)
+{
+    uint64_t avail = 0;
+    uint32_t count = 1;
+
+    LOCK(&ec->lock);
+    {
+        if (ec->self_heal_memory_limit > ec->stats.heal.in_flight) {
+            avail = ec->self_heal_memory_limit - ec->stats.heal.in_flight;
+        }
+        while ((count < depth) && ((count + 1) * size <= avail)) {
+            count++;
+        }
+        ec->stats.heal.in_flight += count * size;
+    }
+    UNLOCK(&ec->lock);
+
+    return count;
+}
+
+static void
+ec_heal_release(ec_t *ec, uint64_t size)
+{
+    LOCK(&ec->lock);
+    {
+        ec->stats.heal.in_flight -= size;
+    }
+    UNLOCK(&ec->lock);
+}
+
+static void
+ec_heal_blocks_prepare(ec_heal_t *heal, uint32_t count)
+{
+    ec_heal_t *block;
+    uint32_t i;
+
+    heal->block_count = 0;
+    if (count < 2) {
+        return;
+    }
+
+    for (i = 0; i < count; i++) {
+        block = &heal->blocks[i];
+        block->offset = heal->offset + i * heal->size;
+        if (block->offset >= heal->total_size) {
+            break;
+        }
+        block->fop = NULL;
+        block->fd = heal->fd;
+        block->xl = heal->xl;
+        block->size = heal->size;
+        block->total_size = heal->total_size;
+        block->iatt.ia_type = heal->iatt.ia_type;
+        block->good = heal->good;
+        block->bad = heal->bad;
+        block->done = 0;
+        heal->block_count++;
+    }
+}
+
+static void
+ec_heal_stats_start(ec_t *ec)
+{
+    LOCK(&ec->lock);
+    {
+        if (GF_ATOMIC_INC(ec->stats.heal.active) == 1) {
+            timespec_now(&ec->stats.heal.busy_since);
+        }
+    }
+    UNLOCK(&ec->lock);
+}
+
+static void
+ec_heal_stats_end(ec_t *ec, int ret)
+{
+    struct timespec now, elapsed;
+
+    if (ret < 0) {
+        GF_ATOMIC_INC(ec->stats.heal.failed);
+    } else {
+        GF_ATOMIC_INC(ec->stats.heal.healed);
+    }
+
+    LOCK(&ec->lock);
+    {
+        if (GF_ATOMIC_DEC(ec->stats.heal.active) == 0) {
+            timespec_now(&now);
+            timespec_sub(&ec->stats.heal.busy_since, &now, &elapsed);
+            ec->stats.heal.busy_time += elapsed.tv_sec * 1000000 +
+                                        elapsed.tv_nsec / 1000;
+        }
+    }
+    UNLOCK(&ec->lock);
+}
+
 int
 ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
                 unsigned char *sources, unsigned char *healed_sinks)
 {
     ec_heal_t *heal = NULL;
+    uint32_t depth, count, i;
+    uint64_t span;
     int ret = 0;
     syncbarrier_t barrier;
 
     if (syncbarrier_init(&barrier))
         return -ENOMEM;
 
+    depth = ec->self_heal_pipeline_depth;
     heal = alloca0(sizeof(*heal));
+    heal->blocks = alloca0(sizeof(*heal->blocks) * depth);
+    for (i = 0; i < depth; i++) {
+        LOCK_INIT(&heal->blocks[i].lock);
+    }
     heal->fd = fd_ref(fd);
     heal->xl = ec->xl;
     heal->data = &barrier;
@@ -2068,7 +2205,7 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
     LOCK_INIT(&heal->lock);
 
     for (heal->offset = 0; (heal->offset < size) && !heal->done;
-         heal->offset += heal->size) {
+         heal->offset += span) {
         /* We immediately abort any heal if a shutdown request has been
          * received to avoid delays. The healing of this file will be
          * restarted by another SHD or other client that accesses the
@@ -2087,13 +2224,26 @@ ec_rebuild_data(call_frame_t *frame, ec_t *ec, fd_t *fd, uint64_t size,
                      uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                      EC_COUNT(healed_sinks, ec->nodes), heal->offset,
                      heal->size);
+
+        /* Several windows are healed at once while the file is locked,
+         * as long as the memory used by all running heals permits it. */
+        count = ec_heal_reserve(ec, depth, heal->size);
+        ec_heal_blocks_prepare(heal, count);
+        span = count * heal->size;
+
         ret = ec_sync_heal_block(frame, ec->xl, heal);
+        ec_heal_release(ec, span);
         if (ret < 0)
             break;
+
+        GF_ATOMIC_ADD(ec->stats.heal.bytes, min(span, size - heal->offset));
     }
     memset(healed_sinks, 0, ec->nodes);
     ec_mask_to_char_array(heal->bad, healed_sinks, ec->nodes);
     fd_unref(heal->fd);
+    for (i = 0; i < depth; i++) {
+        LOCK_DESTROY(&heal->blocks[i].lock);
+    }
     LOCK_DESTROY(&heal->lock);
     syncbarrier_destroy(heal->data);
     if (ret < 0)
@@ -2399,7 +2549,9 @@ unlock:
                  uuid_utoa(fd->inode->gfid), EC_COUNT(sources, ec->nodes),
                  EC_COUNT(healed_sinks, ec->nodes));
 
+    ec_heal_stats_start(ec);
     ret = ec_rebuild_data(frame, ec, fd, size[source], sources, healed_sinks);
+    ec_heal_stats_end(ec, ret);
     if (ret < 0)
         goto out;
 
@@ -258,6 +258,91 @@ out:
     return ret;
 }
 
+typedef struct ec_shd_heal_job {
+    struct subvol_healer *healer;
+    loc_t loc;
+} ec_shd_heal_job_t;
+
+static int
+ec_shd_full_heal_task(void *data)
+{
+    ec_shd_heal_job_t *job = data;
+
+    ec_shd_selfheal(job->healer, job->healer->subvol, &job->loc, _gf_true);
+
+    return 0;
+}
+
+static int
+ec_shd_full_heal_done(int ret, call_frame_t *frame, void *data)
+{
+    ec_shd_heal_job_t *job = data;
+    struct subvol_healer *healer = job->healer;
+
+    loc_wipe(&job->loc);
+    GF_FREE(job);
+
+    pthread_mutex_lock(&healer->mutex);
+    {
+        healer->jobs--;
+        pthread_cond_broadcast(&healer->jobs_cond);
+    }
+    pthread_mutex_unlock(&healer->mutex);
+
+    return 0;
+}
+
+/* Heals the file in a synctask, so that up to shd-max-threads files are
+ * healed at the same time during a full sweep. The caller is blocked while
+ * all of them are busy. */
+static void
+ec_shd_full_heal_spawn(struct subvol_healer *healer, loc_t *loc)
+{
+    ec_t *ec = healer->this->private;
+    ec_shd_heal_job_t *job = NULL;
+
+    job = GF_CALLOC(1, sizeof(*job), ec_mt_ec_heal_job_t);
+    if (job == NULL) {
+        goto heal;
+    }
+    job->healer = healer;
+    if (loc_copy(&job->loc, loc) != 0) {
+        GF_FREE(job);
+        goto heal;
+    }
+
+    pthread_mutex_lock(&healer->mutex);
+    {
+        while (healer->jobs >= ec->shd.max_threads) {
+            pthread_cond_wait(&healer->jobs_cond, &healer->mutex);
+        }
+        healer->jobs++;
+    }
+    pthread_mutex_unlock(&healer->mutex);
+
+    if (synctask_new(healer->this->ctx->env, ec_shd_full_heal_task,
+                     ec_shd_full_heal_done, NULL, job) == 0) {
+        return;
+    }
+
+    ec_shd_full_heal_done(-1, NULL, job);
+
+heal:
+    ec_shd_selfheal(healer, healer->subvol, loc, _gf_true);
+}
+
+static void
+ec_shd_full_heal_wait(struct subvol_healer *healer)
+{
+    pthread_mutex_lock(&healer->mutex);
+    {
+        while (healer->jobs > 0) {
+            pthread_cond_wait(&healer->jobs_cond, &healer->mutex);
+        }
+    }
+    pthread_mutex_unlock(&healer->mutex);
+}
+
 int
 ec_shd_full_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
                  void *data)
@@ -302,7 +387,12 @@ ec_shd_full_heal(xlator_t *subvol, gf_dirent_t *entry, loc_t *parent,
     if (ret < 0)
         goto out;
 
-    ec_shd_selfheal(healer, healer->subvol, &loc, _gf_true);
+    /* Directories are healed before their contents are crawled. */
+    if ((ec->shd.max_threads > 1) && (entry->d_stat.ia_type != IA_IFDIR)) {
+        ec_shd_full_heal_spawn(healer, &loc);
+    } else {
+        ec_shd_selfheal(healer, healer->subvol, &loc, _gf_true);
+    }
 
     ret = 0;
 
@@ -323,6 +413,7 @@ ec_shd_full_sweep(struct subvol_healer *healer, inode_t *inode)
     _mask_cancellation();
     ret = syncop_ftw(ec->xl_list[healer->subvol], &loc,
                      GF_CLIENT_PID_SELF_HEALD, healer, ec_shd_full_heal);
+    ec_shd_full_heal_wait(healer);
     _unmask_cancellation();
     return ret;
 }
@@ -407,6 +498,10 @@ ec_shd_healer_init(xlator_t *this, struct subvol_healer *healer)
     if (ret)
         goto out;
 
+    ret = pthread_cond_init(&healer->jobs_cond, NULL);
+    if (ret)
+        goto out;
+
     healer->this = this;
     healer->running = _gf_false;
     healer->rerun = _gf_false;
@@ -589,6 +684,7 @@ ec_destroy_healer_object(xlator_t *this, struct subvol_healer *healer)
     if (!healer)
         return;
 
+    pthread_cond_destroy(&healer->jobs_cond);
     pthread_cond_destroy(&healer->cond);
     pthread_mutex_destroy(&healer->mutex);
 }
@@ -10,6 +10,7 @@
 
 #include "ec.h"
 #include "ec-messages.h"
+#include "ec-mem-types.h"
 #include "ec-helpers.h"
 #include "ec-common.h"
 #include "ec-combine.h"
@@ -1258,6 +1259,8 @@ ec_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ec_trace("CBK", fop, "idx=%d, frame=%p, op_ret=%d, op_errno=%d", idx, frame,
              op_ret, op_errno);
 
+    ec_read_stats_unwind(ec, fop, idx, op_ret);
+
     cbk = ec_cbk_data_allocate(frame, this, fop, GF_FOP_READ, idx, op_ret,
                                op_errno);
     if (cbk != NULL) {
@@ -1320,6 +1323,8 @@ ec_wind_readv(ec_t *ec, ec_fop_data_t *fop, int32_t idx)
 {
     ec_trace("WIND", fop, "idx=%d", idx);
 
+    ec_read_stats_wind(ec, fop, idx);
+
     STACK_WIND_COOKIE(fop->frame, ec_readv_cbk, (void *)(uintptr_t)idx,
                       ec->xl_list[idx], ec->xl_list[idx]->fops->readv, fop->fd,
                       fop->size, fop->offset, fop->uint32, fop->xdata);
@@ -1425,6 +1430,7 @@ ec_readv(call_frame_t *frame, xlator_t *this, uintptr_t target,
 {
     ec_cbk_t callback = {.readv = func};
     ec_fop_data_t *fop = NULL;
+    ec_t *ec = NULL;
     int32_t error = ENOMEM;
 
     gf_msg_trace("ec", 0, "EC(READ) %p", frame);
@@ -1446,6 +1452,14 @@ ec_readv(call_frame_t *frame, xlator_t *this, uintptr_t target,
     fop->offset = offset;
     fop->uint32 = flags;
 
+    /* Latencies are only measured when they are used to select the bricks.
+     * Without the wind times the read is still valid, just not measured. */
+    ec = this->private;
+    if (ec->read_policy == EC_ADAPTIVE) {
+        fop->wind_time = GF_CALLOC(ec->nodes, sizeof(*fop->wind_time),
+                                   ec_mt_ec_read_stats_t);
+    }
+
     if (fd != NULL) {
         fop->fd = fd_ref(fd);
         if (fop->fd == NULL) {
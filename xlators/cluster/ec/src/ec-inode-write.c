@@ -1730,6 +1730,34 @@ out:
     }
 }
 
+/* Merges the tail of the write with the data read from the bricks. The read
+ * ends where the write buffer ends and is 'length' bytes long. */
+static void
+ec_writev_merge_tail_data(ec_t *ec, ec_fop_data_t *fop, struct iovec *vector,
+                          int32_t count, int32_t op_ret, uint64_t length)
+{
+    uint64_t size, base, tmp;
+
+    tmp = 0;
+    size = fop->size - fop->user_size - fop->head;
+    base = length - size;
+    if (op_ret > base) {
+        tmp = min(op_ret - base, size);
+        ec_iov_copy_to(fop->vector[0].iov_base + fop->size - size, vector,
+                       count, base, tmp);
+
+        size -= tmp;
+    }
+
+    if (size > 0) {
+        memset(fop->vector[0].iov_base + fop->size - size, 0, size);
+    }
+
+    if (ec->stripe_cache) {
+        ec_add_stripe_in_cache(ec, fop);
+    }
+}
+
 int32_t
 ec_writev_merge_tail(call_frame_t *frame, void *cookie, xlator_t *this,
                      int32_t op_ret, int32_t op_errno, struct iovec *vector,
@@ -1738,27 +1766,10 @@ ec_writev_merge_tail(call_frame_t *frame, void *cookie, xlator_t *this,
 {
     ec_t *ec = this->private;
     ec_fop_data_t *fop = frame->local;
-    uint64_t size, base, tmp;
 
     if (op_ret >= 0) {
-        tmp = 0;
-        size = fop->size - fop->user_size - fop->head;
-        base = ec->stripe_size - size;
-        if (op_ret > base) {
-            tmp = min(op_ret - base, size);
-            ec_iov_copy_to(fop->vector[0].iov_base + fop->size - size, vector,
-                           count, base, tmp);
-
-            size -= tmp;
-        }
-
-        if (size > 0) {
-            memset(fop->vector[0].iov_base + fop->size - size, 0, size);
-        }
-
-        if (ec->stripe_cache) {
-            ec_add_stripe_in_cache(ec, fop);
-        }
+        ec_writev_merge_tail_data(ec, fop, vector, count, op_ret,
+                                  ec->stripe_size);
     }
     return 0;
 }
@@ -1798,6 +1809,25 @@ ec_writev_merge_head(call_frame_t *frame, void *cookie, xlator_t *this,
     return 0;
 }
 
+int32_t
+ec_writev_merge_head_tail(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int32_t op_ret, int32_t op_errno,
+                          struct iovec *vector, int32_t count,
+                          struct iatt *stbuf, struct iobref *iobref,
+                          dict_t *xdata)
+{
+    ec_t *ec = this->private;
+    ec_fop_data_t *fop = frame->local;
+
+    if (op_ret >= 0) {
+        ec_writev_merge_head(frame, cookie, this, op_ret, op_errno, vector,
+                             count, stbuf, iobref, xdata);
+        ec_writev_merge_tail_data(ec, fop, vector, count, op_ret, fop->size);
+    }
+
+    return 0;
+}
+
 static int
 ec_make_internal_fop_xdata(dict_t **xdata)
 {
@@ -1996,7 +2026,8 @@ ec_writev_start(ec_fop_data_t *fop)
     ec_fd_t *ctx;
     fd_t *fd;
     dict_t *xdata = NULL;
-    uint64_t tail, current;
+    fop_readv_cbk_t merge;
+    uint64_t tail, current, size;
     int32_t err = -ENOMEM;
     gf_boolean_t found_stripe = _gf_false;
 
@@ -2030,14 +2061,30 @@ ec_writev_start(ec_fop_data_t *fop)
         if (current > fop->offset) {
             found_stripe = ec_get_and_merge_stripe(ec, fop, EC_STRIPE_HEAD);
             if (!found_stripe) {
+                merge = ec_writev_merge_head;
+                size = ec->stripe_size;
+
+                /* Small unaligned writes commonly cross a stripe boundary.
+                 * When both the head and the tail stripes need to be read,
+                 * get them with a single read instead of sending two
+                 * requests to each brick. */
+                if ((tail > 0) && (fop->size == 2 * ec->stripe_size) &&
+                    (current > fop->offset + fop->head + fop->user_size)) {
+                    if (!ec_get_and_merge_stripe(ec, fop, EC_STRIPE_TAIL)) {
+                        merge = ec_writev_merge_head_tail;
+                        size = fop->size;
+                    }
+                    tail = 0;
+                }
+
                 if (ec_make_internal_fop_xdata(&xdata)) {
                     err = -ENOMEM;
                     goto failed_xdata;
                 }
                 ec_readv(fop->frame, fop->xl,
                          ec_get_lock_good_mask(fop->fd->inode, fop->xl),
-                         EC_MINIMUM_MIN, ec_writev_merge_head, NULL, fd,
-                         ec->stripe_size, fop->offset, 0, xdata);
+                         EC_MINIMUM_MIN, merge, NULL, fd, size, fop->offset,
+                         0, xdata);
             }
         } else {
             memset(fop->vector[0].iov_base, 0, fop->head);
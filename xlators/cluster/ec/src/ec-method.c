@@ -197,18 +197,60 @@ ec_method_matrix_insert(ec_matrix_list_t *list, ec_matrix_t *matrix)
     list->count++;
 }
 
+/* Returns the first row of 'mask' if it contains 'columns' consecutive rows
+ * (wrapping around the last one), or -1 otherwise. */
+static int32_t
+ec_method_matrix_healthy(ec_matrix_list_t *list, uintptr_t mask)
+{
+    uintptr_t run, holes;
+    uint32_t first;
+
+    if (mask == 0) {
+        return -1;
+    }
+
+    run = (1ULL << list->columns) - 1;
+    first = __builtin_ctzl(mask);
+    if ((mask >> first) == run) {
+        return first;
+    }
+
+    holes = ~mask & (~0ULL >> (64 - list->rows));
+    if (holes == 0) {
+        return -1;
+    }
+    run = (1ULL << (list->rows - list->columns)) - 1;
+    first = __builtin_ctzl(holes);
+    if ((holes >> first) == run) {
+        return first + list->rows - list->columns;
+    }
+
+    return -1;
+}
+
 static ec_matrix_t *
 ec_method_matrix_get(ec_matrix_list_t *list, uintptr_t mask, uint32_t *rows)
 {
     ec_matrix_t *matrix;
     uint32_t pos;
+    int32_t healthy;
+
+    healthy = ec_method_matrix_healthy(list, mask);
+    if (healthy >= 0) {
+        matrix = __atomic_load_n(&list->healthy[healthy], __ATOMIC_ACQUIRE);
+        if (matrix != NULL) {
+            return matrix;
+        }
+    }
 
     LOCK(&list->lock);
 
     matrix = ec_method_matrix_lookup(list, mask, &pos);
     if (matrix != NULL) {
-        list_del_init(&matrix->lru);
-        matrix->refs++;
+        if (!matrix->pinned) {
+            list_del_init(&matrix->lru);
+            matrix->refs++;
+        }
 
         goto out;
     }
@@ -232,8 +274,14 @@ ec_method_matrix_get(ec_matrix_list_t *list, uintptr_t mask, uint32_t *rows)
 
     ec_method_matrix_init(list, matrix, mask, rows, _gf_true);
 
+    matrix->pinned = _gf_false;
     if (list->count < list->max) {
         ec_method_matrix_insert(list, matrix);
+        if (healthy >= 0) {
+            matrix->pinned = _gf_true;
+            __atomic_store_n(&list->healthy[healthy], matrix,
+                             __ATOMIC_RELEASE);
+        }
     } else {
         matrix->mask = 0;
     }
@@ -247,6 +295,10 @@ out:
 static void
 ec_method_matrix_put(ec_matrix_list_t *list, ec_matrix_t *matrix)
 {
+    if (matrix->pinned) {
+        return;
+    }
+
     LOCK(&list->lock);
 
     ec_method_matrix_unref(list, matrix);
@@ -323,10 +375,16 @@ ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
         goto failed_pool;
     }
 
+    list->healthy = GF_CALLOC(rows, sizeof(ec_matrix_t *), ec_mt_ec_matrix_t);
+    if (list->healthy == NULL) {
+        err = -ENOMEM;
+        goto failed_objects;
+    }
+
     list->gf = ec_gf_prepare(EC_GF_BITS, EC_GF_MOD);
     if (EC_IS_ERR(list->gf)) {
         err = EC_GET_ERR(list->gf);
-        goto failed_objects;
+        goto failed_healthy;
     }
 
     err = ec_method_setup(xl, list, gen);
@@ -340,6 +398,8 @@ ec_method_init(xlator_t *xl, ec_matrix_list_t *list, uint32_t columns,
 
 failed_gf:
     ec_gf_destroy(list->gf);
+failed_healthy:
+    GF_FREE(list->healthy);
 failed_objects:
     GF_FREE(list->objects);
 failed_pool:
@@ -347,6 +407,7 @@ failed_pool:
 failed:
     list->pool = NULL;
     list->objects = NULL;
+    list->healthy = NULL;
     list->gf = NULL;
 
     return err;
@@ -356,6 +417,7 @@ void
 ec_method_fini(ec_matrix_list_t *list)
 {
     ec_matrix_t *matrix;
+    uint32_t i;
 
     if (list->encode == NULL) {
         return;
@@ -366,6 +428,12 @@ ec_method_fini(ec_matrix_list_t *list)
         ec_method_matrix_destroy(list, matrix);
     }
 
+    for (i = 0; i < list->rows; i++) {
+        if (list->healthy[i] != NULL) {
+            ec_method_matrix_destroy(list, list->healthy[i]);
+        }
+    }
+
     GF_ASSERT(list->count == 0);
 
     if (list->pool) /*Init was successful*/
@@ -377,6 +445,7 @@ ec_method_fini(ec_matrix_list_t *list)
     ec_code_destroy(list->code);
     ec_gf_destroy(list->gf);
     GF_FREE(list->objects);
+    GF_FREE(list->healthy);
 
     if (list->pool)
         mem_pool_destroy(list->pool);
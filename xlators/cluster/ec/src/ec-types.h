@@ -128,7 +128,12 @@ typedef void (*ec_wind_f)(ec_t *, ec_fop_data_t *, int32_t);
 typedef int32_t (*ec_handler_f)(ec_fop_data_t *, int32_t);
 typedef void (*ec_resume_f)(ec_fop_data_t *, int32_t);
 
-enum _ec_read_policy { EC_ROUND_ROBIN, EC_GFID_HASH, EC_READ_POLICY_MAX };
+enum _ec_read_policy {
+    EC_ROUND_ROBIN,
+    EC_GFID_HASH,
+    EC_ADAPTIVE,
+    EC_READ_POLICY_MAX
+};
 
 enum _ec_heal_need { EC_HEAL_NONEED, EC_HEAL_MAYBE, EC_HEAL_MUST };
 
@@ -343,6 +348,9 @@ struct _ec_fop_data {
     uintptr_t received; /* Mask of responses */
     uintptr_t good;
 
+    struct timespec *wind_time; /* When a read was sent to each brick.
+                                   Only used by the 'adaptive' policy. */
+
     uid_t uid;
     gid_t gid;
 
@@ -538,6 +546,7 @@ struct _ec_matrix {
     uintptr_t mask;
     ec_code_t *code;
     uint32_t *values;
+    gf_boolean_t pinned; /* Kept until the list is destroyed. */
     ec_matrix_row_t row_data[0];
 };
 
@@ -554,6 +563,11 @@ struct _ec_matrix_list {
     ec_code_t *code;
     ec_matrix_t *encode;
     ec_matrix_t **objects;
+    /* Decoding matrices of the sets of 'columns' consecutive rows, indexed
+     * by the first row. These are the ones used by reads when all bricks
+     * are healthy, so they are never released and can be used without
+     * taking the lock. */
+    ec_matrix_t **healthy;
 };
 
 struct _ec_heal {
@@ -581,6 +595,9 @@ struct _ec_heal {
     uint64_t total_size;
     uint64_t version[2];
     uint64_t raw_size;
+    ec_heal_t *blocks;    /* Blocks healed in parallel while the lock is
+                             held. */
+    uint32_t block_count; /* Number of used entries in 'blocks'. */
 };
 
 struct subvol_healer {
@@ -591,6 +608,8 @@ struct subvol_healer {
     pthread_mutex_t mutex;
     pthread_cond_t cond;
     pthread_t thread;
+    uint32_t jobs; /* Files being healed in parallel by a full sweep. */
+    pthread_cond_t jobs_cond;
 };
 
 struct _ec_self_heald {
@@ -621,6 +640,17 @@ struct _ec_statistics {
                                 requests. (Basically memory allocation
                                 errors). */
     } stripe_cache;
+    struct {
+        gf_atomic_t healed;  /* Files whose data has been healed. */
+        gf_atomic_t failed;  /* Files whose data heal has failed. */
+        gf_atomic_t active;  /* Data heals in progress. */
+        gf_atomic_t bytes;   /* Bytes of file data rebuilt. */
+        uint64_t in_flight;  /* Bytes being rebuilt right now. */
+        uint64_t busy_time;  /* Microseconds with some data heal in
+                                progress, not counting the current
+                                period. */
+        struct timespec busy_since; /* Start of the current period. */
+    } heal; /* The non atomic fields are protected by ec->lock. */
 };
 
 struct _ec {
@@ -649,6 +679,12 @@ struct _ec {
     uintptr_t read_mask;         /*Stores user defined read-mask*/
     gf_atomic_t async_fop_count; /* Number of on going asynchronous fops. */
     xlator_t **xl_list;
+    gf_atomic_t *pending_reads; /* Reads sent to each brick and not yet
+                                   answered. */
+    gf_atomic_t *read_latency;  /* Moving average of the read latency of
+                                   each brick, in microseconds. */
+    gf_atomic_t read_count;     /* Reads dispatched with the adaptive
+                                   policy. */
     gf_lock_t lock;
     gf_timer_t *timer;
     gf_boolean_t shutdown;
@@ -661,6 +697,8 @@ struct _ec {
     uint32_t background_heals;
     uint32_t heal_wait_qlen;
     uint32_t self_heal_window_size; /* max size of read/writes */
+    uint32_t self_heal_pipeline_depth; /* windows healed in parallel */
+    uint64_t self_heal_memory_limit;   /* max data being rebuilt */
     uint32_t eager_lock_timeout;
     uint32_t other_eager_lock_timeout;
     struct list_head pending_fops;
@@ -28,8 +28,13 @@
 static char *ec_read_policies[EC_READ_POLICY_MAX + 1] = {
     [EC_ROUND_ROBIN] = "round-robin",
     [EC_GFID_HASH] = "gfid-hash",
+    [EC_ADAPTIVE] = "adaptive",
     [EC_READ_POLICY_MAX] = NULL};
 
+/* Subvolumes are tracked as bits of uintptr_t masks in fops and answers. */
+_Static_assert(EC_MAX_NODES <= sizeof(uintptr_t) * 8,
+               "EC_MAX_NODES doesn't fit in a subvolume mask");
+
 #define EC_INTERNAL_XATTR_OR_GOTO(name, xattr, op_errno, label)                \
     do {                                                                       \
         if (ec_is_internal_xattr(NULL, (char *)name, NULL, NULL)) {            \
@@ -108,11 +113,23 @@ ec_prepare_childs(xlator_t *this)
 
         return ENOMEM;
     }
+    ec->pending_reads = GF_CALLOC(count, sizeof(ec->pending_reads[0]),
+                                  ec_mt_ec_read_stats_t);
+    ec->read_latency = GF_CALLOC(count, sizeof(ec->read_latency[0]),
+                                 ec_mt_ec_read_stats_t);
+    if ((ec->pending_reads == NULL) || (ec->read_latency == NULL)) {
+        gf_msg(this->name, GF_LOG_ERROR, ENOMEM, EC_MSG_NO_MEMORY,
+               "Allocation of read statistics failed");
+
+        return ENOMEM;
+    }
     ec->xl_up = 0;
     ec->xl_up_count = 0;
 
     count = 0;
     for (child = this->children; child != NULL; child = child->next) {
+        GF_ATOMIC_INIT(ec->pending_reads[count], 0);
+        GF_ATOMIC_INIT(ec->read_latency[count], 0);
         ec->xl_list[count++] = child->xlator;
     }
 
@@ -179,6 +196,9 @@ __ec_destroy_private(xlator_t *this)
             ec->xl_list = NULL;
         }
 
+        GF_FREE(ec->pending_reads);
+        GF_FREE(ec->read_latency);
+
         if (ec->fop_pool != NULL) {
             mem_pool_destroy(ec->fop_pool);
         }
@@ -271,6 +291,10 @@ reconfigure(xlator_t *this, dict_t *options)
                      failed);
     GF_OPTION_RECONF("self-heal-window-size", ec->self_heal_window_size,
                      options, uint32, failed);
+    GF_OPTION_RECONF("self-heal-pipeline-depth", ec->self_heal_pipeline_depth,
+                     options, uint32, failed);
+    GF_OPTION_RECONF("self-heal-memory-limit", ec->self_heal_memory_limit,
+                     options, size_uint64, failed);
     GF_OPTION_RECONF("heal-timeout", ec->shd.timeout, options, int32, failed);
     ec_configure_background_heal_opts(ec, background_heals, heal_wait_qlen);
     GF_OPTION_RECONF("shd-max-threads", ec->shd.max_threads, options, uint32,
@@ -700,6 +724,10 @@ ec_statistics_init(ec_t *ec)
     GF_ATOMIC_INIT(ec->stats.stripe_cache.evicts, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.allocs, 0);
     GF_ATOMIC_INIT(ec->stats.stripe_cache.errors, 0);
+    GF_ATOMIC_INIT(ec->stats.heal.healed, 0);
+    GF_ATOMIC_INIT(ec->stats.heal.failed, 0);
+    GF_ATOMIC_INIT(ec->stats.heal.active, 0);
+    GF_ATOMIC_INIT(ec->stats.heal.bytes, 0);
 }
 
 static int
@@ -792,6 +820,7 @@ init(xlator_t *this)
     LOCK_INIT(&ec->lock);
 
     GF_ATOMIC_INIT(ec->async_fop_count, 0);
+    GF_ATOMIC_INIT(ec->read_count, 0);
     INIT_LIST_HEAD(&ec->pending_fops);
     INIT_LIST_HEAD(&ec->heal_waiting);
     INIT_LIST_HEAD(&ec->healing);
@@ -844,6 +873,10 @@ init(xlator_t *this)
     GF_OPTION_INIT("heal-wait-qlength", ec->heal_wait_qlen, uint32, failed);
     GF_OPTION_INIT("self-heal-window-size", ec->self_heal_window_size, uint32,
                    failed);
+    GF_OPTION_INIT("self-heal-pipeline-depth", ec->self_heal_pipeline_depth,
+                   uint32, failed);
+    GF_OPTION_INIT("self-heal-memory-limit", ec->self_heal_memory_limit,
+                   size_uint64, failed);
     ec_configure_background_heal_opts(ec, ec->background_heals,
                                       ec->heal_wait_qlen);
     GF_OPTION_INIT("read-policy", read_policy, str, failed);
@@ -919,6 +952,10 @@ int32_t
 ec_gf_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
              mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
 {
+    /* the data must be encoded, it is written by a regular writev */
+    if (xdata)
+        dict_del_sizen(xdata, GF_CREATE_WRITE_KEY);
+
     ec_create(frame, this, -1, EC_MINIMUM_MIN, default_create_cbk, NULL, loc,
               flags, mode, umask, fd, xdata);
 
@@ -1520,7 +1557,10 @@ ec_dump_private(xlator_t *this)
 {
     ec_t *ec = NULL;
     char key_prefix[GF_DUMP_MAX_BUF_LEN];
+    char key[GF_DUMP_MAX_BUF_LEN];
     char tmp[65];
+    uint64_t bytes;
+    int32_t i;
 
     GF_ASSERT(this);
 
@@ -1545,9 +1585,21 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("heal-wait-qlength", "%d", ec->heal_wait_qlen);
     gf_proc_dump_write("self-heal-window-size", "%" PRIu32,
                        ec->self_heal_window_size);
+    gf_proc_dump_write("self-heal-pipeline-depth", "%" PRIu32,
+                       ec->self_heal_pipeline_depth);
+    gf_proc_dump_write("self-heal-memory-limit", "%" PRIu64,
+                       ec->self_heal_memory_limit);
     gf_proc_dump_write("healers", "%d", ec->healers);
     gf_proc_dump_write("heal-waiters", "%d", ec->heal_waiters);
     gf_proc_dump_write("read-policy", "%s", ec_read_policies[ec->read_policy]);
+    for (i = 0; i < ec->nodes; i++) {
+        sprintf(key, "pending_reads[%d]", i);
+        gf_proc_dump_write(key, "%" GF_PRI_ATOMIC,
+                           GF_ATOMIC_GET(ec->pending_reads[i]));
+        sprintf(key, "read_latency[%d]", i);
+        gf_proc_dump_write(key, "%" GF_PRI_ATOMIC,
+                           GF_ATOMIC_GET(ec->read_latency[i]));
+    }
     gf_proc_dump_write("parallel-writes", "%d", ec->parallel_writes);
     gf_proc_dump_write("quorum-count", "%u", ec->quorum_count);
 
@@ -1570,6 +1622,26 @@ ec_dump_private(xlator_t *this)
     gf_proc_dump_write("errors", "%" GF_PRI_ATOMIC,
                        GF_ATOMIC_GET(ec->stats.stripe_cache.errors));
 
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s.stats.heal", this->type,
+             this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    bytes = GF_ATOMIC_GET(ec->stats.heal.bytes);
+    gf_proc_dump_write("healed", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.heal.healed));
+    gf_proc_dump_write("failed", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.heal.failed));
+    gf_proc_dump_write("active", "%" GF_PRI_ATOMIC,
+                       GF_ATOMIC_GET(ec->stats.heal.active));
+    gf_proc_dump_write("bytes", "%" PRIu64, bytes);
+    gf_proc_dump_write("in-flight", "%" PRIu64, ec->stats.heal.in_flight);
+    gf_proc_dump_write("busy-time-usec", "%" PRIu64, ec->stats.heal.busy_time);
+    /* Bytes per second while at least one heal was running. */
+    if (ec->stats.heal.busy_time > 0) {
+        gf_proc_dump_write("throughput", "%" PRIu64,
+                           bytes * 1000000 / ec->stats.heal.busy_time);
+    }
+
     return 0;
 }
 
@@ -1732,7 +1804,7 @@ struct volume_options options[] = {
     {
         .key = {"read-policy"},
         .type = GF_OPTION_TYPE_STR,
-        .value = {"round-robin", "gfid-hash"},
+        .value = {"round-robin", "gfid-hash", "adaptive"},
         .default_value = "gfid-hash",
         .op_version = {GD_OP_VERSION_3_7_6},
         .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1741,7 +1813,10 @@ struct volume_options options[] = {
             "inode-read fops happen only on 'k' number of bricks in"
             " n=k+m disperse subvolume. 'round-robin' selects the read"
             " subvolume using round-robin algo. 'gfid-hash' selects read"
-            " subvolume based on hash of the gfid of that file/directory.",
+            " subvolume based on hash of the gfid of that file/directory."
+            " 'adaptive' avoids the bricks whose read latency, multiplied"
+            " by their number of outstanding reads, is much higher than"
+            " the one of the fastest brick.",
     },
     {.key = {"shd-max-threads"},
      .type = GF_OPTION_TYPE_INT,
@@ -1767,7 +1842,7 @@ struct volume_options options[] = {
                     " that can wait in SHD per subvolume"},
     {.key = {"cpu-extensions"},
      .type = GF_OPTION_TYPE_STR,
-     .value = {"none", "auto", "x64", "sse", "avx"},
+     .value = {"none", "auto", "x64", "sse", "avx", "avx512"},
      .default_value = "auto",
      .op_version = {GD_OP_VERSION_3_9_0},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
@@ -1784,6 +1859,28 @@ struct volume_options options[] = {
      .tags = {"disperse"},
      .description = "Maximum number blocks(128KB) per file for which "
                     "self-heal process would be applied simultaneously."},
+    {.key = {"self-heal-pipeline-depth"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 1,
+     .max = 16,
+     .default_value = "1",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Number of self-heal windows of a file that are read and "
+                    "written at the same time, so that the reads of a window "
+                    "overlap with the writes of the previous one."},
+    {.key = {"self-heal-memory-limit"},
+     .type = GF_OPTION_TYPE_SIZET,
+     .min = 1 * GF_UNIT_MB,
+     .max = 4 * GF_UNIT_GB,
+     .default_value = "64MB",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+     .tags = {"disperse"},
+     .description = "Maximum amount of data being healed at the same time by "
+                    "all the heals of the volume. When it's reached, new "
+                    "windows are healed one at a time."},
     {.key = {"optimistic-change-log"},
      .type = GF_OPTION_TYPE_BOOL,
      .default_value = "on",
@@ -0,0 +1,294 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/*
+ * Benchmark for the encoding and decoding functions of the disperse xlator.
+ *
+ * For each layout and each code generator supported by the cpu (plus the
+ * precompiled C code, shown as "none"), it measures:
+ *
+ *   - encode: the rate at which user data is converted into fragments,
+ *   - decode: the rate at which user data is rebuilt from the last
+ *     fragments, so that all the redundancy fragments are used.
+ *
+ * The fragments generated by each generator are compared with the ones of
+ * the C code, and the decoded data with the original one.
+ *
+ * Usage: ec_code_bench [-s size in KiB] [-d seconds] [-l data+redundancy]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "glusterfs/glusterfs.h"
+#include "glusterfs/globals.h"
+#include "glusterfs/xlator.h"
+#include "glusterfs/mem-pool.h"
+
+#include "ec-method.h"
+
+#define BENCH_MAX_LAYOUTS 8
+
+typedef struct {
+    uint32_t data;
+    uint32_t redundancy;
+} bench_layout_t;
+
+static const char *bench_gens[] = {"none", "x64", "sse", "avx", "avx512",
+                                   NULL};
+
+static xlator_t bench_xl;
+static double bench_seconds = 1;
+
+static double
+bench_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void *
+bench_alloc(size_t size)
+{
+    void *ptr = NULL;
+
+    if (posix_memalign(&ptr, EC_METHOD_WORD_SIZE, size) != 0) {
+        fprintf(stderr, "out of memory\n");
+        exit(1);
+    }
+
+    return ptr;
+}
+
+/* MiB of user data processed per second */
+static double
+bench_encode(ec_matrix_list_t *list, uint64_t size, void *in, void **out,
+             uint32_t count)
+{
+    void *ptrs[count];
+    double start, elapsed;
+    uint64_t total = 0;
+
+    start = bench_now();
+    do {
+        memcpy(ptrs, out, sizeof(ptrs));
+        ec_method_encode(list, size, in, ptrs);
+        total += size;
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_seconds);
+
+    return total / elapsed / (1024 * 1024);
+}
+
+static double
+bench_decode(ec_matrix_list_t *list, uint64_t size, uintptr_t mask,
+             uint32_t *rows, void **in, void *out)
+{
+    double start, elapsed;
+    uint64_t total = 0;
+
+    start = bench_now();
+    do {
+        if (ec_method_decode(list, size, mask, rows, in, out) != 0) {
+            return -1;
+        }
+        total += size * list->columns;
+        elapsed = bench_now() - start;
+    } while (elapsed < bench_seconds);
+
+    return total / elapsed / (1024 * 1024);
+}
+
+static int
+bench_layout(bench_layout_t *layout, uint64_t size)
+{
+    ec_matrix_list_t list;
+    uint32_t nodes = layout->data + layout->redundancy;
+    uint64_t frag = size / layout->data;
+    void *ref[nodes];
+    void *out[nodes];
+    void *in[layout->data];
+    uint32_t rows[layout->data];
+    uintptr_t mask = 0;
+    uint8_t *data = NULL;
+    uint8_t *decoded = NULL;
+    double enc, dec;
+    uint32_t i, j;
+    int ret = -1;
+
+    data = bench_alloc(size);
+    decoded = bench_alloc(size);
+    for (i = 0; i < size; i++) {
+        data[i] = random();
+    }
+    for (i = 0; i < nodes; i++) {
+        ref[i] = bench_alloc(frag);
+        out[i] = bench_alloc(frag);
+    }
+
+    /* use the last fragments, so that as many redundancy fragments as
+     * possible are needed to recover the data */
+    for (i = 0; i < layout->data; i++) {
+        j = layout->redundancy + i;
+        rows[i] = j + 1;
+        mask |= 1UL << j;
+    }
+
+    printf("%u+%u, %" PRIu64 " KiB\n", layout->data, layout->redundancy,
+           size / 1024);
+
+    for (i = 0; bench_gens[i] != NULL; i++) {
+        memset(&list, 0, sizeof(list));
+        if (ec_method_init(&bench_xl, &list, layout->data, nodes, nodes * 2,
+                           bench_gens[i]) != 0) {
+            fprintf(stderr, "failed to initialize the matrices\n");
+            goto out;
+        }
+
+        /* ec_code_detect() selects another generator if the requested one
+         * is not supported, and the generator is disabled if the code can't
+         * be built */
+        if ((i > 0) && ((list.code->gen == NULL) ||
+                        (strcmp(list.code->gen->name, bench_gens[i]) != 0))) {
+            printf("  %-8s not supported\n", bench_gens[i]);
+            ec_method_fini(&list);
+            continue;
+        }
+
+        enc = bench_encode(&list, size, data, i == 0 ? ref : out, nodes);
+        for (j = 0; (i > 0) && (j < nodes); j++) {
+            if (memcmp(ref[j], out[j], frag) != 0) {
+                fprintf(stderr, "%s: fragment %u differs\n", bench_gens[i], j);
+                goto out_fini;
+            }
+        }
+
+        for (j = 0; j < layout->data; j++) {
+            in[j] = ref[rows[j] - 1];
+        }
+        memset(decoded, 0, size);
+        dec = bench_decode(&list, frag, mask, rows, in, decoded);
+        if ((dec < 0) || (memcmp(data, decoded, size) != 0)) {
+            fprintf(stderr, "%s: decoding failed\n", bench_gens[i]);
+            goto out_fini;
+        }
+
+        if ((i > 0) && (list.code->gen == NULL)) {
+            printf("  %-8s failed to generate code\n", bench_gens[i]);
+        } else {
+            printf("  %-8s encode %9.1f MiB/s  decode %9.1f MiB/s\n",
+                   bench_gens[i], enc, dec);
+        }
+
+        ec_method_fini(&list);
+    }
+
+    ret = 0;
+    goto out;
+
+out_fini:
+    ec_method_fini(&list);
+out:
+    for (i = 0; i < nodes; i++) {
+        free(ref[i]);
+        free(out[i]);
+    }
+    free(data);
+    free(decoded);
+
+    return ret;
+}
+
+int
+main(int argc, char *argv[])
+{
+    bench_layout_t layouts[BENCH_MAX_LAYOUTS] = {
+        {4, 2}, {8, 3}, {16, 4}};
+    glusterfs_ctx_t *ctx = NULL;
+    gf_boolean_t custom = _gf_false;
+    uint32_t count = 3;
+    uint64_t size = 1024;
+    uint64_t stripe = 0;
+    uint32_t i = 0;
+    int opt = 0;
+
+    while ((opt = getopt(argc, argv, "s:d:l:")) != -1) {
+        switch (opt) {
+            case 's':
+                size = strtoull(optarg, NULL, 0);
+                break;
+            case 'd':
+                bench_seconds = strtod(optarg, NULL);
+                break;
+            case 'l':
+                /* the given layouts replace the default ones */
+                if (!custom) {
+                    custom = _gf_true;
+                    count = 0;
+                }
+                if ((count == BENCH_MAX_LAYOUTS) ||
+                    (sscanf(optarg, "%u+%u", &layouts[count].data,
+                            &layouts[count].redundancy) != 2)) {
+                    fprintf(stderr, "invalid layout '%s'\n", optarg);
+                    return 1;
+                }
+                count++;
+                break;
+            default:
+                fprintf(stderr,
+                        "usage: %s [-s size in KiB] [-d seconds] "
+                        "[-l data+redundancy]\n",
+                        argv[0]);
+                return 1;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        if ((layouts[i].data == 0) ||
+            (layouts[i].data > EC_METHOD_MAX_FRAGMENTS) ||
+            (layouts[i].redundancy == 0) ||
+            (layouts[i].redundancy * 2 >=
+             layouts[i].data + layouts[i].redundancy)) {
+            fprintf(stderr, "invalid layout %u+%u\n", layouts[i].data,
+                    layouts[i].redundancy);
+            return 1;
+        }
+    }
+
+    mem_pools_init();
+
+    ctx = glusterfs_ctx_new();
+    if (!ctx || glusterfs_globals_init(ctx) != 0) {
+        fprintf(stderr, "failed to initialize glusterfs context\n");
+        return 1;
+    }
+    THIS->ctx = ctx;
+
+    bench_xl.name = "ec-bench";
+    bench_xl.ctx = ctx;
+    THIS = &bench_xl;
+
+    for (i = 0; i < count; i++) {
+        /* a whole number of stripes */
+        stripe = EC_METHOD_CHUNK_SIZE * layouts[i].data;
+        if (bench_layout(&layouts[i],
+                         (size * 1024 + stripe - 1) / stripe * stripe) != 0) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
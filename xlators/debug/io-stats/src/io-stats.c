@@ -126,6 +126,11 @@ struct ios_lat {
     double max;
     double avg;
     uint64_t total;
+    /* percentiles, filled from the histograms when dumping */
+    double p50;
+    double p90;
+    double p99;
+    double p999;
 };
 
 struct ios_global_stats {
@@ -156,6 +161,9 @@ struct ios_conf {
     struct ios_global_stats cumulative;
     uint64_t increment;
     struct ios_global_stats incremental;
+    /* latencies in ns, allocated for the fops that are seen */
+    gf_latency_hist_t *cumulative_hist[GF_FOP_MAXVALUE];
+    gf_latency_hist_t *incremental_hist[GF_FOP_MAXVALUE];
     gf_boolean_t dump_fd_stats;
     gf_boolean_t count_fop_hits;
     gf_boolean_t measure_latency;
@@ -891,6 +899,12 @@ io_stats_dump_global_to_json_logfp(xlator_t *this,
                 key_prefix, str_prefix, lc_fop_name, fop_lat_min);
         ios_log(this, logfp, "\"%s.%s.fop.%s.latency_max_usec\": %0.2lf,",
                 key_prefix, str_prefix, lc_fop_name, fop_lat_max);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p50_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, stats->latency[i].p50);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p99_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, stats->latency[i].p99);
+        ios_log(this, logfp, "\"%s.%s.fop.%s.latency_p999_usec\": %0.2lf,",
+                key_prefix, str_prefix, lc_fop_name, stats->latency[i].p999);
 
         fop_ave_usec_sum += fop_lat_ave;
         weighted_fop_ave_usec_sum += fop_hits * fop_lat_ave;
@@ -1379,6 +1393,31 @@ io_stats_dump_global_to_logfp(xlator_t *this, struct ios_global_stats *stats,
     return 0;
 }
 
+static int
+io_stats_dump_percentiles_to_dict(xlator_t *this, dict_t *dict, int interval,
+                                  int fop, struct ios_lat *lat)
+{
+    char key[64] = {0};
+    const char *names[] = {"p50", "p90", "p99", "p999"};
+    double values[] = {lat->p50, lat->p90, lat->p99, lat->p999};
+    int ret = 0;
+    int i;
+
+    for (i = 0; i < 4; i++) {
+        snprintf(key, sizeof(key), "%d-%d-%slatency", interval, fop,
+                 names[i]);
+        ret = dict_set_double(dict, key, values[i]);
+        if (ret) {
+            gf_log(this->name, GF_LOG_ERROR,
+                   "failed to set %s %slatency(%d) with %f", gf_fop_list[fop],
+                   names[i], interval, values[i]);
+            break;
+        }
+    }
+
+    return ret;
+}
+
 int
 io_stats_dump_global_to_dict(xlator_t *this, struct ios_global_stats *stats,
                              struct timeval *now, int interval, dict_t *dict)
@@ -1509,6 +1548,13 @@ io_stats_dump_global_to_dict(xlator_t *this, struct ios_global_stats *stats,
                    gf_fop_list[i], interval, stats->latency[i].max);
             goto out;
         }
+
+        if (stats->latency[i].p50 == 0)
+            continue;
+        ret = io_stats_dump_percentiles_to_dict(this, dict, interval, i,
+                                                &stats->latency[i]);
+        if (ret)
+            goto out;
     }
     for (i = 0; i < GF_UPCALL_FLAGS_MAXVALUE; i++) {
         fop_hits = GF_ATOMIC_GET(stats->upcall_hits[i]);
@@ -1599,6 +1645,37 @@ ios_global_stats_clear(struct ios_global_stats *stats, struct timeval *now)
     stats->started_at = *now;
 }
 
+static void
+ios_latency_hist_clear(gf_latency_hist_t **hists)
+{
+    int i;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        if (hists[i])
+            gf_latency_hist_reset(hists[i]);
+    }
+}
+
+/* Fills the percentiles of a copy of the stats, in microseconds */
+static void
+ios_latency_percentiles(struct ios_global_stats *stats,
+                        gf_latency_hist_t **hists)
+{
+    struct ios_lat *lat = NULL;
+    int i;
+
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        if (!hists[i])
+            continue;
+
+        lat = &stats->latency[i];
+        lat->p50 = gf_latency_hist_percentile(hists[i], 50) / 1000.0;
+        lat->p90 = gf_latency_hist_percentile(hists[i], 90) / 1000.0;
+        lat->p99 = gf_latency_hist_percentile(hists[i], 99) / 1000.0;
+        lat->p999 = gf_latency_hist_percentile(hists[i], 99.9) / 1000.0;
+    }
+}
+
 int
 io_stats_dump(xlator_t *this, struct ios_dump_args *args, ios_info_op_t op,
               gf_boolean_t is_peek)
@@ -1619,17 +1696,21 @@ io_stats_dump(xlator_t *this, struct ios_dump_args *args, ios_info_op_t op,
     gettimeofday(&now, NULL);
     LOCK(&conf->lock);
     {
-        if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_CUMULATIVE)
+        if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_CUMULATIVE) {
             cumulative = conf->cumulative;
+            ios_latency_percentiles(&cumulative, conf->cumulative_hist);
+        }
 
         if (op == GF_IOS_INFO_ALL || op == GF_IOS_INFO_INCREMENTAL) {
             incremental = conf->incremental;
+            ios_latency_percentiles(&incremental, conf->incremental_hist);
             increment = conf->increment;
 
             if (!is_peek) {
                 increment = conf->increment++;
 
                 ios_global_stats_clear(&conf->incremental, &now);
+                ios_latency_hist_clear(conf->incremental_hist);
             }
         }
     }
@@ -1775,6 +1856,16 @@ update_ios_latency_stats(struct ios_global_stats *stats, double elapsed,
                                        GF_ATOMIC_GET(stats->fop_hits[op]);
 }
 
+static void
+update_ios_latency_hist(gf_latency_hist_t **hists, double elapsed,
+                        glusterfs_fop_t op)
+{
+    gf_latency_hist_t *hist = gf_latency_hist_get(&hists[op]);
+
+    if (hist)
+        gf_latency_hist_record(hist, (uint64_t)(elapsed * 1000));
+}
+
 int
 update_ios_latency(struct ios_conf *conf, call_frame_t *frame,
                    glusterfs_fop_t op)
@@ -1791,6 +1882,8 @@ update_ios_latency(struct ios_conf *conf, call_frame_t *frame,
 
     update_ios_latency_stats(&conf->cumulative, elapsed, op);
     update_ios_latency_stats(&conf->incremental, elapsed, op);
+    update_ios_latency_hist(conf->cumulative_hist, elapsed, op);
+    update_ios_latency_hist(conf->incremental_hist, elapsed, op);
     collect_ios_latency_sample(conf, op, elapsed, frame);
 
     return 0;
@@ -3618,6 +3711,8 @@ io_stats_clear(struct ios_conf *conf)
         {
             ios_global_stats_clear(&conf->cumulative, &now);
             ios_global_stats_clear(&conf->incremental, &now);
+            ios_latency_hist_clear(conf->cumulative_hist);
+            ios_latency_hist_clear(conf->incremental_hist);
             conf->increment = 0;
         }
         UNLOCK(&conf->lock);
@@ -3858,12 +3953,18 @@ mem_acct_init(xlator_t *this)
 void
 ios_conf_destroy(struct ios_conf *conf)
 {
+    int i;
+
     if (!conf)
         return;
 
     ios_destroy_top_stats(conf);
     _ios_destroy_dump_thread(conf);
     ios_destroy_sample_buf(conf->ios_sample_buf);
+    for (i = 0; i < GF_FOP_MAXVALUE; i++) {
+        GF_FREE(conf->cumulative_hist[i]);
+        GF_FREE(conf->incremental_hist[i]);
+    }
     LOCK_DESTROY(&conf->lock);
     GF_FREE(conf->dnscache);
     GF_FREE(conf);
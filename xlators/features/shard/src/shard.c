@@ -4658,6 +4658,11 @@ shard_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     frame->local = local;
     local->block_size = priv->block_size;
 
+    /* the file size xattr must account for the data, it is written by a
+     * regular writev */
+    if (xdata)
+        dict_del_sizen(xdata, GF_CREATE_WRITE_KEY);
+
     if (!__is_gsyncd_on_shard_dir(frame, loc)) {
         SHARD_INODE_CREATE_INIT(this, local->block_size, xdata, loc, 0, 0, err);
     }
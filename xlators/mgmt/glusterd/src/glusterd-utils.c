@@ -1957,6 +1957,8 @@ glusterd_volume_start_glusterfs(glusterd_volinfo_t *volinfo,
     char *inet_family = NULL;
     char *global_threading = NULL;
     bool threading = false;
+    char *event_affinity = NULL;
+    bool affinity = false;
 
     GF_ASSERT(volinfo);
     GF_ASSERT(brickinfo);
@@ -2124,6 +2126,15 @@ retry:
         }
     }
 
+    if (dict_get_strn(volinfo->dict, VKEY_CONFIG_EVENT_AFFINITY,
+                      SLEN(VKEY_CONFIG_EVENT_AFFINITY),
+                      &event_affinity) == 0) {
+        if ((gf_string2boolean(event_affinity, &affinity) == 0) &&
+            affinity) {
+            runner_add_arg(&runner, "--event-thread-affinity");
+        }
+    }
+
     runner_add_arg(&runner, "--xlator-option");
     runner_argprintf(&runner, "%s-server.listen-port=%d", volinfo->volname,
                      port);
@@ -12179,6 +12190,7 @@ gd_update_volume_op_versions(glusterd_volinfo_t *volinfo)
 {
     glusterd_conf_t *conf = NULL;
     gf_boolean_t ob_enabled = _gf_false;
+    char *read_policy = NULL;
 
     GF_ASSERT(volinfo);
 
@@ -12217,6 +12229,15 @@ gd_update_volume_op_versions(glusterd_volinfo_t *volinfo)
             volinfo->client_op_version = GD_OP_VERSION_3_6_0;
     }
 
+    /* Older clients reject the 'adaptive' value of an option they know */
+    if (!dict_get_str(volinfo->dict, "disperse.read-policy", &read_policy) &&
+        !strcmp(read_policy, "adaptive")) {
+        if (volinfo->op_version < GD_OP_VERSION_9_0)
+            volinfo->op_version = GD_OP_VERSION_9_0;
+        if (volinfo->client_op_version < GD_OP_VERSION_9_0)
+            volinfo->client_op_version = GD_OP_VERSION_9_0;
+    }
+
     return;
 }
 
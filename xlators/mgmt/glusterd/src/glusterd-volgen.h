@@ -41,6 +41,7 @@
 #define VKEY_CONFIG_GLOBAL_THREADING "config.global-threading"
 #define VKEY_CONFIG_CLIENT_THREADS "config.client-threads"
 #define VKEY_CONFIG_BRICK_THREADS "config.brick-threads"
+#define VKEY_CONFIG_EVENT_AFFINITY "config.event-thread-affinity"
 
 #define AUTH_ALLOW_MAP_KEY "auth.allow"
 #define AUTH_REJECT_MAP_KEY "auth.reject"
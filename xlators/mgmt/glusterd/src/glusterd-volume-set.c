@@ -325,6 +325,24 @@ out:
     return ret;
 }
 
+static int
+validate_disperse_read_policy(glusterd_volinfo_t *volinfo, dict_t *dict,
+                              char *key, char *value, char **op_errstr)
+{
+    char errstr[2048] = "";
+    int ret = 0;
+
+    /* 'adaptive' is newer than the option itself */
+    if (value && !strcmp(value, "adaptive")) {
+        ret = op_version_check(THIS, GD_OP_VERSION_9_0, errstr,
+                               sizeof(errstr));
+        if (ret)
+            *op_errstr = gf_strdup(errstr);
+    }
+
+    return ret;
+}
+
 static int
 validate_replica(glusterd_volinfo_t *volinfo, dict_t *dict, char *key,
                  char *value, char **op_errstr)
@@ -933,6 +951,34 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_4_0_0,
         .flags = VOLOPT_FLAG_CLIENT_OPT,
     },
+    {
+        .key = "cluster.rebal-copy-streams",
+        .voltype = "cluster/distribute",
+        .option = "rebal-copy-streams",
+        .op_version = GD_OP_VERSION_9_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+    {
+        .key = "cluster.lookup-cache-timeout",
+        .voltype = "cluster/distribute",
+        .option = "lookup-cache-timeout",
+        .op_version = GD_OP_VERSION_9_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+    {
+        .key = "cluster.lookup-cache-size",
+        .voltype = "cluster/distribute",
+        .option = "lookup-cache-size",
+        .op_version = GD_OP_VERSION_9_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
+    {
+        .key = "cluster.readdir-prefetch-size",
+        .voltype = "cluster/distribute",
+        .option = "readdir-prefetch-size",
+        .op_version = GD_OP_VERSION_9_0,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+    },
 
     /* NUFA xlator options (Distribute special case) */
     {.key = "cluster.nufa",
@@ -1023,6 +1069,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "data-self-heal-window-size",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.self-heal-pipeline-depth",
+     .voltype = "cluster/replicate",
+     .option = "data-self-heal-pipeline-depth",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.data-change-log",
      .voltype = "cluster/replicate",
      .op_version = 1,
@@ -1238,6 +1289,11 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "performance/io-cache",
      .op_version = 1,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.cache-replacement-policy",
+     .voltype = "performance/io-cache",
+     .option = "cache-replacement-policy",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
 
     /* IO-threads xlator options */
     {.key = "performance.io-thread-count",
@@ -1362,6 +1418,21 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "aggregate-size",
      .op_version = GD_OP_VERSION_4_1_0,
      .flags = OPT_FLAG_CLIENT_OPT},
+    {.key = "performance.write-behind-dirty-budget",
+     .voltype = "performance/write-behind",
+     .option = "dirty-budget",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.write-behind-writeback-size",
+     .voltype = "performance/write-behind",
+     .option = "writeback-size",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "performance.write-behind-writeback-interval",
+     .voltype = "performance/write-behind",
+     .option = "writeback-interval",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.nfs.write-behind-trickling-writes",
      .voltype = "performance/write-behind",
      .option = "trickling-writes",
@@ -1527,6 +1598,17 @@ struct volopt_map_entry glusterd_volopt_map[] = {
                     "necessary for stricter lock complaince as bricks "
                     "cleanup any granted locks when a client "
                     "disconnects."},
+    {.key = "client.create-write-compound",
+     .voltype = "protocol/client",
+     .option = "create-write-compound",
+     .value = "off",
+     .op_version = GD_OP_VERSION_9_0,
+     .validate_fn = validate_boolean,
+     .type = DOC,
+     .description = "When set, glfs_creat_write() sends the create, the "
+                    "write and the close of a small file to the brick as a "
+                    "single request. The write is not seen by the "
+                    "translators above protocol/client."},
 
     /* Although the following option is named ta-remote-port but it will be
      * added as remote-port in client volfile for ta-bricks only.
@@ -1544,6 +1626,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "network.inode-lru-limit",
      .voltype = "protocol/server",
      .op_version = 1},
+    {.key = "network.inode-table-stripes",
+     .voltype = "protocol/server",
+     .option = "inode-table-stripes",
+     .op_version = GD_OP_VERSION_9_0},
     {.key = AUTH_ALLOW_MAP_KEY,
      .voltype = "protocol/server",
      .option = "!server-auth",
@@ -1668,6 +1754,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_3_10_2,
         .value = "9",
     },
+    {
+        .key = "server.zerocopy-threshold",
+        .voltype = "protocol/server",
+        .option = "transport.socket.zerocopy-threshold",
+        .op_version = GD_OP_VERSION_9_0,
+        .value = "0",
+        .description = "Replies of at least this size are sent with "
+                       "MSG_ZEROCOPY on the new client connections. "
+                       "0 disables it.",
+    },
     {
         .key = "transport.listen-backlog",
         .voltype = "protocol/server",
@@ -1738,6 +1834,16 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     },
 
     /* Performance xlators enable/disbable options */
+    /* Added before write-behind so that it sits below all the other
+     * performance translators, where writes reach it. */
+    {.key = "performance.disk-cache",
+     .voltype = "performance/disk-cache",
+     .option = "!perf",
+     .value = "off",
+     .op_version = GD_OP_VERSION_9_0,
+     .description = "enable/disable the persistent cache of file data on a "
+                    "local directory of the client.",
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "performance.write-behind",
      .voltype = "performance/write-behind",
      .option = "!perf",
@@ -2330,6 +2436,9 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .op_version = GD_OP_VERSION_3_8_0,
     },
     {.key = "storage.linux-aio", .voltype = "storage/posix", .op_version = 1},
+    {.key = "storage.linux-io_uring",
+     .voltype = "storage/posix",
+     .op_version = GD_OP_VERSION_9_0},
     {.key = "storage.batch-fsync-mode",
      .voltype = "storage/posix",
      .op_version = 3},
@@ -2700,6 +2809,7 @@ struct volopt_map_entry glusterd_volopt_map[] = {
     {.key = "disperse.read-policy",
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_7_6,
+     .validate_fn = validate_disperse_read_policy,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.shd-max-threads",
      .voltype = "cluster/replicate",
@@ -2710,6 +2820,10 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/replicate",
      .op_version = GD_OP_VERSION_3_7_12,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "cluster.shd-heal-rate-limit",
+     .voltype = "cluster/replicate",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.locking-scheme",
      .voltype = "cluster/replicate",
      .type = DOC,
@@ -2774,6 +2888,14 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .voltype = "cluster/disperse",
      .op_version = GD_OP_VERSION_3_11_0,
      .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.self-heal-pipeline-depth",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
+    {.key = "disperse.self-heal-memory-limit",
+     .voltype = "cluster/disperse",
+     .op_version = GD_OP_VERSION_9_0,
+     .flags = VOLOPT_FLAG_CLIENT_OPT},
     {.key = "cluster.use-compound-fops",
      .voltype = "cluster/replicate",
      .value = "off",
@@ -2846,6 +2968,37 @@ struct volopt_map_entry glusterd_volopt_map[] = {
         .flags = VOLOPT_FLAG_CLIENT_OPT,
         .op_version = GD_OP_VERSION_3_11_0,
     },
+    {
+        .key = "performance.disk-cache-dir",
+        .voltype = "performance/disk-cache",
+        .option = "cache-dir",
+        .type = DOC,
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_9_0,
+        .description = "Local directory of the clients where the data of "
+                       "the volume is cached.",
+    },
+    {
+        .key = "performance.disk-cache-size",
+        .voltype = "performance/disk-cache",
+        .option = "cache-size",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_9_0,
+    },
+    {
+        .key = "performance.disk-cache-block-size",
+        .voltype = "performance/disk-cache",
+        .option = "block-size",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_9_0,
+    },
+    {
+        .key = "performance.disk-cache-timeout",
+        .voltype = "performance/disk-cache",
+        .option = "cache-timeout",
+        .flags = VOLOPT_FLAG_CLIENT_OPT,
+        .op_version = GD_OP_VERSION_9_0,
+    },
 
     /* Brick multiplexing options */
     {.key = GLUSTERD_BRICK_MULTIPLEX_KEY,
@@ -3049,6 +3202,15 @@ struct volopt_map_entry glusterd_volopt_map[] = {
      .option = "!brick-threads",
      .value = "16",
      .op_version = GD_OP_VERSION_6_0},
+    {.key = VKEY_CONFIG_EVENT_AFFINITY,
+     .voltype = "protocol/server",
+     .option = "!event-thread-affinity",
+     .value = "off",
+     .op_version = GD_OP_VERSION_9_0,
+     .validate_fn = validate_boolean,
+     .description = "Give every event thread of the brick processes its own "
+                    "epoll instance and bind each connection to one of "
+                    "them. Takes effect when the bricks are restarted."},
     {.key = "features.cloudsync-remote-read",
      .voltype = "features/cloudsync",
      .value = "off",
@@ -6249,6 +6249,9 @@ fuse_graph_setup(xlator_t *this, glusterfs_graph_t *graph)
             goto unlock;
         }
 
+        if (priv->inode_table_stripes)
+            inode_table_set_lock_stripes(itable, priv->inode_table_stripes);
+
         ((xlator_t *)graph->top)->itable = itable;
 
         prev_graph = priv->next_graph;
@@ -6717,6 +6720,9 @@ init(xlator_t *this_xl)
     GF_OPTION_INIT("invalidate-limit", priv->invalidate_limit, uint32,
                    cleanup_exit);
 
+    GF_OPTION_INIT("inode-table-stripes", priv->inode_table_stripes, uint32,
+                   cleanup_exit);
+
     GF_OPTION_INIT("event-history", priv->event_history, bool, cleanup_exit);
 
     GF_OPTION_INIT("thin-client", priv->thin_client, bool, cleanup_exit);
@@ -7064,6 +7070,15 @@ struct volume_options options[] = {
                        "of outstanding invalidations reaches this limit "
                        "(0 means 'unlimited')",
     },
+    {
+        .key = {"inode-table-stripes"},
+        .type = GF_OPTION_TYPE_INT,
+        .default_value = "0",
+        .min = 0,
+        .max = GF_INODE_TABLE_MAX_STRIPES,
+        .description = "number of striped locks protecting the hash tables "
+                       "of the inode table (0 means a single table lock)",
+    },
     {
         .key = {"auto-invalidation"},
         .type = GF_OPTION_TYPE_BOOL,
@@ -0,0 +1,1366 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Store of the cached blocks on a local directory.
+ *
+ * Blocks are appended to segment files. The index is a log of fixed size
+ * records describing each change of the store: the attributes of the
+ * version of a file which is cached, the blocks stored, the invalidation
+ * of a file and the eviction of a segment. It is replayed when the store
+ * is opened, and rewritten with only the live entries then and when it
+ * grows too much.
+ *
+ * The cache is bounded by evicting the oldest segment. The blocks of a
+ * file are only used after its attributes (size, mtime and ctime) have
+ * been seen unchanged on the volume, which after a restart happens with
+ * the first lookup or read of the file.
+ *
+ * The data read is stored, and the index written, by a thread of the
+ * store, so that neither the replies of the volume nor the other users of
+ * the lock wait for the local disk. Records still queued when the process
+ * dies are lost, which only loses cached data: a file changed in the
+ * meantime doesn't match its attributes anymore. */
+
+#include "disk-cache.h"
+#include <sys/file.h>
+#include <glusterfs/checksum.h>
+#include <glusterfs/syscall.h>
+#include <glusterfs/statedump.h>
+
+#define DKC_SEGMENT_PREFIX "segment."
+#define DKC_INDEX_SLACK 65536
+
+static void *
+dkc_store_worker(void *data);
+
+static void
+dkc_store_req_free(dkc_store_req_t *req);
+
+static uint32_t
+dkc_gfid_hash(uuid_t gfid)
+{
+    uint32_t hashval = 0;
+
+    memcpy(&hashval, &gfid[12], sizeof(hashval));
+
+    return hashval;
+}
+
+static struct list_head *
+dkc_file_bucket(dkc_conf_t *conf, uuid_t gfid)
+{
+    return &conf->files[dkc_gfid_hash(gfid) % DKC_HASH_BUCKETS];
+}
+
+static uint64_t *
+dkc_gen(dkc_conf_t *conf, uuid_t gfid)
+{
+    return &conf->gens[dkc_gfid_hash(gfid) % DKC_GEN_BUCKETS];
+}
+
+static struct list_head *
+dkc_block_bucket(dkc_conf_t *conf, dkc_file_t *file, uint64_t number)
+{
+    return &conf->blocks[(dkc_gfid_hash(file->gfid) + number) %
+                         DKC_HASH_BUCKETS];
+}
+
+static gf_boolean_t
+dkc_attr_same(struct iatt *a, struct iatt *b)
+{
+    return (a->ia_size == b->ia_size) && (a->ia_mtime == b->ia_mtime) &&
+           (a->ia_mtime_nsec == b->ia_mtime_nsec) &&
+           (a->ia_ctime == b->ia_ctime) &&
+           (a->ia_ctime_nsec == b->ia_ctime_nsec);
+}
+
+static dkc_file_t *
+__dkc_file_find(dkc_conf_t *conf, uuid_t gfid)
+{
+    dkc_file_t *file = NULL;
+
+    list_for_each_entry(file, dkc_file_bucket(conf, gfid), hash)
+    {
+        if (!gf_uuid_compare(file->gfid, gfid))
+            return file;
+    }
+
+    return NULL;
+}
+
+static dkc_file_t *
+__dkc_file_get(dkc_conf_t *conf, uuid_t gfid)
+{
+    dkc_file_t *file = NULL;
+
+    file = __dkc_file_find(conf, gfid);
+    if (file)
+        return file;
+
+    file = GF_CALLOC(1, sizeof(*file), gf_dkc_mt_dkc_file_t);
+    if (!file)
+        return NULL;
+
+    INIT_LIST_HEAD(&file->blocks);
+    gf_uuid_copy(file->gfid, gfid);
+    list_add_tail(&file->hash, dkc_file_bucket(conf, gfid));
+    conf->file_count++;
+
+    return file;
+}
+
+static dkc_block_t *
+__dkc_block_find(dkc_conf_t *conf, dkc_file_t *file, uint64_t number)
+{
+    dkc_block_t *block = NULL;
+
+    list_for_each_entry(block, dkc_block_bucket(conf, file, number), hash)
+    {
+        if ((block->file == file) && (block->number == number))
+            return block;
+    }
+
+    return NULL;
+}
+
+static void
+__dkc_block_del(dkc_conf_t *conf, dkc_block_t *block)
+{
+    list_del(&block->hash);
+    list_del(&block->file_list);
+    list_del(&block->segment_list);
+    block->file->block_count--;
+    conf->block_count--;
+
+    GF_FREE(block);
+}
+
+static dkc_block_t *
+__dkc_block_add(dkc_conf_t *conf, dkc_file_t *file, dkc_segment_t *segment,
+                uint64_t number, uint64_t offset, uint32_t length,
+                uint32_t checksum)
+{
+    dkc_block_t *block = NULL;
+
+    block = __dkc_block_find(conf, file, number);
+    if (block)
+        __dkc_block_del(conf, block);
+
+    block = GF_CALLOC(1, sizeof(*block), gf_dkc_mt_dkc_block_t);
+    if (!block)
+        return NULL;
+
+    block->file = file;
+    block->segment = segment;
+    block->number = number;
+    block->offset = offset;
+    block->length = length;
+    block->checksum = checksum;
+    list_add_tail(&block->hash, dkc_block_bucket(conf, file, number));
+    list_add_tail(&block->file_list, &file->blocks);
+    list_add_tail(&block->segment_list, &segment->blocks);
+    file->block_count++;
+    conf->block_count++;
+
+    return block;
+}
+
+static void
+__dkc_file_del(dkc_conf_t *conf, dkc_file_t *file)
+{
+    dkc_block_t *block = NULL;
+    dkc_block_t *tmp = NULL;
+
+    list_for_each_entry_safe(block, tmp, &file->blocks, file_list)
+    {
+        __dkc_block_del(conf, block);
+    }
+
+    list_del(&file->hash);
+    conf->file_count--;
+
+    GF_FREE(file);
+}
+
+static void
+dkc_record_seal(dkc_conf_t *conf, dkc_record_t *rec)
+{
+    rec->magic = DKC_RECORD_MAGIC;
+    rec->block_size = conf->block_size;
+    rec->crc = gf_rsync_weak_checksum((unsigned char *)rec,
+                                      offsetof(dkc_record_t, crc));
+}
+
+static gf_boolean_t
+dkc_record_valid(dkc_record_t *rec)
+{
+    return (rec->magic == DKC_RECORD_MAGIC) &&
+           (rec->crc == gf_rsync_weak_checksum((unsigned char *)rec,
+                                               offsetof(dkc_record_t, crc)));
+}
+
+static void
+dkc_record_file(dkc_record_t *rec, dkc_file_t *file)
+{
+    rec->type = DKC_RECORD_FILE;
+    memcpy(rec->gfid, file->gfid, sizeof(rec->gfid));
+    rec->number = file->attr.ia_size;
+    rec->offset = file->attr.ia_mtime;
+    rec->ctime = file->attr.ia_ctime;
+    rec->nsec[0] = file->attr.ia_mtime_nsec;
+    rec->nsec[1] = file->attr.ia_ctime_nsec;
+}
+
+static void
+dkc_record_block(dkc_record_t *rec, dkc_block_t *block)
+{
+    rec->type = DKC_RECORD_BLOCK;
+    memcpy(rec->gfid, block->file->gfid, sizeof(rec->gfid));
+    rec->number = block->number;
+    rec->segment = block->segment->id;
+    rec->offset = block->offset;
+    rec->length = block->length;
+    rec->checksum = block->checksum;
+}
+
+/* Queues a record for the store thread. Once the queue is full, the index
+ * is rewritten instead from the state in memory, which has the changes of
+ * the records dropped. */
+static void
+__dkc_index_append(xlator_t *this, dkc_conf_t *conf, dkc_record_t *rec)
+{
+    conf->index_records++;
+
+    if (conf->compact)
+        return;
+
+    if (conf->pending_count == DKC_INDEX_BATCH) {
+        conf->compact = _gf_true;
+        pthread_cond_signal(&conf->cond);
+        return;
+    }
+
+    dkc_record_seal(conf, rec);
+    conf->pending[conf->pending_count++] = *rec;
+
+    if (conf->pending_count == DKC_INDEX_BATCH / 2)
+        pthread_cond_signal(&conf->cond);
+}
+
+static void
+__dkc_index_file(xlator_t *this, dkc_conf_t *conf, dkc_file_t *file)
+{
+    dkc_record_t rec = {
+        0,
+    };
+
+    dkc_record_file(&rec, file);
+    __dkc_index_append(this, conf, &rec);
+    file->saved = _gf_true;
+}
+
+static void
+__dkc_index_block(xlator_t *this, dkc_conf_t *conf, dkc_block_t *block)
+{
+    dkc_record_t rec = {
+        0,
+    };
+
+    dkc_record_block(&rec, block);
+    __dkc_index_append(this, conf, &rec);
+}
+
+static void
+__dkc_index_event(xlator_t *this, dkc_conf_t *conf, uint32_t type,
+                  uuid_t gfid, uint64_t segment)
+{
+    dkc_record_t rec = {
+        0,
+    };
+
+    rec.type = type;
+    if (gfid)
+        memcpy(rec.gfid, gfid, sizeof(rec.gfid));
+    rec.segment = segment;
+    __dkc_index_append(this, conf, &rec);
+}
+
+static int
+dkc_index_flush(int fd, dkc_record_t *recs, size_t count)
+{
+    ssize_t size = count * sizeof(*recs);
+
+    return (sys_write(fd, recs, size) == size) ? 0 : -1;
+}
+
+/* Rewrites the index with the records of the live files and blocks. Only
+ * called by the store thread, or before it is started. */
+static int
+dkc_index_compact(xlator_t *this, dkc_conf_t *conf)
+{
+    char path[PATH_MAX];
+    char tmp_path[PATH_MAX];
+    dkc_record_t *recs = NULL;
+    dkc_file_t *file = NULL;
+    dkc_block_t *block = NULL;
+    uint64_t count = 0;
+    int fd = -1;
+    int ret = -1;
+    int i = 0;
+
+    snprintf(path, sizeof(path), "%s/" DKC_INDEX_NAME, conf->cache_dir);
+    snprintf(tmp_path, sizeof(tmp_path), "%s/" DKC_INDEX_NAME ".tmp",
+             conf->cache_dir);
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        recs = GF_CALLOC(conf->file_count + conf->block_count + 1,
+                         sizeof(*recs), gf_dkc_mt_dkc_record_t);
+        if (!recs)
+            goto unlock;
+
+        for (i = 0; i < DKC_HASH_BUCKETS; i++) {
+            list_for_each_entry(file, &conf->files[i], hash)
+            {
+                dkc_record_file(&recs[count], file);
+                dkc_record_seal(conf, &recs[count++]);
+                file->saved = _gf_true;
+
+                list_for_each_entry(block, &file->blocks, file_list)
+                {
+                    dkc_record_block(&recs[count], block);
+                    dkc_record_seal(conf, &recs[count++]);
+                }
+            }
+        }
+
+        /* the records queued so far are superseded */
+        conf->pending_count = 0;
+        conf->compact = _gf_false;
+    }
+unlock:
+    pthread_mutex_unlock(&conf->lock);
+
+    if (!recs)
+        goto out;
+
+    fd = sys_open(tmp_path, O_CREAT | O_TRUNC | O_WRONLY | O_APPEND, 0600);
+    if (fd < 0)
+        goto out;
+
+    if (dkc_index_flush(fd, recs, count) || sys_fsync(fd) ||
+        sys_rename(tmp_path, path))
+        goto out;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (conf->index_fd >= 0)
+            sys_close(conf->index_fd);
+        conf->index_fd = fd;
+        conf->index_records = count + conf->pending_count;
+        conf->index_error = _gf_false;
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    fd = -1;
+    ret = 0;
+
+out:
+    if (ret)
+        gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_INDEX_FAILED,
+               "failed to rewrite the index of %s", conf->cache_dir);
+    if (fd >= 0) {
+        sys_close(fd);
+        sys_unlink(tmp_path);
+    }
+    GF_FREE(recs);
+
+    return ret;
+}
+
+/* Writes the queued records to the index, or rewrites it. Only called by
+ * the store thread. */
+static void
+dkc_index_sync(xlator_t *this, dkc_conf_t *conf)
+{
+    dkc_record_t *recs = NULL;
+    gf_boolean_t compact = _gf_false;
+    uint32_t count = 0;
+    int fd = -1;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        compact = conf->compact;
+        if (!compact) {
+            recs = conf->pending;
+            count = conf->pending_count;
+            conf->pending = conf->flushing;
+            conf->flushing = recs;
+            conf->pending_count = 0;
+        }
+        fd = conf->index_fd;
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    if (compact) {
+        dkc_index_compact(this, conf);
+        return;
+    }
+
+    if (!count || !dkc_index_flush(fd, recs, count))
+        return;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (!conf->index_error)
+            gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_INDEX_FAILED,
+                   "failed to update the index of %s", conf->cache_dir);
+        conf->index_error = _gf_true;
+    }
+    pthread_mutex_unlock(&conf->lock);
+}
+
+static void
+__dkc_segment_unref(dkc_conf_t *conf, dkc_segment_t *segment)
+{
+    char path[PATH_MAX];
+
+    if (--segment->refcount > 0)
+        return;
+
+    sys_close(segment->fd);
+    if (segment->dead) {
+        snprintf(path, sizeof(path), "%s/" DKC_SEGMENT_FMT, conf->cache_dir,
+                 segment->id);
+        sys_unlink(path);
+    }
+
+    GF_FREE(segment);
+}
+
+static dkc_segment_t *
+__dkc_segment_find(dkc_conf_t *conf, uint64_t id)
+{
+    dkc_segment_t *segment = NULL;
+
+    list_for_each_entry(segment, &conf->segments, list)
+    {
+        if (segment->id == id)
+            return segment;
+    }
+
+    return NULL;
+}
+
+static dkc_segment_t *
+__dkc_segment_add(xlator_t *this, dkc_conf_t *conf, uint64_t id, int flags)
+{
+    dkc_segment_t *segment = NULL;
+    dkc_segment_t *prev = NULL;
+    char path[PATH_MAX];
+    struct stat stbuf;
+    int fd = -1;
+
+    snprintf(path, sizeof(path), "%s/" DKC_SEGMENT_FMT, conf->cache_dir, id);
+    fd = sys_open(path, O_RDWR | flags, 0600);
+    if ((fd < 0) || sys_fstat(fd, &stbuf)) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_SEGMENT_FAILED,
+               "failed to open %s", path);
+        goto err;
+    }
+
+    segment = GF_CALLOC(1, sizeof(*segment), gf_dkc_mt_dkc_segment_t);
+    if (!segment)
+        goto err;
+
+    INIT_LIST_HEAD(&segment->blocks);
+    segment->id = id;
+    segment->fd = fd;
+    segment->size = stbuf.st_size;
+    segment->refcount = 1; /* of conf->segments */
+
+    /* keep the list sorted, segments are mostly added in order */
+    list_for_each_entry_reverse(prev, &conf->segments, list)
+    {
+        if (prev->id < id)
+            break;
+    }
+    list_add(&segment->list, &prev->list);
+
+    return segment;
+
+err:
+    if (fd >= 0)
+        sys_close(fd);
+    return NULL;
+}
+
+/* Drops the blocks of the segment, and the segment once no read uses it. */
+static void
+__dkc_segment_evict(xlator_t *this, dkc_conf_t *conf, dkc_segment_t *segment,
+                    gf_boolean_t save)
+{
+    dkc_block_t *block = NULL;
+    dkc_block_t *tmp = NULL;
+    dkc_file_t *file = NULL;
+
+    list_for_each_entry_safe(block, tmp, &segment->blocks, segment_list)
+    {
+        file = block->file;
+        __dkc_block_del(conf, block);
+        if (!file->block_count)
+            __dkc_file_del(conf, file);
+    }
+
+    if (save)
+        __dkc_index_event(this, conf, DKC_RECORD_DROP, NULL, segment->id);
+
+    if (segment == conf->current)
+        conf->current = NULL;
+
+    list_del_init(&segment->list);
+    conf->used -= segment->size;
+    segment->dead = _gf_true;
+    __dkc_segment_unref(conf, segment);
+}
+
+/* Returns the segment where 'length' bytes can be appended. */
+static dkc_segment_t *
+__dkc_segment_current(xlator_t *this, dkc_conf_t *conf, uint32_t length)
+{
+    dkc_segment_t *segment = conf->current;
+
+    if (segment && (segment->size + length <= conf->segment_size))
+        return segment;
+
+    segment = __dkc_segment_add(this, conf, conf->next_segment,
+                                O_CREAT | O_TRUNC);
+    if (!segment)
+        return NULL;
+
+    conf->next_segment++;
+    conf->current = segment;
+
+    return segment;
+}
+
+static void
+__dkc_prune(xlator_t *this, dkc_conf_t *conf)
+{
+    dkc_segment_t *segment = NULL;
+    gf_boolean_t evicted = _gf_false;
+
+    while ((conf->used > conf->cache_size) && !list_empty(&conf->segments)) {
+        segment = list_first_entry(&conf->segments, dkc_segment_t, list);
+        __dkc_segment_evict(this, conf, segment, _gf_true);
+        GF_ATOMIC_INC(conf->evicted);
+        evicted = _gf_true;
+    }
+
+    if (evicted && (conf->index_records > 2 * (conf->block_count +
+                                               conf->file_count) +
+                                              DKC_INDEX_SLACK)) {
+        conf->compact = _gf_true;
+        pthread_cond_signal(&conf->cond);
+    }
+}
+
+static void
+__dkc_invalidate(xlator_t *this, dkc_conf_t *conf, dkc_file_t *file)
+{
+    __dkc_index_event(this, conf, DKC_RECORD_INVALIDATE, file->gfid, 0);
+    __dkc_file_del(conf, file);
+    GF_ATOMIC_INC(conf->invalidations);
+}
+
+static void
+dkc_segment_size_set(dkc_conf_t *conf)
+{
+    conf->segment_size = conf->cache_size / DKC_SEGMENT_COUNT;
+    conf->segment_size = max(conf->segment_size, DKC_SEGMENT_MIN_SIZE);
+    conf->segment_size = min(conf->segment_size, DKC_SEGMENT_MAX_SIZE);
+}
+
+static void
+__dkc_replay_record(xlator_t *this, dkc_conf_t *conf, dkc_record_t *rec,
+                    dkc_segment_t **last)
+{
+    dkc_segment_t *segment = *last;
+    dkc_file_t *file = NULL;
+    struct iatt attr = {
+        0,
+    };
+
+    switch (rec->type) {
+        case DKC_RECORD_FILE:
+            attr.ia_size = rec->number;
+            attr.ia_mtime = rec->offset;
+            attr.ia_mtime_nsec = rec->nsec[0];
+            attr.ia_ctime = rec->ctime;
+            attr.ia_ctime_nsec = rec->nsec[1];
+
+            file = __dkc_file_find(conf, rec->gfid);
+            if (file && !dkc_attr_same(&file->attr, &attr))
+                __dkc_file_del(conf, file);
+
+            file = __dkc_file_get(conf, rec->gfid);
+            if (file)
+                file->attr = attr;
+            break;
+
+        case DKC_RECORD_BLOCK:
+            if (rec->block_size != conf->block_size)
+                break;
+
+            file = __dkc_file_find(conf, rec->gfid);
+            if (!file)
+                break;
+
+            if (!segment || (segment->id != rec->segment))
+                segment = __dkc_segment_find(conf, rec->segment);
+            if (!segment || (rec->offset + rec->length > segment->size))
+                break;
+
+            *last = segment;
+            __dkc_block_add(conf, file, segment, rec->number, rec->offset,
+                            rec->length, rec->checksum);
+            break;
+
+        case DKC_RECORD_INVALIDATE:
+            file = __dkc_file_find(conf, rec->gfid);
+            if (file)
+                __dkc_file_del(conf, file);
+            break;
+
+        case DKC_RECORD_DROP:
+            segment = __dkc_segment_find(conf, rec->segment);
+            if (segment) {
+                if (segment == *last)
+                    *last = NULL;
+                __dkc_segment_evict(this, conf, segment, _gf_false);
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+static void
+__dkc_index_replay(xlator_t *this, dkc_conf_t *conf)
+{
+    dkc_segment_t *last = NULL;
+    dkc_record_t *recs = NULL;
+    char path[PATH_MAX];
+    ssize_t size = 0;
+    off_t offset = 0;
+    int count = 0;
+    int fd = -1;
+    int i = 0;
+
+    snprintf(path, sizeof(path), "%s/" DKC_INDEX_NAME, conf->cache_dir);
+    fd = sys_open(path, O_RDONLY, 0);
+    if (fd < 0)
+        return;
+
+    recs = GF_MALLOC(DKC_INDEX_BATCH * sizeof(*recs), gf_dkc_mt_dkc_record_t);
+    if (!recs)
+        goto out;
+
+    while ((size = sys_read(fd, recs, DKC_INDEX_BATCH * sizeof(*recs))) > 0) {
+        count = size / sizeof(*recs);
+        for (i = 0; i < count; i++) {
+            if (!dkc_record_valid(&recs[i]))
+                goto truncated;
+
+            __dkc_replay_record(this, conf, &recs[i], &last);
+            offset += sizeof(*recs);
+        }
+
+        if (size % sizeof(*recs))
+            goto truncated;
+    }
+
+    goto out;
+
+truncated:
+    /* the end of the index wasn't written completely */
+    gf_msg(this->name, GF_LOG_WARNING, 0, DKC_MSG_INDEX_TRUNCATED,
+           "ignoring the index of %s after offset %" PRId64, conf->cache_dir,
+           offset);
+out:
+    GF_FREE(recs);
+    sys_close(fd);
+}
+
+int
+dkc_store_open(xlator_t *this)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_segment_t *segment = NULL;
+    dkc_segment_t *tmp = NULL;
+    dkc_file_t *file = NULL;
+    dkc_file_t *next = NULL;
+    struct dirent *entry = NULL;
+    struct dirent scratch[2] = {
+        {
+            0,
+        },
+    };
+    char path[PATH_MAX];
+    DIR *dir = NULL;
+    char *end = NULL;
+    uint64_t id = 0;
+    int ret = -1;
+    int i = 0;
+
+    dkc_segment_size_set(conf);
+
+    if (mkdir_p(conf->cache_dir, 0700, _gf_true)) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, DKC_MSG_STORE_OPEN_FAILED,
+               "failed to create %s", conf->cache_dir);
+        goto out;
+    }
+
+    snprintf(path, sizeof(path), "%s/" DKC_LOCK_NAME, conf->cache_dir);
+    conf->lock_fd = sys_open(path, O_CREAT | O_RDWR, 0600);
+    if (conf->lock_fd < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, DKC_MSG_STORE_OPEN_FAILED,
+               "failed to open %s", path);
+        goto out;
+    }
+
+    if (flock(conf->lock_fd, LOCK_EX | LOCK_NB)) {
+        gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_STORE_BUSY,
+               "%s is used by another process", conf->cache_dir);
+        goto out;
+    }
+
+    dir = sys_opendir(conf->cache_dir);
+    if (!dir) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, DKC_MSG_STORE_OPEN_FAILED,
+               "failed to open %s", conf->cache_dir);
+        goto out;
+    }
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        while ((entry = sys_readdir(dir, scratch)) != NULL) {
+            if (strncmp(entry->d_name, DKC_SEGMENT_PREFIX,
+                        SLEN(DKC_SEGMENT_PREFIX)))
+                continue;
+
+            id = strtoull(entry->d_name + SLEN(DKC_SEGMENT_PREFIX), &end, 10);
+            if (*end != '\0')
+                continue;
+
+            segment = __dkc_segment_add(this, conf, id, 0);
+            if (segment)
+                conf->used += segment->size;
+            if (id >= conf->next_segment)
+                conf->next_segment = id + 1;
+        }
+
+        __dkc_index_replay(this, conf);
+
+        /* the blocks only described by records that were lost */
+        list_for_each_entry_safe(segment, tmp, &conf->segments, list)
+        {
+            if (list_empty(&segment->blocks))
+                __dkc_segment_evict(this, conf, segment, _gf_false);
+        }
+
+        for (i = 0; i < DKC_HASH_BUCKETS; i++) {
+            list_for_each_entry_safe(file, next, &conf->files[i], hash)
+            {
+                if (!file->block_count)
+                    __dkc_file_del(conf, file);
+            }
+        }
+
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    sys_closedir(dir);
+
+    ret = dkc_index_compact(this, conf);
+    if (ret)
+        goto out;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        __dkc_prune(this, conf);
+
+        gf_msg(this->name, GF_LOG_INFO, 0, DKC_MSG_STORE_LOADED,
+               "%s: %" PRIu64 " blocks of %" PRIu64 " files, %" PRIu64
+               " bytes used",
+               conf->cache_dir, conf->block_count, conf->file_count,
+               conf->used);
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    ret = gf_thread_create(&conf->store_thread, NULL, dkc_store_worker, this,
+                           "dkcstore");
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, errno, DKC_MSG_STORE_OPEN_FAILED,
+               "failed to start the store thread of %s", conf->cache_dir);
+        goto out;
+    }
+    conf->store_running = _gf_true;
+
+out:
+    if (ret)
+        dkc_store_close(this);
+
+    return ret;
+}
+
+void
+dkc_store_close(xlator_t *this)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_store_req_t *req = NULL;
+    dkc_store_req_t *req_tmp = NULL;
+    dkc_segment_t *segment = NULL;
+    dkc_segment_t *tmp = NULL;
+    dkc_file_t *file = NULL;
+    dkc_file_t *next = NULL;
+    int i = 0;
+
+    if (conf->store_running) {
+        pthread_mutex_lock(&conf->lock);
+        {
+            conf->store_stop = _gf_true;
+            pthread_cond_signal(&conf->cond);
+        }
+        pthread_mutex_unlock(&conf->lock);
+
+        pthread_join(conf->store_thread, NULL);
+        conf->store_running = _gf_false;
+    }
+
+    list_for_each_entry_safe(req, req_tmp, &conf->store_queue, list)
+    {
+        list_del_init(&req->list);
+        dkc_store_req_free(req);
+    }
+    conf->store_queued = 0;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        for (i = 0; i < DKC_HASH_BUCKETS; i++) {
+            list_for_each_entry_safe(file, next, &conf->files[i], hash)
+            {
+                __dkc_file_del(conf, file);
+            }
+        }
+
+        list_for_each_entry_safe(segment, tmp, &conf->segments, list)
+        {
+            list_del_init(&segment->list);
+            __dkc_segment_unref(conf, segment);
+        }
+        conf->current = NULL;
+        conf->used = 0;
+
+        if (conf->index_fd >= 0)
+            sys_close(conf->index_fd);
+        if (conf->lock_fd >= 0)
+            sys_close(conf->lock_fd);
+        conf->index_fd = -1;
+        conf->lock_fd = -1;
+    }
+    pthread_mutex_unlock(&conf->lock);
+}
+
+/* Called with the attributes of a file seen on the volume. The cached
+ * blocks are used again if they match, and dropped otherwise. */
+void
+dkc_store_validate(xlator_t *this, struct iatt *buf)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_file_t *file = NULL;
+
+    if (!conf->enabled || (buf->ia_type != IA_IFREG))
+        return;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        file = __dkc_file_find(conf, buf->ia_gfid);
+        if (file) {
+            if (dkc_attr_same(&file->attr, buf)) {
+                file->attr = *buf;
+                file->validated = time(NULL);
+            } else {
+                (*dkc_gen(conf, buf->ia_gfid))++;
+                __dkc_invalidate(this, conf, file);
+            }
+        }
+    }
+    pthread_mutex_unlock(&conf->lock);
+}
+
+void
+dkc_store_invalidate(xlator_t *this, uuid_t gfid)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_file_t *file = NULL;
+
+    if (!conf->enabled)
+        return;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        /* reads in progress must not store what they got */
+        (*dkc_gen(conf, gfid))++;
+
+        file = __dkc_file_find(conf, gfid);
+        if (file)
+            __dkc_invalidate(this, conf, file);
+    }
+    pthread_mutex_unlock(&conf->lock);
+}
+
+uint64_t
+dkc_store_gen(xlator_t *this, uuid_t gfid)
+{
+    dkc_conf_t *conf = this->private;
+    uint64_t gen = 0;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        gen = *dkc_gen(conf, gfid);
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    return gen;
+}
+
+/* Reads [offset, offset + size) from the store if all of it is cached for a
+ * recently validated version of the file. Returns -1 otherwise. */
+int
+dkc_store_read(xlator_t *this, uuid_t gfid, off_t offset, size_t size,
+               struct iovec *vector, struct iobref **iobref,
+               struct iatt *stbuf)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_file_t *file = NULL;
+    dkc_block_t *block = NULL;
+    dkc_block_t *blocks = NULL;
+    struct iobuf *iobuf = NULL;
+    uint64_t bs = conf->block_size;
+    uint64_t first = 0;
+    uint64_t count = 0;
+    uint64_t i = 0;
+    off_t end = 0;
+    size_t pos = 0;
+    char *data = NULL;
+    int ret = -1;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        file = __dkc_file_find(conf, gfid);
+        if (!file || !file->validated ||
+            (time(NULL) - file->validated >= conf->cache_timeout))
+            goto unlock;
+
+        end = min(offset + size, file->attr.ia_size);
+        if (offset >= end)
+            goto unlock;
+
+        first = offset / bs;
+        count = (end - 1) / bs - first + 1;
+        blocks = GF_MALLOC(count * sizeof(*blocks), gf_dkc_mt_dkc_block_t);
+        if (!blocks)
+            goto unlock;
+
+        for (i = 0; i < count; i++) {
+            block = __dkc_block_find(conf, file, first + i);
+            if (!block ||
+                (block->length != min(bs, file->attr.ia_size -
+                                              (first + i) * bs)))
+                goto unlock;
+            blocks[i] = *block;
+        }
+
+        for (i = 0; i < count; i++)
+            blocks[i].segment->refcount++;
+
+        *stbuf = file->attr;
+        ret = 0;
+    }
+unlock:
+    pthread_mutex_unlock(&conf->lock);
+
+    if (ret)
+        goto out;
+
+    iobuf = iobuf_get2(this->ctx->iobuf_pool, count * bs);
+    if (!iobuf)
+        ret = -1;
+
+    for (i = 0; (ret == 0) && (i < count); i++) {
+        data = iobuf->ptr + pos;
+        if (sys_pread(blocks[i].segment->fd, data, blocks[i].length,
+                      blocks[i].offset) != blocks[i].length) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_READ_FAILED,
+                   "failed to read block %" PRIu64 " of %s",
+                   blocks[i].number, uuid_utoa(gfid));
+            ret = -1;
+        } else if (gf_rsync_weak_checksum((unsigned char *)data,
+                                          blocks[i].length) !=
+                   blocks[i].checksum) {
+            gf_msg(this->name, GF_LOG_WARNING, 0, DKC_MSG_CHECKSUM_MISMATCH,
+                   "block %" PRIu64 " of %s is corrupted", blocks[i].number,
+                   uuid_utoa(gfid));
+            ret = -1;
+        }
+        pos += blocks[i].length;
+    }
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        for (i = 0; i < count; i++)
+            __dkc_segment_unref(conf, blocks[i].segment);
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    if (ret) {
+        dkc_store_invalidate(this, gfid);
+        goto out;
+    }
+
+    *iobref = iobref_new();
+    if (!*iobref || iobref_add(*iobref, iobuf)) {
+        if (*iobref)
+            iobref_unref(*iobref);
+        *iobref = NULL;
+        ret = -1;
+        goto out;
+    }
+
+    vector->iov_base = iobuf->ptr + (offset - first * bs);
+    vector->iov_len = end - offset;
+
+out:
+    if (iobuf)
+        iobuf_unref(iobuf);
+    GF_FREE(blocks);
+
+    return ret;
+}
+
+/* Stores the blocks read from 'offset', which is aligned to the block size.
+ * A last incomplete block is only stored if it ends the file. Nothing is
+ * stored if the file was invalidated since the read was sent ('gen'). */
+static void
+dkc_store_req_run(xlator_t *this, dkc_store_req_t *req)
+{
+    dkc_conf_t *conf = this->private;
+    struct iatt *buf = &req->buf;
+    struct iovec *vector = req->vector;
+    int32_t count = req->count;
+    uint64_t gen = req->gen;
+    off_t offset = req->offset;
+    size_t size = req->size;
+    dkc_file_t *file = NULL;
+    dkc_block_t *block = NULL;
+    dkc_block_t *res = NULL;
+    dkc_segment_t *segment = NULL;
+    uint64_t bs = conf->block_size;
+    uint64_t nblocks = size / bs;
+    uint64_t stored = 0;
+    uint64_t i = 0;
+    char *flat = NULL;
+    char *data = NULL;
+
+    if ((size % bs) && req->eof && (offset + size == buf->ia_size))
+        nblocks++;
+
+    if (!nblocks)
+        return;
+
+    res = GF_CALLOC(nblocks, sizeof(*res), gf_dkc_mt_dkc_block_t);
+    if (!res)
+        return;
+
+    if (count == 1) {
+        data = vector[0].iov_base;
+    } else {
+        flat = GF_MALLOC(size, gf_dkc_mt_char);
+        if (!flat)
+            goto out;
+        iov_unload(flat, vector, count);
+        data = flat;
+    }
+
+    for (i = 0; i < nblocks; i++) {
+        res[i].number = offset / bs + i;
+        res[i].length = min(bs, size - i * bs);
+        res[i].checksum = gf_rsync_weak_checksum(
+            (unsigned char *)data + i * bs, res[i].length);
+    }
+
+    /* space is reserved in the segments, the blocks are added once they
+     * are written */
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (gen != *dkc_gen(conf, buf->ia_gfid))
+            goto unlock;
+
+        file = __dkc_file_find(conf, buf->ia_gfid);
+        if (file && !dkc_attr_same(&file->attr, buf)) {
+            gen = ++(*dkc_gen(conf, buf->ia_gfid));
+            __dkc_invalidate(this, conf, file);
+            file = NULL;
+        }
+
+        for (i = 0; i < nblocks; i++) {
+            if (file && __dkc_block_find(conf, file, res[i].number))
+                continue;
+
+            segment = __dkc_segment_current(this, conf, res[i].length);
+            if (!segment)
+                break;
+
+            res[i].segment = segment;
+            res[i].offset = segment->size;
+            segment->size += res[i].length;
+            segment->refcount++;
+            conf->used += res[i].length;
+        }
+    }
+unlock:
+    pthread_mutex_unlock(&conf->lock);
+
+    for (i = 0; i < nblocks; i++) {
+        if (!res[i].segment)
+            continue;
+
+        if (sys_pwrite(res[i].segment->fd, data + i * bs, res[i].length,
+                       res[i].offset) != res[i].length) {
+            gf_msg(this->name, GF_LOG_WARNING, errno, DKC_MSG_WRITE_FAILED,
+                   "failed to write to segment %" PRIu64 " of %s",
+                   res[i].segment->id, conf->cache_dir);
+            res[i].length = 0;
+        }
+    }
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        file = NULL;
+        if (gen == *dkc_gen(conf, buf->ia_gfid))
+            file = __dkc_file_get(conf, buf->ia_gfid);
+
+        for (i = 0; file && (i < nblocks); i++) {
+            segment = res[i].segment;
+            if (!segment || !res[i].length || segment->dead)
+                continue;
+
+            block = __dkc_block_add(conf, file, segment, res[i].number,
+                                    res[i].offset, res[i].length,
+                                    res[i].checksum);
+            if (!block)
+                continue;
+
+            if (!file->saved || !dkc_attr_same(&file->attr, buf)) {
+                file->attr = *buf;
+                __dkc_index_file(this, conf, file);
+            }
+            __dkc_index_block(this, conf, block);
+            stored++;
+        }
+
+        if (file) {
+            if (file->block_count) {
+                file->attr = *buf;
+                file->validated = time(NULL);
+            } else {
+                __dkc_file_del(conf, file);
+            }
+        }
+
+        for (i = 0; i < nblocks; i++) {
+            if (res[i].segment)
+                __dkc_segment_unref(conf, res[i].segment);
+        }
+
+        __dkc_prune(this, conf);
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    GF_ATOMIC_ADD(conf->stored, stored);
+
+out:
+    GF_FREE(flat);
+    GF_FREE(res);
+}
+
+static void
+dkc_store_req_free(dkc_store_req_t *req)
+{
+    if (req->iobref)
+        iobref_unref(req->iobref);
+    GF_FREE(req->vector);
+    GF_FREE(req);
+}
+
+/* Queues the data read for the store thread, see dkc_store_req_run(). */
+void
+dkc_store_write(xlator_t *this, uint64_t gen, struct iatt *buf, off_t offset,
+                struct iovec *vector, int32_t count, size_t size,
+                gf_boolean_t eof, struct iobref *iobref)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_store_req_t *req = NULL;
+
+    if (!conf->enabled || (size < conf->block_size && !eof) ||
+        (buf->ia_type != IA_IFREG))
+        return;
+
+    req = GF_CALLOC(1, sizeof(*req), gf_dkc_mt_dkc_store_req_t);
+    if (!req)
+        return;
+
+    req->vector = iov_dup(vector, count);
+    if (!req->vector) {
+        GF_FREE(req);
+        return;
+    }
+
+    req->gen = gen;
+    req->buf = *buf;
+    req->offset = offset;
+    req->count = count;
+    req->size = size;
+    req->eof = eof;
+    if (iobref)
+        req->iobref = iobref_ref(iobref);
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        if (conf->store_queued + size <= DKC_STORE_QUEUE_MAX) {
+            list_add_tail(&req->list, &conf->store_queue);
+            conf->store_queued += size;
+            pthread_cond_signal(&conf->cond);
+            req = NULL;
+        }
+    }
+    pthread_mutex_unlock(&conf->lock);
+
+    if (req) {
+        GF_ATOMIC_INC(conf->dropped);
+        dkc_store_req_free(req);
+    }
+}
+
+/* Stores the data queued and writes the index, until the store is closed.
+ * The queue is emptied before exiting. */
+static void *
+dkc_store_worker(void *data)
+{
+    xlator_t *this = data;
+    dkc_conf_t *conf = this->private;
+    dkc_store_req_t *req = NULL;
+    struct timespec timeout = {
+        0,
+    };
+    gf_boolean_t stop = _gf_false;
+
+    THIS = this;
+
+    while (!stop) {
+        pthread_mutex_lock(&conf->lock);
+        {
+            if (list_empty(&conf->store_queue) && !conf->store_stop &&
+                !conf->compact && (conf->pending_count < DKC_INDEX_BATCH / 2)) {
+                clock_gettime(CLOCK_REALTIME, &timeout);
+                timeout.tv_sec += DKC_INDEX_FLUSH_INTERVAL;
+                pthread_cond_timedwait(&conf->cond, &conf->lock, &timeout);
+            }
+
+            req = NULL;
+            if (!list_empty(&conf->store_queue)) {
+                req = list_first_entry(&conf->store_queue, dkc_store_req_t,
+                                       list);
+                list_del_init(&req->list);
+                conf->store_queued -= req->size;
+            }
+            stop = conf->store_stop && !req;
+        }
+        pthread_mutex_unlock(&conf->lock);
+
+        if (req) {
+            dkc_store_req_run(this, req);
+            dkc_store_req_free(req);
+        }
+
+        dkc_index_sync(this, conf);
+    }
+
+    return NULL;
+}
+
+void
+dkc_store_prune(xlator_t *this)
+{
+    dkc_conf_t *conf = this->private;
+
+    if (!conf->enabled)
+        return;
+
+    pthread_mutex_lock(&conf->lock);
+    {
+        dkc_segment_size_set(conf);
+        __dkc_prune(this, conf);
+    }
+    pthread_mutex_unlock(&conf->lock);
+}
+
+void
+dkc_store_dump(xlator_t *this)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_segment_t *segment = NULL;
+    uint64_t segments = 0;
+
+    gf_proc_dump_write("cache_dir", "%s", conf->cache_dir);
+    gf_proc_dump_write("enabled", "%s", conf->enabled ? "yes" : "no");
+    gf_proc_dump_write("cache_size", "%" PRIu64, conf->cache_size);
+    gf_proc_dump_write("block_size", "%" PRIu64, conf->block_size);
+    gf_proc_dump_write("cache_timeout", "%u", conf->cache_timeout);
+
+    if (pthread_mutex_trylock(&conf->lock) == 0) {
+        list_for_each_entry(segment, &conf->segments, list)
+        {
+            segments++;
+        }
+
+        gf_proc_dump_write("used", "%" PRIu64, conf->used);
+        gf_proc_dump_write("files", "%" PRIu64, conf->file_count);
+        gf_proc_dump_write("blocks", "%" PRIu64, conf->block_count);
+        gf_proc_dump_write("segments", "%" PRIu64, segments);
+        gf_proc_dump_write("index_records", "%" PRIu64, conf->index_records);
+        gf_proc_dump_write("pending_records", "%u", conf->pending_count);
+        gf_proc_dump_write("queued_bytes", "%" PRIu64, conf->store_queued);
+        pthread_mutex_unlock(&conf->lock);
+    }
+
+    gf_proc_dump_write("hits", "%" PRId64, GF_ATOMIC_GET(conf->hits));
+    gf_proc_dump_write("misses", "%" PRId64, GF_ATOMIC_GET(conf->misses));
+    gf_proc_dump_write("stored_blocks", "%" PRId64,
+                       GF_ATOMIC_GET(conf->stored));
+    gf_proc_dump_write("evicted_segments", "%" PRId64,
+                       GF_ATOMIC_GET(conf->evicted));
+    gf_proc_dump_write("invalidations", "%" PRId64,
+                       GF_ATOMIC_GET(conf->invalidations));
+    gf_proc_dump_write("dropped_stores", "%" PRId64,
+                       GF_ATOMIC_GET(conf->dropped));
+}
@@ -0,0 +1,703 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+/* Caches the data read from regular files on a local directory, usually on
+ * an SSD, so that it survives the restart of the client. See
+ * disk-cache-store.c for the layout of the store. */
+
+#include "disk-cache.h"
+#include <glusterfs/statedump.h>
+#include <glusterfs/upcall-utils.h>
+
+#define DKC_STACK_UNWIND(fop, frame, params...)                                \
+    do {                                                                       \
+        dkc_local_t *__local = NULL;                                           \
+        if (frame) {                                                           \
+            __local = frame->local;                                            \
+            frame->local = NULL;                                               \
+        }                                                                      \
+        STACK_UNWIND_STRICT(fop, frame, params);                               \
+        GF_FREE(__local);                                                      \
+    } while (0)
+
+static void
+dkc_validate(xlator_t *this, int32_t op_ret, struct iatt *buf)
+{
+    if ((op_ret >= 0) && buf)
+        dkc_store_validate(this, buf);
+}
+
+static void
+dkc_inode_invalidate(xlator_t *this, inode_t *inode)
+{
+    if (inode && !gf_uuid_is_null(inode->gfid))
+        dkc_store_invalidate(this, inode->gfid);
+}
+
+static int32_t
+dkc_lookup_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, inode_t *inode,
+               struct iatt *buf, dict_t *xdata, struct iatt *postparent)
+{
+    dkc_validate(this, op_ret, buf);
+
+    STACK_UNWIND_STRICT(lookup, frame, op_ret, op_errno, inode, buf, xdata,
+                        postparent);
+    return 0;
+}
+
+static int32_t
+dkc_lookup(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    STACK_WIND(frame, dkc_lookup_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->lookup, loc, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_stat_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
+             int32_t op_errno, struct iatt *buf, dict_t *xdata)
+{
+    dkc_validate(this, op_ret, buf);
+
+    STACK_UNWIND_STRICT(stat, frame, op_ret, op_errno, buf, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_stat(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata)
+{
+    STACK_WIND(frame, dkc_stat_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->stat, loc, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_fstat_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iatt *buf,
+              dict_t *xdata)
+{
+    dkc_validate(this, op_ret, buf);
+
+    STACK_UNWIND_STRICT(fstat, frame, op_ret, op_errno, buf, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_fstat(call_frame_t *frame, xlator_t *this, fd_t *fd, dict_t *xdata)
+{
+    STACK_WIND(frame, dkc_fstat_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->fstat, fd, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_readv_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+              int32_t op_ret, int32_t op_errno, struct iovec *vector,
+              int32_t count, struct iatt *stbuf, struct iobref *iobref,
+              dict_t *xdata)
+{
+    dkc_local_t *local = frame->local;
+    struct iovec subvec[count > 0 ? count : 1];
+    struct iovec *dst = subvec;
+    uint32_t start = 0;
+    uint32_t size = 0;
+
+    if (op_ret < 0)
+        goto unwind;
+
+    if (stbuf)
+        dkc_store_write(this, local->gen, stbuf, local->aligned_offset,
+                        vector, count, op_ret, op_ret < local->aligned_size,
+                        iobref);
+
+    /* return only the range the application asked for */
+    start = local->offset - local->aligned_offset;
+    if (op_ret > start)
+        size = min(op_ret - start, local->size);
+
+    count = iov_subset(vector, count, start, size, &dst, count);
+    if (count < 0) {
+        op_ret = -1;
+        op_errno = ENOMEM;
+        goto unwind;
+    }
+
+    op_ret = size;
+    vector = subvec;
+
+unwind:
+    DKC_STACK_UNWIND(readv, frame, op_ret, op_errno, vector, count, stbuf,
+                     iobref, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
+          off_t offset, uint32_t flags, dict_t *xdata)
+{
+    dkc_conf_t *conf = this->private;
+    dkc_local_t *local = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec vector = {
+        0,
+    };
+    struct iatt stbuf = {
+        0,
+    };
+    uint64_t bs = conf->block_size;
+
+    if (!conf->enabled || !size || (fd->inode->ia_type != IA_IFREG) ||
+        (fd->flags & O_DIRECT))
+        goto wind;
+
+    if (dkc_store_read(this, fd->inode->gfid, offset, size, &vector, &iobref,
+                       &stbuf) == 0) {
+        GF_ATOMIC_INC(conf->hits);
+        STACK_UNWIND_STRICT(readv, frame, vector.iov_len, 0, &vector, 1,
+                            &stbuf, iobref, NULL);
+        iobref_unref(iobref);
+        return 0;
+    }
+
+    GF_ATOMIC_INC(conf->misses);
+
+    local = GF_CALLOC(1, sizeof(*local), gf_dkc_mt_dkc_local_t);
+    if (!local)
+        goto wind;
+
+    /* read whole blocks so that they can be stored */
+    local->offset = offset;
+    local->size = size;
+    local->aligned_offset = offset - (offset % bs);
+    local->aligned_size = gf_roof(offset + size, bs) - local->aligned_offset;
+    local->gen = dkc_store_gen(this, fd->inode->gfid);
+    frame->local = local;
+
+    STACK_WIND(frame, dkc_readv_cbk, FIRST_CHILD(this),
+               FIRST_CHILD(this)->fops->readv, fd, local->aligned_size,
+               local->aligned_offset, flags, xdata);
+    return 0;
+
+wind:
+    STACK_WIND_TAIL(frame, FIRST_CHILD(this), FIRST_CHILD(this)->fops->readv,
+                    fd, size, offset, flags, xdata);
+    return 0;
+}
+
+/* The fops modifying the data of a file drop its blocks when they are sent
+ * and again when they complete, so that no read in between stores the old
+ * data. The inode is passed as the cookie. */
+
+static int32_t
+dkc_writev_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+               struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(writev, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
+           struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
+           struct iobref *iobref, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_writev_cbk, fd->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->writev, fd, vector, count,
+                      offset, flags, iobref, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_truncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(truncate, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_truncate(call_frame_t *frame, xlator_t *this, loc_t *loc, off_t offset,
+             dict_t *xdata)
+{
+    dkc_inode_invalidate(this, loc->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_truncate_cbk, loc->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->truncate, loc, offset, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_ftruncate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(ftruncate, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_ftruncate(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+              dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_ftruncate_cbk, fd->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->ftruncate, fd, offset, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_fallocate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                  int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                  struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(fallocate, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd, int32_t mode,
+              off_t offset, size_t len, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_fallocate_cbk, fd->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->fallocate, fd, mode, offset,
+                      len, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_discard_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(discard, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_discard(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+            size_t len, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_discard_cbk, fd->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->discard, fd, offset, len,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+dkc_zerofill_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                 int32_t op_ret, int32_t op_errno, struct iatt *prebuf,
+                 struct iatt *postbuf, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(zerofill, frame, op_ret, op_errno, prebuf, postbuf,
+                        xdata);
+    return 0;
+}
+
+static int32_t
+dkc_zerofill(call_frame_t *frame, xlator_t *this, fd_t *fd, off_t offset,
+             off_t len, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_zerofill_cbk, fd->inode, FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->zerofill, fd, offset, len,
+                      xdata);
+    return 0;
+}
+
+static int32_t
+dkc_copy_file_range_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, struct iatt *stbuf,
+                        struct iatt *prebuf_dst, struct iatt *postbuf_dst,
+                        dict_t *xdata)
+{
+    dkc_inode_invalidate(this, cookie);
+
+    STACK_UNWIND_STRICT(copy_file_range, frame, op_ret, op_errno, stbuf,
+                        prebuf_dst, postbuf_dst, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_copy_file_range(call_frame_t *frame, xlator_t *this, fd_t *fd_in,
+                    off64_t off_in, fd_t *fd_out, off64_t off_out, size_t len,
+                    uint32_t flags, dict_t *xdata)
+{
+    dkc_inode_invalidate(this, fd_out->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_copy_file_range_cbk, fd_out->inode,
+                      FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->copy_file_range, fd_in, off_in,
+                      fd_out, off_out, len, flags, xdata);
+    return 0;
+}
+
+/* An open or a create of an existing file with O_TRUNC empties it. The
+ * cookie tells the callback whether it did. */
+
+static int32_t
+dkc_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+             int32_t op_ret, int32_t op_errno, fd_t *fd, dict_t *xdata)
+{
+    if (cookie && fd)
+        dkc_inode_invalidate(this, fd->inode);
+
+    STACK_UNWIND_STRICT(open, frame, op_ret, op_errno, fd, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_open(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+         fd_t *fd, dict_t *xdata)
+{
+    if (flags & O_TRUNC)
+        dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_open_cbk,
+                      (void *)(uintptr_t)(flags & O_TRUNC), FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->open, loc, flags, fd, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+               int32_t op_ret, int32_t op_errno, fd_t *fd, inode_t *inode,
+               struct iatt *buf, struct iatt *preparent,
+               struct iatt *postparent, dict_t *xdata)
+{
+    if (cookie)
+        dkc_inode_invalidate(this, inode);
+
+    STACK_UNWIND_STRICT(create, frame, op_ret, op_errno, fd, inode, buf,
+                        preparent, postparent, xdata);
+    return 0;
+}
+
+static int32_t
+dkc_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
+           mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
+{
+    /* the gfid is only known here if the inode was already linked */
+    if (flags & O_TRUNC)
+        dkc_inode_invalidate(this, fd->inode);
+
+    STACK_WIND_COOKIE(frame, dkc_create_cbk,
+                      (void *)(uintptr_t)(flags & O_TRUNC), FIRST_CHILD(this),
+                      FIRST_CHILD(this)->fops->create, loc, flags, mode, umask,
+                      fd, xdata);
+    return 0;
+}
+
+static void
+dkc_invalidate(xlator_t *this, void *data)
+{
+    struct gf_upcall *up_data = data;
+    struct gf_upcall_cache_invalidation *up_ci = NULL;
+
+    if (up_data->event_type != GF_UPCALL_CACHE_INVALIDATION)
+        return;
+
+    up_ci = (struct gf_upcall_cache_invalidation *)up_data->data;
+    if (up_ci->flags & (UP_WRITE_FLAGS | UP_INVAL_ATTR))
+        dkc_store_invalidate(this, up_data->gfid);
+}
+
+int
+dkc_notify(xlator_t *this, int event, void *data, ...)
+{
+    if ((event == GF_EVENT_UPCALL) && this->private)
+        dkc_invalidate(this, data);
+
+    return default_notify(this, event, data);
+}
+
+static int32_t
+dkc_priv_dump(xlator_t *this)
+{
+    char key_prefix[GF_DUMP_MAX_BUF_LEN];
+
+    snprintf(key_prefix, GF_DUMP_MAX_BUF_LEN, "%s.%s", this->type, this->name);
+    gf_proc_dump_add_section("%s", key_prefix);
+
+    dkc_store_dump(this);
+
+    return 0;
+}
+
+int32_t
+dkc_mem_acct_init(xlator_t *this)
+{
+    int ret = -1;
+
+    ret = xlator_mem_acct_init(this, gf_dkc_mt_end + 1);
+    return ret;
+}
+
+int32_t
+dkc_reconfigure(xlator_t *this, dict_t *options)
+{
+    dkc_conf_t *conf = NULL;
+
+    conf = this->private;
+
+    GF_OPTION_RECONF("cache-size", conf->cache_size, options, size_uint64,
+                     out);
+    GF_OPTION_RECONF("cache-timeout", conf->cache_timeout, options, time,
+                     out);
+    GF_OPTION_RECONF("pass-through", this->pass_through, options, bool, out);
+
+    dkc_store_prune(this);
+
+out:
+    return 0;
+}
+
+void
+dkc_fini(xlator_t *this)
+{
+    dkc_conf_t *conf = NULL;
+
+    conf = this->private;
+    if (!conf)
+        return;
+
+    dkc_store_close(this);
+
+    pthread_cond_destroy(&conf->cond);
+    pthread_mutex_destroy(&conf->lock);
+    GF_FREE(conf->files);
+    GF_FREE(conf->blocks);
+    GF_FREE(conf->gens);
+    GF_FREE(conf->pending);
+    GF_FREE(conf->flushing);
+    GF_FREE(conf->cache_dir);
+    GF_FREE(conf);
+    this->private = NULL;
+
+    return;
+}
+
+int32_t
+dkc_init(xlator_t *this)
+{
+    dkc_conf_t *conf = NULL;
+    char *cache_dir = NULL;
+    int ret = -1;
+    int i = 0;
+
+    if (!this->children || this->children->next) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, DKC_MSG_STORE_OPEN_FAILED,
+               "FATAL: disk-cache not configured with exactly one child");
+        return -1;
+    }
+
+    conf = GF_CALLOC(1, sizeof(*conf), gf_dkc_mt_dkc_conf_t);
+    if (!conf)
+        goto out;
+
+    GF_OPTION_INIT("cache-dir", cache_dir, path, out);
+    GF_OPTION_INIT("cache-size", conf->cache_size, size_uint64, out);
+    GF_OPTION_INIT("block-size", conf->block_size, size_uint64, out);
+    GF_OPTION_INIT("cache-timeout", conf->cache_timeout, time, out);
+    GF_OPTION_INIT("pass-through", this->pass_through, bool, out);
+
+    /* each volume has its own store under the directory */
+    if (gf_asprintf(&conf->cache_dir, "%s/%s", cache_dir, this->name) < 0) {
+        conf->cache_dir = NULL;
+        goto out;
+    }
+
+    conf->files = GF_CALLOC(DKC_HASH_BUCKETS, sizeof(*conf->files),
+                            gf_dkc_mt_list_head);
+    conf->blocks = GF_CALLOC(DKC_HASH_BUCKETS, sizeof(*conf->blocks),
+                             gf_dkc_mt_list_head);
+    conf->gens = GF_CALLOC(DKC_GEN_BUCKETS, sizeof(*conf->gens),
+                           gf_dkc_mt_uint64_t);
+    conf->pending = GF_CALLOC(DKC_INDEX_BATCH, sizeof(*conf->pending),
+                              gf_dkc_mt_dkc_record_t);
+    conf->flushing = GF_CALLOC(DKC_INDEX_BATCH, sizeof(*conf->flushing),
+                               gf_dkc_mt_dkc_record_t);
+    if (!conf->files || !conf->blocks || !conf->gens || !conf->pending ||
+        !conf->flushing)
+        goto out;
+
+    for (i = 0; i < DKC_HASH_BUCKETS; i++) {
+        INIT_LIST_HEAD(&conf->files[i]);
+        INIT_LIST_HEAD(&conf->blocks[i]);
+    }
+
+    INIT_LIST_HEAD(&conf->segments);
+    INIT_LIST_HEAD(&conf->store_queue);
+    pthread_mutex_init(&conf->lock, NULL);
+    pthread_cond_init(&conf->cond, NULL);
+    conf->index_fd = -1;
+    conf->lock_fd = -1;
+    GF_ATOMIC_INIT(conf->hits, 0);
+    GF_ATOMIC_INIT(conf->misses, 0);
+    GF_ATOMIC_INIT(conf->stored, 0);
+    GF_ATOMIC_INIT(conf->evicted, 0);
+    GF_ATOMIC_INIT(conf->invalidations, 0);
+    GF_ATOMIC_INIT(conf->dropped, 0);
+
+    this->private = conf;
+
+    /* the volume is still usable without the cache */
+    conf->enabled = (dkc_store_open(this) == 0);
+    if (!conf->enabled)
+        gf_msg(this->name, GF_LOG_WARNING, 0, DKC_MSG_STORE_OPEN_FAILED,
+               "the disk cache in %s is disabled", conf->cache_dir);
+
+    ret = 0;
+out:
+    if (ret < 0 && conf) {
+        GF_FREE(conf->files);
+        GF_FREE(conf->blocks);
+        GF_FREE(conf->gens);
+        GF_FREE(conf->pending);
+        GF_FREE(conf->flushing);
+        GF_FREE(conf->cache_dir);
+        GF_FREE(conf);
+        this->private = NULL;
+    }
+
+    return ret;
+}
+
+struct xlator_fops dkc_fops = {
+    .lookup = dkc_lookup,
+    .stat = dkc_stat,
+    .fstat = dkc_fstat,
+    .readv = dkc_readv,
+    .writev = dkc_writev,
+    .truncate = dkc_truncate,
+    .ftruncate = dkc_ftruncate,
+    .fallocate = dkc_fallocate,
+    .discard = dkc_discard,
+    .zerofill = dkc_zerofill,
+    .copy_file_range = dkc_copy_file_range,
+    .open = dkc_open,
+    .create = dkc_create,
+};
+
+struct xlator_cbks dkc_cbks;
+
+struct xlator_dumpops dkc_dumpops = {
+    .priv = dkc_priv_dump,
+};
+
+struct volume_options dkc_options[] = {
+    {
+        .key = {"disk-cache"},
+        .type = GF_OPTION_TYPE_BOOL,
+        .default_value = "off",
+        .description = "enable/disable disk-cache",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE,
+    },
+    {
+        .key = {"cache-dir"},
+        .type = GF_OPTION_TYPE_PATH,
+        .default_value = "/var/cache/glusterfs",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"disk-cache"},
+        .description = "Local directory, preferably on an SSD, where the "
+                       "data read from the volume is kept. Each volume "
+                       "uses a sub-directory of it, which can only be used "
+                       "by one client process at a time.",
+    },
+    {
+        .key = {"cache-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 64 * GF_UNIT_MB,
+        .default_value = "10GB",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"disk-cache"},
+        .description = "Space used by the cache in the local directory. "
+                       "The oldest data is evicted first.",
+    },
+    {
+        .key = {"block-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 64 * GF_UNIT_KB,
+        .max = 4 * GF_UNIT_MB,
+        .default_value = "128KB",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"disk-cache"},
+        .description = "Unit in which the data is cached. Changing it "
+                       "drops the cached data on the next mount.",
+    },
+    {
+        .key = {"cache-timeout"},
+        .type = GF_OPTION_TYPE_TIME,
+        .min = 1,
+        .max = 60,
+        .default_value = "1",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_CLIENT_OPT | OPT_FLAG_DOC,
+        .tags = {"disk-cache"},
+        .description = "Time during which the cached data of a file is "
+                       "used after its size and times were last checked "
+                       "on the volume.",
+    },
+    {.key = {"pass-through"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "false",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+     .tags = {"disk-cache"},
+     .description = "Enable/Disable disk cache translator"},
+
+    {.key = {NULL}},
+};
+
+xlator_api_t xlator_api = {
+    .init = dkc_init,
+    .fini = dkc_fini,
+    .notify = dkc_notify,
+    .reconfigure = dkc_reconfigure,
+    .mem_acct_init = dkc_mem_acct_init,
+    .op_version = {GD_OP_VERSION_9_0},
+    .dumpops = &dkc_dumpops,
+    .fops = &dkc_fops,
+    .cbks = &dkc_cbks,
+    .options = dkc_options,
+    .identifier = "disk-cache",
+    .category = GF_TECH_PREVIEW,
+};
@@ -0,0 +1,195 @@
+/*
+  Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+  This file is part of GlusterFS.
+
+  This file is licensed to you under your choice of the GNU Lesser
+  General Public License, version 3 or any later version (LGPLv3 or
+  later), or the GNU General Public License, version 2 (GPLv2), in all
+  cases as published by the Free Software Foundation.
+*/
+
+#ifndef __DISK_CACHE_H__
+#define __DISK_CACHE_H__
+
+#include "disk-cache-mem-types.h"
+#include "disk-cache-messages.h"
+#include <glusterfs/glusterfs.h>
+#include <glusterfs/xlator.h>
+#include <glusterfs/defaults.h>
+#include <glusterfs/atomic.h>
+#include <glusterfs/iobuf.h>
+
+#define DKC_HASH_BUCKETS 65536
+
+/* generations of the files, a collision only prevents a read from being
+ * stored */
+#define DKC_GEN_BUCKETS 4096
+
+/* reads waiting to be stored, beyond that they are not cached */
+#define DKC_STORE_QUEUE_MAX (64 * GF_UNIT_MB)
+
+/* index records are written by the store thread in batches, at least once
+ * in this many seconds */
+#define DKC_INDEX_BATCH 1024
+#define DKC_INDEX_FLUSH_INTERVAL 1
+
+/* the cache is split in this many segments, within the limits below */
+#define DKC_SEGMENT_COUNT 64
+#define DKC_SEGMENT_MIN_SIZE (16 * GF_UNIT_MB)
+#define DKC_SEGMENT_MAX_SIZE (1 * GF_UNIT_GB)
+
+#define DKC_INDEX_NAME "index"
+#define DKC_LOCK_NAME "lock"
+#define DKC_SEGMENT_FMT "segment.%" PRIu64
+
+#define DKC_RECORD_MAGIC 0x444b4331 /* DKC1 */
+
+enum dkc_record_type {
+    DKC_RECORD_FILE = 1, /* attributes of the cached version of a file */
+    DKC_RECORD_BLOCK,    /* a block of a file was stored */
+    DKC_RECORD_INVALIDATE,
+    DKC_RECORD_DROP, /* a segment was evicted */
+};
+
+/* entry of the index, appended for each change of the store */
+typedef struct dkc_record {
+    uint32_t magic;
+    uint32_t type;
+    unsigned char gfid[16];
+    uint64_t number;   /* BLOCK: block number, FILE: size */
+    uint64_t segment;  /* BLOCK, DROP */
+    uint64_t offset;   /* BLOCK: offset in the segment, FILE: mtime */
+    uint64_t ctime;    /* FILE */
+    uint32_t nsec[2];  /* FILE: of mtime and ctime */
+    uint32_t length;   /* BLOCK */
+    uint32_t checksum; /* BLOCK: of the data */
+    uint32_t block_size;
+    uint32_t crc; /* of the record, must be the last field */
+} dkc_record_t;
+
+typedef struct dkc_segment {
+    struct list_head list; /* conf->segments, oldest first */
+    struct list_head blocks;
+    uint64_t id;
+    uint64_t size; /* space used, including the blocks being written */
+    int fd;
+    int32_t refcount;
+    gf_boolean_t dead;
+} dkc_segment_t;
+
+typedef struct dkc_file {
+    struct list_head hash;
+    struct list_head blocks;
+    uuid_t gfid;
+    struct iatt attr;  /* of the cached version */
+    time_t validated;  /* when attr was last seen on the volume */
+    gf_boolean_t saved; /* attr is in the index */
+    uint32_t block_count;
+} dkc_file_t;
+
+typedef struct dkc_block {
+    struct list_head hash;
+    struct list_head file_list;
+    struct list_head segment_list;
+    dkc_file_t *file;
+    dkc_segment_t *segment;
+    uint64_t number;
+    uint64_t offset; /* in the segment */
+    uint32_t length;
+    uint32_t checksum;
+} dkc_block_t;
+
+/* data read from the volume, to be stored by the store thread */
+typedef struct dkc_store_req {
+    struct list_head list;
+    uint64_t gen;
+    struct iatt buf;
+    off_t offset;
+    struct iovec *vector;
+    int32_t count;
+    size_t size;
+    gf_boolean_t eof;
+    struct iobref *iobref;
+} dkc_store_req_t;
+
+typedef struct dkc_conf {
+    char *cache_dir; /* store of this volume */
+    uint64_t cache_size;
+    uint64_t block_size;
+    uint32_t cache_timeout;
+    gf_boolean_t enabled; /* the store could be opened */
+
+    pthread_mutex_t lock;
+    pthread_cond_t cond; /* wakes up the store thread */
+    pthread_t store_thread;
+    gf_boolean_t store_running;
+    gf_boolean_t store_stop;
+    struct list_head store_queue;
+    uint64_t store_queued; /* bytes */
+    int index_fd; /* only written by the store thread once it runs */
+    int lock_fd;
+    uint64_t index_records;
+    gf_boolean_t index_error;
+    dkc_record_t *pending; /* records not written to the index yet */
+    dkc_record_t *flushing;
+    uint32_t pending_count;
+    gf_boolean_t compact; /* the index must be rewritten */
+    struct list_head *files;
+    struct list_head *blocks;
+    struct list_head segments;
+    dkc_segment_t *current; /* segment blocks are appended to */
+    uint64_t segment_size;
+    uint64_t next_segment;
+    uint64_t used; /* bytes in the segments */
+    uint64_t block_count;
+    uint64_t file_count;
+    uint64_t *gens; /* changed by each invalidation of a file */
+
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+    gf_atomic_t stored;
+    gf_atomic_t evicted;
+    gf_atomic_t invalidations;
+    gf_atomic_t dropped; /* reads not stored as the queue was full */
+} dkc_conf_t;
+
+typedef struct dkc_local {
+    off_t offset; /* requested by the application */
+    size_t size;
+    off_t aligned_offset;
+    size_t aligned_size;
+    uint64_t gen;
+} dkc_local_t;
+
+int
+dkc_store_open(xlator_t *this);
+
+void
+dkc_store_close(xlator_t *this);
+
+void
+dkc_store_validate(xlator_t *this, struct iatt *buf);
+
+void
+dkc_store_invalidate(xlator_t *this, uuid_t gfid);
+
+uint64_t
+dkc_store_gen(xlator_t *this, uuid_t gfid);
+
+int
+dkc_store_read(xlator_t *this, uuid_t gfid, off_t offset, size_t size,
+               struct iovec *vector, struct iobref **iobref,
+               struct iatt *stbuf);
+
+void
+dkc_store_write(xlator_t *this, uint64_t gen, struct iatt *buf, off_t offset,
+                struct iovec *vector, int32_t count, size_t size,
+                gf_boolean_t eof, struct iobref *iobref);
+
+void
+dkc_store_prune(xlator_t *this);
+
+void
+dkc_store_dump(xlator_t *this);
+
+#endif /* __DISK_CACHE_H__ */
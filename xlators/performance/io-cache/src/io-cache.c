@@ -116,7 +116,8 @@ ioc_update_pages(call_frame_t *frame, ioc_inode_t *ioc_inode,
                                count, write_offset, page_end - page_offset);
             } else if (trav) {
                 if (!trav->waitq)
-                    ioc_inode->table->cache_used -= __ioc_page_destroy(trav);
+                    GF_ATOMIC_SUB(ioc_inode->table->cache_used,
+                                  __ioc_page_destroy(trav));
             }
 
             if (trav_offset == rounded_offset)
@@ -188,13 +189,8 @@ ioc_inode_flush(ioc_inode_t *ioc_inode)
     }
     ioc_inode_unlock(ioc_inode);
 
-    if (destroy_size) {
-        ioc_table_lock(ioc_inode->table);
-        {
-            ioc_inode->table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(ioc_inode->table);
-    }
+    if (destroy_size)
+        GF_ATOMIC_SUB(ioc_inode->table->cache_used, destroy_size);
 
     return;
 }
@@ -272,12 +268,7 @@ ioc_inode_update(xlator_t *this, inode_t *inode, char *path, struct iatt *iabuf)
         ioc_inode_flush(ioc_inode);
     }
 
-    ioc_table_lock(ioc_inode->table);
-    {
-        list_move_tail(&ioc_inode->inode_lru,
-                       &table->inode_lru[ioc_inode->weight]);
-    }
-    ioc_table_unlock(ioc_inode->table);
+    ioc_inode_lru_move(ioc_inode);
 
 out:
     return 0;
@@ -444,13 +435,8 @@ ioc_cache_validate_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
         local_stbuf = NULL;
     }
 
-    if (destroy_size) {
-        ioc_table_lock(ioc_inode->table);
-        {
-            ioc_inode->table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(ioc_inode->table);
-    }
+    if (destroy_size)
+        GF_ATOMIC_SUB(ioc_inode->table->cache_used, destroy_size);
 
     if (op_ret < 0)
         local_stbuf = NULL;
@@ -633,12 +619,7 @@ ioc_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
             goto out;
         }
 
-        ioc_table_lock(ioc_inode->table);
-        {
-            list_move_tail(&ioc_inode->inode_lru,
-                           &table->inode_lru[ioc_inode->weight]);
-        }
-        ioc_table_unlock(ioc_inode->table);
+        ioc_inode_lru_move(ioc_inode);
 
         ioc_inode_lock(ioc_inode);
         {
@@ -940,15 +921,7 @@ ioc_release(xlator_t *this, fd_t *fd)
 int32_t
 ioc_need_prune(ioc_table_t *table)
 {
-    int64_t cache_difference = 0;
-
-    ioc_table_lock(table);
-    {
-        cache_difference = table->cache_used - table->cache_size;
-    }
-    ioc_table_unlock(table);
-
-    if (cache_difference > 0)
+    if (GF_ATOMIC_GET(table->cache_used) > (int64_t)table->cache_size)
         return 1;
     else
         return 0;
@@ -1026,6 +999,8 @@ ioc_dispatch_requests(call_frame_t *frame, ioc_inode_t *ioc_inode, fd_t *fd,
                 }
             }
 
+            __ioc_page_referenced(trav, local_offset, trav_size, fault);
+
             __ioc_wait_on_page(trav, frame, local_offset, trav_size);
 
             if (trav->ready) {
@@ -1125,7 +1100,6 @@ ioc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     uint64_t tmp_ioc_inode = 0;
     ioc_inode_t *ioc_inode = NULL;
     ioc_local_t *local = NULL;
-    uint32_t weight = 0;
     ioc_table_t *table = NULL;
     int32_t op_errno = EINVAL;
 
@@ -1207,14 +1181,7 @@ ioc_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
                  "= %" PRId64 " && size = %" GF_PRI_SIZET "",
                  frame, offset, size);
 
-    weight = ioc_inode->weight;
-
-    ioc_table_lock(ioc_inode->table);
-    {
-        list_move_tail(&ioc_inode->inode_lru,
-                       &ioc_inode->table->inode_lru[weight]);
-    }
-    ioc_table_unlock(ioc_inode->table);
+    ioc_inode_lru_move(ioc_inode);
 
     ioc_dispatch_requests(frame, ioc_inode, fd, offset, size);
     return 0;
@@ -1682,6 +1649,15 @@ out:
     return ret;
 }
 
+static ioc_policy_t
+ioc_policy_from_str(const char *policy)
+{
+    if (strcmp(policy, "arc") == 0)
+        return IOC_POLICY_ARC;
+
+    return IOC_POLICY_LRU;
+}
+
 int
 reconfigure(xlator_t *this, dict_t *options)
 {
@@ -1689,6 +1665,7 @@ reconfigure(xlator_t *this, dict_t *options)
     ioc_table_t *table = NULL;
     int ret = -1;
     uint64_t cache_size_new = 0;
+    char *policy = NULL;
     if (!this || !this->private)
         goto out;
 
@@ -1702,6 +1679,10 @@ reconfigure(xlator_t *this, dict_t *options)
         GF_OPTION_RECONF("cache-timeout", table->cache_timeout, options, int32,
                          unlock);
 
+        GF_OPTION_RECONF("cache-replacement-policy", policy, options, str,
+                         unlock);
+        table->policy = ioc_policy_from_str(policy);
+
         data = dict_get(options, "priority");
         if (data) {
             char *option_list = data_to_str(data);
@@ -1763,11 +1744,11 @@ init(xlator_t *this)
 {
     ioc_table_t *table = NULL;
     dict_t *xl_options = NULL;
-    uint32_t index = 0;
     int32_t ret = -1;
     glusterfs_ctx_t *ctx = NULL;
     data_t *data = 0;
     uint32_t num_pages = 0;
+    char *policy = NULL;
 
     xl_options = this->options;
 
@@ -1800,6 +1781,9 @@ init(xlator_t *this)
 
     GF_OPTION_INIT("cache-timeout", table->cache_timeout, int32, out);
 
+    GF_OPTION_INIT("cache-replacement-policy", policy, str, out);
+    table->policy = ioc_policy_from_str(policy);
+
     GF_OPTION_INIT("min-file-size", table->min_file_size, size_uint64, out);
 
     GF_OPTION_INIT("max-file-size", table->max_file_size, size_uint64, out);
@@ -1837,15 +1821,11 @@ init(xlator_t *this)
         goto out;
     }
 
-    table->inode_lru = GF_CALLOC(table->max_pri, sizeof(struct list_head),
-                                 gf_ioc_mt_list_head);
-    if (table->inode_lru == NULL) {
+    GF_ATOMIC_INIT(table->cache_used, 0);
+    if (ioc_shards_init(table) != 0) {
         goto out;
     }
 
-    for (index = 0; index < (table->max_pri); index++)
-        INIT_LIST_HEAD(&table->inode_lru[index]);
-
     this->local_pool = mem_pool_new(ioc_local_t, 64);
     if (!this->local_pool) {
         ret = -1;
@@ -1875,7 +1855,7 @@ init(xlator_t *this)
 out:
     if (ret == -1) {
         if (table != NULL) {
-            GF_FREE(table->inode_lru);
+            ioc_shards_fini(table);
             GF_FREE(table);
         }
     }
@@ -2091,11 +2071,13 @@ ioc_priv_dump(xlator_t *this)
     {
         gf_proc_dump_write("page_size", "%" PRIu64, priv->page_size);
         gf_proc_dump_write("cache_size", "%" PRIu64, priv->cache_size);
-        gf_proc_dump_write("cache_used", "%" PRIu64, priv->cache_used);
+        gf_proc_dump_write("cache_used", "%" PRId64,
+                           GF_ATOMIC_GET(priv->cache_used));
         gf_proc_dump_write("inode_count", "%u", priv->inode_count);
         gf_proc_dump_write("cache_timeout", "%u", priv->cache_timeout);
         gf_proc_dump_write("min-file-size", "%" PRIu64, priv->min_file_size);
         gf_proc_dump_write("max-file-size", "%" PRIu64, priv->max_file_size);
+        ioc_shards_dump(priv);
     }
     pthread_mutex_unlock(&priv->table_lock);
 out:
@@ -2158,6 +2140,7 @@ fini(xlator_t *this)
 
     GF_ASSERT (list_empty (&table->inodes));
     */
+    ioc_shards_fini(table);
     pthread_mutex_destroy(&table->table_lock);
     GF_FREE(table);
 
@@ -2229,6 +2212,18 @@ struct volume_options options[] = {
      .description = "Size of the read cache.",
      .op_version = {1},
      .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"cache-replacement-policy"},
+     .type = GF_OPTION_TYPE_STR,
+     .value = {"lru", "arc"},
+     .default_value = "lru",
+     .description = "Policy used to evict pages when the cache is full. "
+                    "'lru' evicts the pages of the least recently read "
+                    "files of the lowest priority. 'arc' balances the "
+                    "pages read once and the ones read again, so that "
+                    "large sequential reads don't flush the pages which "
+                    "are read repeatedly.",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_CLIENT_OPT | OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"min-file-size"},
      .type = GF_OPTION_TYPE_SIZET,
      .default_value = "0",
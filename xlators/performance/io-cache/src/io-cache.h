@@ -25,12 +25,32 @@
 #define IOC_PAGE_SIZE (1024 * 128) /* 128KB */
 #define IOC_CACHE_SIZE (32 * 1024 * 1024)
 #define IOC_PAGE_TABLE_BUCKET_COUNT 1
+#define IOC_TABLE_SHARDS 8
+#define IOC_GHOST_BUCKETS 256
 
 struct ioc_table;
 struct ioc_local;
 struct ioc_page;
 struct ioc_inode;
 
+typedef enum {
+    IOC_POLICY_LRU,
+    IOC_POLICY_ARC,
+} ioc_policy_t;
+
+/*
+ * lists of the adaptive replacement policy: pages read once (T1) and more
+ * than once (T2), and the pages recently evicted from them (B1 and B2).
+ */
+typedef enum {
+    IOC_ARC_T1,
+    IOC_ARC_T2,
+    IOC_ARC_B1,
+    IOC_ARC_B2,
+    IOC_ARC_LISTS,
+    IOC_ARC_NONE = IOC_ARC_LISTS,
+} ioc_arc_list_t;
+
 struct ioc_priority {
     struct list_head list;
     char *pattern;
@@ -112,6 +132,42 @@ struct ioc_page {
     pthread_mutex_t page_lock;
     int32_t op_errno;
     char stale;
+    struct ioc_shard *shard;
+    struct list_head arc_list;
+    ioc_arc_list_t arc_state; /* protected by the inode and shard locks */
+    off_t ref_end;            /* end of the last read from this page */
+};
+
+/*
+ * ioc_ghost - key of a page evicted by the adaptive replacement policy
+ */
+struct ioc_ghost {
+    struct list_head hash;
+    struct list_head list;
+    uuid_t gfid;
+    off_t offset;
+    ioc_arc_list_t arc_state;
+};
+
+/*
+ * ioc_shard - part of the lists of the table, so that readers of different
+ *             files don't serialize on the table lock. inodes are assigned
+ *             to a shard by address and pages by gfid and offset.
+ *
+ * @lock: protects inode_lru
+ * @arc_lock: protects the lists of the adaptive replacement policy
+ */
+struct ioc_shard {
+    pthread_mutex_t lock;
+    struct list_head *inode_lru;
+    pthread_mutex_t arc_lock;
+    struct list_head arc[IOC_ARC_LISTS];
+    uint64_t arc_count[IOC_ARC_LISTS];
+    uint64_t arc_target; /* wanted number of pages in T1 */
+    struct list_head *ghosts;
+    gf_atomic_t hits;
+    gf_atomic_t misses;
+    gf_atomic_t ghost_hits[2]; /* in B1 and B2 */
 };
 
 struct ioc_cache {
@@ -144,17 +200,20 @@ struct ioc_inode {
                       * on each read
                       */
     inode_t *inode;
+    struct ioc_shard *shard;
 };
 
 struct ioc_table {
     uint64_t page_size;
     uint64_t cache_size;
-    uint64_t cache_used;
+    gf_atomic_t cache_used;
     uint64_t min_file_size;
     uint64_t max_file_size;
     struct list_head inodes; /* list of inodes cached */
     struct list_head active;
-    struct list_head *inode_lru;
+    struct ioc_shard shards[IOC_TABLE_SHARDS];
+    gf_atomic_t prune_shard;
+    ioc_policy_t policy;
     struct list_head priority_list;
     int32_t readv_count;
     pthread_mutex_t table_lock;
@@ -171,6 +230,8 @@ typedef struct ioc_page ioc_page_t;
 typedef struct ioc_inode ioc_inode_t;
 typedef struct ioc_waitq ioc_waitq_t;
 typedef struct ioc_fill ioc_fill_t;
+typedef struct ioc_ghost ioc_ghost_t;
+typedef struct ioc_shard ioc_shard_t;
 
 void *
 str_to_ptr(char *string);
@@ -242,6 +303,10 @@ ioc_frame_fill(ioc_page_t *page, call_frame_t *frame, off_t offset, size_t size,
         pthread_mutex_unlock(&table->table_lock);                              \
     } while (0)
 
+#define ioc_shard_lock(shard) pthread_mutex_lock(&(shard)->lock)
+
+#define ioc_shard_unlock(shard) pthread_mutex_unlock(&(shard)->lock)
+
 #define ioc_local_lock(local)                                                  \
     do {                                                                       \
         gf_msg_trace(local->inode->table->xl->name, 0, "locked local(%p)",     \
@@ -316,4 +381,20 @@ ioc_prune(ioc_table_t *table);
 int32_t
 ioc_need_prune(ioc_table_t *table);
 
+int32_t
+ioc_shards_init(ioc_table_t *table);
+
+void
+ioc_shards_fini(ioc_table_t *table);
+
+void
+ioc_inode_lru_move(ioc_inode_t *ioc_inode);
+
+void
+__ioc_page_referenced(ioc_page_t *page, off_t offset, size_t size,
+                      gf_boolean_t created);
+
+void
+ioc_shards_dump(ioc_table_t *table);
+
 #endif /* __IO_CACHE_H */
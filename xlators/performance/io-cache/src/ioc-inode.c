@@ -180,21 +180,48 @@ ioc_inode_create(ioc_table_t *table, inode_t *inode, uint32_t weight)
     INIT_LIST_HEAD(&ioc_inode->cache.page_lru);
     pthread_mutex_init(&ioc_inode->inode_lock, NULL);
     ioc_inode->weight = weight;
+    ioc_inode->shard = &table->shards[((uintptr_t)inode >> 6) %
+                                      IOC_TABLE_SHARDS];
 
     ioc_table_lock(table);
     {
         table->inode_count++;
         list_add(&ioc_inode->inode_list, &table->inodes);
-        list_add_tail(&ioc_inode->inode_lru, &table->inode_lru[weight]);
     }
     ioc_table_unlock(table);
 
+    ioc_shard_lock(ioc_inode->shard);
+    {
+        list_add_tail(&ioc_inode->inode_lru,
+                      &ioc_inode->shard->inode_lru[weight]);
+    }
+    ioc_shard_unlock(ioc_inode->shard);
+
     gf_msg_trace(table->xl->name, 0, "adding to inode_lru[%d]", weight);
 
 out:
     return ioc_inode;
 }
 
+/*
+ * ioc_inode_lru_move - move an inode to the end of the lru list of its
+ *                      priority, in its shard.
+ *
+ * @ioc_inode: inode which was accessed
+ */
+void
+ioc_inode_lru_move(ioc_inode_t *ioc_inode)
+{
+    ioc_shard_t *shard = ioc_inode->shard;
+
+    ioc_shard_lock(shard);
+    {
+        list_move_tail(&ioc_inode->inode_lru,
+                       &shard->inode_lru[ioc_inode->weight]);
+    }
+    ioc_shard_unlock(shard);
+}
+
 /*
  * ioc_inode_destroy - destroy an ioc_inode_t object.
  *
@@ -215,10 +242,15 @@ ioc_inode_destroy(ioc_inode_t *ioc_inode)
     {
         table->inode_count--;
         list_del(&ioc_inode->inode_list);
-        list_del(&ioc_inode->inode_lru);
     }
     ioc_table_unlock(table);
 
+    ioc_shard_lock(ioc_inode->shard);
+    {
+        list_del(&ioc_inode->inode_lru);
+    }
+    ioc_shard_unlock(ioc_inode->shard);
+
     ioc_inode_flush(ioc_inode);
     rbthash_table_destroy(ioc_inode->cache.page_table);
 
@@ -24,6 +24,7 @@ enum gf_ioc_mem_types_ {
     gf_ioc_mt_ioc_inode_t,
     gf_ioc_mt_ioc_fill_t,
     gf_ioc_mt_ioc_newpage_t,
+    gf_ioc_mt_ioc_ghost_t,
     gf_ioc_mt_end
 };
 #endif
@@ -16,7 +16,12 @@
 #include "ioc-mem-types.h"
 #include <assert.h>
 #include <sys/time.h>
+#include <glusterfs/statedump.h>
 #include "io-cache-messages.h"
+
+#define ioc_ghost_bucket(shard, hashval)                                       \
+    (&(shard)->ghosts[((hashval) / IOC_TABLE_SHARDS) % IOC_GHOST_BUCKETS])
+
 char
 ioc_empty(struct ioc_cache *cache)
 {
@@ -56,6 +61,388 @@ out:
     return page;
 }
 
+static uint32_t
+ioc_page_hash(ioc_table_t *table, uuid_t gfid, off_t offset)
+{
+    uint32_t hashval = 0;
+
+    memcpy(&hashval, &gfid[12], sizeof(hashval));
+
+    return hashval ^ (uint32_t)(offset / table->page_size);
+}
+
+/* number of pages the lists of a shard are sized for */
+static uint64_t
+ioc_shard_pages(ioc_table_t *table)
+{
+    uint64_t pages = table->cache_size / table->page_size / IOC_TABLE_SHARDS;
+
+    return pages ? pages : 1;
+}
+
+int32_t
+ioc_shards_init(ioc_table_t *table)
+{
+    ioc_shard_t *shard = NULL;
+    int32_t i = 0;
+    int32_t j = 0;
+
+    GF_ATOMIC_INIT(table->prune_shard, 0);
+
+    for (i = 0; i < IOC_TABLE_SHARDS; i++) {
+        shard = &table->shards[i];
+
+        pthread_mutex_init(&shard->lock, NULL);
+        pthread_mutex_init(&shard->arc_lock, NULL);
+        for (j = 0; j < IOC_ARC_LISTS; j++)
+            INIT_LIST_HEAD(&shard->arc[j]);
+        GF_ATOMIC_INIT(shard->hits, 0);
+        GF_ATOMIC_INIT(shard->misses, 0);
+        GF_ATOMIC_INIT(shard->ghost_hits[0], 0);
+        GF_ATOMIC_INIT(shard->ghost_hits[1], 0);
+
+        shard->inode_lru = GF_CALLOC(table->max_pri, sizeof(struct list_head),
+                                     gf_ioc_mt_list_head);
+        shard->ghosts = GF_CALLOC(IOC_GHOST_BUCKETS, sizeof(struct list_head),
+                                  gf_ioc_mt_list_head);
+        if (!shard->inode_lru || !shard->ghosts)
+            return -1;
+
+        for (j = 0; j < table->max_pri; j++)
+            INIT_LIST_HEAD(&shard->inode_lru[j]);
+        for (j = 0; j < IOC_GHOST_BUCKETS; j++)
+            INIT_LIST_HEAD(&shard->ghosts[j]);
+    }
+
+    return 0;
+}
+
+static void
+__ioc_ghost_del(ioc_shard_t *shard, ioc_ghost_t *ghost)
+{
+    list_del(&ghost->hash);
+    list_del(&ghost->list);
+    shard->arc_count[ghost->arc_state]--;
+    GF_FREE(ghost);
+}
+
+void
+ioc_shards_fini(ioc_table_t *table)
+{
+    ioc_shard_t *shard = NULL;
+    ioc_ghost_t *ghost = NULL;
+    ioc_ghost_t *tmp = NULL;
+    int32_t i = 0;
+
+    for (i = 0; i < IOC_TABLE_SHARDS; i++) {
+        shard = &table->shards[i];
+
+        if (shard->ghosts) {
+            list_for_each_entry_safe(ghost, tmp, &shard->arc[IOC_ARC_B1],
+                                     list)
+            {
+                __ioc_ghost_del(shard, ghost);
+            }
+            list_for_each_entry_safe(ghost, tmp, &shard->arc[IOC_ARC_B2],
+                                     list)
+            {
+                __ioc_ghost_del(shard, ghost);
+            }
+        }
+
+        GF_FREE(shard->ghosts);
+        GF_FREE(shard->inode_lru);
+        shard->ghosts = NULL;
+        shard->inode_lru = NULL;
+        pthread_mutex_destroy(&shard->arc_lock);
+        pthread_mutex_destroy(&shard->lock);
+    }
+}
+
+static ioc_ghost_t *
+__ioc_ghost_find(ioc_shard_t *shard, uuid_t gfid, off_t offset,
+                 uint32_t hashval)
+{
+    ioc_ghost_t *ghost = NULL;
+
+    list_for_each_entry(ghost, ioc_ghost_bucket(shard, hashval), hash)
+    {
+        if ((ghost->offset == offset) && !gf_uuid_compare(ghost->gfid, gfid))
+            return ghost;
+    }
+
+    return NULL;
+}
+
+/*
+ * __ioc_ghost_add - remember a page evicted from T1 (B1) or T2 (B2).
+ *
+ * the oldest ghosts are dropped so that T1 and B1 hold at most the pages of
+ * the shard, and all the lists at most twice that.
+ */
+static void
+__ioc_ghost_add(ioc_table_t *table, ioc_shard_t *shard, uuid_t gfid,
+                off_t offset, uint32_t hashval, ioc_arc_list_t from)
+{
+    uint64_t *count = shard->arc_count;
+    uint64_t pages = ioc_shard_pages(table);
+    ioc_ghost_t *ghost = NULL;
+    ioc_arc_list_t to = (from == IOC_ARC_T1) ? IOC_ARC_B1 : IOC_ARC_B2;
+    ioc_arc_list_t trim = IOC_ARC_NONE;
+
+    for (;;) {
+        if (count[IOC_ARC_B1] &&
+            (count[IOC_ARC_T1] + count[IOC_ARC_B1] >= pages))
+            trim = IOC_ARC_B1;
+        else if (count[IOC_ARC_T1] + count[IOC_ARC_T2] + count[IOC_ARC_B1] +
+                     count[IOC_ARC_B2] <
+                 2 * pages)
+            break;
+        else if (count[IOC_ARC_B2])
+            trim = IOC_ARC_B2;
+        else if (count[IOC_ARC_B1])
+            trim = IOC_ARC_B1;
+        else
+            return;
+
+        ghost = list_first_entry(&shard->arc[trim], ioc_ghost_t, list);
+        __ioc_ghost_del(shard, ghost);
+    }
+
+    ghost = GF_CALLOC(1, sizeof(*ghost), gf_ioc_mt_ioc_ghost_t);
+    if (ghost == NULL)
+        return;
+
+    gf_uuid_copy(ghost->gfid, gfid);
+    ghost->offset = offset;
+    ghost->arc_state = to;
+    list_add_tail(&ghost->list, &shard->arc[to]);
+    list_add_tail(&ghost->hash, ioc_ghost_bucket(shard, hashval));
+    count[to]++;
+}
+
+static void
+__ioc_arc_move(ioc_shard_t *shard, ioc_page_t *page, ioc_arc_list_t to)
+{
+    if (page->arc_state != IOC_ARC_NONE)
+        shard->arc_count[page->arc_state]--;
+
+    list_move_tail(&page->arc_list, &shard->arc[to]);
+    shard->arc_count[to]++;
+    page->arc_state = to;
+}
+
+static void
+__ioc_arc_unlink(ioc_shard_t *shard, ioc_page_t *page)
+{
+    list_del_init(&page->arc_list);
+    shard->arc_count[page->arc_state]--;
+    page->arc_state = IOC_ARC_NONE;
+}
+
+/*
+ * ioc_arc_insert - add a new page to T1, or to T2 if it was evicted
+ *                  recently. a page found in B1 means T1 was too small, and
+ *                  the target size of T1 grows; it shrinks for B2.
+ */
+static void
+ioc_arc_insert(ioc_table_t *table, ioc_page_t *page, uuid_t gfid,
+               uint32_t hashval)
+{
+    ioc_shard_t *shard = page->shard;
+    ioc_ghost_t *ghost = NULL;
+    ioc_arc_list_t to = IOC_ARC_T1;
+    uint64_t b1 = 0;
+    uint64_t b2 = 0;
+
+    pthread_mutex_lock(&shard->arc_lock);
+    {
+        if (table->policy == IOC_POLICY_ARC)
+            ghost = __ioc_ghost_find(shard, gfid, page->offset, hashval);
+
+        if (ghost) {
+            b1 = shard->arc_count[IOC_ARC_B1];
+            b2 = shard->arc_count[IOC_ARC_B2];
+            if (ghost->arc_state == IOC_ARC_B1) {
+                shard->arc_target += max(b2 / b1, 1);
+                shard->arc_target = min(shard->arc_target,
+                                        ioc_shard_pages(table));
+            } else {
+                shard->arc_target -= min(shard->arc_target, max(b1 / b2, 1));
+            }
+
+            GF_ATOMIC_INC(shard->ghost_hits[ghost->arc_state - IOC_ARC_B1]);
+            __ioc_ghost_del(shard, ghost);
+            to = IOC_ARC_T2;
+        }
+
+        __ioc_arc_move(shard, page, to);
+    }
+    pthread_mutex_unlock(&shard->arc_lock);
+}
+
+/*
+ * __ioc_page_referenced - account a read of [offset, offset + size) from a
+ *                         page.
+ *
+ * with the adaptive policy a page read again moves to T2. reads going
+ * forward through a page, as sequential scans do, leave it in T1, so that
+ * a scan only evicts pages read once. to be called with the inode locked.
+ */
+void
+__ioc_page_referenced(ioc_page_t *page, off_t offset, size_t size,
+                      gf_boolean_t created)
+{
+    ioc_shard_t *shard = page->shard;
+
+    if (created) {
+        GF_ATOMIC_INC(shard->misses);
+    } else {
+        GF_ATOMIC_INC(shard->hits);
+
+        if ((page->inode->table->policy == IOC_POLICY_ARC) &&
+            (page->arc_state != IOC_ARC_NONE) &&
+            ((page->arc_state == IOC_ARC_T2) || (offset < page->ref_end))) {
+            pthread_mutex_lock(&shard->arc_lock);
+            {
+                __ioc_arc_move(shard, page, IOC_ARC_T2);
+            }
+            pthread_mutex_unlock(&shard->arc_lock);
+        }
+    }
+
+    if (offset + size > page->ref_end)
+        page->ref_end = offset + size;
+}
+
+/*
+ * ioc_arc_evict - evict a page of the shard which is neither being filled
+ *                 nor waited on, from T1 if it's over its target size.
+ *
+ * inodes are locked after the shard here, so they are only tried.
+ *
+ * returns the size freed, or -1 if no page could be evicted.
+ */
+static int64_t
+ioc_arc_evict(ioc_table_t *table, ioc_shard_t *shard)
+{
+    ioc_page_t *page = NULL;
+    ioc_inode_t *ioc_inode = NULL;
+    ioc_arc_list_t from = IOC_ARC_T2;
+    uint64_t *count = shard->arc_count;
+    int64_t ret = -1;
+    uint32_t hashval = 0;
+    off_t offset = 0;
+    uuid_t gfid;
+    int32_t i = 0;
+
+    pthread_mutex_lock(&shard->arc_lock);
+    {
+        if (count[IOC_ARC_T1] &&
+            ((count[IOC_ARC_T1] > shard->arc_target) || !count[IOC_ARC_T2]))
+            from = IOC_ARC_T1;
+
+        for (i = 0; (i < 2) && (ret == -1); i++) {
+            list_for_each_entry(page, &shard->arc[from], arc_list)
+            {
+                ioc_inode = page->inode;
+                if (pthread_mutex_trylock(&ioc_inode->inode_lock))
+                    continue;
+
+                if (page->ready && !page->waitq) {
+                    gf_uuid_copy(gfid, ioc_inode->inode->gfid);
+                    offset = page->offset;
+                    __ioc_arc_unlink(shard, page);
+                    ret = __ioc_page_destroy(page);
+                }
+
+                pthread_mutex_unlock(&ioc_inode->inode_lock);
+
+                if (ret != -1)
+                    break;
+            }
+
+            if (ret == -1)
+                from = (from == IOC_ARC_T1) ? IOC_ARC_T2 : IOC_ARC_T1;
+        }
+
+        if (ret != -1) {
+            hashval = ioc_page_hash(table, gfid, offset);
+            __ioc_ghost_add(table, shard, gfid, offset, hashval, from);
+        }
+    }
+    pthread_mutex_unlock(&shard->arc_lock);
+
+    return ret;
+}
+
+static void
+ioc_arc_prune(ioc_table_t *table)
+{
+    uint32_t index = 0;
+    int32_t idle = 0;
+    int64_t size = 0;
+
+    while ((idle < IOC_TABLE_SHARDS) &&
+           (GF_ATOMIC_GET(table->cache_used) > (int64_t)table->cache_size)) {
+        index = GF_ATOMIC_INC(table->prune_shard) % IOC_TABLE_SHARDS;
+        size = ioc_arc_evict(table, &table->shards[index]);
+        if (size == -1) {
+            idle++;
+            continue;
+        }
+
+        idle = 0;
+        GF_ATOMIC_SUB(table->cache_used, size);
+    }
+}
+
+void
+ioc_shards_dump(ioc_table_t *table)
+{
+    ioc_shard_t *shard = NULL;
+    uint64_t count[IOC_ARC_LISTS] = {
+        0,
+    };
+    uint64_t target = 0;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t ghost_hits[2] = {
+        0,
+    };
+    int32_t i = 0;
+    int32_t j = 0;
+
+    for (i = 0; i < IOC_TABLE_SHARDS; i++) {
+        shard = &table->shards[i];
+
+        hits += GF_ATOMIC_GET(shard->hits);
+        misses += GF_ATOMIC_GET(shard->misses);
+        ghost_hits[0] += GF_ATOMIC_GET(shard->ghost_hits[0]);
+        ghost_hits[1] += GF_ATOMIC_GET(shard->ghost_hits[1]);
+
+        pthread_mutex_lock(&shard->arc_lock);
+        {
+            for (j = 0; j < IOC_ARC_LISTS; j++)
+                count[j] += shard->arc_count[j];
+            target += shard->arc_target;
+        }
+        pthread_mutex_unlock(&shard->arc_lock);
+    }
+
+    gf_proc_dump_write("replacement_policy", "%s",
+                       (table->policy == IOC_POLICY_ARC) ? "arc" : "lru");
+    gf_proc_dump_write("hits", "%" PRIu64, hits);
+    gf_proc_dump_write("misses", "%" PRIu64, misses);
+    gf_proc_dump_write("ghost_hits_recent", "%" PRIu64, ghost_hits[0]);
+    gf_proc_dump_write("ghost_hits_frequent", "%" PRIu64, ghost_hits[1]);
+    gf_proc_dump_write("recent_pages", "%" PRIu64, count[IOC_ARC_T1]);
+    gf_proc_dump_write("frequent_pages", "%" PRIu64, count[IOC_ARC_T2]);
+    gf_proc_dump_write("recent_ghosts", "%" PRIu64, count[IOC_ARC_B1]);
+    gf_proc_dump_write("frequent_ghosts", "%" PRIu64, count[IOC_ARC_B2]);
+    gf_proc_dump_write("recent_target", "%" PRIu64, target);
+}
+
 ioc_page_t *
 ioc_page_get(ioc_inode_t *ioc_inode, off_t offset)
 {
@@ -100,6 +487,14 @@ __ioc_page_destroy(ioc_page_t *page)
                        sizeof(page->offset));
         list_del(&page->page_lru);
 
+        if (page->arc_state != IOC_ARC_NONE) {
+            pthread_mutex_lock(&page->shard->arc_lock);
+            {
+                __ioc_arc_unlink(page->shard, page);
+            }
+            pthread_mutex_unlock(&page->shard->arc_lock);
+        }
+
         gf_msg_trace(page->inode->table->xl->name, 0,
                      "destroying page = %p, offset = %" PRId64
                      " "
@@ -165,14 +560,15 @@ __ioc_inode_prune(ioc_inode_t *curr, uint64_t *size_pruned,
         ret = __ioc_page_destroy(page);
 
         if (ret != -1)
-            table->cache_used -= ret;
+            GF_ATOMIC_SUB(table->cache_used, ret);
 
         gf_msg_trace(table->xl->name, 0,
                      "index = %d && "
-                     "table->cache_used = %" PRIu64
+                     "table->cache_used = %" PRId64
                      " && table->"
                      "cache_size = %" PRIu64,
-                     index, table->cache_used, table->cache_size);
+                     index, GF_ATOMIC_GET(table->cache_used),
+                     table->cache_size);
 
         if ((*size_pruned) >= size_to_prune)
             break;
@@ -189,6 +585,9 @@ out:
  * ioc_prune - prune the cache. we have a limit to the number of pages we
  *             can have in-memory.
  *
+ * with the lru policy, the least recently used inodes of the lowest
+ * priority are pruned first, going through the shards in turn.
+ *
  * @table: ioc_table_t of this translator
  *
  */
@@ -196,38 +595,57 @@ int32_t
 ioc_prune(ioc_table_t *table)
 {
     ioc_inode_t *curr = NULL, *next_ioc_inode = NULL;
+    ioc_shard_t *shard = NULL;
     int32_t index = 0;
+    uint32_t first = 0;
+    uint32_t i = 0;
+    int64_t cache_used = 0;
     uint64_t size_to_prune = 0;
     uint64_t size_pruned = 0;
 
     GF_VALIDATE_OR_GOTO("io-cache", table, out);
 
-    ioc_table_lock(table);
-    {
-        size_to_prune = table->cache_used - table->cache_size;
-        /* take out the least recently used inode */
-        for (index = 0; index < table->max_pri; index++) {
-            list_for_each_entry_safe(curr, next_ioc_inode,
-                                     &table->inode_lru[index], inode_lru)
+    if (table->policy == IOC_POLICY_ARC) {
+        ioc_arc_prune(table);
+        goto out;
+    }
+
+    cache_used = GF_ATOMIC_GET(table->cache_used);
+    if (cache_used <= (int64_t)table->cache_size)
+        goto out;
+
+    size_to_prune = cache_used - table->cache_size;
+    first = GF_ATOMIC_INC(table->prune_shard);
+
+    /* take out the least recently used inode */
+    for (index = 0; index < table->max_pri; index++) {
+        for (i = 0; i < IOC_TABLE_SHARDS; i++) {
+            shard = &table->shards[(first + i) % IOC_TABLE_SHARDS];
+
+            ioc_shard_lock(shard);
             {
-                /* prune page-by-page for this inode, till
-                 * we reach the equilibrium */
-                ioc_inode_lock(curr);
+                list_for_each_entry_safe(curr, next_ioc_inode,
+                                         &shard->inode_lru[index], inode_lru)
                 {
-                    __ioc_inode_prune(curr, &size_pruned, size_to_prune, index);
-                }
-                ioc_inode_unlock(curr);
+                    /* prune page-by-page for this inode, till
+                     * we reach the equilibrium */
+                    ioc_inode_lock(curr);
+                    {
+                        __ioc_inode_prune(curr, &size_pruned, size_to_prune,
+                                          index);
+                    }
+                    ioc_inode_unlock(curr);
 
-                if (size_pruned >= size_to_prune)
-                    break;
-            } /* list_for_each_entry_safe (curr...) */
+                    if (size_pruned >= size_to_prune)
+                        break;
+                } /* list_for_each_entry_safe (curr...) */
+            }
+            ioc_shard_unlock(shard);
 
             if (size_pruned >= size_to_prune)
-                break;
-        } /* for(index=0;...) */
-
-    } /* ioc_inode_table locked region end */
-    ioc_table_unlock(table);
+                goto out;
+        }
+    } /* for(index=0;...) */
 
 out:
     return 0;
@@ -247,6 +665,7 @@ __ioc_page_create(ioc_inode_t *ioc_inode, off_t offset)
     ioc_page_t *page = NULL;
     off_t rounded_offset = 0;
     ioc_page_t *newpage = NULL;
+    uint32_t hashval = 0;
 
     GF_VALIDATE_OR_GOTO("io-cache", ioc_inode, out);
 
@@ -269,12 +688,19 @@ __ioc_page_create(ioc_inode_t *ioc_inode, off_t offset)
     newpage->offset = rounded_offset;
     newpage->inode = ioc_inode;
     pthread_mutex_init(&newpage->page_lock, NULL);
+    INIT_LIST_HEAD(&newpage->arc_list);
+    newpage->arc_state = IOC_ARC_NONE;
+
+    hashval = ioc_page_hash(table, ioc_inode->inode->gfid, rounded_offset);
+    newpage->shard = &table->shards[hashval % IOC_TABLE_SHARDS];
 
     rbthash_insert(ioc_inode->cache.page_table, newpage, &rounded_offset,
                    sizeof(rounded_offset));
 
     list_add_tail(&newpage->page_lru, &ioc_inode->cache.page_lru);
 
+    ioc_arc_insert(table, newpage, ioc_inode->inode->gfid, hashval);
+
     page = newpage;
 
     gf_msg_trace("io-cache", 0, "returning new page %p", page);
@@ -522,21 +948,11 @@ unlock:
 
     ioc_waitq_return(waitq);
 
-    if (iobref_page_size) {
-        ioc_table_lock(table);
-        {
-            table->cache_used += iobref_page_size;
-        }
-        ioc_table_unlock(table);
-    }
+    if (iobref_page_size)
+        GF_ATOMIC_ADD(table->cache_used, iobref_page_size);
 
-    if (destroy_size) {
-        ioc_table_lock(table);
-        {
-            table->cache_used -= destroy_size;
-        }
-        ioc_table_unlock(table);
-    }
+    if (destroy_size)
+        GF_ATOMIC_SUB(table->cache_used, destroy_size);
 
     if (ioc_need_prune(ioc_inode->table)) {
         ioc_prune(ioc_inode->table);
@@ -999,7 +1415,7 @@ __ioc_page_error(ioc_page_t *page, int32_t op_ret, int32_t op_errno)
     ret = __ioc_page_destroy(page);
 
     if (ret != -1) {
-        table->cache_used -= ret;
+        GF_ATOMIC_SUB(table->cache_used, ret);
     }
 
 out:
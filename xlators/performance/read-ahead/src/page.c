@@ -135,6 +135,7 @@ ra_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     fd_t *fd = NULL;
     uint64_t tmp_file = 0;
     gf_boolean_t stale = _gf_false;
+    uint64_t latency = 0;
 
     GF_ASSERT(frame);
 
@@ -157,8 +158,14 @@ ra_fault_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
 
     ra_file_lock(file);
     {
-        if (op_ret >= 0)
+        if (op_ret >= 0) {
             file->stbuf = *stbuf;
+            /* used to size the window of the streams */
+            latency = ra_now_usec() - local->start;
+            if (file->latency)
+                latency = (file->latency * 7 + latency) / 8;
+            file->latency = latency;
+        }
 
         page = ra_page_get(file, pending_offset);
 
@@ -272,6 +279,7 @@ ra_page_fault(ra_file_t *file, call_frame_t *frame, off_t offset)
     fault_frame->local = fault_local;
     fault_local->pending_offset = offset;
     fault_local->pending_size = file->page_size;
+    fault_local->start = ra_now_usec();
 
     fault_local->fd = fd_ref(file->fd);
 
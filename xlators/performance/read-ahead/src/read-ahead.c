@@ -26,7 +26,7 @@
 #include "read-ahead-messages.h"
 
 static void
-read_ahead(call_frame_t *frame, ra_file_t *file);
+read_ahead(call_frame_t *frame, ra_file_t *file, ra_stream_t *stream);
 
 int
 ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
@@ -57,7 +57,6 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
     file->conf = conf;
     file->pages.next = &file->pages;
     file->pages.prev = &file->pages;
@@ -74,14 +73,9 @@ ra_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
-    if (!file->disabled) {
-        file->page_count = 1;
-    }
-
     ret = fd_ctx_set(fd, this, (uint64_t)(long)file);
     if (ret == -1) {
         gf_msg(frame->this->name, GF_LOG_WARNING, 0, READ_AHEAD_MSG_NO_MEMORY,
@@ -131,7 +125,6 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     if ((fd->flags & O_DIRECT) || ((fd->flags & O_ACCMODE) == O_WRONLY))
         file->disabled = 1;
 
-    file->offset = (unsigned long long)0;
     // file->size = fd->inode->buf.ia_size;
     file->conf = conf;
     file->pages.next = &file->pages;
@@ -149,7 +142,6 @@ ra_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this, int32_t op_ret,
     ra_conf_unlock(conf);
 
     file->fd = fd;
-    file->page_count = conf->page_count;
     file->page_size = conf->page_size;
     pthread_mutex_init(&file->file_lock, NULL);
 
@@ -216,6 +208,8 @@ flush_region(call_frame_t *frame, ra_file_t *file, off_t offset, off_t size,
             next = trav->next;
             if (trav->offset >= offset) {
                 if (!trav->waitq) {
+                    if (trav->dirty)
+                        file->stats.wasted++;
                     ra_page_purge(trav);
                 } else {
                     trav->stale = 1;
@@ -250,59 +244,226 @@ out:
     return 0;
 }
 
-void
-read_ahead(call_frame_t *frame, ra_file_t *file)
+/* drops the pages outside of the ranges used by the streams */
+static void
+ra_flush_streams(ra_file_t *file)
 {
-    off_t ra_offset = 0;
-    size_t ra_size = 0;
-    off_t trav_offset = 0;
     ra_page_t *trav = NULL;
-    off_t cap = 0;
-    char fault = 0;
+    ra_page_t *next = NULL;
+    gf_boolean_t used = _gf_false;
+    int i = 0;
 
-    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
-    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
+    ra_file_lock(file);
+    {
+        for (trav = file->pages.next; trav != &file->pages; trav = next) {
+            next = trav->next;
+            if (trav->waitq)
+                continue;
 
-    if (!file->page_count) {
-        goto out;
+            used = _gf_false;
+            for (i = 0; !used && (i < RA_STREAMS); i++)
+                used = (trav->offset >= file->streams[i].start) &&
+                       (trav->offset < file->streams[i].end);
+            if (used)
+                continue;
+
+            if (trav->dirty)
+                file->stats.wasted++;
+            ra_page_purge(trav);
+        }
+    }
+    ra_file_unlock(file);
+}
+
+static void
+ra_streams_reset(ra_file_t *file)
+{
+    ra_file_lock(file);
+    {
+        memset(file->streams, 0, sizeof(file->streams));
     }
+    ra_file_unlock(file);
+}
 
-    ra_size = file->page_size * file->page_count;
-    ra_offset = gf_floor(file->offset, file->page_size);
-    cap = file->size ? file->size : file->offset + ra_size;
+static ra_pattern_t
+ra_pattern(off_t stride, size_t size)
+{
+    if (stride == size)
+        return RA_PATTERN_SEQUENTIAL;
+    if (stride < 0)
+        return RA_PATTERN_REVERSE;
+    if (stride > size)
+        return RA_PATTERN_STRIDED;
+
+    return RA_PATTERN_NONE;
+}
 
-    while (ra_offset < min(file->offset + ra_size, cap)) {
-        ra_file_lock(file);
-        {
-            trav = ra_page_get(file, ra_offset);
+/* a sequential stream is read ahead as soon as it's seen, the other
+ * patterns once the same stride has been seen twice */
+static gf_boolean_t
+ra_stream_ready(ra_stream_t *stream)
+{
+    if (stream->pattern == RA_PATTERN_SEQUENTIAL)
+        return stream->matches >= 1;
+
+    return (stream->pattern != RA_PATTERN_NONE) && (stream->matches >= 2);
+}
+
+static off_t
+ra_stream_next(ra_stream_t *stream)
+{
+    if (stream->pattern == RA_PATTERN_SEQUENTIAL)
+        return stream->offset + stream->size;
+
+    return stream->offset + stream->stride;
+}
+
+static uint32_t
+ra_read_pages(ra_file_t *file, size_t size)
+{
+    return max(gf_roof(size, file->page_size) / file->page_size, 1);
+}
+
+/* Finds the stream a read belongs to and updates its pattern. A read
+ * continuing a stream keeps it, one within the pages of a stream changes
+ * its stride, and any other read starts a new stream in place of the least
+ * recently used one. Called with the file lock held. */
+static ra_stream_t *
+__ra_stream_get(ra_conf_t *conf, ra_file_t *file, off_t offset, size_t size)
+{
+    ra_stream_t *stream = NULL;
+    ra_stream_t *trav = NULL;
+    ra_stream_t *closest = NULL;
+    ra_pattern_t pattern = RA_PATTERN_NONE;
+    off_t max_gap = RA_STRIDE_MAX_PAGES * file->page_size;
+    off_t gap = 0;
+    off_t nearest = 0;
+    uint64_t now = ra_now_usec();
+    uint64_t elapsed = 0;
+    int i = 0;
+
+    for (i = 0; !stream && (i < RA_STREAMS); i++) {
+        trav = &file->streams[i];
+        if (trav->size && trav->matches && (ra_stream_next(trav) == offset))
+            stream = trav;
+    }
+
+    for (i = 0; !stream && (i < RA_STREAMS); i++) {
+        trav = &file->streams[i];
+        if (trav->size && trav->matches && (offset >= trav->start) &&
+            (offset < trav->end))
+            stream = trav;
+    }
+
+    /* the closest stream whose pattern isn't known yet */
+    for (i = 0; i < RA_STREAMS; i++) {
+        trav = &file->streams[i];
+        if (stream || !trav->size || trav->matches)
+            continue;
+
+        gap = (offset > trav->offset) ? offset - trav->offset
+                                      : trav->offset - offset;
+        if ((gap <= max_gap) && (!closest || (gap < nearest))) {
+            nearest = gap;
+            closest = trav;
         }
-        ra_file_unlock(file);
+    }
 
-        if (!trav)
-            break;
+    if (!stream)
+        stream = closest;
+
+    if (stream) {
+        stream->stride = offset - stream->offset;
+        pattern = ra_pattern(stream->stride, stream->size);
+        if (stream->matches && (pattern == stream->pattern) &&
+            (ra_stream_next(stream) == offset)) {
+            stream->matches++;
+        } else {
+            if (ra_stream_ready(stream)) {
+                /* the pages read ahead were not the right ones */
+                stream->window = max(stream->window / 2, 1);
+            }
+            stream->pattern = pattern;
+            stream->matches = (pattern != RA_PATTERN_NONE);
+        }
+
+        elapsed = now - stream->stamp;
+        stream->interval = stream->interval
+                               ? (stream->interval * 7 + elapsed) / 8
+                               : elapsed;
+    } else {
+        stream = &file->streams[0];
+        for (i = 1; i < RA_STREAMS; i++) {
+            if (file->streams[i].used < stream->used)
+                stream = &file->streams[i];
+        }
 
-        ra_offset += file->page_size;
+        memset(stream, 0, sizeof(*stream));
+        stream->window = min(ra_read_pages(file, size), conf->page_count);
+        /* reads from the start of the file are most often sequential */
+        if (offset == 0) {
+            stream->pattern = RA_PATTERN_SEQUENTIAL;
+            stream->stride = size;
+            stream->matches = 1;
+        }
     }
 
-    if (trav) {
-        /* comfortable enough */
-        goto out;
+    if ((stream->matches == 1 && stream->pattern == RA_PATTERN_SEQUENTIAL) ||
+        (stream->matches == 2 && stream->pattern != RA_PATTERN_SEQUENTIAL))
+        file->stats.patterns[stream->pattern]++;
+
+    stream->offset = offset;
+    stream->size = size;
+    stream->used = ++file->reads;
+    stream->stamp = now;
+
+    return stream;
+}
+
+/* Sizes the window of a stream from the way a read found its pages: it
+ * grows while the pages read ahead are used, faster when they arrive too
+ * late, to cover the time taken to fetch a page at the rate of the reads.
+ * Called with the file lock held. */
+static void
+__ra_stream_adapt(ra_conf_t *conf, ra_file_t *file, ra_stream_t *stream,
+                  struct ra_stats *seen)
+{
+    uint64_t pages = ra_read_pages(file, stream->size);
+    uint64_t needed = 0;
+
+    if (seen->late) {
+        needed = (file->latency / max(stream->interval, 1) + 1) * pages;
+        stream->window = max(stream->window * 2, needed);
+    } else if (seen->hits && !seen->misses) {
+        stream->window += pages;
     }
 
-    trav_offset = ra_offset;
+    stream->window = min(stream->window, conf->page_count);
+}
 
-    cap = file->size ? file->size : ra_offset + ra_size;
+static uint32_t
+ra_fetch_range(call_frame_t *frame, ra_file_t *file, off_t offset, off_t end)
+{
+    ra_page_t *trav = NULL;
+    uint32_t pages = 0;
+    char fault = 0;
+
+    for (offset = gf_floor(offset, file->page_size); offset < end;
+         offset += file->page_size) {
+        if (file->size && (offset >= file->size))
+            break;
 
-    while (trav_offset < min(ra_offset + ra_size, cap)) {
         fault = 0;
         ra_file_lock(file);
         {
-            trav = ra_page_get(file, trav_offset);
+            trav = ra_page_get(file, offset);
             if (!trav) {
                 fault = 1;
-                trav = ra_page_create(file, trav_offset);
-                if (trav)
+                trav = ra_page_create(file, offset);
+                if (trav) {
                     trav->dirty = 1;
+                    file->stats.prefetched++;
+                }
             }
         }
         ra_file_unlock(file);
@@ -314,14 +475,67 @@ read_ahead(call_frame_t *frame, ra_file_t *file)
 
         if (fault) {
             gf_msg_trace(frame->this->name, 0, "RA at offset=%" PRId64,
-                         trav_offset);
-            ra_page_fault(file, frame, trav_offset);
+                         offset);
+            ra_page_fault(file, frame, offset);
+        }
+        pages++;
+    }
+
+    return pages;
+}
+
+/* Fetches the pages of the next reads expected from the stream, and keeps
+ * the range they cover in the stream. */
+static void
+read_ahead(call_frame_t *frame, ra_file_t *file, ra_stream_t *stream)
+{
+    ra_stream_t copy;
+    off_t start = 0;
+    off_t end = 0;
+    off_t offset = 0;
+    uint32_t pages = 0;
+    uint32_t fetched = 0;
+
+    GF_VALIDATE_OR_GOTO("read-ahead", frame, out);
+    GF_VALIDATE_OR_GOTO(frame->this->name, file, out);
+
+    ra_file_lock(file);
+    {
+        copy = *stream;
+    }
+    ra_file_unlock(file);
+
+    start = copy.offset;
+    end = copy.offset + copy.size;
+
+    if (!ra_stream_ready(&copy)) {
+        goto out;
+    } else if (copy.pattern == RA_PATTERN_SEQUENTIAL) {
+        end += copy.window * file->page_size;
+        ra_fetch_range(frame, file, copy.offset + copy.size, end);
+    } else {
+        /* the next reads are expected at the same distance */
+        for (offset = copy.offset + copy.stride;
+             (offset >= 0) && (pages < copy.window);
+             offset += copy.stride) {
+            fetched = ra_fetch_range(frame, file, offset, offset + copy.size);
+            if (!fetched)
+                break;
+            pages += fetched;
+            start = min(start, offset);
+            end = max(end, (off_t)(offset + copy.size));
         }
-        trav_offset += file->page_size;
     }
 
 out:
-    return;
+    if (file) {
+        ra_file_lock(file);
+        {
+            stream->start = gf_floor(start, file->page_size);
+            stream->end = gf_roof(end, file->page_size);
+        }
+        ra_file_unlock(file);
+    }
 }
 
 int
@@ -336,7 +550,7 @@ ra_need_atime_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
 }
 
 static void
-dispatch_requests(call_frame_t *frame, ra_file_t *file)
+dispatch_requests(call_frame_t *frame, ra_file_t *file, struct ra_stats *seen)
 {
     ra_local_t *local = NULL;
     ra_conf_t *conf = NULL;
@@ -374,6 +588,12 @@ dispatch_requests(call_frame_t *frame, ra_file_t *file)
                 }
                 fault = 1;
                 need_atime_update = 0;
+                seen->misses++;
+            } else if (trav->dirty) {
+                if (trav->ready)
+                    seen->hits++;
+                else
+                    seen->late++;
             }
             trav->dirty = 0;
 
@@ -444,8 +664,11 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     ra_file_t *file = NULL;
     ra_local_t *local = NULL;
     ra_conf_t *conf = NULL;
+    ra_stream_t *stream = NULL;
+    struct ra_stats seen = {
+        0,
+    };
     int op_errno = EINVAL;
-    char expected_offset = 1;
     uint64_t tmp_file = 0;
 
     GF_ASSERT(frame);
@@ -465,30 +688,6 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
         goto disabled;
     }
 
-    if (file->offset != offset) {
-        gf_msg_trace(this->name, 0,
-                     "unexpected offset (%" PRId64 " != %" PRId64
-                     ") "
-                     "resetting",
-                     file->offset, offset);
-
-        expected_offset = file->expected = file->page_count = 0;
-    } else {
-        gf_msg_trace(this->name, 0,
-                     "expected offset (%" PRId64 ") when page_count=%d", offset,
-                     file->page_count);
-
-        if (file->expected < (file->page_size * conf->page_count)) {
-            file->expected += size;
-            file->page_count = min((file->expected / file->page_size),
-                                   conf->page_count);
-        }
-    }
-
-    if (!expected_offset) {
-        flush_region(frame, file, 0, file->pages.prev->offset + 1, 0);
-    }
-
     local = mem_get0(this->local_pool);
     if (!local) {
         op_errno = ENOMEM;
@@ -507,13 +706,31 @@ ra_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
 
     frame->local = local;
 
-    dispatch_requests(frame, file);
+    ra_file_lock(file);
+    {
+        stream = __ra_stream_get(conf, file, offset, size);
+        gf_msg_trace(this->name, 0,
+                     "stream %d: pattern=%d stride=%" PRId64 " window=%u",
+                     (int)(stream - file->streams), stream->pattern,
+                     stream->stride, stream->window);
+    }
+    ra_file_unlock(file);
+
+    dispatch_requests(frame, file, &seen);
 
-    flush_region(frame, file, 0, gf_floor(offset, file->page_size), 0);
+    ra_file_lock(file);
+    {
+        file->stats.hits += seen.hits;
+        file->stats.late += seen.late;
+        file->stats.misses += seen.misses;
+        if (ra_stream_ready(stream))
+            __ra_stream_adapt(conf, file, stream, &seen);
+    }
+    ra_file_unlock(file);
 
-    read_ahead(frame, file);
+    read_ahead(frame, file, stream);
 
-    file->offset = offset + size;
+    ra_flush_streams(file);
 
     ra_frame_return(frame);
 
@@ -641,8 +858,8 @@ ra_writev(call_frame_t *frame, xlator_t *this, fd_t *fd, struct iovec *vector,
 
             flush_region(frame, file, 0, file->pages.prev->offset + 1, 1);
 
-            /* reset the read-ahead counters too */
-            file->expected = file->page_count = 0;
+            /* reset the read-ahead streams too */
+            ra_streams_reset(file);
         }
     }
     UNLOCK(&inode->lock);
@@ -773,6 +990,17 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
     char key_prefix[GF_DUMP_MAX_BUF_LEN] = {
         0,
     };
+    char key[GF_DUMP_MAX_BUF_LEN] = {
+        0,
+    };
+    static const char *patterns[RA_PATTERN_MAX] = {
+        [RA_PATTERN_NONE] = "none",
+        [RA_PATTERN_SEQUENTIAL] = "sequential",
+        [RA_PATTERN_STRIDED] = "strided",
+        [RA_PATTERN_REVERSE] = "reverse",
+    };
+    ra_stream_t *stream = NULL;
+    struct ra_stats *stats = NULL;
 
     fd_ctx_get(fd, this, &tmp_file);
     file = (ra_file_t *)(long)tmp_file;
@@ -803,11 +1031,36 @@ ra_fdctx_dump(xlator_t *this, fd_t *fd)
 
     gf_proc_dump_write("page-size", "%" PRId64, file->page_size);
 
-    gf_proc_dump_write("page-count", "%u", file->page_count);
+    for (i = 0; i < RA_STREAMS; i++) {
+        stream = &file->streams[i];
+        if (!stream->size)
+            continue;
+
+        snprintf(key, sizeof(key), "stream[%d]", i);
+        gf_proc_dump_write(key,
+                           "pattern=%s offset=%" PRId64 " stride=%" PRId64
+                           " window=%u",
+                           patterns[stream->pattern], stream->offset,
+                           stream->stride, stream->window);
+    }
 
-    gf_proc_dump_write("next-expected-offset-for-sequential-reads", "%" PRId64,
-                       file->offset);
+    stats = &file->stats;
+    gf_proc_dump_write("prefetched-pages", "%" PRIu64, stats->prefetched);
+    gf_proc_dump_write("prefetch-hits", "%" PRIu64, stats->hits);
+    gf_proc_dump_write("prefetch-late", "%" PRIu64, stats->late);
+    gf_proc_dump_write("prefetch-wasted", "%" PRIu64, stats->wasted);
+    gf_proc_dump_write("demand-pages", "%" PRIu64, stats->misses);
+    if (stats->prefetched)
+        gf_proc_dump_write("prefetch-efficiency", "%" PRIu64 "%%",
+                           (stats->hits + stats->late) * 100 /
+                               stats->prefetched);
+    gf_proc_dump_write("page-fetch-latency-usec", "%" PRIu64, file->latency);
+    for (i = RA_PATTERN_SEQUENTIAL; i < RA_PATTERN_MAX; i++) {
+        snprintf(key, sizeof(key), "%s-streams", patterns[i]);
+        gf_proc_dump_write(key, "%" PRIu64, stats->patterns[i]);
+    }
 
+    i = 0;
     for (page = file->pages.next; page != &file->pages; page = page->next) {
         gf_proc_dump_write("page", "%d: %p", i++, (void *)page);
         ra_page_dump(page);
@@ -1237,7 +1490,9 @@ struct volume_options options[] = {
      .default_value = "4",
      .op_version = {1},
      .tags = {"read-ahead"},
-     .description = "Number of pages that will be pre-fetched"},
+     .description = "Maximum number of pages that will be pre-fetched for "
+                    "each stream of reads. The number used grows and "
+                    "shrinks with how useful and timely the pages are."},
     {.key = {"page-size"},
      .type = GF_OPTION_TYPE_SIZET,
      .min = 4096,
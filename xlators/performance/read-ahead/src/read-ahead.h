@@ -16,8 +16,16 @@
 #include <glusterfs/dict.h>
 #include <glusterfs/xlator.h>
 #include <glusterfs/common-utils.h>
+#include <glusterfs/timespec.h>
 #include "read-ahead-mem-types.h"
 
+/* readers followed on each fd, so that interleaved streams are each
+ * prefetched */
+#define RA_STREAMS 4
+
+/* largest distance between two reads of a stream, in pages */
+#define RA_STRIDE_MAX_PAGES 64
+
 struct ra_conf;
 struct ra_local;
 struct ra_page;
@@ -51,6 +59,7 @@ struct ra_local {
     fd_t *fd;
     int32_t wait_count;
     pthread_mutex_t local_lock;
+    uint64_t start; /* of a page fault, in usec */
 };
 
 struct ra_page {
@@ -69,21 +78,54 @@ struct ra_page {
     char stale;
 };
 
+typedef enum {
+    RA_PATTERN_NONE,
+    RA_PATTERN_SEQUENTIAL,
+    RA_PATTERN_STRIDED,
+    RA_PATTERN_REVERSE,
+    RA_PATTERN_MAX,
+} ra_pattern_t;
+
+struct ra_stream {
+    ra_pattern_t pattern;
+    off_t offset;      /* of the last read */
+    size_t size;       /* of the last read */
+    off_t stride;      /* between the offsets of the last two reads */
+    uint32_t matches;  /* consecutive reads which followed the stride */
+    uint32_t window;   /* pages read ahead */
+    off_t start;       /* range of the pages kept for the stream */
+    off_t end;
+    uint64_t used;     /* value of file->reads when last read */
+    uint64_t stamp;    /* time of the last read, in usec */
+    uint64_t interval; /* average time between two reads, in usec */
+};
+
+/* efficiency of the read-ahead on an fd, shown in statedumps */
+struct ra_stats {
+    uint64_t prefetched; /* pages read ahead */
+    uint64_t hits;       /* ...which were ready when read */
+    uint64_t late;       /* ...which were still being fetched when read */
+    uint64_t wasted;     /* ...which were dropped without being read */
+    uint64_t misses;     /* pages read on demand */
+    uint64_t patterns[RA_PATTERN_MAX]; /* streams detected */
+};
+
 struct ra_file {
     struct ra_file *next;
     struct ra_file *prev;
     struct ra_conf *conf;
     fd_t *fd;
     int disabled;
-    size_t expected;
     struct ra_page pages;
-    off_t offset;
     size_t size;
     int32_t refcount;
     pthread_mutex_t file_lock;
     struct iatt stbuf;
     uint64_t page_size;
-    uint32_t page_count;
+    struct ra_stream streams[RA_STREAMS];
+    uint64_t reads;
+    uint64_t latency; /* average time to fetch a page, in usec */
+    struct ra_stats stats;
 };
 
 struct ra_conf {
@@ -101,6 +143,7 @@ typedef struct ra_page ra_page_t;
 typedef struct ra_file ra_file_t;
 typedef struct ra_waitq ra_waitq_t;
 typedef struct ra_fill ra_fill_t;
+typedef struct ra_stream ra_stream_t;
 
 ra_page_t *
 ra_page_get(ra_file_t *file, off_t offset);
@@ -168,4 +211,14 @@ ra_local_unlock(ra_local_t *local)
     pthread_mutex_unlock(&local->local_lock);
 }
 
+static inline uint64_t
+ra_now_usec(void)
+{
+    struct timespec ts;
+
+    timespec_now(&ts);
+
+    return ts.tv_sec * 1000000ULL + ts.tv_nsec / 1000;
+}
+
 #endif /* __READ_AHEAD_H */
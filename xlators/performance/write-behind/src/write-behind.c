@@ -22,9 +22,10 @@
 #include "write-behind-mem-types.h"
 #include "write-behind-messages.h"
 
-#define MAX_VECTOR_COUNT 8
+#define MAX_VECTOR_COUNT 32
 #define WB_AGGREGATE_SIZE 131072 /* 128 KB */
 #define WB_WINDOW_SIZE 1048576   /* 1MB */
+#define WB_WRITEBACK_BATCH 64    /* inodes looked at by each writeback */
 
 typedef struct list_head list_head_t;
 struct wb_conf;
@@ -124,6 +125,13 @@ typedef struct wb_inode {
     gf_atomic_int32_t readdirps;
     gf_atomic_int8_t invalidate;
 
+    list_head_t dirty;  /* in conf->dirty_list while window_current is
+                           positive, in the order inodes got dirty.
+                        */
+    time_t dirty_since; /* when window_current became positive */
+    int writeback;      /* set by the writeback scheduler, do not hold
+                           back the last holder anymore.
+                        */
 } wb_inode_t;
 
 typedef struct wb_request {
@@ -172,6 +180,7 @@ typedef struct wb_request {
         int lied : 1;      /* sin committed */
         int fulfilled : 1; /* got server acknowledgement */
         int go : 1;        /* enough aggregating, good to go */
+        int throttled : 1; /* held back by the dirty budget */
     } ordering;
 
     /* for debug purposes. A request might outlive the fop it is
@@ -190,6 +199,29 @@ typedef struct wb_conf {
     gf_boolean_t strict_write_ordering;
     gf_boolean_t strict_O_DIRECT;
     gf_boolean_t resync_after_fsync;
+
+    /* Data lied about by all the inodes, which is not synced yet, is
+     * bounded by dirty_budget. Past it, only the inodes holding less
+     * than an equal share of the budget are written behind, the others
+     * sync their writes before unwinding them.
+     */
+    uint64_t dirty_budget;
+    uint64_t writeback_size;     /* largest write sent while syncing */
+    uint32_t writeback_interval; /* age of data synced in background */
+    gf_atomic_t dirty;           /* sum of the positive window_current */
+    gf_atomic_t dirty_inodes;
+    gf_lock_t lock; /* protects the dirty list */
+    list_head_t dirty_list;
+
+    pthread_t scheduler;
+    pthread_mutex_t scheduler_lock;
+    pthread_cond_t scheduler_cond;
+    gf_boolean_t scheduler_wake;
+    gf_boolean_t scheduler_exit;
+    gf_boolean_t scheduler_running;
+
+    gf_atomic_t throttled_writes;
+    gf_atomic_t background_syncs;
 } wb_conf_t;
 
 wb_inode_t *
@@ -225,6 +257,86 @@ out:
     return wb_inode;
 }
 
+static void
+wb_scheduler_wake(wb_conf_t *conf)
+{
+    pthread_mutex_lock(&conf->scheduler_lock);
+    {
+        conf->scheduler_wake = _gf_true;
+        pthread_cond_signal(&conf->scheduler_cond);
+    }
+    pthread_mutex_unlock(&conf->scheduler_lock);
+}
+
+/* Changes window_current of @wb_inode by @delta, keeping the dirty counters
+ * in line. window_current can drop below zero for a while, as the size of
+ * collapsed writes is given back with their holder, only its positive part
+ * is accounted as dirty.
+ */
+static void
+__wb_window_update(wb_inode_t *wb_inode, ssize_t delta)
+{
+    wb_conf_t *conf = NULL;
+    ssize_t old = 0;
+    ssize_t new = 0;
+    int64_t dirty = 0;
+    int64_t high = 0;
+
+    conf = wb_inode->this->private;
+
+    old = max(wb_inode->window_current, 0);
+    wb_inode->window_current += delta;
+    new = max(wb_inode->window_current, 0);
+
+    if (new == old)
+        return;
+
+    dirty = GF_ATOMIC_ADD(conf->dirty, new - old);
+
+    if (!old || !new) {
+        LOCK(&conf->lock);
+        {
+            if (!old) {
+                wb_inode->dirty_since = time(NULL);
+                list_add_tail(&wb_inode->dirty, &conf->dirty_list);
+                GF_ATOMIC_INC(conf->dirty_inodes);
+            } else {
+                list_del_init(&wb_inode->dirty);
+                GF_ATOMIC_DEC(conf->dirty_inodes);
+            }
+        }
+        UNLOCK(&conf->lock);
+    }
+
+    /* start syncing in background when crossing the high watermark */
+    high = (conf->dirty_budget / 4) * 3;
+    if (high && (new > old) && (dirty >= high) && (dirty - (new - old) < high))
+        wb_scheduler_wake(conf);
+}
+
+/* Whether the writes of @wb_inode are not to be written behind anymore:
+ * the dirty budget is used up and this inode holds at least an equal share
+ * of it.
+ */
+static gf_boolean_t
+__wb_over_budget(wb_inode_t *wb_inode)
+{
+    wb_conf_t *conf = NULL;
+    int64_t inodes = 0;
+
+    conf = wb_inode->this->private;
+
+    if (!conf->dirty_budget)
+        return _gf_false;
+
+    if (GF_ATOMIC_GET(conf->dirty) < conf->dirty_budget)
+        return _gf_false;
+
+    inodes = max(GF_ATOMIC_GET(conf->dirty_inodes), 1);
+
+    return (wb_inode->window_current >= (ssize_t)(conf->dirty_budget / inodes));
+}
+
 static void
 wb_set_invalidate(wb_inode_t *wb_inode)
 {
@@ -426,7 +538,7 @@ __wb_request_unref(wb_request_t *req)
         if (list_empty(&wb_inode->all)) {
             wb_inode->gen = 0;
             /* in case of accounting errors? */
-            wb_inode->window_current = 0;
+            __wb_window_update(wb_inode, -wb_inode->window_current);
         }
 
         list_del_init(&req->winds);
@@ -674,6 +786,7 @@ __wb_inode_create(xlator_t *this, inode_t *inode)
     INIT_LIST_HEAD(&wb_inode->temptation);
     INIT_LIST_HEAD(&wb_inode->wip);
     INIT_LIST_HEAD(&wb_inode->invalidate_list);
+    INIT_LIST_HEAD(&wb_inode->dirty);
 
     wb_inode->this = this;
 
@@ -722,6 +835,20 @@ wb_inode_destroy(wb_inode_t *wb_inode)
     GF_ASSERT(list_empty(&wb_inode->liability));
     GF_ASSERT(list_empty(&wb_inode->temptation));
 
+    /* an inode with dirty data is referenced by the fds of its requests,
+     * so it is not expected to be in the dirty list here.
+     */
+    if (!list_empty(&wb_inode->dirty)) {
+        wb_conf_t *conf = wb_inode->this->private;
+
+        LOCK(&conf->lock);
+        {
+            list_del_init(&wb_inode->dirty);
+            GF_ATOMIC_DEC(conf->dirty_inodes);
+        }
+        UNLOCK(&conf->lock);
+    }
+
     LOCK_DESTROY(&wb_inode->lock);
     GF_FREE(wb_inode);
 out:
@@ -739,7 +866,7 @@ __wb_fulfill_request(wb_request_t *req)
     wb_inode = req->wb_inode;
 
     req->ordering.fulfilled = 1;
-    wb_inode->window_current -= req->total_size;
+    __wb_window_update(wb_inode, -req->total_size);
     wb_inode->transit -= req->total_size;
 
     uuid_utoa_r(req->gfid, gfid);
@@ -1189,9 +1316,11 @@ wb_fulfill(wb_inode_t *wb_inode, list_head_t *liabilities)
     off_t expected_offset = 0;
     size_t curr_aggregate = 0;
     size_t vector_count = 0;
+    uint64_t writeback_size = 0;
     int ret = 0;
 
     conf = wb_inode->this->private;
+    writeback_size = max(conf->writeback_size, conf->aggregate_size);
 
     list_for_each_entry_safe(req, tmp, liabilities, winds)
     {
@@ -1217,7 +1346,11 @@ wb_fulfill(wb_inode_t *wb_inode, list_head_t *liabilities)
             continue;
         }
 
-        if ((curr_aggregate + req->write_size) > conf->aggregate_size) {
+        /* contiguous lies of the same fd and owner are free of
+         * conflicts with each other, they can be synced in a write
+         * larger than aggregate-size.
+         */
+        if ((curr_aggregate + req->write_size) > writeback_size) {
             NEXT_HEAD(head, req);
             continue;
         }
@@ -1263,25 +1396,40 @@ wb_do_unwinds(wb_inode_t *wb_inode, list_head_t *lies)
     return;
 }
 
-void
+int
 __wb_pick_unwinds(wb_inode_t *wb_inode, list_head_t *lies)
 {
     wb_request_t *req = NULL;
     wb_request_t *tmp = NULL;
+    wb_conf_t *conf = NULL;
+    int throttled = 0;
     char gfid[64] = {
         0,
     };
 
+    conf = wb_inode->this->private;
+
     list_for_each_entry_safe(req, tmp, &wb_inode->temptation, lie)
     {
         if (!req->ordering.fulfilled &&
             wb_inode->window_current > wb_inode->window_conf)
             continue;
 
+        if (!req->ordering.fulfilled && __wb_over_budget(wb_inode)) {
+            /* don't hold it for aggregation, it is unwound once synced */
+            if (!req->ordering.throttled) {
+                req->ordering.throttled = 1;
+                req->ordering.go = 1;
+                GF_ATOMIC_INC(conf->throttled_writes);
+                throttled++;
+            }
+            continue;
+        }
+
         list_del_init(&req->lie);
         list_move_tail(&req->unwinds, lies);
 
-        wb_inode->window_current += req->orig_size;
+        __wb_window_update(wb_inode, req->orig_size);
 
         if (!req->ordering.fulfilled) {
             /* burden increased */
@@ -1303,7 +1451,7 @@ __wb_pick_unwinds(wb_inode_t *wb_inode, list_head_t *lies)
         }
     }
 
-    return;
+    return throttled;
 }
 
 int
@@ -1491,6 +1639,14 @@ __wb_preprocess_winds(wb_inode_t *wb_inode)
     if (conf->trickling_writes && !wb_inode->transit && holder)
         holder->ordering.go = 1;
 
+    /* nor if the writeback scheduler asked for it, or the writes of this
+       inode are held back by the dirty budget
+    */
+    if (holder && (wb_inode->writeback || __wb_over_budget(wb_inode)))
+        holder->ordering.go = 1;
+
+    wb_inode->writeback = 0;
+
     if (wb_inode->dontsync > 0)
         wb_inode->dontsync--;
 
@@ -1755,6 +1911,7 @@ wb_process_queue(wb_inode_t *wb_inode)
     list_head_t lies;
     list_head_t liabilities;
     int wind_failure = 0;
+    int throttled = 0;
 
     INIT_LIST_HEAD(&tasks);
     INIT_LIST_HEAD(&lies);
@@ -1770,7 +1927,7 @@ wb_process_queue(wb_inode_t *wb_inode)
 
             __wb_pick_winds(wb_inode, &tasks, &liabilities);
 
-            __wb_pick_unwinds(wb_inode, &lies);
+            throttled = __wb_pick_unwinds(wb_inode, &lies);
         }
         UNLOCK(&wb_inode->lock);
 
@@ -1786,11 +1943,162 @@ wb_process_queue(wb_inode_t *wb_inode)
          */
         if (!list_empty(&liabilities))
             wind_failure = wb_fulfill(wb_inode, &liabilities);
-    } while (wind_failure);
+
+        /* writes held back by the dirty budget are to be wound now */
+    } while (wind_failure || throttled);
 
     return;
 }
 
+typedef struct wb_candidate {
+    wb_inode_t *wb_inode;
+    time_t dirty_since;
+    ssize_t size;
+} wb_candidate_t;
+
+/* largest first, the oldest first among the same size */
+static int
+wb_candidate_cmp(const void *a, const void *b)
+{
+    const wb_candidate_t *ca = a;
+    const wb_candidate_t *cb = b;
+
+    if (ca->size != cb->size)
+        return (ca->size > cb->size) ? -1 : 1;
+
+    if (ca->dirty_since != cb->dirty_since)
+        return (ca->dirty_since < cb->dirty_since) ? -1 : 1;
+
+    return 0;
+}
+
+/* Syncs the inodes dirty for longer than writeback-interval, the oldest
+ * first. While the dirty budget is used beyond its high watermark, the
+ * largest inodes are synced first instead, whatever their age, until enough
+ * is synced to get back to the low watermark.
+ */
+static void
+wb_writeback(xlator_t *this)
+{
+    wb_conf_t *conf = NULL;
+    wb_inode_t *wb_inode = NULL;
+    wb_candidate_t candidates[WB_WRITEBACK_BATCH];
+    int64_t dirty = 0;
+    int64_t excess = 0;
+    time_t now = 0;
+    int smallest = 0;
+    int count = 0;
+    int i = 0;
+
+    conf = this->private;
+    now = time(NULL);
+
+    dirty = GF_ATOMIC_GET(conf->dirty);
+    if (conf->dirty_budget && (dirty >= (conf->dirty_budget / 4) * 3))
+        excess = dirty - conf->dirty_budget / 2;
+
+    LOCK(&conf->lock);
+    {
+        /* the list is in the order inodes got dirty */
+        list_for_each_entry(wb_inode, &conf->dirty_list, dirty)
+        {
+            if (!excess) {
+                if ((count == WB_WRITEBACK_BATCH) ||
+                    ((now - wb_inode->dirty_since) <
+                     conf->writeback_interval))
+                    break;
+            } else if (count == WB_WRITEBACK_BATCH) {
+                /* keep the largest ones */
+                if (wb_inode->window_current <= candidates[smallest].size)
+                    continue;
+
+                count--;
+                candidates[smallest] = candidates[count];
+            }
+
+            candidates[count].wb_inode = wb_inode;
+            candidates[count].dirty_since = wb_inode->dirty_since;
+            candidates[count].size = wb_inode->window_current;
+            count++;
+
+            if (excess && (count == WB_WRITEBACK_BATCH)) {
+                smallest = 0;
+                for (i = 1; i < count; i++) {
+                    if (candidates[i].size < candidates[smallest].size)
+                        smallest = i;
+                }
+            }
+        }
+
+        /* referenced by the fds of their requests as long as they are
+         * dirty, but not necessarily after we drop the lock.
+         */
+        for (i = 0; i < count; i++)
+            inode_ref(candidates[i].wb_inode->inode);
+    }
+    UNLOCK(&conf->lock);
+
+    if (excess)
+        qsort(candidates, count, sizeof(candidates[0]), wb_candidate_cmp);
+
+    for (i = 0; i < count; i++) {
+        wb_inode = candidates[i].wb_inode;
+
+        if (!excess &&
+            (now - candidates[i].dirty_since) < conf->writeback_interval)
+            goto next;
+
+        LOCK(&wb_inode->lock);
+        {
+            wb_inode->writeback = 1;
+        }
+        UNLOCK(&wb_inode->lock);
+
+        wb_process_queue(wb_inode);
+
+        GF_ATOMIC_INC(conf->background_syncs);
+        excess -= candidates[i].size;
+        if (excess < 0)
+            excess = 0;
+    next:
+        inode_unref(wb_inode->inode);
+    }
+}
+
+static void *
+wb_scheduler(void *data)
+{
+    xlator_t *this = data;
+    wb_conf_t *conf = NULL;
+    struct timespec timeout = {
+        0,
+    };
+
+    THIS = this;
+    conf = this->private;
+
+    pthread_mutex_lock(&conf->scheduler_lock);
+    while (!conf->scheduler_exit) {
+        if (!conf->scheduler_wake) {
+            clock_gettime(CLOCK_REALTIME, &timeout);
+            timeout.tv_sec += 1;
+            pthread_cond_timedwait(&conf->scheduler_cond,
+                                   &conf->scheduler_lock, &timeout);
+            if (conf->scheduler_exit)
+                break;
+        }
+        conf->scheduler_wake = _gf_false;
+        pthread_mutex_unlock(&conf->scheduler_lock);
+
+        wb_writeback(this);
+
+        pthread_mutex_lock(&conf->scheduler_lock);
+    }
+    pthread_mutex_unlock(&conf->scheduler_lock);
+
+    return NULL;
+}
+
 void
 wb_set_inode_size(wb_inode_t *wb_inode, struct iatt *postbuf)
 {
@@ -2867,6 +3175,17 @@ wb_priv_dump(xlator_t *this)
     gf_proc_dump_write("window_size", "%" PRIu64, conf->window_size);
     gf_proc_dump_write("flush_behind", "%d", conf->flush_behind);
     gf_proc_dump_write("trickling_writes", "%d", conf->trickling_writes);
+    gf_proc_dump_write("dirty_budget", "%" PRIu64, conf->dirty_budget);
+    gf_proc_dump_write("writeback_size", "%" PRIu64, conf->writeback_size);
+    gf_proc_dump_write("writeback_interval", "%" PRIu32,
+                       conf->writeback_interval);
+    gf_proc_dump_write("dirty", "%" PRId64, GF_ATOMIC_GET(conf->dirty));
+    gf_proc_dump_write("dirty_inodes", "%" PRId64,
+                       GF_ATOMIC_GET(conf->dirty_inodes));
+    gf_proc_dump_write("throttled_writes", "%" PRId64,
+                       GF_ATOMIC_GET(conf->throttled_writes));
+    gf_proc_dump_write("background_syncs", "%" PRId64,
+                       GF_ATOMIC_GET(conf->background_syncs));
 
     ret = 0;
 out:
@@ -3048,6 +3367,18 @@ reconfigure(xlator_t *this, dict_t *options)
     GF_OPTION_RECONF("resync-failed-syncs-after-fsync",
                      conf->resync_after_fsync, options, bool, out);
 
+    GF_OPTION_RECONF("dirty-budget", conf->dirty_budget, options, size_uint64,
+                     out);
+
+    GF_OPTION_RECONF("writeback-size", conf->writeback_size, options,
+                     size_uint64, out);
+
+    GF_OPTION_RECONF("writeback-interval", conf->writeback_interval, options,
+                     time, out);
+
+    /* the budget could have been lowered below what is dirty */
+    wb_scheduler_wake(conf);
+
     ret = 0;
 out:
     return ret;
@@ -3115,8 +3446,35 @@ init(xlator_t *this)
     GF_OPTION_INIT("resync-failed-syncs-after-fsync", conf->resync_after_fsync,
                    bool, out);
 
+    GF_OPTION_INIT("dirty-budget", conf->dirty_budget, size_uint64, out);
+
+    GF_OPTION_INIT("writeback-size", conf->writeback_size, size_uint64, out);
+
+    GF_OPTION_INIT("writeback-interval", conf->writeback_interval, time, out);
+
+    GF_ATOMIC_INIT(conf->dirty, 0);
+    GF_ATOMIC_INIT(conf->dirty_inodes, 0);
+    GF_ATOMIC_INIT(conf->throttled_writes, 0);
+    GF_ATOMIC_INIT(conf->background_syncs, 0);
+    INIT_LIST_HEAD(&conf->dirty_list);
+    LOCK_INIT(&conf->lock);
+    pthread_mutex_init(&conf->scheduler_lock, NULL);
+    pthread_cond_init(&conf->scheduler_cond, NULL);
+
     this->private = conf;
-    ret = 0;
+
+    ret = gf_thread_create(&conf->scheduler, NULL, wb_scheduler, this,
+                           "wbsched");
+    if (ret) {
+        gf_msg(this->name, GF_LOG_ERROR, ret, WRITE_BEHIND_MSG_INIT_FAILED,
+               "failed to start the writeback scheduler");
+        this->private = NULL;
+        pthread_cond_destroy(&conf->scheduler_cond);
+        pthread_mutex_destroy(&conf->scheduler_lock);
+        LOCK_DESTROY(&conf->lock);
+        goto out;
+    }
+    conf->scheduler_running = _gf_true;
 
 out:
     if (ret) {
@@ -3137,6 +3495,21 @@ fini(xlator_t *this)
         goto out;
     }
 
+    if (conf->scheduler_running) {
+        pthread_mutex_lock(&conf->scheduler_lock);
+        {
+            conf->scheduler_exit = _gf_true;
+            pthread_cond_signal(&conf->scheduler_cond);
+        }
+        pthread_mutex_unlock(&conf->scheduler_lock);
+
+        pthread_join(conf->scheduler, NULL);
+    }
+
+    pthread_cond_destroy(&conf->scheduler_cond);
+    pthread_mutex_destroy(&conf->scheduler_lock);
+    LOCK_DESTROY(&conf->lock);
+
     this->private = NULL;
     GF_FREE(conf);
 
@@ -3260,6 +3633,47 @@ struct volume_options options[] = {
                        " so that writes are aggregated till a max of "
                        "\"aggregate-size\" bytes",
     },
+    {
+        .key = {"dirty-budget"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 0,
+        .max = 64 * GF_UNIT_GB,
+        .default_value = "256MB",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "Maximum amount of data written behind, and not yet "
+                       "synced, for all the files together. Once it is "
+                       "reached, writes to files holding more than an equal "
+                       "share of it are synced before returning, and "
+                       "syncing starts in background past 3/4 of it. "
+                       "0 disables the limit.",
+    },
+    {
+        .key = {"writeback-size"},
+        .type = GF_OPTION_TYPE_SIZET,
+        .min = 128 * GF_UNIT_KB,
+        .max = 4 * GF_UNIT_MB,
+        .default_value = "1MB",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "Contiguous cached writes of a file are synced in "
+                       "writes of up to this size, or of aggregate-size "
+                       "if larger.",
+    },
+    {
+        .key = {"writeback-interval"},
+        .type = GF_OPTION_TYPE_TIME,
+        .min = 1,
+        .max = 60,
+        .default_value = "5",
+        .op_version = {GD_OP_VERSION_9_0},
+        .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC | OPT_FLAG_CLIENT_OPT,
+        .tags = {"write-behind"},
+        .description = "Cached writes held back for aggregation longer "
+                       "than this many seconds are synced in background.",
+    },
     {.key = {NULL}},
 };
 
@@ -840,6 +840,11 @@ client_setvolume_cbk(struct rpc_req *req, struct iovec *iov, int count,
         }
     }
 
+    /* older servers don't send it */
+    ret = dict_get_uint32(reply, "opversion", &conf->server_op_version);
+    if (ret)
+        conf->server_op_version = 0;
+
     uint32_t child_up_int;
     ret = dict_get_uint32(reply, "child_up", &child_up_int);
     if (ret) {
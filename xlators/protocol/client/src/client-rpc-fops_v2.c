@@ -2889,6 +2889,230 @@ out:
     return 0;
 }
 
+static void
+client4_compound_args_cbk_free(compound_args_cbk_t *args_cbk)
+{
+    unsigned int i = 0;
+
+    if (!args_cbk)
+        return;
+
+    for (i = 0; args_cbk->rsp_list && (i < args_cbk->fop_length); i++)
+        args_cbk_wipe(&args_cbk->rsp_list[i]);
+
+    GF_FREE(args_cbk->rsp_list);
+    GF_FREE(args_cbk->enum_list);
+    GF_FREE(args_cbk);
+}
+
+static compound_args_cbk_t *
+client4_compound_args_cbk_new(unsigned int count)
+{
+    compound_args_cbk_t *args_cbk = NULL;
+    unsigned int i = 0;
+
+    args_cbk = GF_CALLOC(1, sizeof(*args_cbk), gf_client_mt_compound_rsp_t);
+    if (!args_cbk)
+        return NULL;
+
+    args_cbk->fop_enum = GF_FOP_COMPOUND;
+    args_cbk->fop_length = count;
+    args_cbk->enum_list = GF_CALLOC(count, sizeof(*args_cbk->enum_list),
+                                    gf_client_mt_compound_rsp_t);
+    args_cbk->rsp_list = GF_CALLOC(count, sizeof(*args_cbk->rsp_list),
+                                   gf_client_mt_compound_rsp_t);
+    if (!args_cbk->enum_list || !args_cbk->rsp_list) {
+        args_cbk->fop_length = 0;
+        client4_compound_args_cbk_free(args_cbk);
+        return NULL;
+    }
+
+    for (i = 0; i < count; i++)
+        args_cbk_init(&args_cbk->rsp_list[i]);
+
+    return args_cbk;
+}
+
+/* Stores the result of one fop of the chain. The fd created or opened by
+ * the first one is registered like in a plain create or open. */
+static void
+client4_compound_rsp_store(call_frame_t *frame, xlator_t *this,
+                           compound_rsp_v2 *crsp, default_args_cbk_t *args)
+{
+    clnt_local_t *local = frame->local;
+    gfx_create_rsp *create_rsp = NULL;
+    gfx_open_rsp *open_rsp = NULL;
+    gfx_common_2iatt_rsp *iatt_rsp = NULL;
+    gfx_common_rsp *common_rsp = NULL;
+    struct iatt iatt1 = {
+        0,
+    };
+    struct iatt iatt2 = {
+        0,
+    };
+    struct iatt iatt3 = {
+        0,
+    };
+    dict_t *xdata = NULL;
+    int ret = 0;
+
+    switch (crsp->fop_enum) {
+        case GF_FOP_CREATE:
+            create_rsp = &crsp->compound_rsp_v2_u.compound_create_rsp;
+            client_post_create_v2(this, create_rsp, &iatt1, &iatt2, &iatt3,
+                                  local, &xdata);
+            if (-1 != create_rsp->op_ret) {
+                ret = client_add_fd_to_saved_fds(frame->this, local->fd,
+                                                 &local->loc, local->flags,
+                                                 create_rsp->fd, 0);
+                if (ret) {
+                    create_rsp->op_ret = -1;
+                    create_rsp->op_errno = -ret;
+                }
+            }
+            args_create_cbk_store(args, create_rsp->op_ret,
+                                  gf_error_to_errno(create_rsp->op_errno),
+                                  local->fd, local->loc.inode, &iatt1, &iatt2,
+                                  &iatt3, xdata);
+            break;
+        case GF_FOP_OPEN:
+            open_rsp = &crsp->compound_rsp_v2_u.compound_open_rsp;
+            xdr_to_dict(&open_rsp->xdata, &xdata);
+            if (-1 != open_rsp->op_ret) {
+                ret = client_add_fd_to_saved_fds(frame->this, local->fd,
+                                                 &local->loc, local->flags,
+                                                 open_rsp->fd, 0);
+                if (ret) {
+                    open_rsp->op_ret = -1;
+                    open_rsp->op_errno = -ret;
+                }
+            }
+            args_open_cbk_store(args, open_rsp->op_ret,
+                                gf_error_to_errno(open_rsp->op_errno),
+                                local->fd, xdata);
+            break;
+        case GF_FOP_WRITE:
+            iatt_rsp = &crsp->compound_rsp_v2_u.compound_write_rsp;
+            client_post_common_2iatt(this, iatt_rsp, &iatt1, &iatt2, &xdata);
+            args_writev_cbk_store(args, iatt_rsp->op_ret,
+                                  gf_error_to_errno(iatt_rsp->op_errno),
+                                  &iatt1, &iatt2, xdata);
+            break;
+        case GF_FOP_FSETATTR:
+            iatt_rsp = &crsp->compound_rsp_v2_u.compound_fsetattr_rsp;
+            client_post_common_2iatt(this, iatt_rsp, &iatt1, &iatt2, &xdata);
+            args_fsetattr_cbk_store(args, iatt_rsp->op_ret,
+                                    gf_error_to_errno(iatt_rsp->op_errno),
+                                    &iatt1, &iatt2, xdata);
+            break;
+        case GF_FOP_FSYNC:
+            iatt_rsp = &crsp->compound_rsp_v2_u.compound_fsync_rsp;
+            client_post_common_2iatt(this, iatt_rsp, &iatt1, &iatt2, &xdata);
+            args_fsync_cbk_store(args, iatt_rsp->op_ret,
+                                 gf_error_to_errno(iatt_rsp->op_errno),
+                                 &iatt1, &iatt2, xdata);
+            break;
+        case GF_FOP_FSETXATTR:
+            common_rsp = &crsp->compound_rsp_v2_u.compound_fsetxattr_rsp;
+            xdr_to_dict(&common_rsp->xdata, &xdata);
+            args_fsetxattr_cbk_store(args, common_rsp->op_ret,
+                                     gf_error_to_errno(common_rsp->op_errno),
+                                     xdata);
+            break;
+        case GF_FOP_FLUSH:
+            common_rsp = &crsp->compound_rsp_v2_u.compound_flush_rsp;
+            xdr_to_dict(&common_rsp->xdata, &xdata);
+            args_flush_cbk_store(args, common_rsp->op_ret,
+                                 gf_error_to_errno(common_rsp->op_errno),
+                                 xdata);
+            break;
+        default:
+            args->op_ret = -1;
+            args->op_errno = EINVAL;
+            break;
+    }
+
+    if (xdata)
+        dict_unref(xdata);
+}
+
+int
+client4_0_compound_cbk(struct rpc_req *req, struct iovec *iov, int count,
+                       void *myframe)
+{
+    gfx_compound_rsp rsp = {
+        0,
+    };
+    compound_args_cbk_t *args_cbk = NULL;
+    call_frame_t *frame = NULL;
+    xlator_t *this = NULL;
+    dict_t *xdata = NULL;
+    unsigned int len = 0;
+    unsigned int i = 0;
+    int ret = 0;
+
+    this = THIS;
+
+    frame = myframe;
+
+    if (-1 == req->rpc_status) {
+        rsp.op_ret = -1;
+        rsp.op_errno = ENOTCONN;
+        goto out;
+    }
+
+    ret = xdr_to_generic(*iov, &rsp, (xdrproc_t)xdr_gfx_compound_rsp);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, EINVAL, PC_MSG_XDR_DECODING_FAILED,
+               "XDR decoding failed");
+        rsp.op_ret = -1;
+        rsp.op_errno = EINVAL;
+        goto out;
+    }
+
+    len = rsp.compound_rsp_array.compound_rsp_array_len;
+    if (len > 0) {
+        args_cbk = client4_compound_args_cbk_new(len);
+        if (!args_cbk) {
+            rsp.op_ret = -1;
+            rsp.op_errno = ENOMEM;
+            goto out;
+        }
+    }
+
+    for (i = 0; i < len; i++) {
+        args_cbk->enum_list[i] =
+            rsp.compound_rsp_array.compound_rsp_array_val[i].fop_enum;
+        client4_compound_rsp_store(
+            frame, this, &rsp.compound_rsp_array.compound_rsp_array_val[i],
+            &args_cbk->rsp_list[i]);
+
+        /* the fd couldn't be registered */
+        if ((args_cbk->rsp_list[i].op_ret < 0) && (rsp.op_ret >= 0)) {
+            rsp.op_ret = -1;
+            rsp.op_errno = gf_errno_to_error(args_cbk->rsp_list[i].op_errno);
+        }
+    }
+
+    ret = xdr_to_dict(&rsp.xdata, &xdata);
+out:
+    if (rsp.op_ret == -1) {
+        gf_smsg(this->name, GF_LOG_WARNING, gf_error_to_errno(rsp.op_errno),
+                PC_MSG_REMOTE_OP_FAILED, NULL);
+    }
+
+    CLIENT_STACK_UNWIND(compound, frame, rsp.op_ret,
+                        gf_error_to_errno(rsp.op_errno), args_cbk, xdata);
+
+    client4_compound_args_cbk_free(args_cbk);
+    if (xdata)
+        dict_unref(xdata);
+
+    xdr_free((xdrproc_t)xdr_gfx_compound_rsp, (char *)&rsp);
+
+    return 0;
+}
+
 int32_t
 client4_0_releasedir(call_frame_t *frame, xlator_t *this, void *data)
 {
@@ -6013,6 +6237,284 @@ unwind:
     return 0;
 }
 
+/* Fills the request of a fop done on the fd of the chain. When the first
+ * fop creates or opens it, the remote fd is not known yet and the server
+ * uses the new one. */
+static int
+client4_compound_fd_fop(compound_req_v2 *creq, int fop, default_args_t *args,
+                        int64_t remote_fd)
+{
+    gfx_write_req *write_req = NULL;
+    gfx_fsetxattr_req *fsetxattr_req = NULL;
+    gfx_fsetattr_req *fsetattr_req = NULL;
+    gfx_fsync_req *fsync_req = NULL;
+    gfx_flush_req *flush_req = NULL;
+
+    creq->fop_enum = fop;
+
+    switch (fop) {
+        case GF_FOP_WRITE:
+            write_req = &creq->compound_req_v2_u.compound_write_req;
+            write_req->fd = remote_fd;
+            write_req->size = iov_length(args->vector, args->count);
+            write_req->offset = args->offset;
+            write_req->flag = args->flags;
+            memcpy(write_req->gfid, args->fd->inode->gfid, 16);
+            dict_to_xdr(args->xdata, &write_req->xdata);
+            break;
+        case GF_FOP_FSETXATTR:
+            fsetxattr_req = &creq->compound_req_v2_u.compound_fsetxattr_req;
+            fsetxattr_req->fd = remote_fd;
+            fsetxattr_req->flags = args->flags;
+            memcpy(fsetxattr_req->gfid, args->fd->inode->gfid, 16);
+            dict_to_xdr(args->xattr, &fsetxattr_req->dict);
+            dict_to_xdr(args->xdata, &fsetxattr_req->xdata);
+            break;
+        case GF_FOP_FSETATTR:
+            fsetattr_req = &creq->compound_req_v2_u.compound_fsetattr_req;
+            fsetattr_req->fd = remote_fd;
+            fsetattr_req->valid = args->valid;
+            gfx_stat_from_iattx(&fsetattr_req->stbuf, &args->stat);
+            memcpy(fsetattr_req->gfid, args->fd->inode->gfid, 16);
+            dict_to_xdr(args->xdata, &fsetattr_req->xdata);
+            break;
+        case GF_FOP_FSYNC:
+            fsync_req = &creq->compound_req_v2_u.compound_fsync_req;
+            fsync_req->fd = remote_fd;
+            fsync_req->data = args->datasync;
+            memcpy(fsync_req->gfid, args->fd->inode->gfid, 16);
+            dict_to_xdr(args->xdata, &fsync_req->xdata);
+            break;
+        case GF_FOP_FLUSH:
+            flush_req = &creq->compound_req_v2_u.compound_flush_req;
+            flush_req->fd = remote_fd;
+            memcpy(flush_req->gfid, args->fd->inode->gfid, 16);
+            dict_to_xdr(args->xdata, &flush_req->xdata);
+            break;
+        default:
+            creq->fop_enum = GF_FOP_NULL;
+            return -EINVAL;
+    }
+
+    return 0;
+}
+
+static void
+client4_compound_req_cleanup(compound_req_v2 *creq, unsigned int count)
+{
+    unsigned int i = 0;
+
+    for (i = 0; creq && (i < count); i++) {
+        switch (creq[i].fop_enum) {
+            case GF_FOP_CREATE:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_create_req.xdata.pairs
+                            .pairs_val);
+                break;
+            case GF_FOP_OPEN:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_open_req.xdata.pairs
+                            .pairs_val);
+                break;
+            case GF_FOP_WRITE:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_write_req.xdata.pairs
+                            .pairs_val);
+                break;
+            case GF_FOP_FSETXATTR:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_fsetxattr_req.dict
+                            .pairs.pairs_val);
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_fsetxattr_req.xdata
+                            .pairs.pairs_val);
+                break;
+            case GF_FOP_FSETATTR:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_fsetattr_req.xdata
+                            .pairs.pairs_val);
+                break;
+            case GF_FOP_FSYNC:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_fsync_req.xdata.pairs
+                            .pairs_val);
+                break;
+            case GF_FOP_FLUSH:
+                GF_FREE(creq[i]
+                            .compound_req_v2_u.compound_flush_req.xdata.pairs
+                            .pairs_val);
+                break;
+            default:
+                break;
+        }
+    }
+
+    GF_FREE(creq);
+}
+
+/* Sends a chain of fops on a single file in one request. The first fop is
+ * a create or an open, or a fop on an already opened fd, and the following
+ * ones are done by the server on the same fd, in order. The chain stops at
+ * the first fop that fails. */
+int32_t
+client4_0_compound(call_frame_t *frame, xlator_t *this, void *data)
+{
+    compound_args_t *args = NULL;
+    clnt_conf_t *conf = NULL;
+    clnt_local_t *local = NULL;
+    default_args_t *fop_args = NULL;
+    gfx_compound_req req = {
+        0,
+    };
+    compound_req_v2 *creq = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec *vector = NULL;
+    client_payload_t cp;
+    int64_t remote_fd = -1;
+    fd_t *fd = NULL;
+    unsigned int length = 0;
+    unsigned int i = 0;
+    int count = 0;
+    int op_errno = EINVAL;
+    int ret = 0;
+
+    if (!frame || !this || !data)
+        goto unwind;
+
+    args = data;
+    conf = this->private;
+    length = args->fop_length;
+
+    if ((length == 0) || (length > GF_COMPOUND_MAX_FOPS))
+        goto unwind;
+
+    op_errno = ENOMEM;
+    local = mem_get0(this->local_pool);
+    if (!local)
+        goto unwind;
+    frame->local = local;
+
+    creq = GF_CALLOC(length, sizeof(*creq), gf_client_mt_compound_req_t);
+    iobref = iobref_new();
+    if (!creq || !iobref)
+        goto unwind;
+
+    for (i = 0; i < length; i++) {
+        fop_args = &args->req_list[i];
+        if (args->enum_list[i] == GF_FOP_WRITE)
+            count += fop_args->count;
+    }
+
+    if (count > 0) {
+        vector = GF_CALLOC(count, sizeof(*vector),
+                           gf_client_mt_compound_req_t);
+        if (!vector)
+            goto unwind;
+        count = 0;
+    }
+
+    fop_args = &args->req_list[0];
+    switch (args->enum_list[0]) {
+        case GF_FOP_CREATE:
+            creq[0].fop_enum = GF_FOP_CREATE;
+            ret = client_pre_create_v2(
+                this, &creq[0].compound_req_v2_u.compound_create_req,
+                &fop_args->loc, fop_args->fd, fop_args->mode, fop_args->flags,
+                fop_args->umask, fop_args->xdata);
+            break;
+        case GF_FOP_OPEN:
+            creq[0].fop_enum = GF_FOP_OPEN;
+            ret = client_pre_open_v2(
+                this, &creq[0].compound_req_v2_u.compound_open_req,
+                &fop_args->loc, fop_args->fd, fop_args->flags,
+                fop_args->xdata);
+            break;
+        default:
+            if (!fop_args->fd) {
+                op_errno = EINVAL;
+                goto unwind;
+            }
+            CLIENT_GET_REMOTE_FD(this, fop_args->fd, DEFAULT_REMOTE_FD,
+                                 remote_fd, op_errno, unwind);
+            break;
+    }
+    if (ret) {
+        op_errno = -ret;
+        goto unwind;
+    }
+
+    fd = fop_args->fd;
+    local->fd = fd_ref(fd);
+    if (remote_fd == -1) {
+        /* used to register the new fd */
+        local->flags = fop_args->flags;
+        loc_copy(&local->loc, &fop_args->loc);
+        loc_path(&local->loc, NULL);
+    }
+
+    for (i = 0; i < length; i++) {
+        fop_args = &args->req_list[i];
+        if ((i == 0) && ((args->enum_list[i] == GF_FOP_CREATE) ||
+                         (args->enum_list[i] == GF_FOP_OPEN)))
+            continue;
+
+        if (fop_args->fd != fd) {
+            op_errno = EINVAL;
+            goto unwind;
+        }
+
+        ret = client4_compound_fd_fop(&creq[i], args->enum_list[i], fop_args,
+                                      remote_fd);
+        if (ret) {
+            op_errno = -ret;
+            goto unwind;
+        }
+
+        if (args->enum_list[i] == GF_FOP_WRITE) {
+            memcpy(&vector[count], fop_args->vector,
+                   fop_args->count * sizeof(*vector));
+            count += fop_args->count;
+            if (fop_args->iobref && iobref_merge(iobref, fop_args->iobref))
+                goto unwind;
+        }
+    }
+
+    req.compound_version = 0;
+    req.compound_req_array.compound_req_array_len = length;
+    req.compound_req_array.compound_req_array_val = creq;
+    dict_to_xdr(args->xdata, &req.xdata);
+
+    memset(&cp, 0, sizeof(client_payload_t));
+
+    cp.iobref = iobref;
+    cp.payload = vector;
+    cp.payload_cnt = count;
+    ret = client_submit_request(this, &req, frame, conf->fops,
+                                GFS3_OP_COMPOUND, client4_0_compound_cbk, &cp,
+                                (xdrproc_t)xdr_gfx_compound_req);
+    if (ret) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, PC_MSG_FOP_SEND_FAILED,
+               "failed to send the fop");
+    }
+
+    GF_FREE(req.xdata.pairs.pairs_val);
+    client4_compound_req_cleanup(creq, length);
+    GF_FREE(vector);
+    iobref_unref(iobref);
+
+    return 0;
+
+unwind:
+    CLIENT_STACK_UNWIND(compound, frame, -1, op_errno, NULL, NULL);
+
+    client4_compound_req_cleanup(creq, length);
+    GF_FREE(vector);
+    if (iobref)
+        iobref_unref(iobref);
+
+    return 0;
+}
+
 int32_t
 client4_0_fsetattr(call_frame_t *frame, xlator_t *this, void *data)
 {
@@ -6213,7 +6715,7 @@ rpc_clnt_procedure_t clnt4_0_fop_actors[GF_FOP_MAXVALUE] = {
     [GF_FOP_LEASE] = {"LEASE", client4_0_lease},
     [GF_FOP_GETACTIVELK] = {"GETACTIVELK", client4_0_getactivelk},
     [GF_FOP_SETACTIVELK] = {"SETACTIVELK", client4_0_setactivelk},
-    [GF_FOP_COMPOUND] = {"COMPOUND", NULL},
+    [GF_FOP_COMPOUND] = {"COMPOUND", client4_0_compound},
     [GF_FOP_ICREATE] = {"ICREATE", client4_0_icreate},
     [GF_FOP_NAMELINK] = {"NAMELINK", client4_0_namelink},
     [GF_FOP_COPY_FILE_RANGE] = {"COPY-FILE-RANGE", client4_0_copy_file_range},
@@ -745,6 +745,141 @@ out:
     return 0;
 }
 
+/* Unwinds the create of a create + write + flush chain. The result of the
+ * write, or of the flush if it failed, is returned in GF_CREATE_WRITE_KEY
+ * and the iatt of the file is the one after the write. */
+static int32_t
+client_create_write_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                        int32_t op_ret, int32_t op_errno, void *data,
+                        dict_t *xdata)
+{
+    compound_args_cbk_t *args_cbk = data;
+    default_args_cbk_t *create = NULL;
+    default_args_cbk_t *write = NULL;
+    default_args_cbk_t *flush = NULL;
+    struct iatt *stbuf = NULL;
+    dict_t *rsp_xdata = NULL;
+    int32_t written = 0;
+
+    if (!args_cbk || (args_cbk->fop_length == 0)) {
+        STACK_UNWIND_STRICT(create, frame, -1, op_errno, NULL, NULL, NULL,
+                            NULL, NULL, NULL);
+        return 0;
+    }
+
+    create = &args_cbk->rsp_list[0];
+    if (create->op_ret < 0) {
+        STACK_UNWIND_STRICT(create, frame, create->op_ret, create->op_errno,
+                            NULL, NULL, NULL, NULL, NULL, create->xdata);
+        return 0;
+    }
+
+    /* the write is always done after a successful create, a reply without
+     * it is broken */
+    stbuf = &create->stat;
+    written = -EIO;
+    if (args_cbk->fop_length > 1) {
+        write = &args_cbk->rsp_list[1];
+        if (write->op_ret < 0) {
+            written = -write->op_errno;
+        } else {
+            written = write->op_ret;
+            stbuf = &write->poststat;
+        }
+    }
+    if (args_cbk->fop_length > 2) {
+        flush = &args_cbk->rsp_list[2];
+        if (flush->op_ret < 0)
+            written = -flush->op_errno;
+    }
+
+    rsp_xdata = create->xdata ? dict_ref(create->xdata) : dict_new();
+    if (!rsp_xdata || dict_set_int32_sizen(rsp_xdata, GF_CREATE_WRITE_KEY,
+                                           written)) {
+        /* the file is there, but the caller can't know about the write */
+        gf_msg(this->name, GF_LOG_WARNING, ENOMEM, PC_MSG_NO_MEMORY,
+               "failed to return the result of the write of a create");
+    }
+
+    STACK_UNWIND_STRICT(create, frame, create->op_ret, create->op_errno,
+                        create->fd, create->inode, stbuf, &create->preparent,
+                        &create->postparent, rsp_xdata);
+
+    if (rsp_xdata)
+        dict_unref(rsp_xdata);
+
+    return 0;
+}
+
+/* Sends a create carrying GF_CREATE_WRITE_KEY as a create + write + flush
+ * compound, so that creating a small file takes a single round trip. */
+static int
+client_create_write(call_frame_t *frame, xlator_t *this, loc_t *loc,
+                    int32_t flags, mode_t mode, mode_t umask, fd_t *fd,
+                    dict_t *xdata, data_t *data)
+{
+    int enum_list[3] = {GF_FOP_CREATE, GF_FOP_WRITE, GF_FOP_FLUSH};
+    default_args_t req_list[3];
+    compound_args_t args = {
+        0,
+    };
+    struct iobuf *iobuf = NULL;
+    struct iobref *iobref = NULL;
+    struct iovec vector = {
+        0,
+    };
+    dict_t *create_xdata = NULL;
+    int i = 0;
+    int ret = -1;
+
+    create_xdata = dict_copy_with_ref(xdata, NULL);
+    iobuf = iobuf_get2(this->ctx->iobuf_pool, data->len);
+    iobref = iobref_new();
+    if (!create_xdata || !iobuf || !iobref)
+        goto out;
+
+    dict_del_sizen(create_xdata, GF_CREATE_WRITE_KEY);
+
+    memset(req_list, 0, sizeof(req_list));
+    memcpy(iobuf_ptr(iobuf), data->data, data->len);
+    ret = iobref_add(iobref, iobuf);
+    if (ret)
+        goto out;
+
+    vector.iov_base = iobuf_ptr(iobuf);
+    vector.iov_len = data->len;
+
+    args_create_store(&req_list[0], loc, flags, mode, umask, fd,
+                      create_xdata);
+    args_writev_store(&req_list[1], fd, &vector, 1, 0, 0, iobref, NULL);
+    args_flush_store(&req_list[2], fd, NULL);
+
+    args.fop_enum = GF_FOP_COMPOUND;
+    args.fop_length = 3;
+    args.enum_list = enum_list;
+    args.req_list = req_list;
+
+    gf_msg_debug(this->name, 0,
+                 "sending the create of %s and a write of %d bytes as a "
+                 "compound",
+                 loc->path, data->len);
+
+    STACK_WIND(frame, client_create_write_cbk, this, this->fops->compound,
+               &args, NULL);
+
+    for (i = 0; i < 3; i++)
+        args_wipe(&req_list[i]);
+out:
+    if (create_xdata)
+        dict_unref(create_xdata);
+    if (iobref)
+        iobref_unref(iobref);
+    if (iobuf)
+        iobuf_unref(iobuf);
+
+    return ret;
+}
+
 static int32_t
 client_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
               mode_t mode, mode_t umask, fd_t *fd, dict_t *xdata)
@@ -752,6 +887,7 @@ client_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     int ret = -1;
     clnt_conf_t *conf = NULL;
     rpc_clnt_procedure_t *proc = NULL;
+    data_t *data = NULL;
     clnt_args_t args = {
         0,
     };
@@ -760,6 +896,24 @@ client_create(call_frame_t *frame, xlator_t *this, loc_t *loc, int32_t flags,
     if (!conf || !conf->fops)
         goto out;
 
+    if (xdata)
+        data = dict_get_sizen(xdata, GF_CREATE_WRITE_KEY);
+    if (data) {
+        client_filter_o_direct(conf, &flags);
+        /* bricks older than the compound fop reject it */
+        if (conf->create_write_compound &&
+            (conf->server_op_version >= GD_OP_VERSION_9_0) &&
+            (data->len > 0) && (data->len <= GF_CREATE_WRITE_MAX) &&
+            conf->fops->proctable[GF_FOP_COMPOUND].fn &&
+            !client_create_write(frame, this, loc, flags, mode, umask, fd,
+                                 xdata, data))
+            return 0;
+
+        /* the caller writes the data itself when the key isn't in the
+         * reply */
+        dict_del_sizen(xdata, GF_CREATE_WRITE_KEY);
+    }
+
     proc = &conf->fops->proctable[GF_FOP_CREATE];
     if (proc->fn) {
         args.loc = loc;
@@ -2432,6 +2586,8 @@ build_client_config(xlator_t *this, clnt_conf_t *conf)
 
     GF_OPTION_INIT("testing.old-protocol", conf->old_protocol, bool, out);
     GF_OPTION_INIT("strict-locks", conf->strict_locks, bool, out);
+    GF_OPTION_INIT("create-write-compound", conf->create_write_compound, bool,
+                   out);
 
     conf->client_id = glusterfs_leaf_position(this);
 
@@ -2620,6 +2776,8 @@ reconfigure(xlator_t *this, dict_t *options)
 
     GF_OPTION_RECONF("send-gids", conf->send_gids, options, bool, out);
     GF_OPTION_RECONF("strict-locks", conf->strict_locks, options, bool, out);
+    GF_OPTION_RECONF("create-write-compound", conf->create_write_compound,
+                     options, bool, out);
 
     ret = 0;
 out:
@@ -3013,6 +3171,16 @@ struct volume_options options[] = {
                     "necessary for stricter lock complaince as bricks "
                     "cleanup any granted locks when a client "
                     "disconnects."},
+    {.key = {"create-write-compound"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE,
+     .description = "When set, glfs_creat_write() sends the create, the "
+                    "write and the close of a small file to the brick as a "
+                    "single request. The write is not seen by the "
+                    "translators above protocol/client (io-stats, "
+                    "write-behind, utime, caches...)."},
     {.key = {NULL}},
 };
 
@@ -158,6 +158,10 @@ typedef struct clnt_conf {
                                   complaince as bricks cleanup any granted
                                   locks when a client disconnects.
                                */
+    gf_boolean_t create_write_compound; /* send the data of a create as a
+                                           create + write + flush compound */
+    uint32_t server_op_version; /* given by the brick at handshake, 0 if it
+                                   is older than 9.0 */
 
 } clnt_conf_t;
 
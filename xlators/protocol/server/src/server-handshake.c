@@ -636,6 +636,9 @@ server_setvolume(rpcsvc_request_t *req)
             /* TODO: what is this ? */
             client->bound_xl->itable = inode_table_new(conf->inode_lru_limit,
                                                        client->bound_xl);
+            if (client->bound_xl->itable && conf->inode_table_stripes)
+                inode_table_set_lock_stripes(client->bound_xl->itable,
+                                             conf->inode_table_stripes);
         }
     }
     UNLOCK(&conf->itable_lock);
@@ -658,6 +661,11 @@ server_setvolume(rpcsvc_request_t *req)
     if (ret)
         gf_msg_debug(this->name, 0, "failed to set 'transport-ptr'");
 
+    /* lets the client know which fops it can send */
+    ret = dict_set_uint32(reply, "opversion", GD_OP_VERSION_MAX);
+    if (ret)
+        gf_msg_debug(this->name, 0, "failed to set 'opversion'");
+
 fail:
     /* It is important to validate the lookup on '/' as part of handshake,
        because if lookup itself can't succeed, we should communicate this
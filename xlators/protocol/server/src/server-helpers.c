@@ -166,6 +166,54 @@ server_resolve_wipe(server_resolve_t *resolve)
     loc_wipe(&resolve->resolve_loc);
 }
 
+static void
+server_compound_free(server_compound_t *compound)
+{
+    compound_rsp_v2 *rsp = NULL;
+    gfx_dict *xdata = NULL;
+    u_int i = 0;
+
+    for (i = 0; compound->rsp &&
+                (i < compound->req.compound_req_array.compound_req_array_len);
+         i++) {
+        rsp = &compound->rsp[i];
+        switch (rsp->fop_enum) {
+            case GF_FOP_CREATE:
+                xdata = &rsp->compound_rsp_v2_u.compound_create_rsp.xdata;
+                break;
+            case GF_FOP_OPEN:
+                xdata = &rsp->compound_rsp_v2_u.compound_open_rsp.xdata;
+                break;
+            case GF_FOP_WRITE:
+                xdata = &rsp->compound_rsp_v2_u.compound_write_rsp.xdata;
+                break;
+            case GF_FOP_FSETXATTR:
+                xdata = &rsp->compound_rsp_v2_u.compound_fsetxattr_rsp.xdata;
+                break;
+            case GF_FOP_FSETATTR:
+                xdata = &rsp->compound_rsp_v2_u.compound_fsetattr_rsp.xdata;
+                break;
+            case GF_FOP_FSYNC:
+                xdata = &rsp->compound_rsp_v2_u.compound_fsync_rsp.xdata;
+                break;
+            case GF_FOP_FLUSH:
+                xdata = &rsp->compound_rsp_v2_u.compound_flush_rsp.xdata;
+                break;
+            default:
+                xdata = NULL;
+                break;
+        }
+        if (xdata)
+            GF_FREE(xdata->pairs.pairs_val);
+    }
+
+    /* the request was allocated by the XDR decoder */
+    xdr_free((xdrproc_t)xdr_gfx_compound_req, (char *)&compound->req);
+
+    GF_FREE(compound->rsp);
+    GF_FREE(compound);
+}
+
 void
 free_state(server_state_t *state)
 {
@@ -199,6 +247,11 @@ free_state(server_state_t *state)
         state->xdata = NULL;
     }
 
+    if (state->compound) {
+        server_compound_free(state->compound);
+        state->compound = NULL;
+    }
+
     GF_FREE((void *)state->volume);
 
     GF_FREE((void *)state->name);
@@ -593,6 +646,12 @@ server_build_config(xlator_t *this, server_conf_t *conf)
         conf->inode_lru_limit = 16384;
     }
 
+    ret = dict_get_int32(this->options, "inode-table-stripes",
+                         &conf->inode_table_stripes);
+    if (ret < 0) {
+        conf->inode_table_stripes = 0;
+    }
+
     conf->verify_volfile = 1;
     data = dict_get(this->options, "verify-volfile-checksum");
     if (data) {
@@ -5956,11 +5956,531 @@ out:
     return ret;
 }
 
+static int
+server4_compound_wind(call_frame_t *frame);
+
+static int
+server4_compound_reply(call_frame_t *frame, int32_t op_ret, int32_t op_errno)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    rpcsvc_request_t *req = NULL;
+    gfx_compound_rsp rsp = {
+        0,
+    };
+
+    dict_to_xdr(NULL, &rsp.xdata);
+
+    rsp.op_ret = op_ret;
+    rsp.op_errno = gf_errno_to_error(op_errno);
+    rsp.compound_rsp_array.compound_rsp_array_len = compound->index;
+    rsp.compound_rsp_array.compound_rsp_array_val = compound->rsp;
+
+    req = frame->local;
+    server_submit_reply(frame, req, &rsp, NULL, 0, NULL,
+                        (xdrproc_t)xdr_gfx_compound_rsp);
+
+    return 0;
+}
+
+/* Called when the current fop is done: the next one is sent, or the reply
+ * if it failed or it was the last one. */
+static int
+server4_compound_next(call_frame_t *frame, int32_t op_ret, int32_t op_errno)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+
+    compound->index++;
+    if (op_ret < 0)
+        return server4_compound_reply(frame, -1, op_errno);
+
+    if (compound->index == compound->req.compound_req_array
+                                .compound_req_array_len)
+        return server4_compound_reply(frame, 0, 0);
+
+    return server4_compound_wind(frame);
+}
+
+static void
+server4_compound_log(call_frame_t *frame, xlator_t *this, int32_t op_errno)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    int fop = compound->rsp[compound->index].fop_enum;
+
+    gf_msg(this->name, fop_log_level(fop, op_errno), op_errno,
+           PS_MSG_COMPOUND_INFO,
+           "%" PRId64 ": COMPOUND%d (%s) %s (%s), client: %s, "
+           "error-xlator: %s",
+           frame->root->unique, compound->index, gf_fop_list[fop],
+           state->loc.path, uuid_utoa(state->resolve.gfid),
+           STACK_CLIENT_NAME(frame->root), STACK_ERR_XL_NAME(frame->root));
+}
+
+static int
+server4_compound_create_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno, fd_t *fd,
+                            inode_t *inode, struct iatt *stbuf,
+                            struct iatt *preparent, struct iatt *postparent,
+                            dict_t *xdata)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    gfx_create_rsp *rsp = NULL;
+
+    rsp = &compound->rsp[compound->index].compound_rsp_v2_u.compound_create_rsp;
+    dict_to_xdr(xdata, &rsp->xdata);
+
+    if (op_ret < 0) {
+        server4_compound_log(frame, this, op_errno);
+        goto out;
+    }
+
+    op_ret = server4_post_create(frame, rsp, state, this, fd, inode, stbuf,
+                                 preparent, postparent);
+    if (op_ret) {
+        op_errno = -op_ret;
+        op_ret = -1;
+    }
+
+out:
+    rsp->op_ret = op_ret;
+    rsp->op_errno = gf_errno_to_error(op_errno);
+
+    return server4_compound_next(frame, op_ret, op_errno);
+}
+
+static int
+server4_compound_open_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                          int32_t op_ret, int32_t op_errno, fd_t *fd,
+                          dict_t *xdata)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    gfx_open_rsp *rsp = NULL;
+
+    rsp = &compound->rsp[compound->index].compound_rsp_v2_u.compound_open_rsp;
+    dict_to_xdr(xdata, &rsp->xdata);
+
+    if (op_ret < 0) {
+        server4_compound_log(frame, this, op_errno);
+        goto out;
+    }
+
+    op_ret = server4_post_open(frame, this, rsp, fd);
+
+out:
+    rsp->op_ret = op_ret;
+    rsp->op_errno = gf_errno_to_error(op_errno);
+
+    return server4_compound_next(frame, op_ret, op_errno);
+}
+
+/* writev, fsetattr and fsync */
+static int
+server4_compound_2iatt_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                           int32_t op_ret, int32_t op_errno,
+                           struct iatt *prebuf, struct iatt *postbuf,
+                           dict_t *xdata)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    compound_rsp_v2 *crsp = &compound->rsp[compound->index];
+    gfx_common_2iatt_rsp *rsp = NULL;
+
+    if (crsp->fop_enum == GF_FOP_WRITE)
+        rsp = &crsp->compound_rsp_v2_u.compound_write_rsp;
+    else if (crsp->fop_enum == GF_FOP_FSETATTR)
+        rsp = &crsp->compound_rsp_v2_u.compound_fsetattr_rsp;
+    else
+        rsp = &crsp->compound_rsp_v2_u.compound_fsync_rsp;
+
+    dict_to_xdr(xdata, &rsp->xdata);
+
+    if (op_ret < 0) {
+        server4_compound_log(frame, this, op_errno);
+        goto out;
+    }
+
+    server4_post_common_2iatt(rsp, prebuf, postbuf);
+
+out:
+    rsp->op_ret = op_ret;
+    rsp->op_errno = gf_errno_to_error(op_errno);
+
+    return server4_compound_next(frame, op_ret, op_errno);
+}
+
+/* fsetxattr and flush */
+static int
+server4_compound_common_cbk(call_frame_t *frame, void *cookie, xlator_t *this,
+                            int32_t op_ret, int32_t op_errno, dict_t *xdata)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    compound_rsp_v2 *crsp = &compound->rsp[compound->index];
+    gfx_common_rsp *rsp = NULL;
+
+    if (crsp->fop_enum == GF_FOP_FSETXATTR)
+        rsp = &crsp->compound_rsp_v2_u.compound_fsetxattr_rsp;
+    else
+        rsp = &crsp->compound_rsp_v2_u.compound_flush_rsp;
+
+    dict_to_xdr(xdata, &rsp->xdata);
+
+    if (op_ret < 0)
+        server4_compound_log(frame, this, op_errno);
+
+    rsp->op_ret = op_ret;
+    rsp->op_errno = gf_errno_to_error(op_errno);
+
+    return server4_compound_next(frame, op_ret, op_errno);
+}
+
+/* Sends the current fop of the chain. Nothing in the state can be used
+ * after the wind, the reply may already have been sent. */
+static int
+server4_compound_wind(call_frame_t *frame)
+{
+    server_state_t *state = CALL_STATE(frame);
+    server_compound_t *compound = state->compound;
+    xlator_t *bound_xl = frame->root->client->bound_xl;
+    compound_req_v2 *creq = NULL;
+    gfx_write_req *write_req = NULL;
+    struct iovec vector[MAX_IOVEC];
+    struct iovec *vec = vector;
+    struct iatt stbuf = {
+        0,
+    };
+    dict_t *xdata = NULL;
+    dict_t *dict = NULL;
+    int count = 0;
+    int op_errno = ENOMEM;
+
+    creq = &compound->req.compound_req_array
+                .compound_req_array_val[compound->index];
+    compound->rsp[compound->index].fop_enum = creq->fop_enum;
+
+    switch (creq->fop_enum) {
+        case GF_FOP_CREATE:
+            if (xdr_to_dict(&creq->compound_req_v2_u.compound_create_req.xdata,
+                            &xdata))
+                goto err;
+
+            state->loc.inode = inode_new(state->itable);
+            state->fd = fd_create(state->loc.inode, frame->root->pid);
+            if (!state->fd) {
+                gf_msg("server", GF_LOG_ERROR, 0, PS_MSG_FD_CREATE_FAILED,
+                       "fd creation for the inode %s failed",
+                       state->loc.inode ? uuid_utoa(state->loc.inode->gfid)
+                                        : NULL);
+                goto err;
+            }
+            state->fd->flags = state->flags;
+
+            STACK_WIND(frame, server4_compound_create_cbk, bound_xl,
+                       bound_xl->fops->create, &state->loc, state->flags,
+                       state->mode, state->umask, state->fd, xdata);
+            break;
+        case GF_FOP_OPEN:
+            if (xdr_to_dict(&creq->compound_req_v2_u.compound_open_req.xdata,
+                            &xdata))
+                goto err;
+
+            state->fd = fd_create(state->loc.inode, frame->root->pid);
+            if (!state->fd)
+                goto err;
+            state->fd->flags = state->flags;
+
+            STACK_WIND(frame, server4_compound_open_cbk, bound_xl,
+                       bound_xl->fops->open, &state->loc, state->flags,
+                       state->fd, xdata);
+            break;
+        case GF_FOP_WRITE:
+            write_req = &creq->compound_req_v2_u.compound_write_req;
+            if (xdr_to_dict(&write_req->xdata, &xdata))
+                goto err;
+
+            count = iov_subset(state->payload_vector, state->payload_count,
+                               compound->payload_offset, write_req->size,
+                               &vec, MAX_IOVEC);
+            if (count < 0) {
+                op_errno = EINVAL;
+                goto err;
+            }
+            compound->payload_offset += write_req->size;
+
+            STACK_WIND(frame, server4_compound_2iatt_cbk, bound_xl,
+                       bound_xl->fops->writev, state->fd, vector, count,
+                       write_req->offset, write_req->flag, state->iobref,
+                       xdata);
+            break;
+        case GF_FOP_FSETXATTR:
+            if (xdr_to_dict(
+                    &creq->compound_req_v2_u.compound_fsetxattr_req.dict,
+                    &dict) ||
+                xdr_to_dict(
+                    &creq->compound_req_v2_u.compound_fsetxattr_req.xdata,
+                    &xdata))
+                goto err;
+
+            STACK_WIND(frame, server4_compound_common_cbk, bound_xl,
+                       bound_xl->fops->fsetxattr, state->fd, dict,
+                       creq->compound_req_v2_u.compound_fsetxattr_req.flags,
+                       xdata);
+            break;
+        case GF_FOP_FSETATTR:
+            if (xdr_to_dict(
+                    &creq->compound_req_v2_u.compound_fsetattr_req.xdata,
+                    &xdata))
+                goto err;
+
+            gfx_stat_to_iattx(
+                &creq->compound_req_v2_u.compound_fsetattr_req.stbuf, &stbuf);
+
+            STACK_WIND(frame, server4_compound_2iatt_cbk, bound_xl,
+                       bound_xl->fops->fsetattr, state->fd, &stbuf,
+                       creq->compound_req_v2_u.compound_fsetattr_req.valid,
+                       xdata);
+            break;
+        case GF_FOP_FSYNC:
+            if (xdr_to_dict(&creq->compound_req_v2_u.compound_fsync_req.xdata,
+                            &xdata))
+                goto err;
+
+            STACK_WIND(frame, server4_compound_2iatt_cbk, bound_xl,
+                       bound_xl->fops->fsync, state->fd,
+                       creq->compound_req_v2_u.compound_fsync_req.data, xdata);
+            break;
+        case GF_FOP_FLUSH:
+            if (xdr_to_dict(&creq->compound_req_v2_u.compound_flush_req.xdata,
+                            &xdata))
+                goto err;
+
+            STACK_WIND(frame, server4_compound_common_cbk, bound_xl,
+                       bound_xl->fops->flush, state->fd, xdata);
+            break;
+        default:
+            op_errno = ENOTSUP;
+            goto err;
+    }
+
+    if (dict)
+        dict_unref(dict);
+    if (xdata)
+        dict_unref(xdata);
+
+    return 0;
+
+err:
+    if (dict)
+        dict_unref(dict);
+    if (xdata)
+        dict_unref(xdata);
+
+    switch (creq->fop_enum) {
+        case GF_FOP_CREATE:
+            return server4_compound_create_cbk(frame, NULL, frame->this, -1,
+                                               op_errno, NULL, NULL, NULL,
+                                               NULL, NULL, NULL);
+        case GF_FOP_OPEN:
+            return server4_compound_open_cbk(frame, NULL, frame->this, -1,
+                                             op_errno, NULL, NULL);
+        case GF_FOP_WRITE:
+        case GF_FOP_FSETATTR:
+        case GF_FOP_FSYNC:
+            return server4_compound_2iatt_cbk(frame, NULL, frame->this, -1,
+                                              op_errno, NULL, NULL, NULL);
+        default:
+            return server4_compound_common_cbk(frame, NULL, frame->this, -1,
+                                               op_errno, NULL);
+    }
+}
+
+int
+server4_compound_resume(call_frame_t *frame, xlator_t *bound_xl)
+{
+    server_state_t *state = NULL;
+
+    state = CALL_STATE(frame);
+
+    if (state->resolve.op_ret != 0)
+        return server4_compound_reply(frame, state->resolve.op_ret,
+                                      state->resolve.op_errno);
+
+    return server4_compound_wind(frame);
+}
+
+/* Only the first fop of the chain is resolved, the following ones are done
+ * on its fd. The data of the writes follows the request, in order. */
 int
 server4_0_compound(rpcsvc_request_t *req)
 {
+    server_state_t *state = NULL;
+    call_frame_t *frame = NULL;
+    server_compound_t *compound = NULL;
+    compound_req_v2 *creq = NULL;
+    gfx_compound_req args = {
+        0,
+    };
+    ssize_t len = 0;
+    size_t size = 0;
+    gf_boolean_t valid = _gf_true;
+    u_int count = 0;
+    u_int i = 0;
     int ret = -1;
-    SERVER_REQ_SET_ERROR(req, ret);
+
+    if (!req)
+        return ret;
+
+    ret = rpc_receive_common(req, &frame, &state, &len, &args,
+                             xdr_gfx_compound_req, GF_FOP_COMPOUND);
+    if (ret != 0)
+        goto out;
+
+    ret = -1;
+    count = args.compound_req_array.compound_req_array_len;
+    creq = args.compound_req_array.compound_req_array_val;
+    if ((count == 0) || (count > GF_COMPOUND_MAX_FOPS)) {
+        SERVER_REQ_SET_ERROR(req, ret);
+        goto out;
+    }
+
+    for (i = 0; i < count; i++) {
+        switch (creq[i].fop_enum) {
+            case GF_FOP_CREATE:
+            case GF_FOP_OPEN:
+                valid = (i == 0);
+                break;
+            case GF_FOP_WRITE:
+                size += creq[i].compound_req_v2_u.compound_write_req.size;
+                break;
+            case GF_FOP_FSETXATTR:
+            case GF_FOP_FSETATTR:
+            case GF_FOP_FSYNC:
+            case GF_FOP_FLUSH:
+                break;
+            default:
+                valid = _gf_false;
+                break;
+        }
+
+        if (!valid) {
+            gf_msg(frame->this->name, GF_LOG_WARNING, EINVAL,
+                   PS_MSG_COMPOUND_INFO,
+                   "%" PRId64 ": COMPOUND: fop %d can't be at index %u",
+                   frame->root->unique, creq[i].fop_enum, i);
+            SERVER_REQ_SET_ERROR(req, ret);
+            goto out;
+        }
+    }
+
+    switch (creq[0].fop_enum) {
+        case GF_FOP_CREATE:
+            state->resolve.bname = gf_strdup(
+                creq[0].compound_req_v2_u.compound_create_req.bname);
+            state->mode = creq[0].compound_req_v2_u.compound_create_req.mode;
+            state->umask = creq[0].compound_req_v2_u.compound_create_req.umask;
+            state->flags = gf_flags_to_flags(
+                creq[0].compound_req_v2_u.compound_create_req.flags);
+            set_resolve_gfid(
+                frame->root->client, state->resolve.pargfid,
+                creq[0].compound_req_v2_u.compound_create_req.pargfid);
+            if (state->flags & O_EXCL)
+                state->resolve.type = RESOLVE_NOT;
+            else
+                state->resolve.type = RESOLVE_DONTCARE;
+            break;
+        case GF_FOP_OPEN:
+            state->resolve.type = RESOLVE_MUST;
+            memcpy(state->resolve.gfid,
+                   creq[0].compound_req_v2_u.compound_open_req.gfid, 16);
+            state->flags = gf_flags_to_flags(
+                creq[0].compound_req_v2_u.compound_open_req.flags);
+            break;
+        case GF_FOP_WRITE:
+            state->resolve.type = RESOLVE_MUST;
+            state->resolve.fd_no =
+                creq[0].compound_req_v2_u.compound_write_req.fd;
+            memcpy(state->resolve.gfid,
+                   creq[0].compound_req_v2_u.compound_write_req.gfid, 16);
+            break;
+        case GF_FOP_FSETXATTR:
+            state->resolve.type = RESOLVE_MUST;
+            state->resolve.fd_no =
+                creq[0].compound_req_v2_u.compound_fsetxattr_req.fd;
+            set_resolve_gfid(
+                frame->root->client, state->resolve.gfid,
+                creq[0].compound_req_v2_u.compound_fsetxattr_req.gfid);
+            break;
+        case GF_FOP_FSETATTR:
+            state->resolve.type = RESOLVE_MUST;
+            state->resolve.fd_no =
+                creq[0].compound_req_v2_u.compound_fsetattr_req.fd;
+            memcpy(state->resolve.gfid,
+                   creq[0].compound_req_v2_u.compound_fsetattr_req.gfid, 16);
+            break;
+        case GF_FOP_FSYNC:
+            state->resolve.type = RESOLVE_MUST;
+            state->resolve.fd_no =
+                creq[0].compound_req_v2_u.compound_fsync_req.fd;
+            memcpy(state->resolve.gfid,
+                   creq[0].compound_req_v2_u.compound_fsync_req.gfid, 16);
+            break;
+        default:
+            state->resolve.type = RESOLVE_MUST;
+            state->resolve.fd_no =
+                creq[0].compound_req_v2_u.compound_flush_req.fd;
+            memcpy(state->resolve.gfid,
+                   creq[0].compound_req_v2_u.compound_flush_req.gfid, 16);
+            break;
+    }
+
+    state->iobref = iobref_ref(req->iobref);
+    if (len < req->msg[0].iov_len) {
+        state->payload_vector[0].iov_base = (req->msg[0].iov_base + len);
+        state->payload_vector[0].iov_len = req->msg[0].iov_len - len;
+        state->payload_count = 1;
+    }
+
+    for (i = 1; i < req->count; i++) {
+        state->payload_vector[state->payload_count++] = req->msg[i];
+    }
+
+    if (iov_length(state->payload_vector, state->payload_count) != size) {
+        gf_msg(frame->this->name, GF_LOG_WARNING, EINVAL, PS_MSG_COMPOUND_INFO,
+               "%" PRId64 ": COMPOUND: payload doesn't match the writes",
+               frame->root->unique);
+        SERVER_REQ_SET_ERROR(req, ret);
+        goto out;
+    }
+
+    compound = GF_CALLOC(1, sizeof(*compound), gf_server_mt_compound_rsp_t);
+    if (!compound) {
+        SERVER_REQ_SET_ERROR(req, ret);
+        goto out;
+    }
+    compound->rsp = GF_CALLOC(count, sizeof(*compound->rsp),
+                              gf_server_mt_compound_rsp_t);
+    if (!compound->rsp) {
+        GF_FREE(compound);
+        SERVER_REQ_SET_ERROR(req, ret);
+        goto out;
+    }
+
+    /* owned by the state from now on */
+    compound->req = args;
+    state->compound = compound;
+
+    ret = 0;
+    resolve_and_resume(frame, server4_compound_resume);
+
+    return ret;
+
+out:
+    xdr_free((xdrproc_t)xdr_gfx_compound_req, (char *)&args);
+
     return ret;
 }
 
@@ -239,6 +239,8 @@ server_priv(xlator_t *this)
     };
     uint64_t total_read = 0;
     uint64_t total_write = 0;
+    uint64_t total_msgs = 0;
+    uint64_t total_writes = 0;
     int32_t ret = -1;
 
     GF_VALIDATE_OR_GOTO("server", this, out);
@@ -258,6 +260,8 @@ server_priv(xlator_t *this)
         {
             total_read += xprt->total_bytes_read;
             total_write += xprt->total_bytes_write;
+            total_msgs += xprt->total_msgs_write;
+            total_writes += xprt->total_writes;
         }
     }
     pthread_mutex_unlock(&conf->mutex);
@@ -268,6 +272,16 @@ server_priv(xlator_t *this)
     gf_proc_dump_build_key(key, "server", "total-bytes-write");
     gf_proc_dump_write(key, "%" PRIu64, total_write);
 
+    gf_proc_dump_build_key(key, "server", "total-msgs-write");
+    gf_proc_dump_write(key, "%" PRIu64, total_msgs);
+
+    gf_proc_dump_build_key(key, "server", "total-write-calls");
+    gf_proc_dump_write(key, "%" PRIu64, total_writes);
+
+    gf_proc_dump_build_key(key, "server", "msgs-per-write");
+    gf_proc_dump_write(key, "%.2f",
+                       total_writes ? (double)total_msgs / total_writes : 0.0);
+
     ret = 0;
 out:
     if (ret)
@@ -1756,6 +1770,18 @@ struct volume_options server_options[] = {
                     "in the lru list of the inode cache.",
      .op_version = {1},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"inode-table-stripes"},
+     .type = GF_OPTION_TYPE_INT,
+     .min = 0,
+     .max = GF_INODE_TABLE_MAX_STRIPES,
+     .default_value = "0",
+     .description = "Number of locks protecting the hash tables of the "
+                    "inode table. When not 0, lookups and most inode "
+                    "ref/unref don't take the global inode table lock and "
+                    "pruning is done in background. Only applies to inode "
+                    "tables created after the option is set.",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"trace"}, .type = GF_OPTION_TYPE_BOOL},
     {
         .key = {"config-directory", "conf-dir"},
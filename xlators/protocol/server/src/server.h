@@ -57,6 +57,7 @@ struct server_conf {
     rpcsvc_t *rpc;
     struct rpcsvc_config rpc_conf;
     int inode_lru_limit;
+    int inode_table_stripes;
     gf_boolean_t verify_volfile;
     gf_boolean_t trace;
     char *conf_dir;
@@ -114,6 +115,16 @@ typedef int (*server_resume_fn_t)(call_frame_t *frame, xlator_t *bound_xl);
 int
 resolve_and_resume(call_frame_t *frame, server_resume_fn_t fn);
 
+/* A compound request: the fops are done in order on the fd created or
+ * opened by the first one (or resolved for it), and a single reply is sent
+ * with the result of each of them. */
+typedef struct server_compound {
+    gfx_compound_req req;
+    compound_rsp_v2 *rsp;
+    int index;               /* fop being done */
+    uint32_t payload_offset; /* data of the next write in payload_vector */
+} server_compound_t;
+
 struct _server_state {
     rpc_transport_t *xprt;
     inode_table_t *itable;
@@ -185,6 +196,8 @@ struct _server_state {
 
     /* subdir mount */
     client_t *client;
+
+    server_compound_t *compound;
 };
 
 extern struct rpcsvc_program gluster_handshake_prog;
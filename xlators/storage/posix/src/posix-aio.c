@@ -10,10 +10,49 @@
 #include "posix.h"
 #include <sys/uio.h>
 #include "posix-messages.h"
+#include <glusterfs/async.h>
 
 #ifdef HAVE_LIBAIO
 #include <libaio.h>
 
+struct posix_aio_cb {
+    struct iocb iocb;
+    gf_async_t async;
+    call_frame_t *frame;
+    struct iobuf *iobuf;
+    struct iobref *iobref;
+    struct iatt prebuf;
+    int _fd;
+    fd_t *fd;
+    int op;
+    off_t offset;
+    size_t size;
+    long res;
+    struct iovec iov;
+
+    /* Writes keep a copy of the caller's vector in 'vec', the request
+     * can be submitted after the call stub holding it is destroyed.
+     *
+     * Requests of the same fd merged into this one. They are submitted as a
+     * single iocb and 'vec' holds the vectors of all of them. */
+    struct posix_aio_cb *next;
+    struct iovec *vec;
+    int vec_size; /* entries allocated in 'vec' */
+    off_t end;
+    int nr_reqs;
+};
+
+static int
+posix_fd_want_odirect(fd_t *fd, int opflags, off_t offset, size_t size)
+{
+    /* if instructed, use O_DIRECT always */
+    if ((fd->flags | opflags) & O_DIRECT)
+        return 1;
+
+    /* else use O_DIRECT when feasible */
+    return ((offset | size) & 0xfff) ? 0 : 1;
+}
+
 void
 __posix_fd_set_odirect(fd_t *fd, struct posix_fd *pfd, int opflags,
                        off_t offset, size_t size)
@@ -22,18 +61,7 @@ __posix_fd_set_odirect(fd_t *fd, struct posix_fd *pfd, int opflags,
     int flags = 0;
     int ret = 0;
 
-    odirect = pfd->odirect;
-
-    if ((fd->flags | opflags) & O_DIRECT) {
-        /* if instructed, use O_DIRECT always */
-        odirect = 1;
-    } else {
-        /* else use O_DIRECT when feasible */
-        if ((offset | size) & 0xfff)
-            odirect = 0;
-        else
-            odirect = 1;
-    }
+    odirect = posix_fd_want_odirect(fd, opflags, offset, size);
 
     if (!odirect && pfd->odirect) {
         flags = fcntl(pfd->fd, F_GETFL);
@@ -54,17 +82,192 @@ __posix_fd_set_odirect(fd_t *fd, struct posix_fd *pfd, int opflags,
     }
 }
 
-struct posix_aio_cb {
-    struct iocb iocb;
-    call_frame_t *frame;
-    struct iobuf *iobuf;
-    struct iobref *iobref;
-    struct iatt prebuf;
-    int _fd;
-    fd_t *fd;
-    int op;
-    off_t offset;
-};
+/* Tries to append 'paiocb' to the queued request of the same fd that ends
+ * where it starts, so that both are done with a single iocb. */
+static gf_boolean_t
+__posix_aio_merge(struct posix_private *priv, struct posix_aio_cb *paiocb,
+                  struct iovec *iov, int count)
+{
+    struct posix_aio_cb *head = NULL;
+    struct posix_aio_cb *tail = NULL;
+    struct iovec *vec = NULL;
+    int nr = 0;
+    int i = 0;
+
+    for (i = priv->aio_sq_count - 1; i >= 0; i--) {
+        head = priv->aio_sq[i]->data;
+        if ((head->_fd == paiocb->_fd) && (head->op == paiocb->op))
+            break;
+    }
+
+    if ((i < 0) || (head->end != paiocb->offset))
+        return _gf_false;
+
+    nr = head->iocb.u.v.nr;
+    if ((head->nr_reqs >= POSIX_AIO_MAX_MERGE) ||
+        (nr + count > POSIX_AIO_MAX_MERGE_IOVS))
+        return _gf_false;
+
+    if (head->vec_size < POSIX_AIO_MAX_MERGE_IOVS) {
+        vec = GF_MALLOC(POSIX_AIO_MAX_MERGE_IOVS * sizeof(*vec),
+                        gf_common_mt_iovec);
+        if (!vec)
+            return _gf_false;
+        memcpy(vec, head->iocb.u.v.vec, nr * sizeof(*vec));
+        GF_FREE(head->vec);
+        head->vec = vec;
+        head->vec_size = POSIX_AIO_MAX_MERGE_IOVS;
+        head->iocb.u.v.vec = vec;
+    }
+
+    memcpy(head->vec + nr, iov, count * sizeof(*iov));
+    head->iocb.u.v.nr = nr + count;
+
+    for (tail = head; tail->next; tail = tail->next)
+        ;
+    tail->next = paiocb;
+    head->end += paiocb->size;
+    head->nr_reqs++;
+
+    GF_ATOMIC_INC(priv->aio_merged);
+
+    return _gf_true;
+}
+
+static void
+posix_aio_complete(xlator_t *this, gf_async_t *async);
+
+/* Hands the result of an iocb to the requests merged into it. They are
+ * unwound from the async workers so that the thread reaping the events
+ * only has to reap them. */
+static void
+posix_aio_dispatch(xlator_t *this, struct posix_aio_cb *paiocb, long res)
+{
+    struct posix_aio_cb *next = NULL;
+    long len = 0;
+
+    for (; paiocb; paiocb = next) {
+        next = paiocb->next;
+
+        if (res < 0) {
+            paiocb->res = res;
+        } else {
+            len = min(res, (long)paiocb->size);
+            paiocb->res = len;
+            res -= len;
+        }
+
+        gf_async(&paiocb->async, this, posix_aio_complete);
+    }
+}
+
+static void
+__posix_aio_submit(xlator_t *this)
+{
+    struct posix_private *priv = NULL;
+    struct posix_aio_cb *paiocb = NULL;
+    int done = 0;
+    int ret = 0;
+
+    priv = this->private;
+
+    while (done < priv->aio_sq_count) {
+        ret = io_submit(priv->ctxp, priv->aio_sq_count - done,
+                        &priv->aio_sq[done]);
+        if (ret > 0) {
+            GF_ATOMIC_INC(priv->aio_submits);
+            done += ret;
+            continue;
+        }
+
+        /* The error refers to the first iocb, the others are retried */
+        paiocb = priv->aio_sq[done]->data;
+        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_IO_SUBMIT_FAILED,
+               "io_submit() returned %d,gfid=%s", ret,
+               uuid_utoa(paiocb->fd->inode->gfid));
+        posix_aio_dispatch(this, paiocb, ret ? ret : -EAGAIN);
+        done++;
+    }
+
+    priv->aio_sq_count = 0;
+}
+
+static void
+posix_aio_flush(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+
+    pthread_mutex_lock(&priv->aio_sq_mutex);
+    {
+        __posix_aio_submit(this);
+    }
+    pthread_mutex_unlock(&priv->aio_sq_mutex);
+}
+
+/* Requests done with O_DIRECT are queued and all the requests queued by
+ * concurrent callers are submitted with a single io_submit(): the thread
+ * that takes the queue lock last submits on behalf of the others. Buffered
+ * requests are submitted right away since io_submit() does them
+ * synchronously and batching them would serialize them in one thread. */
+static void
+posix_aio_submit(xlator_t *this, struct posix_fd *pfd,
+                 struct posix_aio_cb *paiocb, struct iovec *iov, int count,
+                 uint32_t flags)
+{
+    struct posix_private *priv = NULL;
+    struct iocb *iocb = &paiocb->iocb;
+    fd_t *fd = paiocb->fd;
+    int ret = 1;
+
+    priv = this->private;
+
+    paiocb->end = paiocb->offset + paiocb->size;
+    paiocb->nr_reqs = 1;
+
+    /* The queued requests are O_DIRECT ones, submit them before the fd
+     * leaves that mode. Done outside of the fd lock since io_submit() can
+     * block; a request queued meanwhile is still correctly aligned and is
+     * merely done through the page cache. */
+    if (pfd->odirect && !posix_fd_want_odirect(fd, flags, paiocb->offset,
+                                               paiocb->size))
+        posix_aio_flush(this);
+
+    LOCK(&fd->lock);
+    {
+        __posix_fd_set_odirect(fd, pfd, flags, paiocb->offset, paiocb->size);
+
+        GF_ATOMIC_INC(priv->aio_requests);
+
+        if (!pfd->odirect) {
+            ret = io_submit(priv->ctxp, 1, &iocb);
+            if (ret == 1)
+                GF_ATOMIC_INC(priv->aio_submits);
+        } else {
+            GF_ATOMIC_INC(priv->aio_sq_waiters);
+            pthread_mutex_lock(&priv->aio_sq_mutex);
+            GF_ATOMIC_DEC(priv->aio_sq_waiters);
+            {
+                if (!__posix_aio_merge(priv, paiocb, iov, count)) {
+                    if (priv->aio_sq_count == POSIX_AIO_MAX_NR_EVENTS)
+                        __posix_aio_submit(this);
+                    priv->aio_sq[priv->aio_sq_count++] = iocb;
+                }
+
+                if (GF_ATOMIC_GET(priv->aio_sq_waiters) == 0)
+                    __posix_aio_submit(this);
+            }
+            pthread_mutex_unlock(&priv->aio_sq_mutex);
+        }
+    }
+    UNLOCK(&fd->lock);
+
+    if (ret != 1) {
+        gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_IO_SUBMIT_FAILED,
+               "io_submit() returned %d,gfid=%s", ret,
+               uuid_utoa(fd->inode->gfid));
+        posix_aio_dispatch(this, paiocb, ret ? ret : -EAGAIN);
+    }
+}
 
 int
 posix_aio_readv_complete(struct posix_aio_cb *paiocb, int res, int res2)
@@ -97,9 +300,9 @@ posix_aio_readv_complete(struct posix_aio_cb *paiocb, int res, int res2)
         op_ret = -1;
         op_errno = -res;
         gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_READV_FAILED,
-               "readv(async) failed fd=%d,size=%lu,offset=%llu (%d)", _fd,
-               paiocb->iocb.u.c.nbytes, (unsigned long long)paiocb->offset,
-               res);
+               "readv(async) failed fd=%d,size=%" GF_PRI_SIZET
+               ",offset=%llu (%d)",
+               _fd, paiocb->size, (unsigned long long)paiocb->offset, res);
         goto out;
     }
 
@@ -144,6 +347,7 @@ out:
     if (paiocb->fd)
         fd_unref(paiocb->fd);
 
+    GF_FREE(paiocb->vec);
     GF_FREE(paiocb);
 
     return 0;
@@ -159,15 +363,11 @@ posix_aio_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     struct posix_fd *pfd = NULL;
     int ret = -1;
     struct posix_aio_cb *paiocb = NULL;
-    struct posix_private *priv = NULL;
-    struct iocb *iocb = NULL;
 
     VALIDATE_OR_GOTO(frame, err);
     VALIDATE_OR_GOTO(this, err);
     VALIDATE_OR_GOTO(fd, err);
 
-    priv = this->private;
-
     ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
     if (ret < 0) {
         gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
@@ -202,30 +402,19 @@ posix_aio_readv(call_frame_t *frame, xlator_t *this, fd_t *fd, size_t size,
     paiocb->_fd = _fd;
     paiocb->op = GF_FOP_READ;
 
+    paiocb->size = size;
+    paiocb->iov.iov_base = iobuf_ptr(iobuf);
+    paiocb->iov.iov_len = size;
+
     paiocb->iocb.data = paiocb;
     paiocb->iocb.aio_fildes = _fd;
-    paiocb->iocb.aio_lio_opcode = IO_CMD_PREAD;
+    paiocb->iocb.aio_lio_opcode = IO_CMD_PREADV;
     paiocb->iocb.aio_reqprio = 0;
-    paiocb->iocb.u.c.buf = iobuf_ptr(iobuf);
-    paiocb->iocb.u.c.nbytes = size;
-    paiocb->iocb.u.c.offset = offset;
-
-    iocb = &paiocb->iocb;
-
-    LOCK(&fd->lock);
-    {
-        __posix_fd_set_odirect(fd, pfd, flags, offset, size);
-
-        ret = io_submit(priv->ctxp, 1, &iocb);
-    }
-    UNLOCK(&fd->lock);
+    paiocb->iocb.u.v.vec = &paiocb->iov;
+    paiocb->iocb.u.v.nr = 1;
+    paiocb->iocb.u.v.offset = offset;
 
-    if (ret != 1) {
-        op_errno = -ret;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_IO_SUBMIT_FAILED,
-               "io_submit() returned %d", ret);
-        goto err;
-    }
+    posix_aio_submit(this, pfd, paiocb, &paiocb->iov, 1, flags);
 
     return 0;
 err:
@@ -306,6 +495,7 @@ out:
             iobref_unref(paiocb->iobref);
         if (paiocb->fd)
             fd_unref(paiocb->fd);
+        GF_FREE(paiocb->vec);
         GF_FREE(paiocb);
     }
 
@@ -323,7 +513,6 @@ posix_aio_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
     int ret = -1;
     struct posix_aio_cb *paiocb = NULL;
     struct posix_private *priv = NULL;
-    struct iocb *iocb = NULL;
 
     VALIDATE_OR_GOTO(frame, err);
     VALIDATE_OR_GOTO(this, err);
@@ -351,18 +540,23 @@ posix_aio_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
     paiocb->fd = fd_ref(fd);
     paiocb->_fd = _fd;
     paiocb->op = GF_FOP_WRITE;
+    paiocb->size = iov_length(iov, count);
 
     paiocb->iocb.data = paiocb;
     paiocb->iocb.aio_fildes = _fd;
     paiocb->iobref = iobref_ref(iobref);
     paiocb->iocb.aio_lio_opcode = IO_CMD_PWRITEV;
     paiocb->iocb.aio_reqprio = 0;
-    paiocb->iocb.u.v.vec = iov;
+    paiocb->vec = iov_dup(iov, count);
+    if (!paiocb->vec) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+    paiocb->vec_size = count;
+    paiocb->iocb.u.v.vec = paiocb->vec;
     paiocb->iocb.u.v.nr = count;
     paiocb->iocb.u.v.offset = offset;
 
-    iocb = &paiocb->iocb;
-
     ret = posix_fdstat(this, fd->inode, _fd, &paiocb->prebuf);
     if (ret != 0) {
         op_errno = errno;
@@ -371,21 +565,7 @@ posix_aio_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
         goto err;
     }
 
-    LOCK(&fd->lock);
-    {
-        __posix_fd_set_odirect(fd, pfd, flags, offset, iov_length(iov, count));
-
-        ret = io_submit(priv->ctxp, 1, &iocb);
-    }
-    UNLOCK(&fd->lock);
-
-    if (ret != 1) {
-        op_errno = -ret;
-        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_IO_SUBMIT_FAILED,
-               "io_submit() returned %d,gfid=%s", ret,
-               uuid_utoa(fd->inode->gfid));
-        goto err;
-    }
+    posix_aio_submit(this, pfd, paiocb, paiocb->vec, count, flags);
 
     return 0;
 err:
@@ -396,12 +576,34 @@ err:
             iobref_unref(paiocb->iobref);
         if (paiocb->fd)
             fd_unref(paiocb->fd);
+        GF_FREE(paiocb->vec);
         GF_FREE(paiocb);
     }
 
     return 0;
 }
 
+static void
+posix_aio_complete(xlator_t *this, gf_async_t *async)
+{
+    struct posix_aio_cb *paiocb = NULL;
+
+    paiocb = caa_container_of(async, struct posix_aio_cb, async);
+
+    switch (paiocb->op) {
+        case GF_FOP_READ:
+            posix_aio_readv_complete(paiocb, paiocb->res, 0);
+            break;
+        case GF_FOP_WRITE:
+            posix_aio_writev_complete(paiocb, paiocb->res, 0);
+            break;
+        default:
+            gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_UNKNOWN_OP,
+                   "unknown op %d found in piocb", paiocb->op);
+            break;
+    }
+}
+
 void *
 posix_aio_thread(void *data)
 {
@@ -411,7 +613,6 @@ posix_aio_thread(void *data)
     int i = 0;
     struct io_event events[POSIX_AIO_MAX_NR_GETEVENTS];
     struct io_event *event = NULL;
-    struct posix_aio_cb *paiocb = NULL;
 
     this = data;
     THIS = this;
@@ -432,20 +633,7 @@ posix_aio_thread(void *data)
         for (i = 0; i < ret; i++) {
             event = &events[i];
 
-            paiocb = event->data;
-
-            switch (paiocb->op) {
-                case GF_FOP_READ:
-                    posix_aio_readv_complete(paiocb, event->res, event->res2);
-                    break;
-                case GF_FOP_WRITE:
-                    posix_aio_writev_complete(paiocb, event->res, event->res2);
-                    break;
-                default:
-                    gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_UNKNOWN_OP,
-                           "unknown op %d found in piocb", paiocb->op);
-                    break;
-            }
+            posix_aio_dispatch(this, event->data, event->res);
         }
     }
 
@@ -475,9 +663,17 @@ posix_aio_init(xlator_t *this)
         goto out;
     }
 
+    pthread_mutex_init(&priv->aio_sq_mutex, NULL);
+    GF_ATOMIC_INIT(priv->aio_sq_waiters, 0);
+    GF_ATOMIC_INIT(priv->aio_requests, 0);
+    GF_ATOMIC_INIT(priv->aio_submits, 0);
+    GF_ATOMIC_INIT(priv->aio_merged, 0);
+    priv->aio_sq_count = 0;
+
     ret = gf_thread_create(&priv->aiothread, NULL, posix_aio_thread, this,
                            "posixaio");
     if (ret != 0) {
+        pthread_mutex_destroy(&priv->aio_sq_mutex);
         io_destroy(priv->ctxp);
         goto out;
     }
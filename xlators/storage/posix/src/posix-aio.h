@@ -15,7 +15,12 @@
 #define POSIX_AIO_MAX_NR_EVENTS 256
 
 // Maximum number of completed IO operations to reap per getevents syscall
-#define POSIX_AIO_MAX_NR_GETEVENTS 16
+#define POSIX_AIO_MAX_NR_GETEVENTS 64
+
+// Maximum number of contiguous requests of an fd merged into one iocb, and
+// of vectors of the merged iocb
+#define POSIX_AIO_MAX_MERGE 16
+#define POSIX_AIO_MAX_MERGE_IOVS 64
 
 int
 posix_aio_on(xlator_t *this);
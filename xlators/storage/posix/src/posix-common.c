@@ -46,6 +46,7 @@
 #include <glusterfs/timer.h>
 #include "glusterfs3-xdr.h"
 #include "posix-aio.h"
+#include "posix-io-uring.h"
 #include <glusterfs/glusterfs-acl.h>
 #include "posix-messages.h"
 #include <glusterfs/events.h>
@@ -119,6 +120,26 @@ posix_priv(xlator_t *this)
     gf_proc_dump_write("max_read", "%" PRId64, GF_ATOMIC_GET(priv->read_value));
     gf_proc_dump_write("max_write", "%" PRId64,
                        GF_ATOMIC_GET(priv->write_value));
+#ifdef HAVE_LIBAIO
+    if (priv->aio_capable) {
+        gf_proc_dump_write("aio.requests", "%" PRId64,
+                           GF_ATOMIC_GET(priv->aio_requests));
+        gf_proc_dump_write("aio.submits", "%" PRId64,
+                           GF_ATOMIC_GET(priv->aio_submits));
+        gf_proc_dump_write("aio.merged", "%" PRId64,
+                           GF_ATOMIC_GET(priv->aio_merged));
+    }
+#endif
+#ifdef HAVE_LIBURING
+    if (priv->io_uring_capable) {
+        gf_proc_dump_write("io_uring.requests", "%" PRId64,
+                           GF_ATOMIC_GET(priv->uring_sqes));
+        gf_proc_dump_write("io_uring.submits", "%" PRId64,
+                           GF_ATOMIC_GET(priv->uring_submits));
+        gf_proc_dump_write("io_uring.fixed_buffers", "%d",
+                           priv->uring_fixed_count);
+    }
+#endif
 
     return 0;
 }
@@ -345,11 +366,25 @@ posix_reconfigure(xlator_t *this, dict_t *options)
 #endif
 
     GF_OPTION_RECONF("linux-aio", priv->aio_configured, options, bool, out);
+    GF_OPTION_RECONF("linux-io_uring", priv->io_uring_configured, options,
+                     bool, out);
 
-    if (priv->aio_configured)
-        posix_aio_on(this);
-    else
+    if (priv->aio_configured && priv->io_uring_configured) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_INVALID_OPTION,
+               "linux-aio and linux-io_uring cannot be enabled together");
+        goto out;
+    }
+
+    if (priv->io_uring_configured) {
         posix_aio_off(this);
+        posix_io_uring_on(this);
+    } else {
+        posix_io_uring_off(this);
+        if (priv->aio_configured)
+            posix_aio_on(this);
+        else
+            posix_aio_off(this);
+    }
 
     GF_OPTION_RECONF("update-link-count-parent", priv->update_pgfid_nlinks,
                      options, bool, out);
@@ -966,6 +1001,8 @@ posix_init(xlator_t *this)
 
     _private->aio_init_done = _gf_false;
     _private->aio_capable = _gf_false;
+    _private->io_uring_init_done = _gf_false;
+    _private->io_uring_capable = _gf_false;
 
     GF_OPTION_INIT("brick-uid", uid, int32, out);
     GF_OPTION_INIT("brick-gid", gid, int32, out);
@@ -974,6 +1011,15 @@ posix_init(xlator_t *this)
 
     GF_OPTION_INIT("linux-aio", _private->aio_configured, bool, out);
 
+    GF_OPTION_INIT("linux-io_uring", _private->io_uring_configured, bool, out);
+
+    if (_private->aio_configured && _private->io_uring_configured) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_INVALID_OPTION,
+               "linux-aio and linux-io_uring cannot be enabled together");
+        ret = -1;
+        goto out;
+    }
+
     if (_private->aio_configured) {
         op_ret = posix_aio_on(this);
 
@@ -985,6 +1031,17 @@ posix_init(xlator_t *this)
         }
     }
 
+    if (_private->io_uring_configured) {
+        op_ret = posix_io_uring_on(this);
+
+        if (op_ret == -1) {
+            gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_POSIX_AIO,
+                   "Posix io_uring init failed");
+            ret = -1;
+            goto out;
+        }
+    }
+
     GF_OPTION_INIT("node-uuid-pathinfo", _private->node_uuid_pathinfo, bool,
                    out);
     if (_private->node_uuid_pathinfo &&
@@ -1165,6 +1222,9 @@ posix_fini(xlator_t *this)
         (void)gf_thread_cleanup_xint(priv->fsyncer);
         priv->fsyncer = 0;
     }
+
+    posix_io_uring_fini(this);
+
     /*unlock brick dir*/
     if (priv->mount_lock)
         (void)sys_closedir(priv->mount_lock);
@@ -1211,6 +1271,15 @@ struct volume_options posix_options[] = {
      .description = "Support for native Linux AIO",
      .op_version = {1},
      .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
+    {.key = {"linux-io_uring"},
+     .type = GF_OPTION_TYPE_BOOL,
+     .default_value = "off",
+     .description = "Use io_uring for readv, writev, fsync and fallocate. "
+                    "Requests are batched in a ring and completed by a "
+                    "dedicated thread instead of blocking io-threads. "
+                    "Cannot be enabled together with linux-aio.",
+     .op_version = {GD_OP_VERSION_9_0},
+     .flags = OPT_FLAG_SETTABLE | OPT_FLAG_DOC},
     {.key = {"brick-uid"},
      .type = GF_OPTION_TYPE_INT,
      .min = -1,
@@ -0,0 +1,994 @@
+/*
+   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#include "posix.h"
+#include <sys/uio.h>
+#include "posix-messages.h"
+#include "posix-handle.h"
+#include "posix-metadata.h"
+#include "posix-io-uring.h"
+
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+
+#define ALIGN_SIZE 4096
+
+/*
+ * io_uring engine.
+ *
+ * readv, writev, fsync and fallocate are queued in a ring shared by all the
+ * io-threads, and are completed (and unwound) by a dedicated thread that
+ * reaps the completion queue. The fops that need to be serialized with
+ * other writes (appends, atomic updates), O_SYNC writes, unaligned writes
+ * to O_DIRECT fds and the cloudsync ones keep using the synchronous
+ * implementation.
+ *
+ * Submission queue entries are prepared under sq_mutex. The thread holding
+ * the mutex only enters the kernel when nobody else is waiting to queue a
+ * request; otherwise the next holder submits its entries together with its
+ * own, so a burst of fops costs a single io_uring_enter().
+ *
+ * The arenas of the iobuf pool are pinned and registered as fixed buffers
+ * at init, and reads and single vector writes landing in them use the
+ * READ_FIXED/WRITE_FIXED opcodes, which saves the kernel from mapping the
+ * pages for every request. Only the arenas which exist at that time are
+ * registered: buffers of the arenas the pool adds later are not found by
+ * posix_io_uring_fixed_index() and go through the regular READV/WRITEV
+ * opcodes. Replacing the registered set would need the ring to be idle.
+ *
+ * The fops table is shared by all the posix instances of a multiplexed
+ * brick, so every fop checks that its own instance has a ring.
+ */
+
+struct posix_uring_req {
+    call_frame_t *frame;
+    fd_t *fd;
+    int _fd;
+    glusterfs_fop_t op;
+    off_t offset;
+    size_t size;
+    struct iovec iov;
+    struct iovec *vector; /* writev: copy of the caller's vector, which
+                             can be gone before the entry is submitted */
+    struct iobuf *iobuf;
+    struct iobref *iobref;
+    dict_t *xdata;
+    struct iatt prebuf;
+};
+
+static gf_boolean_t
+posix_io_uring_need_sync(dict_t *xdata)
+{
+    if (!xdata)
+        return _gf_false;
+
+    return (dict_get_sizen(xdata, GF_CS_OBJECT_STATUS) ||
+            dict_get_sizen(xdata, GF_CS_OBJECT_REPAIR) ||
+            dict_get_sizen(xdata, GLUSTERFS_WRITE_IS_APPEND) ||
+            dict_get_sizen(xdata, GLUSTERFS_WRITE_UPDATE_ATOMIC));
+}
+
+/* O_DIRECT needs the buffers, their sizes and the offset to be aligned.
+ * posix_writev() bounces unaligned buffers through an aligned one. */
+static gf_boolean_t
+posix_io_uring_aligned(struct iovec *iov, int count, off_t offset)
+{
+    int i = 0;
+
+    if (offset % ALIGN_SIZE)
+        return _gf_false;
+
+    for (i = 0; i < count; i++) {
+        if (((uintptr_t)iov[i].iov_base | iov[i].iov_len) % ALIGN_SIZE)
+            return _gf_false;
+    }
+
+    return _gf_true;
+}
+
+static int
+posix_io_uring_fixed_index(struct posix_private *priv, void *buf, size_t size)
+{
+    struct iobuf_arena *arena = NULL;
+    int i = 0;
+
+    for (i = 0; i < priv->uring_fixed_count; i++) {
+        arena = priv->uring_fixed_arenas[i];
+        if ((char *)buf >= (char *)arena->mem_base &&
+            (char *)buf + size <= (char *)arena->mem_base + arena->arena_size)
+            return i;
+    }
+
+    return -1;
+}
+
+static struct posix_uring_req *
+posix_io_uring_req_new(call_frame_t *frame, fd_t *fd, int _fd,
+                       glusterfs_fop_t op, off_t offset)
+{
+    struct posix_uring_req *req = NULL;
+
+    req = GF_CALLOC(1, sizeof(*req), gf_posix_mt_uring_req);
+    if (!req)
+        return NULL;
+
+    req->frame = frame;
+    req->fd = fd_ref(fd);
+    req->_fd = _fd;
+    req->op = op;
+    req->offset = offset;
+
+    return req;
+}
+
+static void
+posix_io_uring_req_free(struct posix_uring_req *req)
+{
+    if (req->iobuf)
+        iobuf_unref(req->iobuf);
+    if (req->iobref)
+        iobref_unref(req->iobref);
+    if (req->xdata)
+        dict_unref(req->xdata);
+    if (req->fd)
+        fd_unref(req->fd);
+
+    GF_FREE(req->vector);
+    GF_FREE(req);
+}
+
+static void
+posix_io_uring_sqe_set_req(struct posix_private *priv,
+                           struct io_uring_sqe *sqe,
+                           struct posix_uring_req *req)
+{
+    io_uring_sqe_set_data(sqe, req);
+    GF_ATOMIC_INC(priv->uring_inflight);
+}
+
+/* Takes sq_mutex and returns a free submission queue entry. The caller
+ * must call posix_io_uring_submit() even if NULL is returned. */
+static struct io_uring_sqe *
+posix_io_uring_get_sqe(struct posix_private *priv)
+{
+    struct io_uring_sqe *sqe = NULL;
+    int ret = 0;
+
+    GF_ATOMIC_INC(priv->uring_sq_waiters);
+    pthread_mutex_lock(&priv->uring_sq_mutex);
+    GF_ATOMIC_DEC(priv->uring_sq_waiters);
+
+    sqe = io_uring_get_sqe(&priv->ring);
+    if (!sqe) {
+        /* The queue is full of entries nobody has submitted yet. */
+        ret = io_uring_submit(&priv->ring);
+        if (ret > 0) {
+            GF_ATOMIC_INC(priv->uring_submits);
+            GF_ATOMIC_ADD(priv->uring_sqes, ret);
+        }
+        sqe = io_uring_get_sqe(&priv->ring);
+    }
+
+    return sqe;
+}
+
+static void
+__posix_io_uring_submit(xlator_t *this, struct posix_private *priv)
+{
+    int ret = 0;
+
+    if (!io_uring_sq_ready(&priv->ring))
+        return;
+
+    ret = io_uring_submit(&priv->ring);
+    if (ret < 0) {
+        /* The entries stay in the queue, they are submitted again by the
+         * next fop or by the completion thread. */
+        gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_IO_SUBMIT_FAILED,
+               "io_uring_submit() returned %d", ret);
+        return;
+    }
+
+    GF_ATOMIC_INC(priv->uring_submits);
+    GF_ATOMIC_ADD(priv->uring_sqes, ret);
+}
+
+/* Submits the queued entries, unless another thread is about to queue its
+ * own and will submit them all at once, and releases sq_mutex. */
+static void
+posix_io_uring_submit(xlator_t *this, struct posix_private *priv)
+{
+    if (GF_ATOMIC_GET(priv->uring_sq_waiters) == 0)
+        __posix_io_uring_submit(this, priv);
+
+    pthread_mutex_unlock(&priv->uring_sq_mutex);
+}
+
+static void
+posix_io_uring_readv_complete(struct posix_uring_req *req, int res)
+{
+    call_frame_t *frame = req->frame;
+    xlator_t *this = frame->this;
+    struct posix_private *priv = this->private;
+    fd_t *fd = req->fd;
+    struct iobref *iobref = NULL;
+    struct iovec iov = {
+        0,
+    };
+    struct iatt postbuf = {
+        0,
+    };
+    int op_ret = -1;
+    int op_errno = 0;
+    int ret = 0;
+
+    if (res < 0) {
+        op_errno = -res;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_READV_FAILED,
+               "readv(io_uring) failed fd=%d,size=%" GF_PRI_SIZET
+               ",offset=%llu (%d)",
+               req->_fd, req->size, (unsigned long long)req->offset, res);
+        goto out;
+    }
+
+    ret = posix_fdstat(this, fd->inode, req->_fd, &postbuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+               "fstat failed on fd=%d", req->_fd);
+        goto out;
+    }
+
+    iobref = iobref_new();
+    if (!iobref) {
+        op_errno = ENOMEM;
+        goto out;
+    }
+
+    iobref_add(iobref, req->iobuf);
+
+    iov.iov_base = iobuf_ptr(req->iobuf);
+    iov.iov_len = res;
+
+    posix_set_ctime(frame, this, NULL, req->_fd, fd->inode, &postbuf);
+
+    /* Hack to notify higher layers of EOF. */
+    if (!postbuf.ia_size || (req->offset + iov.iov_len) >= postbuf.ia_size)
+        op_errno = ENOENT;
+
+    GF_ATOMIC_ADD(priv->read_value, res);
+    op_ret = res;
+
+out:
+    STACK_UNWIND_STRICT(readv, frame, op_ret, op_errno, &iov, 1, &postbuf,
+                        iobref, NULL);
+    if (iobref)
+        iobref_unref(iobref);
+}
+
+static int32_t
+posix_io_uring_readv(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     size_t size, off_t offset, uint32_t flags, dict_t *xdata)
+{
+    int32_t op_errno = EINVAL;
+    struct posix_private *priv = NULL;
+    struct posix_fd *pfd = NULL;
+    struct posix_uring_req *req = NULL;
+    struct io_uring_sqe *sqe = NULL;
+    int index = -1;
+    int ret = -1;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd, err);
+    VALIDATE_OR_GOTO(fd->inode, err);
+
+    priv = this->private;
+
+    if (!priv->io_uring_capable || posix_io_uring_need_sync(xdata) ||
+        (fd->inode->ia_type == IA_IFBLK) || (fd->inode->ia_type == IA_IFCHR))
+        return posix_readv(frame, this, fd, size, offset, flags, xdata);
+
+    ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+               "pfd is NULL from fd=%p", fd);
+        goto err;
+    }
+
+    if (!size) {
+        op_errno = EINVAL;
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_INVALID_ARGUMENT,
+               "size=%" GF_PRI_SIZET, size);
+        goto err;
+    }
+
+    req = posix_io_uring_req_new(frame, fd, pfd->fd, GF_FOP_READ, offset);
+    if (!req) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    req->iobuf = iobuf_get_page_aligned(this->ctx->iobuf_pool, size,
+                                        ALIGN_SIZE);
+    if (!req->iobuf) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    req->size = size;
+    req->iov.iov_base = iobuf_ptr(req->iobuf);
+    req->iov.iov_len = size;
+    index = posix_io_uring_fixed_index(priv, req->iov.iov_base, size);
+
+    sqe = posix_io_uring_get_sqe(priv);
+    if (sqe) {
+        if (index >= 0)
+            io_uring_prep_read_fixed(sqe, req->_fd, req->iov.iov_base, size,
+                                     offset, index);
+        else
+            io_uring_prep_readv(sqe, req->_fd, &req->iov, 1, offset);
+        posix_io_uring_sqe_set_req(priv, sqe, req);
+    }
+    posix_io_uring_submit(this, priv);
+
+    if (!sqe) {
+        posix_io_uring_req_free(req);
+        return posix_readv(frame, this, fd, size, offset, flags, xdata);
+    }
+
+    return 0;
+err:
+    STACK_UNWIND_STRICT(readv, frame, -1, op_errno, NULL, 0, NULL, NULL,
+                        NULL);
+    if (req)
+        posix_io_uring_req_free(req);
+
+    return 0;
+}
+
+static void
+posix_io_uring_writev_complete(struct posix_uring_req *req, int res)
+{
+    call_frame_t *frame = req->frame;
+    xlator_t *this = frame->this;
+    struct posix_private *priv = this->private;
+    fd_t *fd = req->fd;
+    dict_t *rsp_xdata = NULL;
+    struct iatt postbuf = {
+        0,
+    };
+    int op_ret = -1;
+    int op_errno = 0;
+    int ret = 0;
+
+    if (res < 0) {
+        op_errno = -res;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_WRITEV_FAILED,
+               "writev(io_uring) failed fd=%d,offset=%llu (%d)", req->_fd,
+               (unsigned long long)req->offset, res);
+        goto out;
+    }
+
+    rsp_xdata = _fill_writev_xdata(fd, req->xdata, this, 0);
+
+    ret = posix_fdstat(this, fd->inode, req->_fd, &postbuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+               "fstat failed on fd=%d", req->_fd);
+        goto out;
+    }
+
+    posix_set_ctime(frame, this, NULL, req->_fd, fd->inode, &postbuf);
+
+    GF_ATOMIC_ADD(priv->write_value, res);
+    op_ret = res;
+
+out:
+    STACK_UNWIND_STRICT(writev, frame, op_ret, op_errno, &req->prebuf,
+                        &postbuf, rsp_xdata);
+    if (rsp_xdata)
+        dict_unref(rsp_xdata);
+}
+
+static int32_t
+posix_io_uring_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                      struct iovec *iov, int32_t count, off_t offset,
+                      uint32_t flags, struct iobref *iobref, dict_t *xdata)
+{
+    int32_t op_errno = EINVAL;
+    struct posix_private *priv = NULL;
+    struct posix_fd *pfd = NULL;
+    struct posix_uring_req *req = NULL;
+    struct io_uring_sqe *sqe = NULL;
+    int index = -1;
+    int ret = -1;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd, err);
+    VALIDATE_OR_GOTO(fd->inode, err);
+    VALIDATE_OR_GOTO(iov, err);
+
+    priv = this->private;
+
+    if (!priv->io_uring_capable || posix_io_uring_need_sync(xdata) ||
+        (flags & (O_SYNC | O_DSYNC)) || (fd->inode->ia_type == IA_IFBLK) ||
+        (fd->inode->ia_type == IA_IFCHR))
+        return posix_writev(frame, this, fd, iov, count, offset, flags,
+                            iobref, xdata);
+
+    DISK_SPACE_CHECK_AND_GOTO(frame, priv, xdata, op_errno, op_errno, err);
+
+    ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+               "pfd is NULL from fd=%p", fd);
+        goto err;
+    }
+
+    if ((pfd->flags & O_DIRECT) && !posix_io_uring_aligned(iov, count, offset))
+        return posix_writev(frame, this, fd, iov, count, offset, flags,
+                            iobref, xdata);
+
+    ret = posix_check_internal_writes(this, fd, pfd->fd, xdata);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_ERROR, 0, 0,
+               "possible overwrite from internal client, fd=%p", fd);
+        op_errno = EBUSY;
+        goto err;
+    }
+
+    req = posix_io_uring_req_new(frame, fd, pfd->fd, GF_FOP_WRITE, offset);
+    if (!req) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    if (iobref)
+        req->iobref = iobref_ref(iobref);
+    if (xdata)
+        req->xdata = dict_ref(xdata);
+
+    ret = posix_fdstat(this, fd->inode, req->_fd, &req->prebuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+               "pre-operation fstat failed on fd=%p", fd);
+        goto err;
+    }
+
+    if (count == 1)
+        index = posix_io_uring_fixed_index(priv, iov[0].iov_base,
+                                           iov[0].iov_len);
+
+    if (index < 0) {
+        req->vector = iov_dup(iov, count);
+        if (!req->vector) {
+            op_errno = ENOMEM;
+            goto err;
+        }
+    }
+
+    sqe = posix_io_uring_get_sqe(priv);
+    if (sqe) {
+        if (index >= 0)
+            io_uring_prep_write_fixed(sqe, req->_fd, iov[0].iov_base,
+                                      iov[0].iov_len, offset, index);
+        else
+            io_uring_prep_writev(sqe, req->_fd, req->vector, count, offset);
+        posix_io_uring_sqe_set_req(priv, sqe, req);
+    }
+    posix_io_uring_submit(this, priv);
+
+    if (!sqe) {
+        posix_io_uring_req_free(req);
+        return posix_writev(frame, this, fd, iov, count, offset, flags,
+                            iobref, xdata);
+    }
+
+    return 0;
+err:
+    STACK_UNWIND_STRICT(writev, frame, -1, op_errno, NULL, NULL, NULL);
+    if (req)
+        posix_io_uring_req_free(req);
+
+    return 0;
+}
+
+static void
+posix_io_uring_fsync_complete(struct posix_uring_req *req, int res)
+{
+    call_frame_t *frame = req->frame;
+    xlator_t *this = frame->this;
+    struct iatt postbuf = {
+        0,
+    };
+    int op_ret = -1;
+    int op_errno = 0;
+    int ret = 0;
+
+    if (res < 0) {
+        op_errno = -res;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSYNC_FAILED,
+               "fsync(io_uring) on fd=%d failed", req->_fd);
+        goto out;
+    }
+
+    ret = posix_fdstat(this, req->fd->inode, req->_fd, &postbuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_FSTAT_FAILED,
+               "post-operation fstat failed on fd=%d", req->_fd);
+        goto out;
+    }
+
+    op_ret = 0;
+
+out:
+    STACK_UNWIND_STRICT(fsync, frame, op_ret, op_errno, &req->prebuf,
+                        &postbuf, NULL);
+}
+
+static int32_t
+posix_io_uring_fsync(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                     int32_t datasync, dict_t *xdata)
+{
+    int32_t op_errno = EINVAL;
+    struct posix_private *priv = NULL;
+    struct posix_fd *pfd = NULL;
+    struct posix_uring_req *req = NULL;
+    struct io_uring_sqe *sqe = NULL;
+    int ret = -1;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd, err);
+
+    priv = this->private;
+
+    if (!priv->io_uring_capable ||
+        (priv->batch_fsync_mode && xdata && dict_get(xdata, "batch-fsync")))
+        return posix_fsync(frame, this, fd, datasync, xdata);
+
+    ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_PFD_NULL,
+               "pfd not found in fd's ctx");
+        goto err;
+    }
+
+    req = posix_io_uring_req_new(frame, fd, pfd->fd, GF_FOP_FSYNC, 0);
+    if (!req) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+
+    ret = posix_fdstat(this, fd->inode, req->_fd, &req->prebuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_WARNING, op_errno, P_MSG_FSTAT_FAILED,
+               "pre-operation fstat failed on fd=%p", fd);
+        goto err;
+    }
+
+    sqe = posix_io_uring_get_sqe(priv);
+    if (sqe) {
+        io_uring_prep_fsync(sqe, req->_fd,
+                            datasync ? IORING_FSYNC_DATASYNC : 0);
+        posix_io_uring_sqe_set_req(priv, sqe, req);
+    }
+    posix_io_uring_submit(this, priv);
+
+    if (!sqe) {
+        posix_io_uring_req_free(req);
+        return posix_fsync(frame, this, fd, datasync, xdata);
+    }
+
+    return 0;
+err:
+    STACK_UNWIND_STRICT(fsync, frame, -1, op_errno, NULL, NULL, NULL);
+    if (req)
+        posix_io_uring_req_free(req);
+
+    return 0;
+}
+
+static void
+posix_io_uring_fallocate_complete(struct posix_uring_req *req, int res)
+{
+    call_frame_t *frame = req->frame;
+    xlator_t *this = frame->this;
+    struct iatt postbuf = {
+        0,
+    };
+    int op_ret = -1;
+    int op_errno = 0;
+    int ret = 0;
+
+    if (res < 0) {
+        op_errno = -res;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FALLOCATE_FAILED,
+               "fallocate(io_uring) failed on %s offset: %jd, "
+               "len:%zu",
+               uuid_utoa(req->fd->inode->gfid), req->offset, req->size);
+        goto out;
+    }
+
+    ret = posix_fdstat(this, req->fd->inode, req->_fd, &postbuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+               "fallocate (fstat) failed on fd=%d", req->_fd);
+        goto out;
+    }
+
+    posix_set_ctime(frame, this, NULL, req->_fd, req->fd->inode, &postbuf);
+
+    op_ret = 0;
+
+out:
+    STACK_UNWIND_STRICT(fallocate, frame, op_ret, op_errno, &req->prebuf,
+                        &postbuf, NULL);
+}
+
+static int32_t
+posix_io_uring_fallocate(call_frame_t *frame, xlator_t *this, fd_t *fd,
+                         int32_t keep_size, off_t offset, size_t len,
+                         dict_t *xdata)
+{
+    int32_t op_errno = EINVAL;
+    int32_t flags = 0;
+    struct posix_private *priv = NULL;
+    struct posix_fd *pfd = NULL;
+    struct posix_uring_req *req = NULL;
+    struct io_uring_sqe *sqe = NULL;
+    int ret = -1;
+
+    VALIDATE_OR_GOTO(frame, err);
+    VALIDATE_OR_GOTO(this, err);
+    VALIDATE_OR_GOTO(fd, err);
+
+    priv = this->private;
+
+    if (!priv->io_uring_capable || posix_io_uring_need_sync(xdata))
+        return posix_glfallocate(frame, this, fd, keep_size, offset, len,
+                                 xdata);
+
+    /* see posix_do_fallocate() */
+    if (priv->disk_reserve)
+        posix_disk_space_check(this);
+
+    DISK_SPACE_CHECK_AND_GOTO(frame, priv, xdata, op_errno, op_errno, err);
+
+#ifdef FALLOC_FL_KEEP_SIZE
+    if (keep_size)
+        flags = FALLOC_FL_KEEP_SIZE;
+#endif /* FALLOC_FL_KEEP_SIZE */
+
+    ret = posix_fd_ctx_get(fd, this, &pfd, &op_errno);
+    if (ret < 0) {
+        gf_msg_debug(this->name, 0, "pfd is NULL from fd=%p", fd);
+        goto err;
+    }
+
+    req = posix_io_uring_req_new(frame, fd, pfd->fd, GF_FOP_FALLOCATE,
+                                 offset);
+    if (!req) {
+        op_errno = ENOMEM;
+        goto err;
+    }
+    req->size = len;
+
+    ret = posix_fdstat(this, fd->inode, req->_fd, &req->prebuf);
+    if (ret != 0) {
+        op_errno = errno;
+        gf_msg(this->name, GF_LOG_ERROR, op_errno, P_MSG_FSTAT_FAILED,
+               "fallocate (fstat) failed on fd=%p", fd);
+        goto err;
+    }
+
+    sqe = posix_io_uring_get_sqe(priv);
+    if (sqe) {
+        io_uring_prep_fallocate(sqe, req->_fd, flags, offset, len);
+        posix_io_uring_sqe_set_req(priv, sqe, req);
+    }
+    posix_io_uring_submit(this, priv);
+
+    if (!sqe) {
+        posix_io_uring_req_free(req);
+        return posix_glfallocate(frame, this, fd, keep_size, offset, len,
+                                 xdata);
+    }
+
+    return 0;
+err:
+    STACK_UNWIND_STRICT(fallocate, frame, -1, op_errno, NULL, NULL, NULL);
+    if (req)
+        posix_io_uring_req_free(req);
+
+    return 0;
+}
+
+static void
+posix_io_uring_complete(xlator_t *this, struct posix_uring_req *req, int res)
+{
+    switch (req->op) {
+        case GF_FOP_READ:
+            posix_io_uring_readv_complete(req, res);
+            break;
+        case GF_FOP_WRITE:
+            posix_io_uring_writev_complete(req, res);
+            break;
+        case GF_FOP_FSYNC:
+            posix_io_uring_fsync_complete(req, res);
+            break;
+        case GF_FOP_FALLOCATE:
+            posix_io_uring_fallocate_complete(req, res);
+            break;
+        default:
+            gf_msg(this->name, GF_LOG_ERROR, 0, P_MSG_UNKNOWN_OP,
+                   "unknown op %d found in io_uring request", req->op);
+            break;
+    }
+
+    posix_io_uring_req_free(req);
+}
+
+static void *
+posix_io_uring_thread(void *data)
+{
+    xlator_t *this = NULL;
+    struct posix_private *priv = NULL;
+    struct io_uring_cqe *cqes[POSIX_IO_URING_MAX_NR_CQES];
+    struct posix_uring_req *reqs[POSIX_IO_URING_MAX_NR_CQES];
+    int res[POSIX_IO_URING_MAX_NR_CQES];
+    struct io_uring_cqe *cqe = NULL;
+    gf_boolean_t stop = _gf_false;
+    unsigned int count = 0;
+    unsigned int i = 0;
+    int ret = 0;
+
+    this = data;
+    THIS = this;
+    priv = this->private;
+
+    /* Once stopped, keep reaping until the requests still in the ring
+     * are completed, so that their frames are unwound. */
+    while (!stop || GF_ATOMIC_GET(priv->uring_inflight) > 0) {
+        ret = io_uring_wait_cqe(&priv->ring, &cqe);
+        if (ret < 0) {
+            if (ret == -EINTR || ret == -EAGAIN)
+                continue;
+            gf_msg(this->name, GF_LOG_ERROR, -ret, P_MSG_IO_GETEVENTS_FAILED,
+                   "io_uring_wait_cqe() returned %d", ret);
+            break;
+        }
+
+        /* Reap everything that has completed, and give the entries back
+         * to the kernel before unwinding, which can take a while. */
+        count = io_uring_peek_batch_cqe(&priv->ring, cqes,
+                                        POSIX_IO_URING_MAX_NR_CQES);
+        for (i = 0; i < count; i++) {
+            reqs[i] = io_uring_cqe_get_data(cqes[i]);
+            res[i] = cqes[i]->res;
+        }
+        io_uring_cq_advance(&priv->ring, count);
+
+        /* Entries left behind by a failed submission. If the mutex is
+         * taken, its owner submits them. */
+        if (pthread_mutex_trylock(&priv->uring_sq_mutex) == 0) {
+            __posix_io_uring_submit(this, priv);
+            pthread_mutex_unlock(&priv->uring_sq_mutex);
+        }
+
+        for (i = 0; i < count; i++) {
+            /* posix_io_uring_fini() sends a NOP without request */
+            if (!reqs[i]) {
+                stop = _gf_true;
+                continue;
+            }
+            posix_io_uring_complete(this, reqs[i], res[i]);
+            GF_ATOMIC_DEC(priv->uring_inflight);
+        }
+    }
+
+    return NULL;
+}
+
+/* Arenas the iobuf pool adds after this are not registered, see above. */
+static void
+posix_io_uring_register_arenas(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct iovec iov[POSIX_IO_URING_MAX_FIXED_BUFS];
+    int count = 0;
+    int ret = 0;
+    int i = 0;
+
+    count = iobuf_pool_pin_arenas(this->ctx->iobuf_pool,
+                                  priv->uring_fixed_arenas,
+                                  POSIX_IO_URING_MAX_FIXED_BUFS);
+    if (!count)
+        return;
+
+    for (i = 0; i < count; i++) {
+        iov[i].iov_base = priv->uring_fixed_arenas[i]->mem_base;
+        iov[i].iov_len = priv->uring_fixed_arenas[i]->arena_size;
+    }
+
+    ret = io_uring_register_buffers(&priv->ring, iov, count);
+    if (ret < 0) {
+        /* Most likely RLIMIT_MEMLOCK, this is not fatal */
+        gf_msg(this->name, GF_LOG_INFO, -ret, P_MSG_IO_SETUP_FAILED,
+               "io_uring_register_buffers() failed. ret=%d. Continuing "
+               "without fixed buffers",
+               ret);
+        iobuf_pool_unpin_arenas(this->ctx->iobuf_pool, priv->uring_fixed_arenas,
+                                count);
+        return;
+    }
+
+    priv->uring_fixed_count = count;
+}
+
+static int
+posix_io_uring_init(xlator_t *this)
+{
+    struct posix_private *priv = NULL;
+    struct io_uring_probe *probe = NULL;
+    int ret = 0;
+
+    priv = this->private;
+
+    ret = io_uring_queue_init(POSIX_IO_URING_NR_ENTRIES, &priv->ring, 0);
+    if (ret == -ENOSYS) {
+        gf_msg(this->name, GF_LOG_WARNING, 0, P_MSG_IO_URING_UNAVAILABLE,
+               "Linux io_uring not available at run-time."
+               " Continuing with synchronous IO");
+        return 0;
+    }
+
+    if (ret < 0) {
+        gf_msg(this->name, GF_LOG_WARNING, -ret, P_MSG_IO_SETUP_FAILED,
+               "io_uring_queue_init() failed. ret=%d", ret);
+        return -1;
+    }
+
+    /* fallocate is only there since Linux 5.6 */
+    probe = io_uring_get_probe_ring(&priv->ring);
+    if (probe) {
+        priv->uring_fallocate = io_uring_opcode_supported(probe,
+                                                          IORING_OP_FALLOCATE);
+        io_uring_free_probe(probe);
+    }
+
+    pthread_mutex_init(&priv->uring_sq_mutex, NULL);
+    GF_ATOMIC_INIT(priv->uring_sq_waiters, 0);
+    GF_ATOMIC_INIT(priv->uring_inflight, 0);
+    GF_ATOMIC_INIT(priv->uring_submits, 0);
+    GF_ATOMIC_INIT(priv->uring_sqes, 0);
+
+    posix_io_uring_register_arenas(this);
+
+    ret = gf_thread_create(&priv->uring_thread, NULL, posix_io_uring_thread,
+                           this, "iouring");
+    if (ret != 0) {
+        if (priv->uring_fixed_count) {
+            iobuf_pool_unpin_arenas(this->ctx->iobuf_pool,
+                                    priv->uring_fixed_arenas,
+                                    priv->uring_fixed_count);
+            priv->uring_fixed_count = 0;
+        }
+        io_uring_queue_exit(&priv->ring);
+        pthread_mutex_destroy(&priv->uring_sq_mutex);
+        return -1;
+    }
+
+    priv->io_uring_capable = _gf_true;
+
+    return 0;
+}
+
+int
+posix_io_uring_on(xlator_t *this)
+{
+    struct posix_private *priv = NULL;
+    int ret = 0;
+
+    priv = this->private;
+
+    if (!priv->io_uring_init_done) {
+        ret = posix_io_uring_init(this);
+        priv->io_uring_init_done = _gf_true;
+    }
+
+    if (priv->io_uring_capable) {
+        this->fops->readv = posix_io_uring_readv;
+        this->fops->writev = posix_io_uring_writev;
+        this->fops->fsync = posix_io_uring_fsync;
+        if (priv->uring_fallocate)
+            this->fops->fallocate = posix_io_uring_fallocate;
+    }
+
+    return ret;
+}
+
+int
+posix_io_uring_off(xlator_t *this)
+{
+    this->fops->readv = posix_readv;
+    this->fops->writev = posix_writev;
+    this->fops->fsync = posix_fsync;
+    this->fops->fallocate = posix_glfallocate;
+
+    return 0;
+}
+
+void
+posix_io_uring_fini(xlator_t *this)
+{
+    struct posix_private *priv = this->private;
+    struct io_uring_sqe *sqe = NULL;
+
+    if (!priv->io_uring_capable)
+        return;
+
+    sqe = posix_io_uring_get_sqe(priv);
+    if (sqe) {
+        io_uring_prep_nop(sqe);
+        io_uring_sqe_set_data(sqe, NULL);
+    }
+    posix_io_uring_submit(this, priv);
+
+    if (!sqe) {
+        gf_msg(this->name, GF_LOG_WARNING, EBUSY, P_MSG_IO_SUBMIT_FAILED,
+               "could not stop the io_uring thread");
+        return;
+    }
+
+    pthread_join(priv->uring_thread, NULL);
+
+    if (priv->uring_fixed_count) {
+        io_uring_unregister_buffers(&priv->ring);
+        iobuf_pool_unpin_arenas(this->ctx->iobuf_pool, priv->uring_fixed_arenas,
+                                priv->uring_fixed_count);
+        priv->uring_fixed_count = 0;
+    }
+
+    io_uring_queue_exit(&priv->ring);
+    pthread_mutex_destroy(&priv->uring_sq_mutex);
+    priv->io_uring_capable = _gf_false;
+}
+
+#else
+
+int
+posix_io_uring_on(xlator_t *this)
+{
+    gf_msg(this->name, GF_LOG_INFO, 0, P_MSG_IO_URING_UNAVAILABLE,
+           "Linux io_uring not available at build-time."
+           " Continuing with synchronous IO");
+    return 0;
+}
+
+int
+posix_io_uring_off(xlator_t *this)
+{
+    return 0;
+}
+
+void
+posix_io_uring_fini(xlator_t *this)
+{
+    return;
+}
+
+#endif
@@ -0,0 +1,30 @@
+/*
+   Copyright (c) 2026 Red Hat, Inc. <http://www.redhat.com>
+   This file is part of GlusterFS.
+
+   This file is licensed to you under your choice of the GNU Lesser
+   General Public License, version 3 or any later version (LGPLv3 or
+   later), or the GNU General Public License, version 2 (GPLv2), in all
+   cases as published by the Free Software Foundation.
+*/
+#ifndef _POSIX_IO_URING_H
+#define _POSIX_IO_URING_H
+
+// Number of entries in the submission queue. The completion queue gets
+// twice as many.
+#define POSIX_IO_URING_NR_ENTRIES 512
+
+// Maximum number of completions to reap in one go
+#define POSIX_IO_URING_MAX_NR_CQES 64
+
+// Maximum number of iobuf arenas registered as fixed buffers
+#define POSIX_IO_URING_MAX_FIXED_BUFS 64
+
+int
+posix_io_uring_on(xlator_t *this);
+int
+posix_io_uring_off(xlator_t *this);
+void
+posix_io_uring_fini(xlator_t *this);
+
+#endif /* !_POSIX_IO_URING_H */
@@ -42,6 +42,11 @@
 #include "posix-aio.h"
 #endif
 
+#ifdef HAVE_LIBURING
+#include <liburing.h>
+#include "posix-io-uring.h"
+#endif
+
 #define VECTOR_SIZE 64 * 1024 /* vector size 64KB*/
 #define MAX_NO_VECT 1024
 
@@ -195,6 +200,31 @@ struct posix_private {
 #ifdef HAVE_LIBAIO
     io_context_t ctxp;
     pthread_t aiothread;
+    /* O_DIRECT requests waiting to be submitted */
+    pthread_mutex_t aio_sq_mutex;
+    struct iocb *aio_sq[POSIX_AIO_MAX_NR_EVENTS];
+    int aio_sq_count;
+    gf_atomic_t aio_sq_waiters; /* threads waiting to queue a request */
+    gf_atomic_t aio_requests;
+    gf_atomic_t aio_submits; /* io_submit() calls */
+    gf_atomic_t aio_merged;  /* requests merged into another one */
+#endif
+
+    gf_boolean_t io_uring_configured;
+    gf_boolean_t io_uring_init_done;
+    gf_boolean_t io_uring_capable;
+#ifdef HAVE_LIBURING
+    struct io_uring ring;
+    pthread_t uring_thread;
+    pthread_mutex_t uring_sq_mutex;
+    gf_atomic_t uring_sq_waiters; /* threads waiting to queue a request */
+    gf_atomic_t uring_submits;    /* io_uring_enter() calls */
+    gf_atomic_t uring_sqes;       /* requests submitted */
+    gf_atomic_t uring_inflight;   /* requests queued, not yet completed */
+    /* iobuf arenas registered as fixed buffers */
+    struct iobuf_arena *uring_fixed_arenas[POSIX_IO_URING_MAX_FIXED_BUFS];
+    int uring_fixed_count;
+    gf_boolean_t uring_fallocate; /* kernel supports IORING_OP_FALLOCATE */
 #endif
 
     /* node-uuid in pathinfo xattr */
@@ -525,6 +555,9 @@ posix_writev(call_frame_t *frame, xlator_t *this, fd_t *fd,
              struct iovec *vector, int32_t count, off_t offset, uint32_t flags,
              struct iobref *iobref, dict_t *xdata);
 
+dict_t *
+_fill_writev_xdata(fd_t *fd, dict_t *xdata, xlator_t *this, int is_append);
+
 int32_t
 posix_statfs(call_frame_t *frame, xlator_t *this, loc_t *loc, dict_t *xdata);
 